@@ -2,24 +2,92 @@
 #define CONFIG_H
 
 #include <string>
+#include <cstdint>
 #include <vector>
 #include <filesystem>
 
 namespace Config {
     // File paths
     const std::string SIGNATURE_DB_PATH = "data/signatures.db";
+    const std::string FUZZY_SIGNATURE_DB_PATH = "data/fuzzy_signatures.db";
+    const std::string PE_SIGNATURE_DB_PATH = "data/pe_signatures.db";
+    const std::string ENGINE_SNAPSHOT_PATH = "data/engine.snapshot";     // Rebuilt when any database changes
     const std::string QUARANTINE_PATH = "data/quarantine/";
+    const std::string SCAN_STATE_PATH = "data/scan_state/";
     const std::string LOG_PATH = "logs/scan_results.log";
 
     // Scan settings
     const size_t SCAN_BUFFER_SIZE = 8192;
     const float ENTROPY_THRESHOLD = 7.0f;
+    const float HEURISTIC_SCORE_THRESHOLD = 1.0f;   // Weighted detector score needed to flag a file
     const size_t MAX_FILE_SIZE = 100 * 1024 * 1024; // 100MB
     const int SCAN_THREADS = 4;
+    const int FUZZY_MATCH_THRESHOLD = 40;           // Max digest distance reported as a variant
+    const int FILE_SCAN_TIMEOUT_MS = 30000;         // Per-file budget for batch and background scans (0 = none)
+    const int REALTIME_SCAN_TIMEOUT_MS = 2000;      // Per-change budget for real-time protection
+    const size_t ENCODED_RUN_MIN_LENGTH = 256;      // Shortest base64/hex run treated as a possible blob
+    const size_t ENCODED_RUN_MAX_REPORTED = 64;     // Long runs kept per scan; later ones are only counted
+    const float BASE64_BLOB_ENTROPY = 5.0f;         // Bits per byte; random data encodes to about 6
+    const float HEX_BLOB_ENTROPY = 3.5f;            // Bits per byte; random data encodes to about 4
+    const float HEURISTIC_ENTROPY_THRESHOLD = 6.5f; // Whole-content entropy that counts as packed or encrypted
+
+    // Streaming scan settings
+    const size_t SCAN_CHUNK_SIZE = 64 * 1024;
+    const size_t HEAD_TAIL_SCAN_SIZE = 4 * 1024 * 1024;      // Bytes read from each end of oversized files
+    const size_t MEDIA_FULL_SCAN_LIMIT = 16 * 1024 * 1024;   // Media/disk images above this get head/tail only
+    const uint64_t MEDIA_SAMPLED_SCAN_LIMIT = 256 * 1024 * 1024;   // Media/disk images above this are sampled
+    const uint64_t SAMPLED_SCAN_LIMIT = 2ULL * 1024 * 1024 * 1024; // Other files above this are sampled
+    const size_t SAMPLE_EDGE_SIZE = 1024 * 1024;             // Bytes a sampled scan reads from each end
+    const size_t SAMPLE_BLOCK_SIZE = 64 * 1024;
+    const size_t SAMPLE_BLOCK_COUNT = 64;                    // Pseudo-random blocks from the rest of the file
+    const size_t SCAN_ARENA_SIZE = 256 * 1024;               // Per-thread block for per-file temporaries
+    const size_t STREAM_HEAD_SIZE = 64 * 1024;               // Bytes a stream scan holds back to parse headers
+    const size_t FILE_TYPE_SNIFF_SIZE = 4096;                // Bytes examined for magic numbers
+
+    // Asynchronous reads
+    const size_t ASYNC_READ_BUFFERS = 64;    // Shared pool of SCAN_CHUNK_SIZE buffers
+    const size_t ASYNC_READ_DEPTH = 8;       // Reads kept in flight per file
+    const int ASYNC_READ_THREADS = 8;        // Thread pool size when io_uring is unavailable
+
+    // Background scan pacing (0 = unlimited)
+    const double BACKGROUND_SCAN_BYTES_PER_SEC = 32.0 * 1024 * 1024;
+    const double BACKGROUND_SCAN_FILES_PER_SEC = 200.0;
+    const double BACKGROUND_SCAN_CPU_DUTY = 0.25;      // Fraction of one core a background scan may use
+    const double ADAPTIVE_LATENCY_FACTOR = 2.0;        // Back off once read latency doubles over baseline
+    const int BACKGROUND_SCAN_INTERVAL_SEC = 3600;     // Rest between continuous scan passes
+    const bool BACKGROUND_SCAN_INCREMENTAL = true;     // Skip directories and files unchanged since the last pass
+    const int BACKGROUND_SCAN_VERIFY_INTERVAL_SEC = 7 * 24 * 3600; // Full pass at least this often
+
+    // Ransomware detection
+    const size_t FINGERPRINT_CACHE_SIZE = 65536;     // Files whose content fingerprint is remembered
+    const size_t FINGERPRINT_SAMPLE_BLOCKS = 8;      // Spread evenly from head to tail
+    const size_t FINGERPRINT_BLOCK_SIZE = 4096;
+    const uint64_t FINGERPRINT_MIN_SIZE = 1024;      // Smaller samples cannot show a reliable entropy
+    const float FINGERPRINT_LOW_ENTROPY = 6.0f;      // Plain content; compressed and encrypted data is near 8
+    const int RANSOMWARE_WINDOW_SEC = 60;
+    const size_t RANSOMWARE_FILE_THRESHOLD = 10;     // Files that look encrypted within the window
+    const size_t REPLACEMENT_PENDING_FILES = 256;    // Unpaired deletions or creations kept per directory
+    const size_t REPLACEMENT_PENDING_DIRECTORIES = 256;
+
+    // Scan daemon
+    const std::string DAEMON_SOCKET_PATH = "data/scand.sock";
+    const size_t DAEMON_MAX_PIPELINE = 64;   // Requests a client may have outstanding
+    const size_t DAEMON_MAX_LINE = 8192;
 
     // Monitor settings
     const int MONITOR_INTERVAL_MS = 100;
     const size_t MAX_PROCESS_MEMORY = 1024 * 1024 * 1024; // 1GB
+    const size_t HOOK_BASELINE_CACHE_SIZE = 512;    // Module files whose export prologues are kept for hook checks
+    const bool MONITOR_MEMORY_SCAN = false;         // Scan the memory of changed processes between sweeps
+    const int MEMORY_SWEEP_INTERVAL_SEC = 3600;     // Full sweep of every process's memory; 0 disables
+    const bool MONITOR_HOOK_CHECK = true;           // Check exports of processes that started or mapped new code
+    const int MONITOR_ANALYSIS_BUDGET_MS = 200;     // Memory analysis per poll; later changes wait for the next one
+    const size_t MONITOR_ANALYSIS_BACKLOG = 1024;   // Changed processes waiting for analysis; the sweep covers the rest
+    const size_t REALTIME_NOTIFY_BUFFER_SIZE = 64 * 1024; // Change notification buffer; 64KB is the limit on network shares
+    const size_t REALTIME_QUEUE_LIMIT = 16384;      // Changes waiting to be scanned before the rest fall back to a rescan
+    const int REALTIME_SCAN_THREADS = 2;
+    const int OVERFLOW_RESCAN_SLACK_MS = 2000;      // Rescans after lost notifications start this far before the last delivery
+    const size_t REALTIME_ACTIVE_DIRECTORIES = 64;  // Recently changed directories rescanned first after an overflow
     
     // Suspicious file extensions
     const std::vector<std::string> SUSPICIOUS_EXTENSIONS = {
@@ -36,8 +104,12 @@ namespace Config {
     };
 
     // Network monitoring
-    const int NETWORK_BUFFER_SIZE = 65536;
+    const int NETWORK_BUFFER_SIZE = 65536;    // Out-of-order bytes held per flow direction
     const std::vector<int> MONITORED_PORTS = {80, 443, 445, 3389, 4444, 8080};
+    const size_t PCAP_READ_BUFFER_SIZE = 4 * 1024 * 1024;
+    const size_t MAX_TRACKED_FLOWS = 65536;
+    const int FLOW_IDLE_TIMEOUT_SEC = 120;
+    const size_t FLOW_INSPECT_LIMIT = 1024 * 1024;  // Bytes scanned per flow direction
 }
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -6,10 +6,13 @@
 #include <iostream>
 #include <string>
 #include <filesystem>
+#include <ctime>
+#include <iomanip>
 #include <windows.h>
 
 AntivirusApp::AntivirusApp()
     : scanner("data/signatures.db"),
+      scheduler(scanner),
       realTimeProtectionEnabled(false),
       running(true) {
     Logger::logInfo("Antivirus initialized");
@@ -49,11 +52,11 @@ void AntivirusApp::processCommand(const std::string& input) {
     }
     else if (input == "6") {
         viewQuarantine(); // Show available files first
-        std::cout << "\nEnter the name of the file to restore (including .quarantine extension): ";
-        std::string filename;
-        std::getline(std::cin, filename);
-        if (!filename.empty()) {
-            scanner.unquarantine(filename);
+        std::cout << "\nEnter the ID of the file to restore: ";
+        std::string id;
+        std::getline(std::cin, id);
+        if (!id.empty()) {
+            scanner.unquarantine(id);
         }
     }
     else if (input == "7") {
@@ -65,6 +68,10 @@ void AntivirusApp::processCommand(const std::string& input) {
         }
     }
     else if (input == "8") {
+        manageBackgroundScan();
+    }
+    else if (input == "9") {
+        scheduler.stop();
         running = false;
     }
     else {
@@ -122,22 +129,87 @@ void AntivirusApp::toggleRealTimeProtection() {
     }
 }
 
-void AntivirusApp::viewQuarantine() {
-    const std::string quarantinePath = "data/quarantine/";
-    std::cout << "\n=== Quarantined Files ===\n";
+void AntivirusApp::manageBackgroundScan() {
+    ScanThrottle& throttle = scheduler.getThrottle();
+    const char* priorities[] = {"normal", "low", "idle"};
 
-    if (!std::filesystem::exists(quarantinePath)) {
-        std::cout << "No quarantined files found.\n";
+    std::cout << "\n=== Background Scan ===\n"
+              << "Status: " << (scheduler.isRunning() ? "running" : "stopped")
+              << " (" << scheduler.getFilesScanned() << " files, "
+              << scheduler.getThreatsFound() << " threats)\n"
+              << "Read limit: " << throttle.getBytesPerSecond() / (1024 * 1024) << " MB/s, "
+              << "file limit: " << throttle.getFilesPerSecond() << " files/s, "
+              << "CPU duty: " << throttle.getCpuDutyCycle() * 100 << "%\n"
+              << "I/O priority: " << priorities[static_cast<int>(throttle.getIoPriority())]
+              << ", adaptive: " << (throttle.isAdaptive() ? "on" : "off")
+              << " (scale " << throttle.getAdaptiveScale() << ")\n"
+              << "1. " << (scheduler.isRunning() ? "Stop" : "Start") << " background scan\n"
+              << "2. Set read limit (MB/s, 0 = unlimited)\n"
+              << "3. Set file limit (files/s, 0 = unlimited)\n"
+              << "4. Set CPU duty cycle (%)\n"
+              << "5. Set I/O priority (normal/low/idle)\n"
+              << "6. Toggle adaptive back-off\n"
+              << "Choose an option: ";
+
+    std::string choice;
+    std::getline(std::cin, choice);
+
+    if (choice == "1") {
+        if (scheduler.isRunning()) {
+            scheduler.stop();
+            std::cout << "Background scan stopped.\n";
+        } else {
+            std::cout << "Enter directory path to scan in the background: ";
+            std::string dirPath;
+            std::getline(std::cin, dirPath);
+            if (std::filesystem::is_directory(dirPath)) {
+                scheduler.start(dirPath);
+                std::cout << "Background scan started.\n";
+            } else {
+                std::cout << "Directory does not exist.\n";
+            }
+        }
         return;
     }
 
-    int count = 0;
-    for (const auto& entry : std::filesystem::directory_iterator(quarantinePath)) {
-        std::cout << ++count << ". " << entry.path().filename().string() << "\n";
+    std::cout << "Enter new value: ";
+    std::string value;
+    std::getline(std::cin, value);
+
+    if (choice == "2") {
+        throttle.setBytesPerSecond(std::stod(value) * 1024 * 1024);
+    } else if (choice == "3") {
+        throttle.setFilesPerSecond(std::stod(value));
+    } else if (choice == "4") {
+        throttle.setCpuDutyCycle(std::stod(value) / 100.0);
+    } else if (choice == "5") {
+        if (value == "normal") throttle.setIoPriority(IoPriority::Normal);
+        else if (value == "low") throttle.setIoPriority(IoPriority::Low);
+        else if (value == "idle") throttle.setIoPriority(IoPriority::Idle);
+        else std::cout << "Unknown priority.\n";
+    } else if (choice == "6") {
+        throttle.setAdaptive(!throttle.isAdaptive());
+    } else {
+        std::cout << "Invalid option!\n";
+        return;
     }
+    std::cout << "Background scan settings updated.\n";
+}
 
-    if (count == 0) {
+void AntivirusApp::viewQuarantine() {
+    std::cout << "\n=== Quarantined Files ===\n";
+
+    auto entries = scanner.listQuarantine();
+    if (entries.empty()) {
         std::cout << "No quarantined files found.\n";
+        return;
+    }
+
+    for (const auto& entry : entries) {
+        std::time_t when = static_cast<std::time_t>(entry.timestamp);
+        std::cout << entry.id << "  " << entry.originalPath << "\n"
+                  << "    " << std::put_time(std::localtime(&when), "%Y-%m-%d %H:%M:%S")
+                  << "  " << entry.reason << "\n";
     }
 }
 
@@ -148,17 +220,11 @@ void AntivirusApp::updateSignatures() {
 }
 
 void AntivirusApp::quarantineFile(const std::string& path) {
-    try {
-        std::filesystem::create_directories("data/quarantine");
-        std::string quarantinePath = "data/quarantine/" +
-                                     std::filesystem::path(path).filename().string() +
-                                     ".quarantine";
-        std::filesystem::rename(path, quarantinePath);
-        Logger::logInfo("File has been quarantined: " + quarantinePath);
-        std::cout << "File has been quarantined.\n";
-    } catch (const std::exception& e) {
-        Logger::logError("Error quarantining file: " + std::string(e.what()));
-        std::cout << "Error quarantining file: " << e.what() << "\n";
+    std::string id = scanner.quarantine(path, "Manual quarantine");
+    if (!id.empty()) {
+        std::cout << "File has been quarantined (ID " << id << ").\n";
+    } else {
+        std::cout << "Error quarantining file.\n";
     }
 }
 
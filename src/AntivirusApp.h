@@ -3,12 +3,14 @@
 
 #include "scanner/FileScanner.h"
 #include "scanner/RealTimeMonitor.h"
+#include "scanner/ScanScheduler.h"
 #include "ui/ConsoleUI.h"
 #include <string>
 
 class AntivirusApp {
 private:
     FileScanner scanner;
+    ScanScheduler scheduler;
     RealTimeMonitor monitor;
     ConsoleUI ui;
     bool realTimeProtectionEnabled;
@@ -18,6 +20,7 @@ private:
     void scanSingleFile(const std::string& path);
     void scanDirectory(const std::string& path);
     void toggleRealTimeProtection();
+    void manageBackgroundScan();
     void viewQuarantine();
     void updateSignatures();
     void quarantineFile(const std::string& path);
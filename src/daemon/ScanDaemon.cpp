@@ -0,0 +1,459 @@
+#include "ScanDaemon.h"
+
+#ifdef __linux__
+
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const uint64_t LISTEN_TAG = 0;
+    const uint64_t WAKE_TAG = 1;
+    const size_t MAX_FDS_PER_MESSAGE = 32;
+    const size_t READ_SIZE = 16384;
+
+    std::string descriptorPath(int fd) {
+        char target[4096];
+        ssize_t length = readlink(("/proc/self/fd/" + std::to_string(fd)).c_str(), target, sizeof(target) - 1);
+        return length > 0 ? std::string(target, static_cast<size_t>(length)) : "fd:" + std::to_string(fd);
+    }
+}
+
+ScanDaemon::ScanDaemon(const FileScanner& scanner, int workers)
+    : scanner(scanner), workerCount(std::max(1, workers)) {}
+
+ScanDaemon::~ScanDaemon() {
+    stop();
+    shutdown();
+}
+
+bool ScanDaemon::setupSocket(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        Logger::logError("Daemon socket path too long: " + socketPath);
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(socketPath).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    // A stale socket from a previous run would make bind fail
+    unlink(socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    // Create the socket as 0660 rather than fixing it up afterwards, so it is
+    // never reachable by other users in between
+    mode_t previousMask = umask(0117);
+    bool bound = listenFd >= 0 && bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    int bindError = errno;
+    umask(previousMask);
+    if (!bound || listen(listenFd, SOMAXCONN) != 0) {
+        Logger::logError("Cannot listen on " + socketPath + ": " + std::strerror(bound ? errno : bindError));
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        Logger::logError("Cannot set up daemon event loop: " + std::string(std::strerror(errno)));
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_TAG;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.u64 = WAKE_TAG;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    return true;
+}
+
+bool ScanDaemon::run(const std::string& socketPath) {
+    running = true;
+    cancelScans.reset();
+    if (!setupSocket(socketPath)) {
+        running = false;
+        shutdown();
+        return false;
+    }
+
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&ScanDaemon::workerLoop, this);
+    }
+    Logger::logInfo("Scan daemon listening on " + socketPath);
+
+    epoll_event events[64];
+    while (running) {
+        int count = epoll_wait(epollFd, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            Logger::logError("Daemon event loop failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptClients();
+            } else if (tag == WAKE_TAG) {
+                uint64_t value;
+                while (read(wakeFd, &value, sizeof(value)) > 0) {}
+                drainCompletions();
+            } else {
+                auto it = clients.find(tag);
+                if (it == clients.end()) continue;
+                // A hung-up peer can no longer receive its answers
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    closeClient(tag);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) flushResponses(tag, it->second);
+                if ((events[i].events & EPOLLIN) && clients.count(tag)) readClient(tag);
+            }
+        }
+    }
+
+    shutdown();
+    unlink(socketPath.c_str());
+    Logger::logInfo("Scan daemon stopped");
+    return true;
+}
+
+void ScanDaemon::stop() {
+    running = false;
+    cancelScans.cancel();
+    // Only async-signal-safe calls here
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void ScanDaemon::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    jobs.clear();
+
+    while (!clients.empty()) {
+        closeClient(clients.begin()->first);
+    }
+    for (int* fd : {&listenFd, &wakeFd, &epollFd}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+}
+
+void ScanDaemon::acceptClients() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Logger::logWarning("Daemon accept failed: " + std::string(std::strerror(errno)));
+            }
+            return;
+        }
+
+        ucred peer{};
+        socklen_t length = sizeof(peer);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0) {
+            Logger::logWarning("Cannot identify daemon client: " + std::string(std::strerror(errno)));
+            close(fd);
+            continue;
+        }
+
+        uint64_t id = nextClientId++;
+        Client& client = clients[id];
+        client.fd = fd;
+        client.trusted = peer.uid == 0 || peer.uid == geteuid();
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void ScanDaemon::readClient(uint64_t id) {
+    Client& client = clients[id];
+    char data[READ_SIZE];
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS_PER_MESSAGE)];
+
+    while (!client.readPaused) {
+        iovec iov{data, sizeof(data)};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        ssize_t received = recvmsg(client.fd, &message, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            closeClient(id);
+            return;
+        }
+
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+                size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const unsigned char* payload = CMSG_DATA(header);
+                for (size_t i = 0; i < count; i++) {
+                    int fd;
+                    std::memcpy(&fd, payload + i * sizeof(int), sizeof(int));
+                    client.descriptors.push_back(fd);
+                }
+            }
+        }
+        if (message.msg_flags & MSG_CTRUNC) {
+            Logger::logWarning("Daemon client sent more descriptors than one message can carry");
+        }
+        // Each descriptor waits for its FDSCAN, and no more requests than that can be outstanding
+        if (client.descriptors.size() > Config::DAEMON_MAX_PIPELINE) {
+            Logger::logWarning("Daemon client sent more descriptors than it has requests, disconnecting");
+            closeClient(id);
+            return;
+        }
+
+        if (received == 0) {
+            client.peerClosed = true;
+            break;
+        }
+        client.input.append(data, static_cast<size_t>(received));
+        processInput(id, client);
+        if (clients.find(id) == clients.end()) return;
+    }
+
+    // Answer everything already asked before closing a half-closed connection
+    if (client.peerClosed && client.pending.empty() && client.outputOffset == client.output.size()) {
+        closeClient(id);
+        return;
+    }
+    updateInterest(id, client);
+}
+
+void ScanDaemon::processInput(uint64_t id, Client& client) {
+    size_t start = 0;
+    while (client.pending.size() < Config::DAEMON_MAX_PIPELINE) {
+        size_t newline = client.input.find('\n', start);
+        if (newline == std::string::npos) break;
+
+        std::string line = client.input.substr(start, newline - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = newline + 1;
+        if (!line.empty()) handleRequest(id, client, line);
+    }
+    client.input.erase(0, start);
+
+    if (client.input.size() > Config::DAEMON_MAX_LINE && client.input.find('\n') == std::string::npos) {
+        Logger::logWarning("Daemon client sent an oversized request, disconnecting");
+        closeClient(id);
+        return;
+    }
+
+    // Back-pressure: stop reading once the pipeline is full
+    client.readPaused = client.pending.size() >= Config::DAEMON_MAX_PIPELINE;
+    flushResponses(id, client);
+}
+
+void ScanDaemon::handleRequest(uint64_t id, Client& client, const std::string& line) {
+    auto response = std::make_shared<Response>();
+    client.pending.push_back(response);
+    requestCount++;
+
+    size_t space = line.find(' ');
+    std::string command = line.substr(0, space);
+    std::string argument = space == std::string::npos ? "" : line.substr(space + 1);
+
+    auto answer = [&response](const std::string& text) {
+        response->text = text;
+        response->ready = true;
+    };
+
+    if (command == "PING") {
+        answer("PONG");
+    } else if (command == "STATS") {
+        answer("STATS requests=" + std::to_string(requestCount.load()) +
+               " threats=" + std::to_string(threatCount.load()) +
+               " clients=" + std::to_string(clients.size()));
+    } else if (command == "SCAN" || command == "FDSCAN") {
+        Job job{id, response, FileHandle(), argument};
+        if (command == "FDSCAN") {
+            if (client.descriptors.empty()) {
+                answer("ERROR no descriptor attached");
+                return;
+            }
+            int fd = client.descriptors.front();
+            client.descriptors.pop_front();
+            job.file = FileHandle::adopt(fd, argument.empty() ? descriptorPath(fd) : argument);
+        } else if (argument.empty()) {
+            answer("ERROR missing path");
+            return;
+        } else if (!client.trusted) {
+            // The daemon could open files this client cannot; it has to open them itself
+            answer("ERROR permission denied, use FDSCAN");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobReady.notify_one();
+    } else {
+        answer("ERROR unknown command");
+    }
+}
+
+void ScanDaemon::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this] { return !jobs.empty() || !running; });
+            if (!running) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        std::string result;
+        if (!job.file.isOpen()) {
+            job.file = FileHandle::open(job.path);
+        }
+        if (!job.file.isOpen()) {
+            result = "ERROR cannot open file";
+        } else {
+            ScanBudget budget(std::chrono::milliseconds(Config::FILE_SCAN_TIMEOUT_MS), &cancelScans);
+            switch (scanner.scan(job.file, budget)) {
+                case ScanStatus::Threat:
+                    threatCount++;
+                    result = "FOUND";
+                    break;
+                case ScanStatus::TimedOut:
+                    result = "TIMEOUT";
+                    break;
+                case ScanStatus::Cancelled:
+                    result = "ERROR shutting down";
+                    break;
+                default:
+                    result = "OK";
+                    break;
+            }
+        }
+        job.file.close();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job.response->text = std::move(result);
+            job.response->ready = true;
+            completed.push_back(job.clientId);
+        }
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void ScanDaemon::drainCompletions() {
+    std::vector<uint64_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(completed);
+    }
+    std::sort(ready.begin(), ready.end());
+    ready.erase(std::unique(ready.begin(), ready.end()), ready.end());
+
+    for (uint64_t id : ready) {
+        auto it = clients.find(id);
+        if (it == clients.end()) continue; // Client left while its scan ran
+        Client& client = it->second;
+
+        flushResponses(id, client);
+        if (clients.find(id) == clients.end()) continue;
+
+        // Room in the pipeline again: parse what was held back
+        if (client.readPaused && client.pending.size() < Config::DAEMON_MAX_PIPELINE) {
+            client.readPaused = false;
+            processInput(id, client);
+            if (clients.find(id) == clients.end()) continue;
+        }
+        if (client.peerClosed && client.pending.empty() && client.outputOffset == client.output.size()) {
+            closeClient(id);
+            continue;
+        }
+        updateInterest(id, client);
+    }
+}
+
+void ScanDaemon::flushResponses(uint64_t id, Client& client) {
+    {
+        // Responses leave strictly in request order
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!client.pending.empty() && client.pending.front()->ready) {
+            client.output += client.pending.front()->text;
+            client.output += '\n';
+            client.pending.pop_front();
+        }
+    }
+
+    while (client.outputOffset < client.output.size()) {
+        ssize_t sent = send(client.fd, client.output.data() + client.outputOffset,
+                            client.output.size() - client.outputOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            closeClient(id);
+            return;
+        }
+        client.outputOffset += static_cast<size_t>(sent);
+    }
+
+    if (client.outputOffset == client.output.size()) {
+        client.output.clear();
+        client.outputOffset = 0;
+    }
+}
+
+void ScanDaemon::updateInterest(uint64_t id, Client& client) {
+    bool wantWrite = client.outputOffset < client.output.size();
+    bool wantRead = !client.readPaused && !client.peerClosed;
+
+    epoll_event event{};
+    event.events = (wantRead ? uint32_t(EPOLLIN) : 0u) | (wantWrite ? uint32_t(EPOLLOUT) : 0u);
+    event.data.u64 = id;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+void ScanDaemon::closeClient(uint64_t id) {
+    auto it = clients.find(id);
+    if (it == clients.end()) return;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    for (int fd : it->second.descriptors) {
+        close(fd);
+    }
+    clients.erase(it);
+}
+
+#endif // __linux__
@@ -0,0 +1,102 @@
+#ifndef SCAN_DAEMON_H
+#define SCAN_DAEMON_H
+
+#ifdef __linux__
+
+#include "../scanner/FileScanner.h"
+#include "Config.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Resident scan service on a Unix domain socket. The signature databases and
+// detectors are loaded once; clients then pay only a socket round trip.
+//
+// Protocol: newline-terminated requests, answered in order on each connection.
+// A client may pipeline up to DAEMON_MAX_PIPELINE requests before reading.
+//   SCAN <path>      scan a file by path; only for clients running as root or the daemon's user
+//   FDSCAN [name]    scan the descriptor passed with SCM_RIGHTS alongside this line
+//   PING             liveness check
+//   STATS            counters
+// Responses: OK | FOUND | TIMEOUT | ERROR <reason> | PONG | STATS <key=value ...>
+class ScanDaemon {
+public:
+    explicit ScanDaemon(const FileScanner& scanner, int workers = Config::SCAN_THREADS);
+    ~ScanDaemon();
+
+    ScanDaemon(const ScanDaemon&) = delete;
+    ScanDaemon& operator=(const ScanDaemon&) = delete;
+
+    // Serves until stop() is called; returns false if the socket could not be set up
+    bool run(const std::string& socketPath = Config::DAEMON_SOCKET_PATH);
+    // Safe to call from a signal handler
+    void stop();
+
+private:
+    struct Response {
+        std::string text;
+        bool ready = false;
+    };
+
+    struct Client {
+        int fd = -1;
+        bool trusted = false;                   // Peer may have the daemon open paths for it
+        std::string input;
+        std::deque<int> descriptors;            // Received with SCM_RIGHTS, claimed by FDSCAN in order
+        std::deque<std::shared_ptr<Response>> pending;
+        std::string output;
+        size_t outputOffset = 0;
+        bool readPaused = false;
+        bool peerClosed = false;
+    };
+
+    struct Job {
+        uint64_t clientId;
+        std::shared_ptr<Response> response;
+        FileHandle file;
+        std::string path;
+    };
+
+    const FileScanner& scanner;
+    int workerCount;
+    int epollFd = -1;
+    int listenFd = -1;
+    int wakeFd = -1;
+    std::atomic<bool> running{false};
+    CancellationToken cancelScans;     // Lets stop() interrupt scans in progress
+
+    std::unordered_map<uint64_t, Client> clients;
+    uint64_t nextClientId = 2;  // 0 and 1 tag the listening socket and the wake descriptor
+
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    std::vector<uint64_t> completed;
+    std::vector<std::thread> workers;
+
+    std::atomic<uint64_t> requestCount{0};
+    std::atomic<uint64_t> threatCount{0};
+
+    bool setupSocket(const std::string& socketPath);
+    void acceptClients();
+    void readClient(uint64_t id);
+    void processInput(uint64_t id, Client& client);
+    void handleRequest(uint64_t id, Client& client, const std::string& line);
+    void flushResponses(uint64_t id, Client& client);
+    void updateInterest(uint64_t id, Client& client);
+    void closeClient(uint64_t id);
+    void drainCompletions();
+    void workerLoop();
+    void shutdown();
+};
+
+#endif // __linux__
+
+#endif // SCAN_DAEMON_H
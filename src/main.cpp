@@ -1,24 +1,110 @@
-#include "AntivirusApp.h"
+#include "network/NetworkAnalyzer.h"
 #include "utils/Logger.h"
-#include <windows.h>
 #include <filesystem>
 #include <iostream>  // For std::cerr
 #include <exception>
+#include <cstring>
+
+namespace {
+    // Offline mode: vet a capture from a file or a pipe ("-") and exit
+    int runPcapAnalysis(const std::string& path) {
+        NetworkAnalyzer analyzer;
+        bool ok = analyzer.analyzeCapture(path);
+
+        const NetworkStats& stats = analyzer.stats();
+        std::cout << stats.packets << " packets, " << stats.segments << " monitored segments, "
+                  << stats.payloadBytes << " payload bytes, " << stats.flows << " flows ("
+                  << stats.evictedFlows << " evicted, " << stats.droppedFlows << " dropped), "
+                  << stats.skippedBytes << " bytes skipped" << std::endl;
+        for (const NetworkFinding& finding : analyzer.findings()) {
+            std::cout << "SUSPICIOUS " << finding.client.toString() << ":" << finding.clientPort
+                      << (finding.toServer ? " -> " : " <- ")
+                      << finding.server.toString() << ":" << finding.serverPort
+                      << " at offset " << finding.streamOffset << std::endl;
+        }
+
+        if (!ok) return 1;
+        return analyzer.findings().empty() ? 0 : 2;
+    }
+}
+
+#ifdef _WIN32
+#include "AntivirusApp.h"
+#include <windows.h>
+#endif
+
+#ifdef __linux__
+#include "daemon/ScanDaemon.h"
+#include "scanner/ProcessMonitor.h"
+#include <csignal>
 
-int main() {
+namespace {
+    ScanDaemon* activeDaemon = nullptr;
+
+    void stopDaemon(int) {
+        if (activeDaemon) activeDaemon->stop();
+    }
+
+    // Resident mode: load everything once, then serve scan requests on a socket
+    // while watching the process table
+    int runDaemon(const std::string& socketPath) {
+        FileScanner scanner(Config::SIGNATURE_DB_PATH);
+        ScanDaemon daemon(scanner);
+        ProcessMemoryScanner memoryScanner;
+        HookDetector hookDetector;
+        ProcessMonitor processMonitor(Config::MONITOR_MEMORY_SCAN ? &memoryScanner : nullptr,
+                                      Config::MONITOR_HOOK_CHECK ? &hookDetector : nullptr);
+        activeDaemon = &daemon;
+        std::signal(SIGINT, stopDaemon);
+        std::signal(SIGTERM, stopDaemon);
+
+        if (Config::MEMORY_SWEEP_INTERVAL_SEC > 0) {
+            memoryScanner.startSweeping(std::chrono::seconds(Config::MEMORY_SWEEP_INTERVAL_SEC));
+        }
+        processMonitor.startMonitoring();
+        bool ok = daemon.run(socketPath);
+        processMonitor.stopMonitoring();
+        memoryScanner.stopSweeping();
+        activeDaemon = nullptr;
+        return ok ? 0 : 1;
+    }
+}
+#endif
+
+int main(int argc, char* argv[]) {
     try {
+#ifdef _WIN32
         // Set console output to UTF-8
         SetConsoleOutputCP(CP_UTF8);
+#endif
         
         // Create necessary directories
         std::filesystem::create_directories("data");
         std::filesystem::create_directories("data/quarantine");
         std::filesystem::create_directories("logs");
 
+        // --pcap <capture file, or - for standard input>
+        if (argc > 2 && std::strcmp(argv[1], "--pcap") == 0) {
+            return runPcapAnalysis(argv[2]);
+        }
+
+#ifdef __linux__
+        // --daemon [socket path]
+        if (argc > 1 && std::strcmp(argv[1], "--daemon") == 0) {
+            return runDaemon(argc > 2 ? argv[2] : Config::DAEMON_SOCKET_PATH);
+        }
+#endif
+
+#ifdef _WIN32
         AntivirusApp app;
         app.run();
         
         return 0;
+#else
+        // The interactive console needs the Win32 monitor and analyzers
+        std::cerr << "Usage: " << argv[0] << " --daemon [socket path] | --pcap <capture file|->" << std::endl;
+        return 1;
+#endif
     } catch (const std::exception& e) {
         Logger::logError("Fatal error: " + std::string(e.what()));
         std::cerr << "Fatal error: " << e.what() << std::endl;
@@ -0,0 +1,226 @@
+#include "NetworkAnalyzer.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const uint64_t NANOS_PER_SECOND = 1000000000ULL;
+    const uint64_t IDLE_TIMEOUT_NS = static_cast<uint64_t>(Config::FLOW_IDLE_TIMEOUT_SEC) * NANOS_PER_SECOND;
+    // Sweeping the whole table is linear, so only do it a few times per timeout
+    const uint64_t SWEEP_INTERVAL_NS = std::max<uint64_t>(IDLE_TIMEOUT_NS / 8, NANOS_PER_SECOND);
+
+    std::string endpoint(const IpAddress& address, uint16_t port) {
+        return address.toString() + ":" + std::to_string(port);
+    }
+}
+
+size_t NetworkAnalyzer::FlowKeyHash::operator()(const FlowKey& key) const {
+    uint64_t words[4];
+    std::memcpy(words, key.client.bytes.data(), 16);
+    std::memcpy(words + 2, key.server.bytes.data(), 16);
+
+    uint64_t hash = ((static_cast<uint64_t>(key.clientPort) << 16) | key.serverPort) * 0x9E3779B97F4A7C15ULL;
+    for (uint64_t word : words) {
+        hash ^= word;
+        hash *= 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    }
+    return static_cast<size_t>(hash);
+}
+
+NetworkAnalyzer::NetworkAnalyzer(const PatternAutomaton& automaton) : automaton(automaton) {
+    for (int port : Config::MONITORED_PORTS) {
+        if (port >= 0 && port < 65536) monitoredPorts.set(static_cast<size_t>(port));
+    }
+    flows.reserve(std::min<size_t>(Config::MAX_TRACKED_FLOWS, 4096));
+}
+
+bool NetworkAnalyzer::analyzeCapture(const std::string& path) {
+    try {
+        PcapReader reader;
+        bool ok = reader.read(path, [this](const CapturedPacket& packet) {
+            processPacket(packet);
+            return true;
+        });
+
+        Logger::logInfo("Analyzed capture " + path + ": " + std::to_string(counters.packets) + " packets, " +
+                        std::to_string(counters.flows) + " flows, " +
+                        std::to_string(counters.findings) + " findings");
+        return ok;
+    } catch (const std::exception& e) {
+        Logger::logError("Error analyzing capture " + path + ": " + e.what());
+        return false;
+    }
+}
+
+void NetworkAnalyzer::processPacket(const CapturedPacket& packet) {
+    counters.packets++;
+    TcpSegment segment;
+    if (!PacketParser::parseTcp(packet.linkType, packet.data, packet.capturedLength, segment)) return;
+    handleSegment(segment, packet.timestampNs);
+}
+
+void NetworkAnalyzer::handleSegment(const TcpSegment& segment, uint64_t timestampNs) {
+    bool destinationMonitored = monitoredPorts.test(segment.destinationPort);
+    bool sourceMonitored = monitoredPorts.test(segment.sourcePort);
+    if (!destinationMonitored && !sourceMonitored) return;
+
+    // When both ports are monitored, pick the server the same way for either direction
+    bool toServer = destinationMonitored;
+    if (destinationMonitored && sourceMonitored) {
+        toServer = segment.destinationPort != segment.sourcePort
+            ? segment.destinationPort < segment.sourcePort
+            : segment.destination.bytes < segment.source.bytes;
+    }
+    FlowKey key = toServer
+        ? FlowKey{segment.source, segment.destination, segment.sourcePort, segment.destinationPort}
+        : FlowKey{segment.destination, segment.source, segment.destinationPort, segment.sourcePort};
+
+    counters.segments++;
+    counters.payloadBytes += segment.payloadLength;
+
+    if (timestampNs >= lastSweepNs + SWEEP_INTERVAL_NS) {
+        evictIdle(timestampNs);
+        lastSweepNs = timestampNs;
+    }
+
+    auto it = flows.find(key);
+    if (it == flows.end()) {
+        // Only open flows for segments that start or carry a stream
+        if (segment.flags & PacketParser::TCP_RST) return;
+        if (segment.payloadLength == 0 && !(segment.flags & PacketParser::TCP_SYN)) return;
+        if (flows.size() >= Config::MAX_TRACKED_FLOWS) {
+            counters.droppedFlows++;
+            return;
+        }
+        it = flows.try_emplace(key, automaton).first;
+        counters.flows++;
+    }
+
+    Flow& flow = it->second;
+    flow.lastSeenNs = timestampNs;
+    if (segment.flags & PacketParser::TCP_RST) {
+        flows.erase(it);
+        return;
+    }
+
+    Direction& direction = toServer ? flow.toServer : flow.toClient;
+    receive(key, direction, toServer, segment, timestampNs);
+    if (segment.flags & PacketParser::TCP_FIN) direction.closed = true;
+    if (flow.toServer.closed && flow.toClient.closed) flows.erase(it);
+}
+
+void NetworkAnalyzer::receive(const FlowKey& key, Direction& direction, bool toServer,
+                              const TcpSegment& segment, uint64_t timestampNs) {
+    uint32_t sequence = segment.sequence;
+    if (segment.flags & PacketParser::TCP_SYN) {
+        // The SYN itself consumes one sequence number
+        sequence++;
+        if (!direction.synced) {
+            direction.initialSequence = sequence;
+            direction.synced = true;
+        }
+    }
+    if (segment.payloadLength == 0 || direction.done) return;
+    if (!direction.synced) {
+        // Flow was already open when the capture started
+        direction.initialSequence = sequence;
+        direction.synced = true;
+    }
+
+    // Unwrap the 32-bit sequence number around the current stream position
+    uint32_t relative = sequence - direction.initialSequence;
+    int32_t distance = static_cast<int32_t>(relative - static_cast<uint32_t>(direction.delivered));
+    int64_t position = static_cast<int64_t>(direction.delivered) + distance;
+
+    const unsigned char* data = segment.payload;
+    size_t length = segment.payloadLength;
+    while (!direction.done) {
+        if (position <= static_cast<int64_t>(direction.delivered)) {
+            // Retransmissions may still carry some new bytes at the end
+            uint64_t overlap = direction.delivered - position;
+            if (overlap >= length) return;
+            inspect(key, direction, toServer, data + overlap, length - overlap, timestampNs);
+            drain(key, direction, toServer, timestampNs);
+            return;
+        }
+
+        uint64_t offset = static_cast<uint64_t>(position);
+        if (direction.pendingBytes + length <= static_cast<size_t>(Config::NETWORK_BUFFER_SIZE)) {
+            buffer(direction, offset, data, length);
+            return;
+        }
+
+        // Out of room: give up on the gap and resume at the earliest bytes held
+        uint64_t next = direction.pending.empty() ? offset : std::min(offset, direction.pending.begin()->first);
+        counters.skippedBytes += next - direction.delivered;
+        direction.delivered = next;
+        drain(key, direction, toServer, timestampNs);
+    }
+}
+
+void NetworkAnalyzer::buffer(Direction& direction, uint64_t offset, const unsigned char* data, size_t length) {
+    auto [it, inserted] = direction.pending.try_emplace(offset);
+    if (!inserted && it->second.size() >= length) return;
+    direction.pendingBytes += length - it->second.size();
+    it->second.assign(reinterpret_cast<const char*>(data), length);
+}
+
+void NetworkAnalyzer::drain(const FlowKey& key, Direction& direction, bool toServer, uint64_t timestampNs) {
+    while (!direction.pending.empty() && !direction.done) {
+        auto it = direction.pending.begin();
+        if (it->first > direction.delivered) break;
+
+        uint64_t offset = it->first;
+        std::string bytes = std::move(it->second);
+        direction.pendingBytes -= bytes.size();
+        direction.pending.erase(it);
+
+        // Overlapping segments only contribute what lies past the delivered point
+        uint64_t overlap = direction.delivered - offset;
+        if (overlap < bytes.size()) {
+            inspect(key, direction, toServer, reinterpret_cast<const unsigned char*>(bytes.data()) + overlap,
+                    bytes.size() - overlap, timestampNs);
+        }
+    }
+}
+
+void NetworkAnalyzer::inspect(const FlowKey& key, Direction& direction, bool toServer,
+                              const unsigned char* data, size_t length, uint64_t timestampNs) {
+    uint64_t start = direction.delivered;
+    direction.delivered += length;
+
+    if (start < Config::FLOW_INSPECT_LIMIT) {
+        size_t scanned = static_cast<size_t>(std::min<uint64_t>(length, Config::FLOW_INSPECT_LIMIT - start));
+        if (direction.scanner.update(data, scanned, start)) {
+            NetworkFinding finding{key.client, key.server, key.clientPort, key.serverPort,
+                                   toServer, start + scanned, timestampNs};
+            reported.push_back(finding);
+            counters.findings++;
+            direction.done = true;
+
+            Logger::logWarning(std::string("Suspicious content in ") +
+                               (toServer ? "client-to-server" : "server-to-client") + " stream " +
+                               endpoint(key.client, key.clientPort) + " -> " +
+                               endpoint(key.server, key.serverPort) +
+                               " before offset " + std::to_string(finding.streamOffset));
+        }
+    }
+    if (direction.delivered >= Config::FLOW_INSPECT_LIMIT) direction.done = true;
+
+    if (direction.done) {
+        direction.pending.clear();
+        direction.pendingBytes = 0;
+    }
+}
+
+void NetworkAnalyzer::evictIdle(uint64_t nowNs) {
+    for (auto it = flows.begin(); it != flows.end();) {
+        if (nowNs > it->second.lastSeenNs + IDLE_TIMEOUT_NS) {
+            it = flows.erase(it);
+            counters.evictedFlows++;
+        } else {
+            ++it;
+        }
+    }
+}
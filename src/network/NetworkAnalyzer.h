@@ -0,0 +1,110 @@
+#ifndef NETWORK_ANALYZER_H
+#define NETWORK_ANALYZER_H
+
+#include "PacketParser.h"
+#include "PcapReader.h"
+#include "../utils/Utils.h"
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct NetworkFinding {
+    IpAddress client;
+    IpAddress server;
+    uint16_t clientPort;
+    uint16_t serverPort;    // The monitored port
+    bool toServer;          // Direction the matching bytes travelled
+    uint64_t streamOffset;  // End of the chunk that completed the match
+    uint64_t timestampNs;
+};
+
+struct NetworkStats {
+    uint64_t packets = 0;
+    uint64_t segments = 0;      // TCP segments on monitored ports
+    uint64_t payloadBytes = 0;
+    uint64_t flows = 0;
+    uint64_t evictedFlows = 0;  // Idle past FLOW_IDLE_TIMEOUT_SEC
+    uint64_t droppedFlows = 0;  // Not tracked because the flow table was full
+    uint64_t skippedBytes = 0;  // Gaps given up on when reassembly ran out of room
+    uint64_t findings = 0;
+};
+
+// Reassembles TCP flows on Config::MONITORED_PORTS from a capture and runs
+// the content pattern automaton over each direction of the stream. Matches
+// that span segment boundaries are found because the automaton state is
+// carried from one in-order segment to the next.
+//
+// Memory is bounded: at most MAX_TRACKED_FLOWS flows, NETWORK_BUFFER_SIZE
+// out-of-order bytes per direction, and flows idle for FLOW_IDLE_TIMEOUT_SEC
+// of capture time are evicted. Each direction reports at most one finding.
+class NetworkAnalyzer {
+public:
+    explicit NetworkAnalyzer(const PatternAutomaton& automaton = Utils::suspiciousStringPatterns());
+
+    // Returns false if the capture could not be read to the end
+    bool analyzeCapture(const std::string& path);
+    void processPacket(const CapturedPacket& packet);
+
+    const NetworkStats& stats() const { return counters; }
+    const std::vector<NetworkFinding>& findings() const { return reported; }
+    size_t activeFlows() const { return flows.size(); }
+
+private:
+    struct FlowKey {
+        IpAddress client;
+        IpAddress server;
+        uint16_t clientPort;
+        uint16_t serverPort;
+
+        bool operator==(const FlowKey& other) const {
+            return clientPort == other.clientPort && serverPort == other.serverPort &&
+                   client == other.client && server == other.server;
+        }
+    };
+
+    struct FlowKeyHash {
+        size_t operator()(const FlowKey& key) const;
+    };
+
+    struct Direction {
+        explicit Direction(const PatternAutomaton& automaton) : scanner(automaton) {}
+
+        Utils::PatternScanner scanner;
+        std::map<uint64_t, std::string> pending;   // Out-of-order segments by stream offset
+        size_t pendingBytes = 0;
+        uint32_t initialSequence = 0;
+        uint64_t delivered = 0;     // Stream bytes scanned or skipped so far
+        bool synced = false;
+        bool closed = false;
+        bool done = false;          // Matched or past FLOW_INSPECT_LIMIT
+    };
+
+    struct Flow {
+        explicit Flow(const PatternAutomaton& automaton) : toServer(automaton), toClient(automaton) {}
+
+        Direction toServer;
+        Direction toClient;
+        uint64_t lastSeenNs = 0;
+    };
+
+    const PatternAutomaton& automaton;
+    std::bitset<65536> monitoredPorts;
+    std::unordered_map<FlowKey, Flow, FlowKeyHash> flows;
+    std::vector<NetworkFinding> reported;
+    NetworkStats counters;
+    uint64_t lastSweepNs = 0;
+
+    void handleSegment(const TcpSegment& segment, uint64_t timestampNs);
+    void receive(const FlowKey& key, Direction& direction, bool toServer,
+                 const TcpSegment& segment, uint64_t timestampNs);
+    void buffer(Direction& direction, uint64_t offset, const unsigned char* data, size_t length);
+    void drain(const FlowKey& key, Direction& direction, bool toServer, uint64_t timestampNs);
+    void inspect(const FlowKey& key, Direction& direction, bool toServer,
+                 const unsigned char* data, size_t length, uint64_t timestampNs);
+    void evictIdle(uint64_t nowNs);
+};
+
+#endif // NETWORK_ANALYZER_H
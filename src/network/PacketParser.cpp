@@ -0,0 +1,133 @@
+#include "PacketParser.h"
+#include "PcapReader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const uint16_t ETHERTYPE_IPV4 = 0x0800;
+    const uint16_t ETHERTYPE_IPV6 = 0x86DD;
+    const uint16_t ETHERTYPE_VLAN = 0x8100;
+    const uint16_t ETHERTYPE_QINQ = 0x88A8;
+    const uint8_t PROTOCOL_TCP = 6;
+
+    uint16_t be16(const unsigned char* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    uint32_t be32(const unsigned char* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+}
+
+std::string IpAddress::toString() const {
+    char text[48];
+    if (version == 4) {
+        std::snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    } else {
+        std::snprintf(text, sizeof(text), "[%x:%x:%x:%x:%x:%x:%x:%x]",
+                      be16(&bytes[0]), be16(&bytes[2]), be16(&bytes[4]), be16(&bytes[6]),
+                      be16(&bytes[8]), be16(&bytes[10]), be16(&bytes[12]), be16(&bytes[14]));
+    }
+    return text;
+}
+
+bool PacketParser::parseTcp(uint16_t linkType, const unsigned char* data, size_t length, TcpSegment& segment) {
+    switch (linkType) {
+        case LinkType::ETHERNET: {
+            if (length < 14) return false;
+            size_t offset = 12;
+            uint16_t etherType = be16(data + offset);
+            // 802.1Q and 802.1ad tags, possibly stacked
+            while ((etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ) && offset + 6 <= length) {
+                offset += 4;
+                etherType = be16(data + offset);
+            }
+            offset += 2;
+            if (etherType != ETHERTYPE_IPV4 && etherType != ETHERTYPE_IPV6) return false;
+            return parseIp(data + offset, length - offset, segment);
+        }
+        case LinkType::LINUX_SLL:
+            if (length < 16) return false;
+            return parseIp(data + 16, length - 16, segment);
+        case LinkType::LINUX_SLL2:
+            if (length < 20) return false;
+            return parseIp(data + 20, length - 20, segment);
+        case LinkType::NULL_LOOPBACK:
+            // The address family is in the capturing host's byte order; the IP version says enough
+            if (length < 4) return false;
+            return parseIp(data + 4, length - 4, segment);
+        case LinkType::RAW:
+        case LinkType::IPV4:
+        case LinkType::IPV6:
+            return parseIp(data, length, segment);
+        default:
+            return false;
+    }
+}
+
+bool PacketParser::parseIp(const unsigned char* data, size_t length, TcpSegment& segment) {
+    if (length < 1) return false;
+    switch (data[0] >> 4) {
+        case 4: return parseIpv4(data, length, segment);
+        case 6: return parseIpv6(data, length, segment);
+        default: return false;
+    }
+}
+
+bool PacketParser::parseIpv4(const unsigned char* data, size_t length, TcpSegment& segment) {
+    if (length < 20) return false;
+    size_t headerLength = static_cast<size_t>(data[0] & 0x0F) * 4;
+    size_t totalLength = be16(data + 2);
+    if (headerLength < 20 || totalLength < headerLength || headerLength > length) return false;
+    // More-fragments flag or a fragment offset
+    if (be16(data + 6) & 0x3FFF) return false;
+    if (data[9] != PROTOCOL_TCP) return false;
+
+    segment.source = IpAddress();
+    segment.destination = IpAddress();
+    segment.source.version = segment.destination.version = 4;
+    std::memcpy(segment.source.bytes.data(), data + 12, 4);
+    std::memcpy(segment.destination.bytes.data(), data + 16, 4);
+
+    // Ethernet pads short frames; the IP length says where the packet really ends
+    size_t end = std::min(length, totalLength);
+    return parseTcpHeader(data + headerLength, end - headerLength, segment);
+}
+
+bool PacketParser::parseIpv6(const unsigned char* data, size_t length, TcpSegment& segment) {
+    if (length < 40) return false;
+    size_t end = std::min(length, 40 + static_cast<size_t>(be16(data + 4)));
+    uint8_t nextHeader = data[6];
+    size_t offset = 40;
+
+    // Hop-by-hop, routing, destination options and authentication headers
+    while (nextHeader == 0 || nextHeader == 43 || nextHeader == 60 || nextHeader == 51) {
+        if (offset + 8 > end) return false;
+        size_t extensionLength = nextHeader == 51 ? (static_cast<size_t>(data[offset + 1]) + 2) * 4
+                                                  : (static_cast<size_t>(data[offset + 1]) + 1) * 8;
+        nextHeader = data[offset];
+        offset += extensionLength;
+    }
+    if (nextHeader != PROTOCOL_TCP || offset > end) return false;
+
+    segment.source.version = segment.destination.version = 6;
+    std::memcpy(segment.source.bytes.data(), data + 8, 16);
+    std::memcpy(segment.destination.bytes.data(), data + 24, 16);
+    return parseTcpHeader(data + offset, end - offset, segment);
+}
+
+bool PacketParser::parseTcpHeader(const unsigned char* data, size_t length, TcpSegment& segment) {
+    if (length < 20) return false;
+    size_t headerLength = static_cast<size_t>(data[12] >> 4) * 4;
+    if (headerLength < 20 || headerLength > length) return false;
+
+    segment.sourcePort = be16(data);
+    segment.destinationPort = be16(data + 2);
+    segment.sequence = be32(data + 4);
+    segment.flags = data[13];
+    segment.payload = data + headerLength;
+    segment.payloadLength = length - headerLength;
+    return true;
+}
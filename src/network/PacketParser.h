@@ -0,0 +1,49 @@
+#ifndef PACKET_PARSER_H
+#define PACKET_PARSER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct IpAddress {
+    std::array<uint8_t, 16> bytes{};    // IPv4 uses the first four
+    uint8_t version = 0;
+
+    bool operator==(const IpAddress& other) const {
+        return version == other.version && bytes == other.bytes;
+    }
+    std::string toString() const;
+};
+
+// A TCP segment decoded in place; payload points into the captured packet
+struct TcpSegment {
+    IpAddress source;
+    IpAddress destination;
+    uint16_t sourcePort;
+    uint16_t destinationPort;
+    uint32_t sequence;
+    uint8_t flags;
+    const unsigned char* payload;
+    size_t payloadLength;
+};
+
+// Decodes link, IP and TCP headers without copying. IP fragments are not
+// reassembled; they are rare on TCP and are skipped.
+class PacketParser {
+public:
+    static constexpr uint8_t TCP_FIN = 0x01;
+    static constexpr uint8_t TCP_SYN = 0x02;
+    static constexpr uint8_t TCP_RST = 0x04;
+
+    // Returns false for anything other than an unfragmented TCP segment
+    static bool parseTcp(uint16_t linkType, const unsigned char* data, size_t length, TcpSegment& segment);
+
+private:
+    static bool parseIp(const unsigned char* data, size_t length, TcpSegment& segment);
+    static bool parseIpv4(const unsigned char* data, size_t length, TcpSegment& segment);
+    static bool parseIpv6(const unsigned char* data, size_t length, TcpSegment& segment);
+    static bool parseTcpHeader(const unsigned char* data, size_t length, TcpSegment& segment);
+};
+
+#endif // PACKET_PARSER_H
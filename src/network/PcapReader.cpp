@@ -0,0 +1,223 @@
+#include "PcapReader.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+    // Classic pcap magic numbers as read little-endian
+    const uint32_t PCAP_MICROS_LE = 0xA1B2C3D4;
+    const uint32_t PCAP_NANOS_LE = 0xA1B23C4D;
+    const uint32_t PCAP_MICROS_BE = 0xD4C3B2A1;
+    const uint32_t PCAP_NANOS_BE = 0x4D3CB2A1;
+
+    // pcapng block types
+    const uint32_t BLOCK_SECTION_HEADER = 0x0A0D0D0A;
+    const uint32_t BLOCK_INTERFACE = 1;
+    const uint32_t BLOCK_SIMPLE_PACKET = 3;
+    const uint32_t BLOCK_ENHANCED_PACKET = 6;
+    const uint32_t BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+    const uint16_t OPTION_END = 0;
+    const uint16_t OPTION_TSRESOL = 9;
+
+    // Larger records are treated as corruption rather than buffered
+    const size_t MAX_RECORD_SIZE = 16 * 1024 * 1024;
+
+    uint32_t littleEndian32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+}
+
+PcapReader::PcapReader(size_t bufferSize) : buffer(std::max<size_t>(bufferSize, 64 * 1024)) {}
+
+bool PcapReader::read(const std::string& path, const PacketCallback& callback) {
+    begin = 0;
+    end = 0;
+    packets = 0;
+    bigEndian = false;
+
+    bool fromPipe = path == "-";
+    if (fromPipe) {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        input = stdin;
+    } else {
+        input = std::fopen(path.c_str(), "rb");
+    }
+    if (!input) {
+        Logger::logError("Cannot open capture: " + path);
+        return false;
+    }
+
+    bool ok = false;
+    try {
+        if (!fill(4)) {
+            Logger::logError("Capture is empty: " + path);
+        } else {
+            uint32_t magic = littleEndian32(&buffer[begin]);
+            if (magic == BLOCK_SECTION_HEADER) {
+                ok = readPcapNg(callback);
+            } else if (magic == PCAP_MICROS_LE || magic == PCAP_NANOS_LE ||
+                       magic == PCAP_MICROS_BE || magic == PCAP_NANOS_BE) {
+                ok = readClassic(magic, callback);
+            } else {
+                Logger::logError("Not a pcap or pcapng capture: " + path);
+            }
+        }
+    } catch (...) {
+        if (!fromPipe) std::fclose(input);
+        input = nullptr;
+        throw;
+    }
+
+    if (!fromPipe) std::fclose(input);
+    input = nullptr;
+    if (!ok) Logger::logError("Malformed capture after " + std::to_string(packets) + " packets: " + path);
+    return ok;
+}
+
+bool PcapReader::fill(size_t length) {
+    if (end - begin >= length) return true;
+    if (length > MAX_RECORD_SIZE) return false;
+
+    // Move the partial record to the front; the buffer only grows for
+    // records larger than itself
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (buffer.size() < length) buffer.resize(length);
+
+    while (end < length) {
+        size_t got = std::fread(buffer.data() + end, 1, buffer.size() - end, input);
+        if (got == 0) return false;
+        end += got;
+    }
+    return true;
+}
+
+uint16_t PcapReader::read16(const unsigned char* p) const {
+    return bigEndian ? static_cast<uint16_t>((p[0] << 8) | p[1])
+                     : static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t PcapReader::read32(const unsigned char* p) const {
+    if (!bigEndian) return littleEndian32(p);
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint64_t PcapReader::toNanoseconds(uint64_t timestamp, uint64_t unitsPerSecond) {
+    if (unitsPerSecond == 1000000000ULL) return timestamp;
+    uint64_t seconds = timestamp / unitsPerSecond;
+    uint64_t remainder = timestamp % unitsPerSecond;
+    return seconds * 1000000000ULL +
+           static_cast<uint64_t>(static_cast<long double>(remainder) * 1e9L / unitsPerSecond);
+}
+
+bool PcapReader::readClassic(uint32_t magic, const PacketCallback& callback) {
+    bigEndian = magic == PCAP_MICROS_BE || magic == PCAP_NANOS_BE;
+    uint64_t unitsPerSecond = (magic == PCAP_NANOS_LE || magic == PCAP_NANOS_BE) ? 1000000000ULL : 1000000ULL;
+
+    if (!fill(24)) return false;
+    // The upper bits of the link type field carry FCS information
+    uint16_t linkType = static_cast<uint16_t>(read32(&buffer[begin + 20]) & 0xFFFF);
+    begin += 24;
+
+    while (fill(16)) {
+        uint32_t captured = read32(&buffer[begin + 8]);
+        if (captured > MAX_RECORD_SIZE) return false;
+        if (!fill(16 + static_cast<size_t>(captured))) {
+            Logger::logWarning("Capture ends in the middle of a packet");
+            return true;
+        }
+
+        const unsigned char* record = &buffer[begin];
+        uint64_t timestamp = static_cast<uint64_t>(read32(record)) * unitsPerSecond + read32(record + 4);
+        CapturedPacket packet{record + 16, captured, read32(record + 12),
+                              toNanoseconds(timestamp, unitsPerSecond), linkType};
+        begin += 16 + captured;
+        packets++;
+        if (!callback(packet)) return true;
+    }
+    return true;
+}
+
+bool PcapReader::readPcapNg(const PacketCallback& callback) {
+    std::vector<Interface> interfaces;
+
+    while (fill(12)) {
+        const unsigned char* block = &buffer[begin];
+        // A capture may hold several sections, each with its own byte order
+        if (littleEndian32(block) == BLOCK_SECTION_HEADER) {
+            uint32_t byteOrder = littleEndian32(block + 8);
+            if (byteOrder != BYTE_ORDER_MAGIC && byteOrder != 0x4D3C2B1A) return false;
+            bigEndian = byteOrder != BYTE_ORDER_MAGIC;
+            interfaces.clear();
+        }
+
+        uint32_t type = read32(block);
+        uint32_t length = read32(block + 4);
+        if (length < 12 || length % 4 != 0 || length > MAX_RECORD_SIZE) return false;
+        if (!fill(length)) {
+            Logger::logWarning("Capture ends in the middle of a block");
+            return true;
+        }
+
+        block = &buffer[begin];
+        const unsigned char* body = block + 8;
+        size_t bodyLength = length - 12;
+        bool keepReading = true;
+
+        if (type == BLOCK_INTERFACE && bodyLength >= 8) {
+            Interface interface{read16(body), 1000000ULL};
+            for (size_t option = 8; option + 4 <= bodyLength;) {
+                uint16_t code = read16(body + option);
+                uint16_t optionLength = read16(body + option + 2);
+                if (code == OPTION_END || option + 4 + optionLength > bodyLength) break;
+                if (code == OPTION_TSRESOL && optionLength >= 1) {
+                    uint8_t resolution = body[option + 4];
+                    uint8_t exponent = resolution & 0x7F;
+                    if (resolution & 0x80) {
+                        interface.unitsPerSecond = exponent < 64 ? 1ULL << exponent : 1;
+                    } else {
+                        interface.unitsPerSecond = 1;
+                        for (uint8_t i = 0; i < exponent && i < 19; i++) interface.unitsPerSecond *= 10;
+                    }
+                }
+                option += 4 + ((optionLength + 3u) & ~3u);
+            }
+            interfaces.push_back(interface);
+        } else if (type == BLOCK_ENHANCED_PACKET && bodyLength >= 20) {
+            uint32_t interfaceId = read32(body);
+            uint32_t captured = read32(body + 12);
+            if (interfaceId < interfaces.size() && captured <= bodyLength - 20) {
+                const Interface& interface = interfaces[interfaceId];
+                uint64_t timestamp = (static_cast<uint64_t>(read32(body + 4)) << 32) | read32(body + 8);
+                CapturedPacket packet{body + 20, captured, read32(body + 16),
+                                      toNanoseconds(timestamp, interface.unitsPerSecond), interface.linkType};
+                packets++;
+                keepReading = callback(packet);
+            }
+        } else if (type == BLOCK_SIMPLE_PACKET && bodyLength >= 4 && !interfaces.empty()) {
+            // Simple packets carry no timestamp and always belong to the first interface
+            uint32_t original = read32(body);
+            uint32_t captured = static_cast<uint32_t>(std::min<size_t>(original, bodyLength - 4));
+            CapturedPacket packet{body + 4, captured, original, 0, interfaces[0].linkType};
+            packets++;
+            keepReading = callback(packet);
+        }
+        // Name resolution, statistics and custom blocks carry no packets
+
+        begin += length;
+        if (!keepReading) return true;
+    }
+    return true;
+}
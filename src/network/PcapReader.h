@@ -0,0 +1,69 @@
+#ifndef PCAP_READER_H
+#define PCAP_READER_H
+
+#include "Config.h"
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Link-layer types we can decode (LINKTYPE_* values shared by pcap and pcapng)
+namespace LinkType {
+    const uint16_t NULL_LOOPBACK = 0;
+    const uint16_t ETHERNET = 1;
+    const uint16_t RAW = 101;
+    const uint16_t LINUX_SLL = 113;
+    const uint16_t IPV4 = 228;
+    const uint16_t IPV6 = 229;
+    const uint16_t LINUX_SLL2 = 276;
+}
+
+struct CapturedPacket {
+    const unsigned char* data;      // Only valid during the callback
+    uint32_t capturedLength;
+    uint32_t originalLength;
+    uint64_t timestampNs;
+    uint16_t linkType;
+};
+
+// Streams packets out of a pcap or pcapng capture, from a file or a pipe
+// ("-" reads standard input). Records are handed to the callback in place
+// from one large read buffer, so nothing is copied or allocated per packet.
+class PcapReader {
+public:
+    // Return false from the callback to stop reading
+    using PacketCallback = std::function<bool(const CapturedPacket& packet)>;
+
+    explicit PcapReader(size_t bufferSize = Config::PCAP_READ_BUFFER_SIZE);
+
+    // Returns false if the capture could not be opened or is malformed;
+    // packets before the damage have already been delivered
+    bool read(const std::string& path, const PacketCallback& callback);
+
+    uint64_t packetsRead() const { return packets; }
+
+private:
+    struct Interface {
+        uint16_t linkType;
+        uint64_t unitsPerSecond;    // Timestamp resolution
+    };
+
+    std::vector<unsigned char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    std::FILE* input = nullptr;
+    bool bigEndian = false;     // Byte order of the capture, not of this machine
+    uint64_t packets = 0;
+
+    // Makes at least `length` unread bytes available at buffer[begin]
+    bool fill(size_t length);
+    uint16_t read16(const unsigned char* p) const;
+    uint32_t read32(const unsigned char* p) const;
+
+    bool readClassic(uint32_t magic, const PacketCallback& callback);
+    bool readPcapNg(const PacketCallback& callback);
+    static uint64_t toNanoseconds(uint64_t timestamp, uint64_t unitsPerSecond);
+};
+
+#endif // PCAP_READER_H
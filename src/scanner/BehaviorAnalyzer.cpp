@@ -1,5 +1,7 @@
 #include "BehaviorAnalyzer.h"
 #include "utils/Logger.h"
+#include "utils/Utils.h"
+#include "utils/ScanBudget.h"
 #include <algorithm>
 #include "Config.h"
 #include <psapi.h>
@@ -114,20 +116,26 @@ void BehaviorAnalyzer::logSuspiciousActivity(const std::string& activity, DWORD
 bool BehaviorAnalyzer::checkProcessMemory(HANDLE processHandle) {
     MEMORY_BASIC_INFORMATION mbi;
     SIZE_T address = 0;
+    std::vector<unsigned char> buffer(Config::SCAN_CHUNK_SIZE);
 
-    while (VirtualQueryEx(processHandle, (LPCVOID)address, &mbi, sizeof(mbi))) {
+    while (!ScanBudget::threadExhausted() && VirtualQueryEx(processHandle, (LPCVOID)address, &mbi, sizeof(mbi))) {
         // Check if memory region is executable
         if (mbi.State == MEM_COMMIT && 
             (mbi.Protect & (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE))) {
             
-            // Read memory region
-            std::vector<unsigned char> buffer(mbi.RegionSize);
-            SIZE_T bytesRead;
-            
-            if (ReadProcessMemory(processHandle, mbi.BaseAddress, buffer.data(), 
-                                mbi.RegionSize, &bytesRead)) {
-                // Scan for suspicious patterns
-                if (scanForShellcode(buffer)) {
+            // Read the region a chunk at a time; the scanner carries the
+            // pattern overlap across chunk boundaries
+            Utils::PatternScanner scanner(Utils::shellcodePatterns());
+            SIZE_T base = (SIZE_T)mbi.BaseAddress;
+            for (SIZE_T offset = 0; offset < mbi.RegionSize && !ScanBudget::threadExhausted();
+                 offset += buffer.size()) {
+                SIZE_T toRead = std::min<SIZE_T>(buffer.size(), mbi.RegionSize - offset);
+                SIZE_T bytesRead = 0;
+                if (!ReadProcessMemory(processHandle, (LPCVOID)(base + offset), buffer.data(),
+                                       toRead, &bytesRead) || bytesRead == 0) {
+                    continue;
+                }
+                if (scanner.update(buffer.data(), bytesRead, offset)) {
                     return true;
                 }
             }
@@ -142,33 +150,34 @@ bool BehaviorAnalyzer::checkProcessMemory(HANDLE processHandle) {
 
 bool BehaviorAnalyzer::detectAPIHooks(HANDLE processHandle) {
     try {
-        // Check for API hooks in common DLLs
-        std::vector<std::wstring> commonDlls = {L"kernel32.dll", L"user32.dll", L"ntdll.dll"};
-        
-        for (const auto& dll : commonDlls) {
-            HMODULE module = GetModuleHandleW(dll.c_str());
-            if (!module) continue;
-
-            MODULEINFO moduleInfo;
-            if (GetModuleInformation(processHandle, module, &moduleInfo, sizeof(moduleInfo))) {
-                std::vector<unsigned char> buffer(moduleInfo.SizeOfImage);
-                SIZE_T bytesRead;
-                
-                if (ReadProcessMemory(processHandle, moduleInfo.lpBaseOfDll, buffer.data(), 
-                                    buffer.size(), &bytesRead)) {
-                    // Check for hook signatures
-                    // This is a simplified check - in practice, you'd want more sophisticated detection
-                    for (size_t i = 0; i < buffer.size() - 5; i++) {
-                        if (buffer[i] == 0xE9 || buffer[i] == 0xFF) { // JMP or CALL
-                            Logger::logWarning("Potential API hook detected in " + 
-                                             std::string(dll.begin(), dll.end()));
-                            return true;
-                        }
-                    }
-                }
+        HMODULE modules[1024];
+        DWORD needed;
+        if (!EnumProcessModules(processHandle, modules, sizeof(modules), &needed)) {
+            return false;
+        }
+
+        HookDetector::MemoryReader read = [processHandle](uint64_t address, unsigned char* buffer, size_t length) {
+            SIZE_T bytesRead = 0;
+            return ReadProcessMemory(processHandle, (LPCVOID)address, buffer, length, &bytesRead) &&
+                   bytesRead == length;
+        };
+
+        bool hooked = false;
+        DWORD moduleCount = std::min<DWORD>(needed / sizeof(HMODULE), 1024);
+        for (DWORD i = 0; i < moduleCount && !ScanBudget::threadExhausted(); i++) {
+            WCHAR modulePath[MAX_PATH];
+            if (!GetModuleFileNameExW(processHandle, modules[i], modulePath, MAX_PATH)) continue;
+
+            int size = WideCharToMultiByte(CP_UTF8, 0, modulePath, -1, nullptr, 0, nullptr, nullptr);
+            std::string path(size > 0 ? size - 1 : 0, '\0');
+            WideCharToMultiByte(CP_UTF8, 0, modulePath, -1, &path[0], size, nullptr, nullptr);
+
+            for (const auto& finding : hookDetector.checkModule(path, (uint64_t)modules[i], read)) {
+                Logger::logWarning("API hook detected: " + finding.function + " in " + finding.module);
+                hooked = true;
             }
         }
-        return false;
+        return hooked;
     } catch (const std::exception& e) {
         Logger::logError("API hook detection error: " + std::string(e.what()));
         return false;
@@ -176,32 +185,6 @@ bool BehaviorAnalyzer::detectAPIHooks(HANDLE processHandle) {
 }
 
 bool BehaviorAnalyzer::scanForShellcode(const std::vector<unsigned char>& memory) {
-    std::vector<std::vector<unsigned char>> patterns = {
-        {0x33, 0xC0, 0x50, 0x68},  // XOR EAX, EAX; PUSH EAX; PUSH
-        {0x55, 0x8B, 0xEC},        // PUSH EBP; MOV EBP, ESP
-        {0x90, 0x90, 0x90, 0x90},  // NOP sled
-        {0xE8, 0x00, 0x00, 0x00},  // CALL $+5
-        {0xEB},                     // JMP SHORT
-        {0xFF, 0xD0},              // CALL EAX
-        {0xB8, 0x00, 0x00, 0x00}   // MOV EAX, immediate
-    };
-
-    // Add basic process injection detection
-    const std::vector<std::string> suspiciousAPIs = {
-        "VirtualAlloc",
-        "WriteProcessMemory",
-        "CreateRemoteThread",
-        "LoadLibraryA"
-    };
-
-    // Scan memory for patterns
-    for (const auto& pattern : patterns) {
-        for (size_t i = 0; i <= memory.size() - pattern.size(); i++) {
-            if (std::equal(pattern.begin(), pattern.end(), memory.begin() + i)) {
-                return true;
-            }
-        }
-    }
-    
-    return false;
+    Utils::PatternScanner scanner(Utils::shellcodePatterns());
+    return scanner.update(memory.data(), memory.size(), 0);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define BEHAVIOR_ANALYZER_H
 
 #include <windows.h>
+#include "HookDetector.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -25,6 +26,8 @@ private:
         std::unordered_map<std::string, size_t> apiCalls;
     };
 
+    HookDetector hookDetector;
+
     bool isSuspiciousBehavior(const ProcessInfo& info);
     bool checkMemoryRegion(HANDLE process, MEMORY_BASIC_INFORMATION& mbi);
     bool scanForShellcode(const std::vector<unsigned char>& memory);
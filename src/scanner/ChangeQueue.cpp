@@ -0,0 +1,93 @@
+#include "ChangeQueue.h"
+#include <algorithm>
+
+ChangeQueue::ChangeQueue(size_t capacity) : capacity(capacity) {}
+
+std::string ChangeQueue::keyOf(const ChangeJob& job) {
+    // A rescan of a directory must not merge with a change to a file of the same name
+    return job.rescan ? "*" + job.path : job.path;
+}
+
+bool ChangeQueue::push(ChangeJob job) {
+    std::string key = keyOf(job);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) return false;
+
+        auto it = pending.find(key);
+        if (it != pending.end()) {
+            ChangeJob& waiting = it->second;
+            stats.coalesced++;
+            if (job.rescan) {
+                // One pass covering both requests
+                waiting.recursive = waiting.recursive || job.recursive;
+                waiting.since = std::min(waiting.since, job.since);
+            }
+            if (job.priority >= waiting.priority) return true;
+            waiting.priority = job.priority;
+            queues[static_cast<size_t>(job.priority)].push_back(std::move(key));
+        } else {
+            if (!job.rescan && pendingFiles >= capacity) {
+                stats.rejected++;
+                return false;
+            }
+            if (!job.rescan) pendingFiles++;
+            stats.queued++;
+            queues[static_cast<size_t>(job.priority)].push_back(key);
+            pending.emplace(std::move(key), std::move(job));
+        }
+    }
+    available.notify_one();
+    return true;
+}
+
+std::optional<ChangeJob> ChangeQueue::pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        for (size_t level = 0; level < queues.size(); level++) {
+            auto& queue = queues[level];
+            while (!queue.empty()) {
+                std::string key = std::move(queue.front());
+                queue.pop_front();
+
+                auto it = pending.find(key);
+                if (it == pending.end() || static_cast<size_t>(it->second.priority) != level) continue;
+
+                ChangeJob job = std::move(it->second);
+                pending.erase(it);
+                if (!job.rescan) pendingFiles--;
+                return job;
+            }
+        }
+        if (closed) return std::nullopt;
+        available.wait(lock);
+    }
+}
+
+void ChangeQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        for (auto& queue : queues) {
+            queue.clear();
+        }
+        pending.clear();
+        pendingFiles = 0;
+    }
+    available.notify_all();
+}
+
+void ChangeQueue::reopen() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = false;
+}
+
+size_t ChangeQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+ChangeQueueStats ChangeQueue::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,73 @@
+#ifndef CHANGE_QUEUE_H
+#define CHANGE_QUEUE_H
+
+#include "Config.h"
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Order in which queued changes are scanned
+enum class ChangePriority {
+    High,       // New files, executables and other high-risk extensions
+    Normal,
+    Low         // System and application data paths, checked last
+};
+
+struct ChangeJob {
+    std::string path;
+    ChangePriority priority = ChangePriority::Normal;
+    // Rescan jobs name a directory whose files changed since `since` are queued again
+    bool rescan = false;
+    bool recursive = false;
+    int64_t since = 0;      // Same clock as FileHandle::modifiedTime()
+};
+
+struct ChangeQueueStats {
+    size_t queued = 0;
+    size_t coalesced = 0;       // Changes to a path that was already waiting
+    size_t rejected = 0;        // Changes turned away because the queue was full
+};
+
+// Pending real-time scan jobs, highest priority first and in arrival order
+// within a priority. A path already waiting is not queued twice; a repeated
+// change can only raise its priority. File jobs are bounded by capacity so a
+// burst cannot grow the queue without limit, while rescan jobs are always
+// accepted since they are how rejected changes are recovered.
+class ChangeQueue {
+public:
+    explicit ChangeQueue(size_t capacity = Config::REALTIME_QUEUE_LIMIT);
+
+    // False if the queue is full or closed
+    bool push(ChangeJob job);
+    // Blocks until a job is available; empty once the queue is closed
+    std::optional<ChangeJob> pop();
+
+    // Wakes every waiting pop() and discards what is still queued
+    void close();
+    void reopen();
+
+    size_t size() const;
+    ChangeQueueStats getStats() const;
+
+private:
+    size_t capacity;
+    // Keys of waiting jobs by priority; a key whose job has since moved to
+    // a higher priority is skipped when it comes up
+    std::array<std::deque<std::string>, 3> queues;
+    std::unordered_map<std::string, ChangeJob> pending;
+    size_t pendingFiles = 0;
+    bool closed = false;
+    ChangeQueueStats stats;
+    mutable std::mutex mutex;
+    std::condition_variable available;
+
+    static std::string keyOf(const ChangeJob& job);
+};
+
+#endif // CHANGE_QUEUE_H
@@ -0,0 +1,272 @@
+#include "DirectoryWalker.h"
+#include "../utils/Logger.h"
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
+
+namespace {
+    // Directories waiting in the queue keep their descriptor open up to this
+    // many; beyond it they are reopened by path to stay clear of fd limits
+    const size_t MAX_QUEUED_DESCRIPTORS = 256;
+
+#ifdef __linux__
+    const size_t DENTS_BUFFER_SIZE = 64 * 1024;
+
+    struct linux_dirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    const int DIRECTORY_FLAGS = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+#endif
+}
+
+DirectoryWalker::DirectoryWalker(int threads)
+    : threadCount(threads > 0 ? threads : 1), filter(nullptr), activeJobs(0), queuedDescriptors(0),
+      stopped(false), filesFound(0) {}
+
+size_t DirectoryWalker::walk(const std::string& rootPath, const FileCallback& onFile, DirectoryFilter* filter) {
+    this->filter = filter;
+    pending.clear();
+    activeJobs = 0;
+    queuedDescriptors = 0;
+    stopped = false;
+    filesFound = 0;
+
+    pushDirectory(-1, rootPath);
+
+    if (threadCount == 1) {
+        worker(onFile);
+    } else {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(&DirectoryWalker::worker, this, std::cref(onFile));
+        }
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+
+#ifdef __linux__
+    // Close whatever was left queued after an early stop
+    for (auto& job : pending) {
+        if (job.dirFd >= 0) ::close(job.dirFd);
+    }
+#endif
+    pending.clear();
+    return filesFound;
+}
+
+void DirectoryWalker::pushDirectory(int dirFd, std::string path) {
+    std::lock_guard<std::mutex> lock(mutex);
+#ifdef __linux__
+    if (dirFd >= 0) {
+        if (queuedDescriptors >= MAX_QUEUED_DESCRIPTORS) {
+            ::close(dirFd);
+            dirFd = -1;
+        } else {
+            queuedDescriptors++;
+        }
+    }
+#endif
+    pending.push_back({dirFd, std::move(path)});
+    available.notify_one();
+}
+
+void DirectoryWalker::worker(const FileCallback& onFile) {
+    while (true) {
+        DirectoryJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return !pending.empty() || activeJobs == 0 || stopped; });
+            if (stopped || pending.empty()) {
+                // Nothing queued and nobody left who could queue more
+                available.notify_all();
+                return;
+            }
+
+            // Depth-first keeps the queue, and the descriptors it holds, small
+            job = std::move(pending.back());
+            pending.pop_back();
+            if (job.dirFd >= 0) queuedDescriptors--;
+            activeJobs++;
+        }
+
+        processDirectory(std::move(job), onFile);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeJobs--;
+        }
+        available.notify_all();
+    }
+}
+
+#ifdef __linux__
+
+void DirectoryWalker::processDirectory(DirectoryJob job, const FileCallback& onFile) {
+    int dirFd = job.dirFd >= 0 ? job.dirFd : ::open(job.path.c_str(), DIRECTORY_FLAGS);
+    if (dirFd < 0) {
+        Logger::logWarning("Cannot open directory " + job.path + ": " + std::strerror(errno));
+        return;
+    }
+
+    std::string prefix = job.path;
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+
+    DirectoryStamp stamp{0, 0, 0};
+    std::vector<std::string> subdirectories;
+    if (filter) {
+        struct stat st;
+        if (::fstat(dirFd, &st) == 0) {
+            stamp = {static_cast<uint64_t>(st.st_ino),
+                     static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec,
+                     static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec};
+            if (filter->skipDirectory(job.path, stamp, subdirectories)) {
+                for (const auto& name : subdirectories) {
+                    int childFd = ::openat(dirFd, name.c_str(), DIRECTORY_FLAGS);
+                    if (childFd >= 0) {
+                        pushDirectory(childFd, prefix + name);
+                    }
+                }
+                ::close(dirFd);
+                return;
+            }
+        }
+    }
+
+    std::vector<char> buffer(DENTS_BUFFER_SIZE);
+    bool complete = true;
+
+    while (!stopped) {
+        long bytes = syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+        if (bytes <= 0) {
+            if (bytes < 0) {
+                Logger::logWarning("Cannot read directory " + job.path + ": " + std::strerror(errno));
+                complete = false;
+            }
+            break;
+        }
+
+        for (long pos = 0; pos < bytes && !stopped;) {
+            auto* entry = reinterpret_cast<linux_dirent64*>(buffer.data() + pos);
+            pos += entry->d_reclen;
+
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                // Some filesystems do not fill d_type in
+                struct stat st;
+                if (::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                    complete = false;
+                    continue;
+                }
+                type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_LNK;
+            }
+
+            if (type == DT_DIR) {
+                int childFd = ::openat(dirFd, name, DIRECTORY_FLAGS);
+                if (childFd >= 0) {
+                    pushDirectory(childFd, prefix + name);
+                }
+                if (filter) subdirectories.emplace_back(name);
+            } else if (type == DT_REG) {
+                FileHandle file = FileHandle::openAt(dirFd, name, prefix + name);
+                if (!file.isOpen()) {
+                    complete = false;
+                    continue;
+                }
+
+                filesFound++;
+                if (!onFile(file)) {
+                    stopped = true;
+                    available.notify_all();
+                }
+            }
+            // Symlinks, devices, fifos and sockets are never followed or scanned
+        }
+    }
+
+    if (filter) {
+        filter->directoryListed(job.path, stamp, subdirectories, complete && !stopped);
+    }
+    ::close(dirFd);
+}
+
+#else
+
+void DirectoryWalker::processDirectory(DirectoryJob job, const FileCallback& onFile) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    DirectoryStamp stamp{0, 0, 0};
+    std::vector<std::string> subdirectories;
+    if (filter) {
+        // No portable inode or change time here; the write time still moves on every entry change
+        auto writeTime = fs::last_write_time(job.path, ec);
+        if (!ec) {
+            stamp.mtime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+            if (filter->skipDirectory(job.path, stamp, subdirectories)) {
+                for (const auto& name : subdirectories) {
+                    pushDirectory(-1, (fs::path(job.path) / name).string());
+                }
+                return;
+            }
+        }
+    }
+
+    fs::directory_iterator it(job.path, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        Logger::logWarning("Cannot open directory " + job.path + ": " + ec.message());
+        return;
+    }
+
+    bool complete = true;
+    for (; !stopped && it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            complete = false;
+            break;
+        }
+
+        // The iterator caches the entry type, so this does not stat again
+        if (it->is_symlink(ec)) continue;
+        if (it->is_directory(ec)) {
+            pushDirectory(-1, it->path().string());
+            if (filter) subdirectories.push_back(it->path().filename().string());
+        } else if (it->is_regular_file(ec)) {
+            FileHandle file = FileHandle::open(it->path().string());
+            if (!file.isOpen()) {
+                complete = false;
+                continue;
+            }
+
+            filesFound++;
+            if (!onFile(file)) {
+                stopped = true;
+                available.notify_all();
+            }
+        }
+    }
+
+    if (filter) {
+        filter->directoryListed(job.path, stamp, subdirectories, complete && !stopped);
+    }
+}
+
+#endif
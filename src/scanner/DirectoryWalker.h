@@ -0,0 +1,77 @@
+#ifndef DIRECTORY_WALKER_H
+#define DIRECTORY_WALKER_H
+
+#include "../utils/FileHandle.h"
+#include "Config.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Identity and change stamps of a directory. Adding, removing or renaming
+// an entry updates them; rewriting a file in place does not.
+struct DirectoryStamp {
+    uint64_t inode;
+    int64_t mtime;
+    int64_t ctime;
+
+    bool operator==(const DirectoryStamp& other) const {
+        return inode == other.inode && mtime == other.mtime && ctime == other.ctime;
+    }
+};
+
+// Lets an incremental walk skip listing directories it already knows.
+// Called concurrently from the worker threads.
+class DirectoryFilter {
+public:
+    virtual ~DirectoryFilter() = default;
+
+    // Return true to skip listing the directory and visit `subdirectories` instead
+    virtual bool skipDirectory(const std::string& path, const DirectoryStamp& stamp,
+                               std::vector<std::string>& subdirectories) = 0;
+    // Called once every file of a listed directory has been through the callback.
+    // complete is false if an entry could not be opened or the walk stopped early.
+    virtual void directoryListed(const std::string& path, const DirectoryStamp& stamp,
+                                 const std::vector<std::string>& subdirectories, bool complete) = 0;
+};
+
+// Parallel directory tree walker. Each worker enumerates whole directories
+// and hands open regular files to the callback, so the scan stages never
+// look a path up again. On Linux it uses getdents64 with d_type and
+// directory-relative openat(), which costs one open and one fstat per file.
+class DirectoryWalker {
+public:
+    // Called concurrently from the worker threads; return false to stop the walk
+    using FileCallback = std::function<bool(FileHandle& file)>;
+
+    // A thread count of one walks on the calling thread
+    explicit DirectoryWalker(int threads = Config::SCAN_THREADS);
+
+    // Returns the number of files handed to the callback
+    size_t walk(const std::string& rootPath, const FileCallback& onFile, DirectoryFilter* filter = nullptr);
+
+private:
+    struct DirectoryJob {
+        int dirFd;          // Open descriptor, or -1 to reopen by path
+        std::string path;
+    };
+
+    int threadCount;
+    DirectoryFilter* filter;
+    std::deque<DirectoryJob> pending;
+    size_t activeJobs;
+    size_t queuedDescriptors;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::atomic<bool> stopped;
+    std::atomic<size_t> filesFound;
+
+    void worker(const FileCallback& onFile);
+    void pushDirectory(int dirFd, std::string path);
+    void processDirectory(DirectoryJob job, const FileCallback& onFile);
+};
+
+#endif // DIRECTORY_WALKER_H
@@ -0,0 +1,431 @@
+#include "EngineSnapshot.h"
+#include "SignatureDatabase.h"
+#include "PESignatureIndex.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+    const char MAGIC[8] = {'A', 'V', 'E', 'N', 'G', 'I', 'N', 'E'};
+    const uint32_t BYTE_ORDER_TAG = 0x01020304;
+
+    enum SectionId : uint32_t {
+        SECTION_STRINGS = 1,
+        SECTION_SHA256 = 2,
+        SECTION_IMPORT_HASHES = 3,
+        SECTION_SECTION_HASHES = 4,
+        SECTION_FUZZY_NODES = 5,
+        SECTION_FUZZY_CHILDREN = 6
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t sourceCount;
+        uint32_t sectionCount;
+        uint64_t sourcesOffset;
+        uint64_t sectionsOffset;
+        uint64_t fileSize;
+    };
+
+    struct SourceRecord {
+        uint32_t pathOffset;
+        uint32_t pathLength;
+        uint64_t size;
+        int64_t mtime;
+    };
+
+    struct SectionRecord {
+        uint32_t id;
+        uint32_t count;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(Header) == 48 && sizeof(SourceRecord) == 24 && sizeof(SectionRecord) == 24,
+                  "snapshot records must have a fixed layout");
+
+    struct Fingerprint {
+        uint64_t size;
+        int64_t mtime;
+    };
+
+    Fingerprint fingerprint(const std::string& path) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        if (ec) return {UINT64_MAX, 0};
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        return {size, ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count())};
+    }
+
+    template <size_t N>
+    bool parseHex(const std::string& text, std::array<uint8_t, N>& out) {
+        if (text.size() != N * 2) return false;
+        for (size_t i = 0; i < N; i++) {
+            char pair[3] = {text[i * 2], text[i * 2 + 1], '\0'};
+            char* end = nullptr;
+            unsigned long value = std::strtoul(pair, &end, 16);
+            if (end != pair + 2) return false;
+            out[i] = static_cast<uint8_t>(value);
+        }
+        return true;
+    }
+
+    // Accumulates sections in memory; every section starts 8-byte aligned
+    class Builder {
+    public:
+        uint32_t addString(const std::string& text) {
+            auto it = stringOffsets.find(text);
+            if (it != stringOffsets.end()) return it->second;
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings.insert(strings.end(), text.begin(), text.end());
+            stringOffsets.emplace(text, offset);
+            return offset;
+        }
+
+        template <typename T>
+        void addSection(uint32_t id, const std::vector<T>& records) {
+            addSection(id, static_cast<uint32_t>(records.size()),
+                       reinterpret_cast<const unsigned char*>(records.data()), records.size() * sizeof(T));
+        }
+
+        void addSection(uint32_t id, uint32_t count, const unsigned char* data, size_t size) {
+            pad();
+            sections.push_back({id, count, body.size(), size});
+            body.insert(body.end(), data, data + size);
+        }
+
+        bool write(const std::string& path, const std::vector<std::string>& sources) {
+            std::vector<SourceRecord> sourceRecords;
+            for (const auto& source : sources) {
+                Fingerprint print = fingerprint(source);
+                sourceRecords.push_back({addString(source), static_cast<uint32_t>(source.size()),
+                                         print.size, print.mtime});
+            }
+            addSection(SECTION_STRINGS, 0, strings.data(), strings.size());
+
+            // Layout: header, source table, section table, then the section bodies
+            uint64_t sourcesOffset = sizeof(Header);
+            uint64_t sectionsOffset = sourcesOffset + sourceRecords.size() * sizeof(SourceRecord);
+            uint64_t bodyOffset = (sectionsOffset + sections.size() * sizeof(SectionRecord) + 7) & ~7ULL;
+            for (auto& section : sections) section.offset += bodyOffset;
+
+            Header header{};
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = EngineSnapshot::VERSION;
+            header.byteOrder = BYTE_ORDER_TAG;
+            header.sourceCount = static_cast<uint32_t>(sourceRecords.size());
+            header.sectionCount = static_cast<uint32_t>(sections.size());
+            header.sourcesOffset = sourcesOffset;
+            header.sectionsOffset = sectionsOffset;
+            header.fileSize = bodyOffset + body.size();
+
+            // Write beside the target and rename, so readers never map a half-written file
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                out.write(reinterpret_cast<const char*>(sourceRecords.data()),
+                          sourceRecords.size() * sizeof(SourceRecord));
+                out.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(SectionRecord));
+                std::vector<char> padding(bodyOffset - sectionsOffset - sections.size() * sizeof(SectionRecord));
+                out.write(padding.data(), padding.size());
+                out.write(reinterpret_cast<const char*>(body.data()), body.size());
+                if (!out) return false;
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tempPath, path, ec);
+            if (ec) {
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        std::vector<unsigned char> strings;
+        std::unordered_map<std::string, uint32_t> stringOffsets;
+        std::vector<SectionRecord> sections;
+        std::vector<unsigned char> body;
+
+        void pad() {
+            body.resize((body.size() + 7) & ~size_t(7), 0);
+        }
+    };
+}
+
+struct EngineSnapshot::HashRecord {
+    uint8_t digest[16];
+    uint32_t labelOffset;
+    uint32_t labelLength;
+};
+
+struct EngineSnapshot::FuzzyNodeRecord {
+    uint8_t digest[FuzzyDigest::ENCODED_SIZE];
+    uint8_t reserved;
+    uint32_t labelOffset;
+    uint32_t labelLength;
+    uint32_t firstChild;
+    uint32_t childCount;
+};
+
+struct EngineSnapshot::FuzzyChildRecord {
+    uint16_t distance;
+    uint16_t reserved;
+    uint32_t node;
+};
+
+std::shared_ptr<const EngineSnapshot> EngineSnapshot::load(const std::string& path,
+                                                           const std::vector<std::string>& sources) {
+    MappedFile mapped = MappedFile::open(path);
+    if (!mapped.isOpen()) return nullptr;
+
+    std::shared_ptr<EngineSnapshot> snapshot(new EngineSnapshot());
+    if (!snapshot->attach(std::move(mapped), sources)) {
+        Logger::logInfo("Engine snapshot is out of date: " + path);
+        return nullptr;
+    }
+    return snapshot;
+}
+
+bool EngineSnapshot::attach(MappedFile mapped, const std::vector<std::string>& sources) {
+    static_assert(sizeof(HashRecord) == 24 && sizeof(FuzzyNodeRecord) == 52 && sizeof(FuzzyChildRecord) == 8,
+                  "snapshot records must have a fixed layout");
+
+    const unsigned char* base = mapped.data();
+    size_t size = mapped.size();
+    if (size < sizeof(Header)) return false;
+
+    const Header* header = reinterpret_cast<const Header*>(base);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+        header->byteOrder != BYTE_ORDER_TAG || header->fileSize != size) {
+        return false;
+    }
+
+    auto inBounds = [size](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+    if (!inBounds(header->sourcesOffset, uint64_t(header->sourceCount) * sizeof(SourceRecord)) ||
+        !inBounds(header->sectionsOffset, uint64_t(header->sectionCount) * sizeof(SectionRecord))) {
+        return false;
+    }
+
+    const SectionRecord* table = reinterpret_cast<const SectionRecord*>(base + header->sectionsOffset);
+    for (uint32_t i = 0; i < header->sectionCount; i++) {
+        const SectionRecord& section = table[i];
+        if (!inBounds(section.offset, section.size)) return false;
+        const unsigned char* data = base + section.offset;
+
+        auto records = [&](size_t recordSize) {
+            return section.size == uint64_t(section.count) * recordSize;
+        };
+        switch (section.id) {
+            case SECTION_STRINGS:
+                strings = data;
+                stringsSize = static_cast<size_t>(section.size);
+                break;
+            case SECTION_SHA256:
+                if (!records(32)) return false;
+                sha256 = data;
+                sha256Count = section.count;
+                break;
+            case SECTION_IMPORT_HASHES:
+                if (!records(sizeof(HashRecord))) return false;
+                imports = reinterpret_cast<const HashRecord*>(data);
+                importCount = section.count;
+                break;
+            case SECTION_SECTION_HASHES:
+                if (!records(sizeof(HashRecord))) return false;
+                sections = reinterpret_cast<const HashRecord*>(data);
+                sectionCount = section.count;
+                break;
+            case SECTION_FUZZY_NODES:
+                if (!records(sizeof(FuzzyNodeRecord))) return false;
+                fuzzyNodes = reinterpret_cast<const FuzzyNodeRecord*>(data);
+                fuzzyNodeCount = section.count;
+                break;
+            case SECTION_FUZZY_CHILDREN:
+                if (!records(sizeof(FuzzyChildRecord))) return false;
+                fuzzyChildren = reinterpret_cast<const FuzzyChildRecord*>(data);
+                fuzzyChildCount = section.count;
+                break;
+            default:
+                break; // Sections from a newer minor layout are ignored
+        }
+    }
+
+    // Stale if the set of sources or any of their fingerprints changed
+    if (header->sourceCount != sources.size()) return false;
+    const SourceRecord* recorded = reinterpret_cast<const SourceRecord*>(base + header->sourcesOffset);
+    for (size_t i = 0; i < sources.size(); i++) {
+        Fingerprint current = fingerprint(sources[i]);
+        if (label(recorded[i].pathOffset, recorded[i].pathLength) != sources[i] ||
+            recorded[i].size != current.size || recorded[i].mtime != current.mtime) {
+            return false;
+        }
+    }
+
+    file = std::move(mapped);
+    return true;
+}
+
+std::string EngineSnapshot::label(uint32_t offset, uint32_t length) const {
+    if (offset > stringsSize || length > stringsSize - offset) return "";
+    return std::string(reinterpret_cast<const char*>(strings + offset), length);
+}
+
+bool EngineSnapshot::containsSha256(const std::string& hexDigest) const {
+    std::array<uint8_t, 32> digest;
+    if (!parseHex(hexDigest, digest)) return false;
+
+    size_t low = 0, high = sha256Count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = std::memcmp(sha256 + middle * 32, digest.data(), 32);
+        if (order == 0) return true;
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return false;
+}
+
+std::optional<std::string> EngineSnapshot::findHash(const HashRecord* table, size_t count,
+                                                    const std::string& hexDigest) const {
+    std::array<uint8_t, 16> digest;
+    if (!parseHex(hexDigest, digest)) return std::nullopt;
+
+    const HashRecord* end = table + count;
+    const HashRecord* it = std::lower_bound(table, end, digest, [](const HashRecord& record, const auto& key) {
+        return std::memcmp(record.digest, key.data(), 16) < 0;
+    });
+    if (it == end || std::memcmp(it->digest, digest.data(), 16) != 0) return std::nullopt;
+    return label(it->labelOffset, it->labelLength);
+}
+
+std::optional<std::string> EngineSnapshot::findImportHash(const std::string& hexDigest) const {
+    return findHash(imports, importCount, hexDigest);
+}
+
+std::optional<std::string> EngineSnapshot::findSectionHash(const std::string& hexDigest) const {
+    return findHash(sections, sectionCount, hexDigest);
+}
+
+std::optional<SimilarityMatch> EngineSnapshot::findClosest(const FuzzyDigest& digest, int maxDistance) const {
+    if (!digest.valid || fuzzyNodeCount == 0) return std::nullopt;
+
+    // Same BK-tree walk as SimilarityIndex, over the mapped node array
+    int bestDistance = maxDistance + 1;
+    uint32_t best = 0;
+    std::vector<uint32_t> pending{0};
+
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        pending.pop_back();
+        if (index >= fuzzyNodeCount) continue;
+
+        const FuzzyNodeRecord& node = fuzzyNodes[index];
+        int distance = fuzzyDistance(digest, FuzzyDigest::decode(node.digest));
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = index;
+            if (distance == 0) break;
+        }
+
+        if (node.firstChild > fuzzyChildCount || node.childCount > fuzzyChildCount - node.firstChild) continue;
+        for (uint32_t i = 0; i < node.childCount; i++) {
+            const FuzzyChildRecord& child = fuzzyChildren[node.firstChild + i];
+            if (std::abs(child.distance - distance) < bestDistance) {
+                pending.push_back(child.node);
+            }
+        }
+    }
+
+    if (bestDistance > maxDistance) return std::nullopt;
+    const FuzzyNodeRecord& node = fuzzyNodes[best];
+    return SimilarityMatch{label(node.labelOffset, node.labelLength),
+                           FuzzyDigest::decode(node.digest).toString(), bestDistance};
+}
+
+bool EngineSnapshot::save(const std::string& path, const std::vector<std::string>& sources,
+                          const SignatureDatabase& signatures, const SimilarityIndex& similarity,
+                          const PESignatureIndex& peSignatures) {
+    try {
+        Builder builder;
+
+        {
+            std::lock_guard<std::mutex> lock(signatures.mutex);
+            std::vector<std::array<uint8_t, 32>> digests;
+            for (const auto& hex : signatures.signatures) {
+                std::string lower = hex;
+                std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                std::array<uint8_t, 32> digest;
+                if (parseHex(lower, digest)) digests.push_back(digest);
+            }
+            std::sort(digests.begin(), digests.end());
+            digests.erase(std::unique(digests.begin(), digests.end()), digests.end());
+            builder.addSection(SECTION_SHA256, digests);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(peSignatures.mutex);
+            auto hashTable = [&](const std::unordered_map<std::string, std::string>& entries) {
+                std::vector<HashRecord> records;
+                for (const auto& [hex, family] : entries) {
+                    std::array<uint8_t, 16> digest;
+                    if (!parseHex(hex, digest)) continue;
+                    HashRecord record{};
+                    std::memcpy(record.digest, digest.data(), 16);
+                    record.labelOffset = builder.addString(family);
+                    record.labelLength = static_cast<uint32_t>(family.size());
+                    records.push_back(record);
+                }
+                std::sort(records.begin(), records.end(), [](const HashRecord& a, const HashRecord& b) {
+                    return std::memcmp(a.digest, b.digest, 16) < 0;
+                });
+                return records;
+            };
+            builder.addSection(SECTION_IMPORT_HASHES, hashTable(peSignatures.importHashes));
+            builder.addSection(SECTION_SECTION_HASHES, hashTable(peSignatures.sectionHashes));
+        }
+
+        {
+            std::shared_lock<std::shared_mutex> lock(similarity.mutex);
+            std::vector<FuzzyNodeRecord> nodes;
+            std::vector<FuzzyChildRecord> children;
+            for (const auto& node : similarity.nodes) {
+                FuzzyNodeRecord record{};
+                node.digest.encode(record.digest);
+                const std::string& text = similarity.labels[node.label];
+                record.labelOffset = builder.addString(text);
+                record.labelLength = static_cast<uint32_t>(text.size());
+                record.firstChild = static_cast<uint32_t>(children.size());
+                record.childCount = static_cast<uint32_t>(node.children.size());
+                for (const auto& [distance, index] : node.children) {
+                    children.push_back({distance, 0, index});
+                }
+                nodes.push_back(record);
+            }
+            builder.addSection(SECTION_FUZZY_NODES, nodes);
+            builder.addSection(SECTION_FUZZY_CHILDREN, children);
+        }
+
+        if (!builder.write(path, sources)) {
+            Logger::logError("Error writing engine snapshot: " + path);
+            return false;
+        }
+        Logger::logInfo("Engine snapshot written: " + path);
+        return true;
+    } catch (const std::exception& e) {
+        Logger::logError("Error building engine snapshot: " + std::string(e.what()));
+        return false;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef ENGINE_SNAPSHOT_H
+#define ENGINE_SNAPSHOT_H
+
+#include "SimilarityIndex.h"
+#include "../utils/MappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class SignatureDatabase;
+class PESignatureIndex;
+
+// Compiled engine state in one position-independent file: sorted hash
+// tables, the fuzzy BK-tree and a shared string table, all addressed by
+// file offsets. Loading is a single mmap; lookups binary-search or walk the
+// mapped arrays directly, so only the pages a lookup touches are read.
+//
+// The header records the size and mtime of every source database. A
+// snapshot whose sources changed, or written by another format version,
+// is rejected and the caller rebuilds it from the text databases.
+class EngineSnapshot {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    // Returns nullptr if the snapshot is missing, invalid or stale
+    static std::shared_ptr<const EngineSnapshot> load(const std::string& path,
+                                                      const std::vector<std::string>& sources);
+    static bool save(const std::string& path, const std::vector<std::string>& sources,
+                     const SignatureDatabase& signatures, const SimilarityIndex& similarity,
+                     const PESignatureIndex& peSignatures);
+
+    bool containsSha256(const std::string& hexDigest) const;
+    std::optional<std::string> findImportHash(const std::string& hexDigest) const;
+    std::optional<std::string> findSectionHash(const std::string& hexDigest) const;
+    std::optional<SimilarityMatch> findClosest(const FuzzyDigest& digest, int maxDistance) const;
+
+    size_t signatureCount() const { return sha256Count; }
+    size_t fuzzyCount() const { return fuzzyNodeCount; }
+    size_t peSignatureCount() const { return importCount + sectionCount; }
+
+private:
+    struct HashRecord;
+    struct FuzzyNodeRecord;
+    struct FuzzyChildRecord;
+
+    MappedFile file;
+    const unsigned char* strings = nullptr;
+    size_t stringsSize = 0;
+    const unsigned char* sha256 = nullptr;
+    size_t sha256Count = 0;
+    const HashRecord* imports = nullptr;
+    size_t importCount = 0;
+    const HashRecord* sections = nullptr;
+    size_t sectionCount = 0;
+    const FuzzyNodeRecord* fuzzyNodes = nullptr;
+    size_t fuzzyNodeCount = 0;
+    const FuzzyChildRecord* fuzzyChildren = nullptr;
+    size_t fuzzyChildCount = 0;
+
+    EngineSnapshot() = default;
+    bool attach(MappedFile mapped, const std::vector<std::string>& sources);
+    std::string label(uint32_t offset, uint32_t length) const;
+    std::optional<std::string> findHash(const HashRecord* table, size_t count, const std::string& hexDigest) const;
+};
+
+#endif // ENGINE_SNAPSHOT_H
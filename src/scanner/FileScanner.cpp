@@ -1,7 +1,13 @@
 #include "FileScanner.h"
+#include "../utils/ContentSampler.h"
+#include "../utils/FileTypeClassifier.h"
 #include "../utils/HashUtil.h"
 #include "../utils/Utils.h"
 #include "../utils/Logger.h"
+#include "../utils/PEParser.h"
+#include "Config.h"
+#include "DirectoryWalker.h"
+#include "EngineSnapshot.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -9,109 +15,306 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
-#include <windows.h>
+#include <optional>
 
-FileScanner::FileScanner(const std::string& dbPath) {
-    signatures = std::make_unique<SignatureDatabase>(dbPath);
-}
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
-bool FileScanner::scanFile(const std::string& filePath) const {
-    try {
-        if (!std::filesystem::exists(filePath)) {
-            Logger::logError("File not found: " + filePath);
-            return false;
+namespace {
+    // What sampling must not miss in a PE: the start of each section, the
+    // entry point and any overlay appended after the image
+    std::vector<ScanRegion> peStructuralRegions(const PEInfo& info, uint64_t fileSize, uint64_t blockSize) {
+        std::vector<ScanRegion> regions;
+        uint64_t imageEnd = 0;
+        for (const auto& section : PEParser::sectionRegions(info, fileSize)) {
+            if (section.length == 0) continue;
+            regions.push_back({section.offset, std::min(section.length, blockSize)});
+            imageEnd = std::max(imageEnd, section.offset + section.length);
         }
 
-        // Check file hash
-        std::string fileHash = HashUtil::computeSHA256(filePath);
-        if (signatures->contains(fileHash)) {
-            Logger::logWarning("Malicious file detected: " + filePath);
-            return true;
+        int64_t entry = PEParser::rvaToOffset(info, info.entryPoint);
+        if (entry >= 0 && static_cast<uint64_t>(entry) < fileSize) {
+            regions.push_back({static_cast<uint64_t>(entry), std::min(blockSize, fileSize - entry)});
         }
-
-        // Perform heuristic analysis
-        if (heuristicScan(filePath)) {
-            Logger::logWarning("Suspicious behavior detected: " + filePath);
-            return true;
+        if (imageEnd > 0 && imageEnd < fileSize) {
+            regions.push_back({imageEnd, std::min(blockSize, fileSize - imageEnd)});
         }
+        return regions;
+    }
+}
 
+FileScanner::FileScanner(const std::string& dbPath)
+    : databasePaths{dbPath, Config::FUZZY_SIGNATURE_DB_PATH, Config::PE_SIGNATURE_DB_PATH},
+      scoringEngine(Config::HEURISTIC_SCORE_THRESHOLD) {
+    // Map the compiled snapshot when it matches the databases; otherwise
+    // parse the text databases once and compile them for the next start
+    auto snapshot = EngineSnapshot::load(Config::ENGINE_SNAPSHOT_PATH, databasePaths);
+
+    signatures = std::make_unique<SignatureDatabase>(dbPath, snapshot);
+    similarityIndex = std::make_unique<SimilarityIndex>(Config::FUZZY_SIGNATURE_DB_PATH, snapshot);
+    peSignatures = std::make_unique<PESignatureIndex>(Config::PE_SIGNATURE_DB_PATH, snapshot);
+
+    if (!snapshot) {
+        EngineSnapshot::save(Config::ENGINE_SNAPSHOT_PATH, databasePaths, *signatures, *similarityIndex, *peSignatures);
+    }
+    registerDetectors();
+}
+
+void FileScanner::registerDetectors() {
+    // No single weak signal reaches the threshold on its own
+    scoringEngine.addDetector({DETECTOR_PE_CHARACTERISTICS, 1.0f, 0.2f,
+        [this](const ScanContext& ctx) { return checkPEFile(ctx.source); },
+        FileTypes::bit(FileType::PE)});
+
+    scoringEngine.addDetector({DETECTOR_HIGH_ENTROPY, 10.0f, 0.45f,
+        [](const ScanContext& ctx) {
+            ChunkedReader reader;
+            Utils::ByteHistogram histogram;
+            bool readOk = reader.read(ctx.source, ctx.plan.regions,
+                [&histogram](const unsigned char* data, size_t length, uint64_t) {
+                    histogram.update(data, length);
+                    return true;
+                });
+            return readOk && histogram.entropy() > Config::HEURISTIC_ENTROPY_THRESHOLD;
+        },
+        // Compressed formats are dense by design
+        FileTypes::ALL & ~(FileTypes::MEDIA | FileTypes::bit(FileType::Archive))});
+
+    // Magic bytes are the attacker's to choose, so the packer and strings
+    // checks run on every type. Together they reach the threshold, so no
+    // type can be picked to keep a file from being flagged.
+    scoringEngine.addDetector({DETECTOR_PACKER_SIGNATURE, 20.0f, 0.6f,
+        [](const ScanContext& ctx) { return Utils::isPacked(ctx.source, ctx.plan.regions); },
+        FileTypes::ALL});
+
+    scoringEngine.addDetector({DETECTOR_SUSPICIOUS_STRINGS, 40.0f, 0.4f,
+        [](const ScanContext& ctx) {
+            return Utils::containsSuspiciousStrings(ctx.source, ctx.plan.regions);
+        },
+        FileTypes::ALL});
+}
+
+bool FileScanner::scanFile(const std::string& filePath) const {
+    FileHandle file = FileHandle::open(filePath);
+    if (!file.isOpen()) {
+        Logger::logError("File not found: " + filePath);
         return false;
-    } catch (const std::exception& e) {
-        Logger::logError("Error scanning file: " + std::string(e.what()));
-        return false;
     }
+    return scanFile(file);
+}
+
+bool FileScanner::scanFile(const FileHandle& file) const {
+    return scan(file, ScanBudget(std::chrono::milliseconds(Config::FILE_SCAN_TIMEOUT_MS))) == ScanStatus::Threat;
+}
+
+ScanStatus FileScanner::scan(const FileHandle& file, const ScanBudget& budget,
+                             ScanDeduplicator* deduplicator) const {
+    return scanSource(file, budget, deduplicator);
+}
+
+ScanStatus FileScanner::scanBuffer(std::span<const std::byte> buffer, const BufferMetadata& metadata) const {
+    return scanBuffer(buffer, metadata, ScanBudget(std::chrono::milliseconds(Config::FILE_SCAN_TIMEOUT_MS)));
+}
+
+ScanStatus FileScanner::scanBuffer(std::span<const std::byte> buffer, const BufferMetadata& metadata,
+                                   const ScanBudget& budget) const {
+    ScanStatus status = scanSource(ScanSource(buffer, metadata.name), budget, nullptr);
+    if (status == ScanStatus::Threat && !metadata.origin.empty()) {
+        Logger::logWarning("Threat in content from " + metadata.origin + ": " + metadata.name);
+    }
+    return status;
 }
 
-bool FileScanner::heuristicScan(const std::string& filePath) const {
+ScanStatus FileScanner::scanSource(const ScanSource& source, const ScanBudget& budget,
+                                   ScanDeduplicator* deduplicator) const {
+    const std::string& filePath = source.name();
+    ScanBudget::Scope budgetScope(budget);
+
+    // Reports why the scan stopped early, or nullopt while there is budget left
+    auto budgetStatus = [&filePath]() -> std::optional<ScanStatus> {
+        switch (ScanBudget::threadState()) {
+            case ScanBudget::State::TimedOut:
+                Logger::logWarning("Scan timed out, partial verdict is clean: " + filePath);
+                return ScanStatus::TimedOut;
+            case ScanBudget::State::Cancelled:
+                Logger::logInfo("Scan cancelled: " + filePath);
+                return ScanStatus::Cancelled;
+            default:
+                return std::nullopt;
+        }
+    };
+
     try {
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file) return false;
+        ScanPlan plan = scanPolicy.plan(filePath, source.size());
+        if (plan.mode == ScanMode::Skip) {
+            Logger::logInfo("Skipping oversized file: " + filePath);
+            return ScanStatus::Clean;
+        }
 
-        // Calculate entropy
-        std::vector<unsigned char> buffer(8192);
-        size_t totalSize = 0;
-        std::vector<int> byteFrequency(256, 0);
-        float entropy = 0.0f;
+        // Decides which detectors apply, from the first few KB only
+        FileClassification fileType = FileTypeClassifier::classify(source);
+        if (source.isFile() && fingerprintCache.isEnabled()) {
+            fingerprintCache.refresh(source.fileHandle());
+        }
 
-        while (file.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) {
-            size_t bytesRead = file.gcount();
-            totalSize += bytesRead;
+        // The import hash needs only the headers, so check it before reading the whole file
+        PEInfo peInfo;
+        bool isPE = fileType.type == FileType::PE && PEParser::parse(source, peInfo);
+        if (isPE) {
+            auto family = peSignatures->findImportHash(PEParser::importHash(peInfo));
+            if (family) {
+                Logger::logWarning("Import table matches " + *family + ": " + filePath);
+                return ScanStatus::Threat;
+            }
+        }
+        if (auto status = budgetStatus()) return *status;
 
-            for (size_t i = 0; i < bytesRead; i++) {
-                byteFrequency[buffer[i]]++;
+        if (plan.mode == ScanMode::Sampled) {
+            if (isPE) {
+                ScanPolicy::addRegions(plan, peStructuralRegions(peInfo, source.size(),
+                                                                 scanPolicy.getSampling().blockSize));
+            }
+            if (!sampleLooksSuspicious(source, plan, fileType.type)) {
+                if (auto status = budgetStatus()) return *status;
+                return ScanStatus::Clean;
             }
+            plan = {ScanMode::Full, source.size(), {{0, source.size()}}};
         }
 
-        // Calculate entropy
-        for (int frequency : byteFrequency) {
-            if (frequency > 0) {
-                float probability = static_cast<float>(frequency) / totalSize;
-                entropy -= probability * std::log2f(probability);
+        // Check file hash
+        FileDigests digests = HashUtil::computeDigests(
+            source, isPE ? PEParser::sectionRegions(peInfo, source.size()) : std::vector<ScanRegion>{});
+
+        auto scanContent = [&]() {
+            if (signatures->contains(digests.sha256)) {
+                Logger::logWarning("Malicious file detected: " + filePath);
+                return ScanStatus::Threat;
             }
+
+            auto sectionFamily = peSignatures->findSection(digests.sectionMD5);
+            if (sectionFamily) {
+                Logger::logWarning("PE section matches " + *sectionFamily + ": " + filePath);
+                return ScanStatus::Threat;
+            }
+
+            // Near-duplicates of known samples
+            auto variant = similarityIndex->findClosest(digests.fuzzy, Config::FUZZY_MATCH_THRESHOLD);
+            if (variant) {
+                Logger::logWarning("Variant of " + variant->label + " detected (distance " +
+                                   std::to_string(variant->distance) + "): " + filePath);
+                return ScanStatus::Threat;
+            }
+
+            // Perform heuristic analysis
+            ScanStatus status = heuristicScan(source, plan, fileType.type);
+            if (status == ScanStatus::Threat) {
+                Logger::logWarning("Suspicious behavior detected: " + filePath);
+            } else if (status != ScanStatus::Clean) {
+                return budgetStatus().value_or(status);
+            }
+            return status;
+        };
+
+        if (!deduplicator) return scanContent();
+
+        // The plan and the script check depend on the extension, so copies are only shared when they match too
+        bool reused = false;
+        std::string contentKey = "sha256:" + digests.sha256 + ":" + std::to_string(static_cast<int>(plan.mode)) +
+                                 ":" + FileTypeClassifier::typeName(fileType.type);
+        ScanStatus status = deduplicator->run(contentKey, scanContent, &reused);
+        if (reused && status == ScanStatus::Threat) {
+            Logger::logWarning("Copy of detected content: " + filePath);
         }
+        return status;
+    } catch (const std::exception& e) {
+        // Reads cut short by the budget surface as read errors
+        if (auto status = budgetStatus()) return *status;
+        Logger::logError("Error scanning file: " + std::string(e.what()));
+        return ScanStatus::Clean;
+    }
+}
+
+bool FileScanner::sampleLooksSuspicious(const ScanSource& source, const ScanPlan& plan, FileType fileType) const {
+    // Always sampled, whatever the type: the magic bytes it was classified by
+    // are the attacker's to choose
+    SampleEstimate estimate = ContentSampler::estimate(source, plan.regions);
+    if (!estimate.complete) return false;
+
+    // A sample sees a small part of the file, so any pattern in it calls for
+    // the full scan rather than a weighed score that a single signal cannot
+    // reach. Entropy only counts where the type is not compressed by nature.
+    bool suspicious = estimate.packerBlocks > 0 || estimate.stringBlocks > 0 ||
+                      (scoringEngine.appliesTo(DETECTOR_HIGH_ENTROPY, fileType) &&
+                       estimate.entropy - estimate.entropyMargin > Config::HEURISTIC_ENTROPY_THRESHOLD);
+    Logger::logInfo("Sampled " + estimate.describe() + (suspicious ? ", escalating to a full scan: " : ": ") +
+                    source.name());
+    return suspicious;
+}
 
-        // Perform all checks
-        return (entropy > 6.5f) ||          // High entropy
-               checkPEFile(filePath) ||     // Suspicious PE characteristics
-               Utils::isPacked(filePath) || // Packed executable detection
-               Utils::containsSuspiciousStrings(filePath); // Known bad patterns
+ScanStatus FileScanner::heuristicScan(const ScanSource& source, const ScanPlan& plan, FileType fileType) const {
+    try {
+        ScanVerdict verdict = scoringEngine.evaluate({source, plan, fileType});
+        if (verdict.malicious) {
+            std::string reasons;
+            for (const auto& name : verdict.triggered) {
+                reasons += (reasons.empty() ? "" : ", ") + name;
+            }
+            Logger::logWarning("Heuristic score " + std::to_string(verdict.score) +
+                               " (" + reasons + "): " + source.name());
+            return ScanStatus::Threat;
+        }
+        return verdict.complete ? ScanStatus::Clean : ScanStatus::TimedOut;
     } catch (const std::exception& e) {
         Logger::logError("Error in heuristic scan: " + std::string(e.what()));
-        return false;
+        return ScanStatus::Clean;
     }
 }
 
 bool FileScanner::scanDirectory(const std::string& dirPath) const {
     try {
-        if (!std::filesystem::exists(dirPath)) {
+        if (!std::filesystem::is_directory(dirPath)) {
             Logger::logError("Directory not found: " + dirPath);
             return false;
         }
 
-        size_t fileCount = 0;
-        size_t threatCount = 0;
-
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(dirPath)) {
-            if (entry.is_regular_file()) {
-                fileCount++;
-                if (scanFile(entry.path().string())) {
-                    threatCount++;
-                    try {
-                        std::string quarantinePath = "data/quarantine/" + 
-                            entry.path().filename().string() + ".quarantine";
-                        std::filesystem::create_directories("data/quarantine");
-                        std::filesystem::rename(entry.path(), quarantinePath);
-                        Logger::logInfo("File quarantined: " + quarantinePath);
-                    } catch (const std::exception& e) {
-                        Logger::logError("Failed to quarantine file: " + std::string(e.what()));
-                    }
-                }
+        std::atomic<size_t> threatCount{0};
+        std::atomic<size_t> timeoutCount{0};
+        DirectoryWalker walker(Config::SCAN_THREADS);
+        ScanDeduplicator deduplicator;
+
+        size_t fileCount = walker.walk(dirPath, [this, &threatCount, &timeoutCount, &deduplicator](FileHandle& file) {
+            // Hard links are recognised before any content is read
+            bool reused = false;
+            ScanStatus status = deduplicator.run(ScanDeduplicator::identityKey(file), [&]() {
+                return scan(file, ScanBudget(std::chrono::milliseconds(Config::FILE_SCAN_TIMEOUT_MS)),
+                            &deduplicator);
+            }, &reused);
+            if (status == ScanStatus::TimedOut) timeoutCount++;
+            if (reused && status == ScanStatus::Threat) {
+                Logger::logWarning("Link to detected file: " + file.path());
             }
-        }
+            if (status == ScanStatus::Threat) {
+                threatCount++;
+                // Windows cannot move a file that is still open
+                std::string path = file.path();
+                file.close();
+                quarantineStore.quarantine(path, "Directory scan");
+            }
+            return true;
+        });
 
         Logger::logInfo("Directory scan complete: " + 
                        std::to_string(fileCount) + " files scanned, " +
-                       std::to_string(threatCount) + " threats found");
+                       std::to_string(threatCount) + " threats found, " +
+                       std::to_string(timeoutCount) + " timed out, " +
+                       std::to_string(deduplicator.reusedCount()) + " duplicates reused");
+
+        for (const auto& stats : getDetectorStats()) {
+            Logger::logInfo("Detector " + stats.name + ": " + std::to_string(stats.hits) + "/" +
+                            std::to_string(stats.runs) + " hits, avg " +
+                            std::to_string(stats.averageMicros) + "us");
+        }
 
         return threatCount > 0;
     } catch (const std::exception& e) {
@@ -120,23 +323,16 @@ bool FileScanner::scanDirectory(const std::string& dirPath) const {
     }
 }
 
-bool FileScanner::checkPEFile(const std::string& filePath) const {
+bool FileScanner::checkPEFile(const ScanSource& source) const {
     try {
-        std::ifstream file(filePath, std::ios::binary);
-        IMAGE_DOS_HEADER dosHeader;
-        file.read(reinterpret_cast<char*>(&dosHeader), sizeof(dosHeader));
-        
-        if (dosHeader.e_magic != IMAGE_DOS_SIGNATURE) return false;
-        
-        file.seekg(dosHeader.e_lfanew);
-        IMAGE_NT_HEADERS ntHeader;
-        file.read(reinterpret_cast<char*>(&ntHeader), sizeof(ntHeader));
-        
+        PEInfo info;
+        if (!PEParser::parse(source, info, false)) return false;
+
         // Check for suspicious characteristics
-        if ((ntHeader.FileHeader.Characteristics & IMAGE_FILE_DLL) ||
-            (ntHeader.OptionalHeader.Subsystem == IMAGE_SUBSYSTEM_UNKNOWN) ||
-            (ntHeader.OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_DYNAMIC_BASE)) {
-            Logger::logWarning("Suspicious PE characteristics detected: " + filePath);
+        if ((info.characteristics & PEParser::FILE_DLL) ||
+            (info.subsystem == PEParser::SUBSYSTEM_UNKNOWN) ||
+            (info.dllCharacteristics & PEParser::DLL_DYNAMIC_BASE)) {
+            Logger::logWarning("Suspicious PE characteristics detected: " + source.name());
             return true;
         }
         return false;
@@ -145,35 +341,29 @@ bool FileScanner::checkPEFile(const std::string& filePath) const {
     }
 }
 
-void FileScanner::unquarantine(const std::string& filename) {
+std::string FileScanner::quarantine(const std::string& filePath, const std::string& reason) {
+    return quarantineStore.quarantine(filePath, reason);
+}
+
+std::vector<QuarantineEntry> FileScanner::listQuarantine() const {
+    return quarantineStore.list();
+}
+
+void FileScanner::unquarantine(const std::string& id) {
     try {
-        std::string quarantinePath = "data/quarantine/" + filename;
-        
-        if (!std::filesystem::exists(quarantinePath)) {
-            Logger::logError("Quarantined file not found: " + quarantinePath);
+        if (!quarantineStore.find(id)) {
+            Logger::logError("Quarantined file not found: " + id);
             std::cout << "Quarantined file not found.\n";
             return;
         }
 
-        // Remove .quarantine extension
-        std::string originalName = filename;
-        const std::string quarantineExt = ".quarantine";
-        if (originalName.length() >= quarantineExt.length() && 
-            originalName.substr(originalName.length() - quarantineExt.length()) == quarantineExt) {
-            originalName = originalName.substr(0, originalName.length() - quarantineExt.length());
+        std::string destPath;
+        if (!quarantineStore.restore(id, &destPath)) {
+            std::cout << "Error restoring file.\n";
+            return;
         }
 
-        // Create a unique destination path
-        std::string destPath = createUniqueRestorePath(originalName);
-
-        // Copy the file and preserve attributes
-        std::filesystem::copy(quarantinePath, destPath, 
-                            std::filesystem::copy_options::overwrite_existing);
-        
-        // Restore file permissions
         if (restoreFilePermissions(destPath)) {
-            // Remove quarantined file only after successful restoration
-            std::filesystem::remove(quarantinePath);
             Logger::logInfo("File restored successfully: " + destPath);
             std::cout << "File restored successfully to: " << destPath << "\n";
         } else {
@@ -188,25 +378,21 @@ void FileScanner::unquarantine(const std::string& filename) {
 
 void FileScanner::unquarantineAll() {
     try {
-        const std::string quarantinePath = "data/quarantine/";
-        if (!std::filesystem::exists(quarantinePath)) {
+        if (quarantineStore.size() == 0) {
             std::cout << "No files in quarantine.\n";
             return;
         }
 
-        bool anyRestored = false;
-        for (const auto& entry : std::filesystem::directory_iterator(quarantinePath)) {
-            try {
-                unquarantine(entry.path().filename().string());
-                anyRestored = true;
-            } catch (const std::exception& e) {
-                Logger::logError("Error restoring file " + entry.path().string() + ": " + e.what());
-                std::cout << "Error restoring " << entry.path().filename().string() << "\n";
+        std::vector<std::string> restoredPaths;
+        size_t restored = quarantineStore.restoreAll(&restoredPaths);
+        for (const auto& path : restoredPaths) {
+            if (!restoreFilePermissions(path)) {
+                Logger::logWarning("File restored but permissions could not be fully restored: " + path);
             }
         }
 
-        if (anyRestored) {
-            std::cout << "Finished restoring files from quarantine.\n";
+        if (restored > 0) {
+            std::cout << "Restored " << restored << " files from quarantine.\n";
         } else {
             std::cout << "No files were restored from quarantine.\n";
         }
@@ -218,6 +404,7 @@ void FileScanner::unquarantineAll() {
 
 bool FileScanner::restoreFilePermissions(const std::string& path) {
     try {
+#ifdef _WIN32
         // Convert string to wide string for Windows API
         int size_needed = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
         std::wstring wpath(size_needed, 0);
@@ -237,6 +424,16 @@ bool FileScanner::restoreFilePermissions(const std::string& path) {
             Logger::logWarning("Failed to restore file attributes for: " + path);
             return false;
         }
+#else
+        // Make sure the owner can read and write the restored file
+        std::error_code ec;
+        std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+                                     std::filesystem::perm_options::add, ec);
+        if (ec) {
+            Logger::logWarning("Failed to restore file attributes for: " + path);
+            return false;
+        }
+#endif
 
         return true;
     } catch (...) {
@@ -244,19 +441,25 @@ bool FileScanner::restoreFilePermissions(const std::string& path) {
     }
 }
 
-std::string FileScanner::createUniqueRestorePath(const std::string& originalPath) {
-    std::filesystem::path path(originalPath);
-    std::string baseName = path.stem().string();
-    std::string extension = path.extension().string();
-    std::string destPath = originalPath;
-    
-    int counter = 1;
-    while (std::filesystem::exists(destPath)) {
-        destPath = baseName + "_restored_" + std::to_string(counter) + extension;
-        counter++;
+std::vector<DetectorStats> FileScanner::getDetectorStats() const {
+    return scoringEngine.getStats();
+}
+
+std::string FileScanner::engineVersion() const {
+    // Any signature change alters a database's size or write time
+    std::string version;
+    for (const auto& path : databasePaths) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        auto mtime = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(path, ec);
+        version += std::to_string(ec ? 0 : size) + ":" +
+                   std::to_string(mtime.time_since_epoch().count()) + ";";
     }
-    
-    return destPath;
+    return version;
+}
+
+ScanPlan FileScanner::planScan(const std::string& filePath) const {
+    return scanPolicy.plan(filePath);
 }
 
 void FileScanner::updateSignatures() {
@@ -2,33 +2,89 @@
 #define FILE_SCANNER_H
 
 #include "SignatureDatabase.h"
+#include "SimilarityIndex.h"
+#include "PESignatureIndex.h"
+#include "ScanPolicy.h"
+#include "ScoringEngine.h"
+#include "QuarantineStore.h"
+#include "ScanDeduplicator.h"
+#include "FingerprintCache.h"
+#include "../utils/ScanBudget.h"
+#include "../utils/ScanSource.h"
+#include <cstddef>
+#include <span>
 #include <string>
 #include <memory>
 #include <chrono>
 #include <thread>
-#include <windows.h>
+
+// Describes content handed to FileScanner::scanBuffer
+struct BufferMetadata {
+    std::string name;       // Original file name; its extension selects the scan policy
+    std::string origin;     // Where the content came from, such as "mail" or "upload", for logs
+};
 
 class FileScanner {
 public:
     explicit FileScanner(const std::string& dbPath);
     virtual ~FileScanner() = default;
 
+    // Both scan within FILE_SCAN_TIMEOUT_MS and report only definite threats
     bool scanFile(const std::string& filePath) const;
+    bool scanFile(const FileHandle& file) const;
+    // Also installs the budget for the calling thread. With a deduplicator,
+    // identical content is only scanned once per pass.
+    ScanStatus scan(const FileHandle& file, const ScanBudget& budget,
+                    ScanDeduplicator* deduplicator = nullptr) const;
+    // Runs the same pipeline over caller-owned memory, in place: nothing is
+    // copied or written to disk. The first form uses FILE_SCAN_TIMEOUT_MS.
+    ScanStatus scanBuffer(std::span<const std::byte> buffer, const BufferMetadata& metadata) const;
+    ScanStatus scanBuffer(std::span<const std::byte> buffer, const BufferMetadata& metadata,
+                          const ScanBudget& budget) const;
     bool scanDirectory(const std::string& dirPath) const;
+    std::string quarantine(const std::string& filePath, const std::string& reason);
     void unquarantineAll();
-    void unquarantine(const std::string& filename);
+    void unquarantine(const std::string& id);
+    std::vector<QuarantineEntry> listQuarantine() const;
     void updateSignatures();
 
+    ScanPlan planScan(const std::string& filePath) const;
+    ScanPolicy& getScanPolicy() { return scanPolicy; }
+    // File scans record a content fingerprint here once it is enabled
+    FingerprintCache& getFingerprintCache() const { return fingerprintCache; }
+    std::vector<DetectorStats> getDetectorStats() const;
+    // Changes whenever any signature database changes
+    std::string engineVersion() const;
+
 private:
+    friend class StreamScanner;
+
+    // Heuristic detector names, also used to look up weights for stream scans
+    static constexpr const char* DETECTOR_PE_CHARACTERISTICS = "pe-characteristics";
+    static constexpr const char* DETECTOR_HIGH_ENTROPY = "high-entropy";
+    static constexpr const char* DETECTOR_PACKER_SIGNATURE = "packer-signature";
+    static constexpr const char* DETECTOR_SUSPICIOUS_STRINGS = "suspicious-strings";
+
+    std::vector<std::string> databasePaths;
     std::unique_ptr<SignatureDatabase> signatures;
+    std::unique_ptr<SimilarityIndex> similarityIndex;
+    std::unique_ptr<PESignatureIndex> peSignatures;
+    ScanPolicy scanPolicy;
+    ScoringEngine scoringEngine;
+    mutable QuarantineStore quarantineStore;  // Internally synchronized
+    mutable FingerprintCache fingerprintCache;  // Internally synchronized
     
-    bool heuristicScan(const std::string& filePath) const;
+    ScanStatus scanSource(const ScanSource& source, const ScanBudget& budget,
+                          ScanDeduplicator* deduplicator) const;
+    ScanStatus heuristicScan(const ScanSource& source, const ScanPlan& plan, FileType fileType) const;
+    // Reads only the sampled regions of the plan; true if a full scan should follow
+    bool sampleLooksSuspicious(const ScanSource& source, const ScanPlan& plan, FileType fileType) const;
     bool scanFileContent(const std::string& filePath) const;
     bool isFileTypeSupported(const std::string& filePath) const;
-    bool checkPEFile(const std::string& filePath) const;
+    bool checkPEFile(const ScanSource& source) const;
+    void registerDetectors();
     void logScanResult(const std::string& filePath, bool threat) const;
     bool restoreFilePermissions(const std::string& path);
-    std::string createUniqueRestorePath(const std::string& originalPath);
 };
 
 #endif // FILE_SCANNER_H
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "FingerprintCache.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+    // Formats that are dense by design; turning into one is a conversion, not encryption
+    constexpr uint32_t DENSE_TYPES = FileTypes::MEDIA | FileTypes::bit(FileType::Archive);
+
+    // Only these can be one side of a change that compare reports
+    bool mayBeOriginal(const ContentFingerprint& fingerprint) {
+        return fingerprint.size >= Config::FINGERPRINT_MIN_SIZE &&
+               (fingerprint.type != FileType::Unknown || fingerprint.entropy < Config::FINGERPRINT_LOW_ENTROPY);
+    }
+
+    bool mayBeEncrypted(const ContentFingerprint& fingerprint) {
+        return fingerprint.size >= Config::FINGERPRINT_MIN_SIZE && fingerprint.entropy >= Config::ENTROPY_THRESHOLD;
+    }
+}
+
+FingerprintCache::FingerprintCache(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+ContentFingerprint FingerprintCache::measure(const ScanSource& source) {
+    const size_t blockSize = Config::FINGERPRINT_BLOCK_SIZE;
+    const uint64_t blocks = std::max<size_t>(Config::FINGERPRINT_SAMPLE_BLOCKS, 1);
+
+    ContentFingerprint fingerprint;
+    fingerprint.size = source.size();
+    if (source.isFile()) fingerprint.modifiedTime = source.fileHandle().modifiedTime();
+
+    // Small files are read whole; larger ones at the same fractions every time
+    bool whole = fingerprint.size <= blocks * blockSize;
+    uint64_t count = whole ? (fingerprint.size + blockSize - 1) / blockSize : blocks;
+
+    Utils::ByteHistogram histogram;
+    unsigned char block[blockSize];
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t offset = whole ? i * blockSize
+                                : (blocks > 1 ? i * (fingerprint.size - blockSize) / (blocks - 1) : 0);
+        int64_t got = source.readAt(block, blockSize, offset);
+        if (got <= 0) break;
+
+        if (i == 0) {
+            fingerprint.type = FileTypeClassifier::classify({block, static_cast<size_t>(got)}, source.name()).type;
+        }
+        histogram.update(block, static_cast<size_t>(got));
+    }
+    fingerprint.entropy = histogram.size() > 0 ? histogram.entropy() : 0.0f;
+    return fingerprint;
+}
+
+FingerprintChange FingerprintCache::compare(const ContentFingerprint& before, const ContentFingerprint& after) {
+    if (before.size < Config::FINGERPRINT_MIN_SIZE || after.size < Config::FINGERPRINT_MIN_SIZE) {
+        return FingerprintChange::None;
+    }
+    // Encrypted data is close to random; a rewrite that stays below this is an ordinary edit
+    if (after.entropy < Config::ENTROPY_THRESHOLD) return FingerprintChange::None;
+
+    if (before.type != FileType::Unknown && after.type == FileType::Unknown) {
+        return FingerprintChange::TypeLoss;
+    }
+    // Some ransomware leaves the header alone, so the type alone is not enough
+    if (before.entropy < Config::FINGERPRINT_LOW_ENTROPY &&
+        (after.type == before.type || !(FileTypes::bit(after.type) & DENSE_TYPES))) {
+        return FingerprintChange::EntropyRise;
+    }
+    return FingerprintChange::None;
+}
+
+std::optional<ContentFingerprint> FingerprintCache::find(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(path);
+    if (it == index.end()) return std::nullopt;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void FingerprintCache::store(const std::string& path, const ContentFingerprint& fingerprint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(path);
+    if (it != index.end()) {
+        it->second->second = fingerprint;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(path, fingerprint);
+    index.emplace(entries.front().first, entries.begin());
+}
+
+void FingerprintCache::refresh(const FileHandle& file) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(file.path());
+        if (it != index.end() && it->second->second.size == file.size() &&
+            it->second->second.modifiedTime == file.modifiedTime()) {
+            return;
+        }
+    }
+    store(file.path(), measure(file));
+}
+
+void FingerprintCache::rename(const std::string& from, const std::string& to) {
+    std::optional<ContentFingerprint> fingerprint;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(from);
+        if (it == index.end()) return;
+        fingerprint = it->second->second;
+        auto entry = it->second;
+        index.erase(it);
+        entries.erase(entry);
+    }
+    store(to, *fingerprint);
+}
+
+std::optional<ContentFingerprint> FingerprintCache::remove(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(path);
+    if (it == index.end()) return std::nullopt;
+    auto entry = it->second;
+    ContentFingerprint fingerprint = entry->second;
+    index.erase(it);
+    entries.erase(entry);
+    return fingerprint;
+}
+
+size_t FingerprintCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::optional<ReplacementTracker::Replacement> ReplacementTracker::deleted(const std::string& path,
+                                                                          const ContentFingerprint& fingerprint) {
+    if (!mayBeOriginal(fingerprint)) return std::nullopt;
+    return pair(deletions, creations, true, path, fingerprint);
+}
+
+std::optional<ReplacementTracker::Replacement> ReplacementTracker::created(const std::string& path,
+                                                                          const ContentFingerprint& fingerprint) {
+    if (!mayBeEncrypted(fingerprint)) return std::nullopt;
+    return pair(creations, deletions, false, path, fingerprint);
+}
+
+std::optional<ReplacementTracker::Replacement> ReplacementTracker::pair(PendingFiles& waiting, PendingFiles& opposite,
+                                                                       bool isDeletion, const std::string& path,
+                                                                       const ContentFingerprint& fingerprint) {
+    const auto window = std::chrono::seconds(Config::RANSOMWARE_WINDOW_SEC);
+    auto now = std::chrono::steady_clock::now();
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    auto expired = [&](const PendingFile& file) { return now - file.time > window; };
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto candidates = opposite.find(directory);
+    if (candidates != opposite.end()) {
+        std::deque<PendingFile>& files = candidates->second;
+        while (!files.empty() && expired(files.front())) files.pop_front();
+
+        for (auto it = files.begin(); it != files.end(); ++it) {
+            const ContentFingerprint& before = isDeletion ? fingerprint : it->fingerprint;
+            const ContentFingerprint& after = isDeletion ? it->fingerprint : fingerprint;
+            FingerprintChange change = FingerprintCache::compare(before, after);
+            if (change == FingerprintChange::None) continue;
+
+            Replacement replacement{isDeletion ? path : it->path, isDeletion ? it->path : path, change};
+            files.erase(it);
+            if (files.empty()) opposite.erase(candidates);
+            return replacement;
+        }
+        if (files.empty()) opposite.erase(candidates);
+    }
+
+    // Directories whose files all expired are only dropped when room is needed
+    if (waiting.size() >= Config::REPLACEMENT_PENDING_DIRECTORIES && !waiting.count(directory)) {
+        std::erase_if(waiting, [&](const auto& entry) { return expired(entry.second.back()); });
+        if (waiting.size() >= Config::REPLACEMENT_PENDING_DIRECTORIES) return std::nullopt;
+    }
+    std::deque<PendingFile>& files = waiting[directory];
+    if (files.size() >= Config::REPLACEMENT_PENDING_FILES) files.pop_front();
+    files.push_back({path, fingerprint, now});
+    return std::nullopt;
+}
@@ -0,0 +1,101 @@
+#ifndef FINGERPRINT_CACHE_H
+#define FINGERPRINT_CACHE_H
+
+#include "../utils/FileTypeClassifier.h"
+#include "../utils/ScanSource.h"
+#include "Config.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Compact summary of a file's content, cheap enough to take on every change
+struct ContentFingerprint {
+    float entropy = 0.0f;       // Bits per byte over the sampled blocks
+    FileType type = FileType::Unknown;
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;
+};
+
+// How a rewrite changed a file, when it looks like encryption
+enum class FingerprintChange {
+    None,
+    TypeLoss,       // Recognized content became unidentifiable, high-entropy data
+    EntropyRise     // Plain content became dense without turning into a known compressed format
+};
+
+// Remembers the last fingerprint of recently scanned or changed files, up to
+// FINGERPRINT_CACHE_SIZE, dropping the least recently used. A fingerprint is
+// measured from FINGERPRINT_SAMPLE_BLOCKS blocks at fixed fractions of the
+// file, so the same file is always sampled the same way and the cost does
+// not grow with its size. Internally synchronized.
+class FingerprintCache {
+public:
+    explicit FingerprintCache(size_t capacity = Config::FINGERPRINT_CACHE_SIZE);
+
+    static ContentFingerprint measure(const ScanSource& source);
+    static FingerprintChange compare(const ContentFingerprint& before, const ContentFingerprint& after);
+
+    // Scans only record fingerprints while something is watching for changes
+    void setEnabled(bool enabled) { active = enabled; }
+    bool isEnabled() const { return active; }
+
+    std::optional<ContentFingerprint> find(const std::string& path);
+    void store(const std::string& path, const ContentFingerprint& fingerprint);
+    // Measures the file unless the cached fingerprint has the same size and modification time
+    void refresh(const FileHandle& file);
+    void rename(const std::string& from, const std::string& to);
+    // Returns the fingerprint the file had, if any
+    std::optional<ContentFingerprint> remove(const std::string& path);
+    size_t size() const;
+
+private:
+    using Entry = std::pair<std::string, ContentFingerprint>;
+
+    size_t capacity;
+    std::atomic<bool> active{false};
+    std::list<Entry> entries;       // Most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;   // Keys point into entries
+    mutable std::mutex mutex;
+};
+
+// Ransomware that writes an encrypted copy under a new name and deletes the
+// original leaves no file whose fingerprint changed. This pairs a deleted
+// file with one created in the same directory within RANSOMWARE_WINDOW_SEC,
+// in either order, and compares the two as if one had been rewritten into
+// the other. Each file pairs at most once. Internally synchronized.
+class ReplacementTracker {
+public:
+    struct Replacement {
+        std::string original;
+        std::string copy;
+        FingerprintChange change = FingerprintChange::None;
+    };
+
+    std::optional<Replacement> deleted(const std::string& path, const ContentFingerprint& fingerprint);
+    std::optional<Replacement> created(const std::string& path, const ContentFingerprint& fingerprint);
+
+private:
+    struct PendingFile {
+        std::string path;
+        ContentFingerprint fingerprint;
+        std::chrono::steady_clock::time_point time;
+    };
+    using PendingFiles = std::unordered_map<std::string, std::deque<PendingFile>>;   // By directory
+
+    PendingFiles deletions;
+    PendingFiles creations;
+    std::mutex mutex;
+
+    std::optional<Replacement> pair(PendingFiles& waiting, PendingFiles& opposite, bool isDeletion,
+                                    const std::string& path, const ContentFingerprint& fingerprint);
+};
+
+#endif // FINGERPRINT_CACHE_H
@@ -0,0 +1,230 @@
+#include "HookDetector.h"
+#include "../utils/ElfParser.h"
+#include "../utils/FileHandle.h"
+#include "../utils/Logger.h"
+#include "../utils/PEParser.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include "ProcessMemoryScanner.h"
+#endif
+
+namespace {
+    // Nearby exports are fetched from the target with one read
+    const size_t MAX_READ_WINDOW = 4096;
+
+    void addValue(unsigned char* bytes, uint8_t width, uint64_t delta) {
+        uint64_t value = 0;
+        std::memcpy(&value, bytes, width);
+        value += delta;
+        std::memcpy(bytes, &value, width);
+    }
+
+    template <typename Range>
+    std::vector<std::pair<uint8_t, uint8_t>> fixupsWithin(uint64_t start, size_t length,
+                                                          const Range& relocations, uint8_t width) {
+        std::vector<std::pair<uint8_t, uint8_t>> fixups;
+        // A relocated field may start a few bytes before the prologue
+        uint64_t from = start >= width ? start - width + 1 : 0;
+        auto it = std::lower_bound(relocations.begin(), relocations.end(), from);
+        for (; it != relocations.end() && *it < start + length; ++it) {
+            int64_t offset = static_cast<int64_t>(*it) - static_cast<int64_t>(start);
+            fixups.emplace_back(static_cast<uint8_t>(std::max<int64_t>(offset, 0)),
+                                static_cast<uint8_t>(offset < 0 ? width + offset : width));
+        }
+        return fixups;
+    }
+}
+
+HookDetector::HookDetector(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+std::shared_ptr<HookDetector::Baseline> HookDetector::buildBaseline(const FileHandle& file) {
+    auto baseline = std::make_shared<Baseline>();
+    auto addPrologue = [&](const std::string& name, uint64_t address, int64_t fileOffset, uint64_t size) {
+        if (fileOffset < 0) return;
+        Prologue prologue{name, address, 0, {}, {}};
+        size_t length = size > 0 ? static_cast<size_t>(std::min<uint64_t>(size, PROLOGUE_SIZE)) : PROLOGUE_SIZE;
+        int64_t bytesRead = file.readAt(prologue.bytes, length, static_cast<uint64_t>(fileOffset));
+        if (bytesRead <= 0) return;
+        prologue.length = static_cast<uint8_t>(bytesRead);
+        baseline->prologues.push_back(std::move(prologue));
+    };
+
+    PEInfo pe;
+    ElfInfo elf;
+    if (PEParser::parse(file, pe, false)) {
+        baseline->isPE = true;
+        baseline->pointerWidth = pe.is64 ? 8 : 4;
+        baseline->preferredBase = pe.imageBase;
+        baseline->linkBase = 0;
+        PEParser::readExports(file, pe);
+        PEParser::readRelocations(file, pe);
+
+        std::vector<uint64_t> relocations;
+        for (const auto& relocation : pe.relocations) relocations.push_back(relocation.rva);
+        std::sort(relocations.begin(), relocations.end());
+
+        for (const auto& entry : pe.exports) {
+            addPrologue(entry.name, entry.rva, PEParser::rvaToOffset(pe, entry.rva), 0);
+        }
+        for (auto& prologue : baseline->prologues) {
+            prologue.fixups = fixupsWithin(prologue.address, prologue.length, relocations, baseline->pointerWidth);
+        }
+    } else if (ElfParser::parse(file, elf)) {
+        baseline->isPE = false;
+        baseline->pointerWidth = elf.is64 ? 8 : 4;
+        baseline->preferredBase = 0;
+        baseline->linkBase = UINT64_MAX;
+        for (const auto& segment : elf.loadSegments) {
+            baseline->linkBase = std::min<uint64_t>(baseline->linkBase, segment.virtualAddress & ~0xFFFULL);
+        }
+        for (const auto& function : elf.functions) {
+            addPrologue(function.name, function.value, ElfParser::addressToOffset(elf, function.value),
+                        function.size);
+        }
+        for (auto& prologue : baseline->prologues) {
+            prologue.fixups = fixupsWithin(prologue.address, prologue.length, elf.relocations,
+                                           baseline->pointerWidth);
+        }
+    } else {
+        return nullptr;
+    }
+
+    // Aliases share an address; one check covers them all
+    std::sort(baseline->prologues.begin(), baseline->prologues.end(),
+              [](const Prologue& a, const Prologue& b) { return a.address < b.address; });
+    baseline->prologues.erase(std::unique(baseline->prologues.begin(), baseline->prologues.end(),
+                                          [](const Prologue& a, const Prologue& b) { return a.address == b.address; }),
+                              baseline->prologues.end());
+    return baseline;
+}
+
+std::shared_ptr<const HookDetector::Baseline> HookDetector::baselineFor(const std::string& path) {
+    FileHandle file = FileHandle::open(path);
+    if (!file.isOpen()) return nullptr;
+
+    // The same library reached through different paths or process roots is one file
+    std::string key = std::to_string(file.device()) + ":" + std::to_string(file.inode()) + ":" +
+                      std::to_string(file.modifiedTime());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            cache.splice(cache.begin(), cache, it->second);
+            return it->second->second;
+        }
+    }
+
+    std::shared_ptr<const Baseline> baseline = buildBaseline(file);
+    std::lock_guard<std::mutex> lock(mutex);
+    // Another thread may have built it meanwhile
+    auto it = index.find(key);
+    if (it != index.end()) return it->second->second;
+
+    // A rebuilt library has a new mtime; its old baseline ages out like any other
+    if (cache.size() >= capacity) {
+        index.erase(cache.back().first);
+        cache.pop_back();
+    }
+    cache.emplace_front(key, baseline);
+    index.emplace(key, cache.begin());
+    return baseline;
+}
+
+std::vector<HookFinding> HookDetector::checkModule(const std::string& path, uint64_t loadBase,
+                                                   const MemoryReader& read) {
+    std::vector<HookFinding> findings;
+    std::shared_ptr<const Baseline> baseline = baselineFor(path);
+    if (!baseline) return findings;
+
+    uint64_t delta = loadBase - baseline->preferredBase;
+    uint64_t bias = loadBase - baseline->linkBase;
+    std::vector<unsigned char> window;
+    const auto& prologues = baseline->prologues;
+
+    for (size_t first = 0; first < prologues.size();) {
+        // Group exports that fit in one read window
+        size_t last = first;
+        uint64_t start = prologues[first].address;
+        while (last + 1 < prologues.size() &&
+               prologues[last + 1].address + prologues[last + 1].length - start <= MAX_READ_WINDOW) {
+            last++;
+        }
+        uint64_t end = prologues[last].address + prologues[last].length;
+        window.resize(static_cast<size_t>(end - start));
+
+        if (read(bias + start, window.data(), window.size())) {
+            for (size_t i = first; i <= last; i++) {
+                const Prologue& prologue = prologues[i];
+                unsigned char expected[PROLOGUE_SIZE];
+                std::memcpy(expected, prologue.bytes, prologue.length);
+                const unsigned char* actual = window.data() + (prologue.address - start);
+
+                std::vector<bool> ignored(prologue.length, false);
+                for (const auto& [offset, width] : prologue.fixups) {
+                    // PE fields wholly inside the prologue can be relocated; anything
+                    // else the loader touched is left out of the comparison
+                    if (baseline->isPE && width == baseline->pointerWidth && offset + width <= prologue.length) {
+                        addValue(expected + offset, width, delta);
+                    } else {
+                        std::fill(ignored.begin() + offset,
+                                  ignored.begin() + std::min<size_t>(offset + width, prologue.length), true);
+                    }
+                }
+
+                for (size_t b = 0; b < prologue.length; b++) {
+                    if (!ignored[b] && expected[b] != actual[b]) {
+                        findings.push_back({path, prologue.name, bias + prologue.address});
+                        break;
+                    }
+                }
+            }
+        }
+        first = last + 1;
+    }
+
+    return findings;
+}
+
+#ifdef __linux__
+std::vector<HookFinding> HookDetector::checkProcess(pid_t pid) {
+    std::vector<HookFinding> findings;
+    int memFd = open(("/proc/" + std::to_string(pid) + "/mem").c_str(), O_RDONLY | O_CLOEXEC);
+    if (memFd < 0) return findings;
+
+    MemoryReader read = [memFd](uint64_t address, unsigned char* buffer, size_t length) {
+        return pread(memFd, buffer, length, static_cast<off_t>(address)) == static_cast<ssize_t>(length);
+    };
+
+    // The mapping at file offset 0 gives the load bias: it is where the
+    // first PT_LOAD segment (virtual address 0 for shared objects) landed
+    std::vector<std::string> checked;
+    for (const auto& region : ProcessMemoryScanner::readMaps(pid)) {
+        if (region.offset != 0 || region.inode == 0 || region.path.empty() || region.path[0] != '/') continue;
+        if (region.path.find(".so") == std::string::npos) continue;
+        if (std::find(checked.begin(), checked.end(), region.path) != checked.end()) continue;
+        checked.push_back(region.path);
+
+        // Go through the process's own view of the file, in case it lives in another mount namespace
+        std::string path = "/proc/" + std::to_string(pid) + "/root" + region.path;
+        for (auto& finding : checkModule(path, region.start, read)) {
+            finding.module = region.path;
+            Logger::logWarning("Hooked export " + finding.function + " in " + finding.module +
+                               " (process " + std::to_string(pid) + ")");
+            findings.push_back(std::move(finding));
+        }
+    }
+
+    close(memFd);
+    return findings;
+}
+#endif
+
+size_t HookDetector::cachedModules() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cache.size();
+}
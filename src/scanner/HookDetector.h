@@ -0,0 +1,82 @@
+#ifndef HOOK_DETECTOR_H
+#define HOOK_DETECTOR_H
+
+#include "Config.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/types.h>
+#endif
+
+class FileHandle;
+
+struct HookFinding {
+    std::string module;
+    std::string function;
+    uint64_t address;
+};
+
+// Finds inline hooks by comparing the first bytes of every exported function
+// in memory with the same bytes in the module's file on disk. Bytes the
+// loader legitimately rewrites are accounted for: PE base relocations are
+// re-applied for the actual load address and ELF relocation targets are
+// ignored. Baselines are cached per file identity (device, inode, mtime),
+// so the same library seen through any process or path is parsed once and
+// repeat sweeps only read a few bytes per export from the target process.
+// At most `capacity` baselines are kept, least recently used dropped first.
+class HookDetector {
+public:
+    static constexpr size_t PROLOGUE_SIZE = 16;
+
+    explicit HookDetector(size_t capacity = Config::HOOK_BASELINE_CACHE_SIZE);
+
+    // Reads `length` bytes of target memory at `address`
+    using MemoryReader = std::function<bool(uint64_t address, unsigned char* buffer, size_t length)>;
+
+    // Checks a PE or ELF module whose first page is mapped at loadBase in the
+    // target reached through `read`
+    std::vector<HookFinding> checkModule(const std::string& path, uint64_t loadBase, const MemoryReader& read);
+
+#ifdef __linux__
+    // Every ELF shared object mapped into the process
+    std::vector<HookFinding> checkProcess(pid_t pid);
+#endif
+
+    size_t cachedModules() const;
+
+private:
+    struct Prologue {
+        std::string name;
+        uint64_t address;               // RVA for PE, virtual address for ELF
+        uint8_t length;
+        unsigned char bytes[PROLOGUE_SIZE];
+        std::vector<std::pair<uint8_t, uint8_t>> fixups; // (offset, width) rewritten by the loader
+    };
+
+    struct Baseline {
+        bool isPE;
+        uint8_t pointerWidth;
+        uint64_t preferredBase;           // PE image base the relocations assume
+        uint64_t linkBase;                // ELF address of the first loaded page
+        std::vector<Prologue> prologues;  // Sorted by address
+    };
+
+    using Entry = std::pair<std::string, std::shared_ptr<const Baseline>>;
+
+    size_t capacity;
+    std::list<Entry> cache;         // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    mutable std::mutex mutex;
+
+    std::shared_ptr<const Baseline> baselineFor(const std::string& path);
+    static std::shared_ptr<Baseline> buildBaseline(const FileHandle& file);
+};
+
+#endif // HOOK_DETECTOR_H
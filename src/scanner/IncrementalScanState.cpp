@@ -0,0 +1,262 @@
+#include "IncrementalScanState.h"
+#include "../utils/Logger.h"
+#include "Config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    const char MAGIC[8] = {'A', 'V', 'S', 'T', 'A', 'T', 'E', '1'};
+    const uint32_t STATE_VERSION = 1;
+    const uint32_t MAX_STRING_LENGTH = 64 * 1024;
+
+    uint64_t fnv1a(const char* data, size_t length) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    // Directory paths from the walker and parents of file paths agree once trailing separators go
+    std::string directoryKey(std::string path) {
+        while (path.size() > 1 && (path.back() == '/' || path.back() == '\\')) path.pop_back();
+        return path;
+    }
+
+    void splitPath(const std::string& filePath, std::string& parent, std::string& name) {
+        size_t separator = filePath.find_last_of("/\\");
+        if (separator == std::string::npos) {
+            parent = ".";
+            name = filePath;
+            return;
+        }
+        parent = directoryKey(filePath.substr(0, separator == 0 ? 1 : separator));
+        name = filePath.substr(separator + 1);
+    }
+
+    template <typename T>
+    void writeValue(std::ofstream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeString(std::ofstream& out, const std::string& text) {
+        writeValue(out, static_cast<uint32_t>(text.size()));
+        out.write(text.data(), text.size());
+    }
+
+    template <typename T>
+    bool readValue(std::ifstream& in, T& value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    }
+
+    bool readString(std::ifstream& in, std::string& text) {
+        uint32_t length;
+        if (!readValue(in, length) || length > MAX_STRING_LENGTH) return false;
+        text.resize(length);
+        return static_cast<bool>(in.read(&text[0], length));
+    }
+}
+
+IncrementalScanState::IncrementalScanState(const std::string& rootPath, const std::string& engineVersion)
+    : rootPath(directoryKey(rootPath)), engineVersion(engineVersion), fullPassTime(0),
+      fullPass(true), pruned(0) {}
+
+std::string IncrementalScanState::statePathFor(const std::string& rootPath) {
+    std::string key = directoryKey(rootPath);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.state",
+                  static_cast<unsigned long long>(fnv1a(key.data(), key.size())));
+    return Config::SCAN_STATE_PATH + name;
+}
+
+bool IncrementalScanState::load(const std::string& statePath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    previous.clear();
+    fullPassTime = 0;
+
+    try {
+        std::ifstream in(statePath, std::ios::binary);
+        if (!in) return false;
+
+        char magic[sizeof(MAGIC)];
+        uint32_t version;
+        std::string root, engine;
+        int64_t passTime;
+        uint32_t directoryCount;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            !readValue(in, version) || version != STATE_VERSION ||
+            !readString(in, root) || !readString(in, engine) ||
+            !readValue(in, passTime) || !readValue(in, directoryCount)) {
+            Logger::logWarning("Ignoring unreadable scan state: " + statePath);
+            return false;
+        }
+        if (root != rootPath || engine != engineVersion) {
+            Logger::logInfo("Signatures changed since the last scan of " + rootPath + ", running a full pass");
+            return false;
+        }
+
+        std::unordered_map<std::string, DirectoryRecord> loaded;
+        for (uint32_t i = 0; i < directoryCount; i++) {
+            std::string path;
+            DirectoryRecord record;
+            uint8_t clean;
+            uint32_t subdirectoryCount, fileCount;
+            if (!readString(in, path) || !readValue(in, record.stamp) || !readValue(in, clean) ||
+                !readValue(in, subdirectoryCount)) {
+                return false;
+            }
+            record.clean = clean != 0;
+            record.subdirectories.resize(subdirectoryCount);
+            for (auto& name : record.subdirectories) {
+                if (!readString(in, name)) return false;
+            }
+            if (!readValue(in, fileCount)) return false;
+            record.files.resize(fileCount);
+            if (fileCount > 0 && !in.read(reinterpret_cast<char*>(record.files.data()),
+                                          fileCount * sizeof(FileRecord))) {
+                return false;
+            }
+            loaded.emplace(std::move(path), std::move(record));
+        }
+
+        previous = std::move(loaded);
+        fullPassTime = passTime;
+        return true;
+    } catch (const std::exception& e) {
+        Logger::logError("Error loading scan state: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool IncrementalScanState::save(const std::string& statePath, bool passCompleted) {
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+        if (!passCompleted) {
+            current.insert(previous.begin(), previous.end());
+        }
+        if (fullPass && passCompleted) {
+            fullPassTime = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        std::filesystem::create_directories(std::filesystem::path(statePath).parent_path());
+        std::string tempPath = statePath + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(MAGIC, sizeof(MAGIC));
+            writeValue(out, STATE_VERSION);
+            writeString(out, rootPath);
+            writeString(out, engineVersion);
+            writeValue(out, fullPassTime);
+            writeValue(out, static_cast<uint32_t>(current.size()));
+            for (const auto& [path, record] : current) {
+                writeString(out, path);
+                writeValue(out, record.stamp);
+                writeValue(out, static_cast<uint8_t>(record.clean));
+                writeValue(out, static_cast<uint32_t>(record.subdirectories.size()));
+                for (const auto& name : record.subdirectories) {
+                    writeString(out, name);
+                }
+                writeValue(out, static_cast<uint32_t>(record.files.size()));
+                out.write(reinterpret_cast<const char*>(record.files.data()),
+                          record.files.size() * sizeof(FileRecord));
+            }
+            if (!out) {
+                Logger::logError("Error writing scan state: " + tempPath);
+                return false;
+            }
+        }
+        std::filesystem::rename(tempPath, statePath);
+
+        previous = std::move(current);
+        current.clear();
+        return true;
+    } catch (const std::exception& e) {
+        Logger::logError("Error saving scan state: " + std::string(e.what()));
+        return false;
+    }
+}
+
+void IncrementalScanState::beginPass(bool full) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fullPass = full;
+    current.clear();
+    pending.clear();
+    pruned = 0;
+}
+
+bool IncrementalScanState::unchanged(const FileHandle& file) const {
+    if (fullPass) return false;
+
+    std::string parent, name;
+    splitPath(file.path(), parent, name);
+    uint64_t nameHash = fnv1a(name.data(), name.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = previous.find(parent);
+    if (it == previous.end()) return false;
+
+    const auto& files = it->second.files;
+    auto match = std::lower_bound(files.begin(), files.end(), nameHash,
+                                  [](const FileRecord& record, uint64_t hash) { return record.nameHash < hash; });
+    for (; match != files.end() && match->nameHash == nameHash; ++match) {
+        if (match->inode == file.inode() && match->size == file.size() &&
+            match->mtime == file.modifiedTime() && match->ctime == file.changeTime()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IncrementalScanState::recordFile(const FileHandle& file, bool clean) {
+    std::string parent, name;
+    splitPath(file.path(), parent, name);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    PendingDirectory& directory = pending[parent];
+    if (!clean) {
+        directory.dirty = true;
+        return;
+    }
+    directory.files.push_back({fnv1a(name.data(), name.size()), file.inode(), file.size(),
+                               file.modifiedTime(), file.changeTime()});
+}
+
+bool IncrementalScanState::skipDirectory(const std::string& path, const DirectoryStamp& stamp,
+                                         std::vector<std::string>& subdirectories) {
+    if (fullPass) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string key = directoryKey(path);
+    auto it = previous.find(key);
+    if (it == previous.end() || !it->second.clean || !(it->second.stamp == stamp)) return false;
+
+    subdirectories = it->second.subdirectories;
+    current[key] = it->second;
+    pruned++;
+    return true;
+}
+
+void IncrementalScanState::directoryListed(const std::string& path, const DirectoryStamp& stamp,
+                                           const std::vector<std::string>& subdirectories, bool complete) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string key = directoryKey(path);
+
+    DirectoryRecord record{stamp, false, subdirectories, {}};
+    auto it = pending.find(key);
+    if (it != pending.end()) {
+        record.files = std::move(it->second.files);
+        record.clean = complete && !it->second.dirty;
+        pending.erase(it);
+    } else {
+        record.clean = complete;
+    }
+    std::sort(record.files.begin(), record.files.end(),
+              [](const FileRecord& a, const FileRecord& b) { return a.nameHash < b.nameHash; });
+    current[key] = std::move(record);
+}
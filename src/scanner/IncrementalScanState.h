@@ -0,0 +1,82 @@
+#ifndef INCREMENTAL_SCAN_STATE_H
+#define INCREMENTAL_SCAN_STATE_H
+
+#include "DirectoryWalker.h"
+#include "../utils/FileHandle.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What the last scan pass of a tree saw: a stamp and the subdirectory names
+// for every directory, and a metadata summary for every file found clean.
+//
+// A directory whose stamp is unchanged and whose files were all clean is not
+// listed again; the walk goes straight to its known subdirectories. Inside a
+// directory that did change, files with unchanged metadata are not rescanned.
+// A file rewritten in place leaves its directory stamp alone, so it is only
+// picked up by the next full pass (or by real-time protection). Full passes
+// also run whenever the signature databases change.
+class IncrementalScanState : public DirectoryFilter {
+public:
+    IncrementalScanState(const std::string& rootPath, const std::string& engineVersion);
+
+    // Where the state for a scan root is kept
+    static std::string statePathFor(const std::string& rootPath);
+
+    // State from another root or engine version is discarded
+    bool load(const std::string& statePath);
+    // An incomplete pass keeps what it did not reach from the previous pass
+    bool save(const std::string& statePath, bool passCompleted);
+
+    // A full pass trusts nothing recorded earlier
+    void beginPass(bool full);
+    bool isFullPass() const { return fullPass; }
+    int64_t lastFullPassTime() const { return fullPassTime; }
+
+    // True if the file matches a clean record from the previous pass
+    bool unchanged(const FileHandle& file) const;
+    void recordFile(const FileHandle& file, bool clean);
+
+    size_t prunedDirectories() const { return pruned.load(); }
+
+    bool skipDirectory(const std::string& path, const DirectoryStamp& stamp,
+                       std::vector<std::string>& subdirectories) override;
+    void directoryListed(const std::string& path, const DirectoryStamp& stamp,
+                         const std::vector<std::string>& subdirectories, bool complete) override;
+
+private:
+    struct FileRecord {
+        uint64_t nameHash;
+        uint64_t inode;
+        uint64_t size;
+        int64_t mtime;
+        int64_t ctime;
+    };
+
+    struct DirectoryRecord {
+        DirectoryStamp stamp;
+        bool clean;
+        std::vector<std::string> subdirectories;
+        std::vector<FileRecord> files;      // Sorted by nameHash
+    };
+
+    struct PendingDirectory {
+        std::vector<FileRecord> files;
+        bool dirty = false;
+    };
+
+    std::string rootPath;
+    std::string engineVersion;
+    int64_t fullPassTime;
+    bool fullPass;
+    std::unordered_map<std::string, DirectoryRecord> previous;
+    std::unordered_map<std::string, DirectoryRecord> current;
+    std::unordered_map<std::string, PendingDirectory> pending;
+    mutable std::mutex mutex;
+    std::atomic<size_t> pruned;
+};
+
+#endif // INCREMENTAL_SCAN_STATE_H
@@ -0,0 +1,108 @@
+#include "PESignatureIndex.h"
+#include "EngineSnapshot.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+PESignatureIndex::PESignatureIndex(const std::string& dbPath, std::shared_ptr<const EngineSnapshot> snapshot)
+    : snapshot(std::move(snapshot)), dbPath(dbPath) {
+    if (this->snapshot) {
+        Logger::logInfo("Loaded " + std::to_string(this->snapshot->peSignatureCount()) +
+                        " PE signatures from engine snapshot");
+        return;
+    }
+    load();
+}
+
+void PESignatureIndex::load() {
+    std::lock_guard<std::mutex> lock(mutex);
+    importHashes.clear();
+    sectionHashes.clear();
+
+    try {
+        if (!std::filesystem::exists(dbPath)) return;
+
+        std::ifstream file(dbPath);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            if (line.back() == '\r') line.pop_back();
+
+            size_t colon = line.find(':');
+            size_t tab = line.find('\t');
+            if (colon == std::string::npos || (tab != std::string::npos && tab < colon)) continue;
+
+            std::string kind = line.substr(0, colon);
+            std::string hash = line.substr(colon + 1, tab == std::string::npos ? std::string::npos : tab - colon - 1);
+            std::string family = tab == std::string::npos ? "unnamed" : line.substr(tab + 1);
+            std::transform(hash.begin(), hash.end(), hash.begin(), ::tolower);
+
+            if (kind == "imphash") {
+                importHashes[hash] = family;
+            } else if (kind == "section") {
+                sectionHashes[hash] = family;
+            }
+        }
+
+        Logger::logInfo("Loaded " + std::to_string(importHashes.size()) + " import hashes and " +
+                        std::to_string(sectionHashes.size()) + " section hashes");
+    } catch (const std::exception& e) {
+        Logger::logError("Error loading PE signatures: " + std::string(e.what()));
+    }
+}
+
+std::optional<std::string> PESignatureIndex::findImportHash(const std::string& imphash) const {
+    if (imphash.empty()) return std::nullopt;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = importHashes.find(imphash);
+    if (it != importHashes.end()) return it->second;
+    return snapshot ? snapshot->findImportHash(imphash) : std::nullopt;
+}
+
+std::optional<std::string> PESignatureIndex::findSection(const std::vector<std::string>& hashes) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& hash : hashes) {
+        if (hash.empty()) continue;
+        auto it = sectionHashes.find(hash);
+        if (it != sectionHashes.end()) return it->second;
+        if (snapshot) {
+            auto family = snapshot->findSectionHash(hash);
+            if (family) return family;
+        }
+    }
+    return std::nullopt;
+}
+
+bool PESignatureIndex::addImportHash(const std::string& imphash, const std::string& family) {
+    if (!append("imphash", imphash, family)) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    importHashes[imphash] = family;
+    return true;
+}
+
+bool PESignatureIndex::addSectionHash(const std::string& sectionHash, const std::string& family) {
+    if (!append("section", sectionHash, family)) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    sectionHashes[sectionHash] = family;
+    return true;
+}
+
+bool PESignatureIndex::append(const std::string& kind, const std::string& hash, const std::string& family) {
+    if (hash.empty()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream file(dbPath, std::ios::app);
+    file << kind << ':' << hash << '\t' << family << '\n';
+    if (!file) {
+        Logger::logError("Error saving PE signature to: " + dbPath);
+        return false;
+    }
+    return true;
+}
+
+size_t PESignatureIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return importHashes.size() + sectionHashes.size() + (snapshot ? snapshot->peSignatureCount() : 0);
+}
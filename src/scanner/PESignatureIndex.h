@@ -0,0 +1,45 @@
+#ifndef PE_SIGNATURE_INDEX_H
+#define PE_SIGNATURE_INDEX_H
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class EngineSnapshot;
+
+// Family-level signatures for PE files: import hashes and raw section MD5s.
+// Repacking changes the whole-file hash, but a family usually keeps its
+// import table and often several sections byte for byte.
+//
+// File format, one signature per line:
+//   imphash:<md5>\t<family>
+//   section:<md5>\t<family>
+class PESignatureIndex {
+public:
+    explicit PESignatureIndex(const std::string& dbPath, std::shared_ptr<const EngineSnapshot> snapshot = nullptr);
+
+    std::optional<std::string> findImportHash(const std::string& imphash) const;
+    // Family of the first section that matches a known section hash
+    std::optional<std::string> findSection(const std::vector<std::string>& sectionHashes) const;
+
+    bool addImportHash(const std::string& imphash, const std::string& family);
+    bool addSectionHash(const std::string& sectionHash, const std::string& family);
+    size_t size() const;
+
+private:
+    friend class EngineSnapshot;
+
+    std::unordered_map<std::string, std::string> importHashes;
+    std::unordered_map<std::string, std::string> sectionHashes;
+    std::shared_ptr<const EngineSnapshot> snapshot;
+    mutable std::mutex mutex;
+    std::string dbPath;
+
+    void load();
+    bool append(const std::string& kind, const std::string& hash, const std::string& family);
+};
+
+#endif // PE_SIGNATURE_INDEX_H
@@ -0,0 +1,367 @@
+#include "ProcessMemoryScanner.h"
+
+#ifdef __linux__
+
+#include "../utils/Logger.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    const uint64_t PAGEMAP_SOFT_DIRTY = 1ULL << 55;
+
+    std::vector<pid_t> listProcesses() {
+        std::vector<pid_t> pids;
+        DIR* proc = opendir("/proc");
+        if (!proc) return pids;
+
+        while (dirent* entry = readdir(proc)) {
+            char* end = nullptr;
+            long pid = std::strtol(entry->d_name, &end, 10);
+            if (*end == '\0' && pid > 0 && pid != getpid()) {
+                pids.push_back(static_cast<pid_t>(pid));
+            }
+        }
+        closedir(proc);
+        return pids;
+    }
+
+    // Kernels built without CONFIG_MEM_SOFT_DIRTY accept clear_refs but never
+    // set the bit, which would make every region look untouched. A page this
+    // process has just written is soft-dirty wherever tracking works.
+    bool softDirtySupported() {
+        static const bool supported = []() {
+            const long pageSize = sysconf(_SC_PAGESIZE);
+            void* page = mmap(nullptr, static_cast<size_t>(pageSize), PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (page == MAP_FAILED) return false;
+            *static_cast<volatile char*>(page) = 1;
+
+            uint64_t entry = 0;
+            int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                off_t offset = static_cast<off_t>(reinterpret_cast<uintptr_t>(page) / pageSize * sizeof(uint64_t));
+                if (pread(fd, &entry, sizeof(entry), offset) != sizeof(entry)) entry = 0;
+                close(fd);
+            }
+            munmap(page, static_cast<size_t>(pageSize));
+            return (entry & PAGEMAP_SOFT_DIRTY) != 0;
+        }();
+        return supported;
+    }
+
+    std::string processName(pid_t pid) {
+        std::ifstream comm("/proc/" + std::to_string(pid) + "/comm");
+        std::string name;
+        std::getline(comm, name);
+        return name;
+    }
+}
+
+ProcessMemoryScanner::ProcessMemoryScanner(int threads) : threads(std::max(1, threads)) {}
+
+ProcessMemoryScanner::~ProcessMemoryScanner() {
+    stopSweeping();
+}
+
+void ProcessMemoryScanner::startSweeping(std::chrono::seconds interval) {
+    if (sweeping.exchange(true)) return;
+    cancelSweep.reset();
+    sweepThread = std::thread(&ProcessMemoryScanner::sweepLoop, this, interval);
+    Logger::logInfo("Memory sweeps started");
+}
+
+void ProcessMemoryScanner::stopSweeping() {
+    if (!sweeping.exchange(false)) return;
+    cancelSweep.cancel();
+    {
+        std::lock_guard<std::mutex> lock(sweepMutex);
+    }
+    wake.notify_all();
+    if (sweepThread.joinable()) {
+        sweepThread.join();
+    }
+    cancelSweep.reset();
+    Logger::logInfo("Memory sweeps stopped");
+}
+
+void ProcessMemoryScanner::sweepLoop(std::chrono::seconds interval) {
+    while (sweeping) {
+        auto next = std::chrono::steady_clock::now() + interval;
+        try {
+            sweep();
+        } catch (const std::exception& e) {
+            Logger::logError("Memory sweep error: " + std::string(e.what()));
+        }
+
+        std::unique_lock<std::mutex> lock(sweepMutex);
+        wake.wait_until(lock, next, [this] { return !sweeping; });
+    }
+}
+
+std::vector<MemoryRegion> ProcessMemoryScanner::readMaps(pid_t pid) {
+    std::vector<MemoryRegion> regions;
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    std::string line;
+
+    while (std::getline(maps, line)) {
+        // start-end perms offset dev inode [path]
+        MemoryRegion region{};
+        std::istringstream fields(line);
+        std::string range, dev;
+        fields >> range >> region.perms >> std::hex >> region.offset >> dev >> std::dec >> region.inode;
+        if (!fields) continue;
+
+        size_t dash = range.find('-');
+        if (dash == std::string::npos) continue;
+        region.start = std::stoull(range.substr(0, dash), nullptr, 16);
+        region.end = std::stoull(range.substr(dash + 1), nullptr, 16);
+
+        std::getline(fields >> std::ws, region.path);
+        regions.push_back(std::move(region));
+    }
+    return regions;
+}
+
+bool ProcessMemoryScanner::shouldScan(const MemoryRegion& region) {
+    if (region.perms.size() < 3 || region.perms[0] != 'r') return false;
+    // Kernel-provided pages cannot be read and never hold injected code
+    if (region.path == "[vvar]" || region.path == "[vsyscall]" || region.path == "[vdso]") return false;
+
+    bool executable = region.perms[2] == 'x';
+    bool anonymous = region.inode == 0;
+    bool writable = region.perms[1] == 'w';
+    return executable || (anonymous && writable);
+}
+
+std::string ProcessMemoryScanner::regionKey(const MemoryRegion& region) {
+    return std::to_string(region.start) + "-" + std::to_string(region.end) + " " + region.perms +
+           " " + std::to_string(region.inode) + " " + std::to_string(region.offset);
+}
+
+uint64_t ProcessMemoryScanner::processStartTime(pid_t pid) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string content;
+    std::getline(stat, content);
+
+    // Field 22; the command name in field 2 may contain spaces, so count from its closing paren
+    size_t paren = content.rfind(')');
+    if (paren == std::string::npos) return 0;
+    std::istringstream fields(content.substr(paren + 2));
+    std::string field;
+    for (int i = 3; i <= 22 && fields >> field; i++) {
+        if (i == 22) return std::stoull(field);
+    }
+    return 0;
+}
+
+bool ProcessMemoryScanner::clearSoftDirty(pid_t pid) {
+    if (!softDirtySupported()) return false;
+    int fd = open(("/proc/" + std::to_string(pid) + "/clear_refs").c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool cleared = write(fd, "4", 1) == 1;
+    close(fd);
+    return cleared;
+}
+
+bool ProcessMemoryScanner::regionUnchanged(int pagemap, const MemoryRegion& region,
+                                           const ProcessState& state) const {
+    if (state.cleanRegions.find(regionKey(region)) == state.cleanRegions.end()) return false;
+
+    // Other processes can write a shared mapping without touching this one's page tables
+    if (region.perms.size() < 4 || region.perms[3] != 'p') return false;
+    // ptrace and process_vm_writev write through the protection, and mprotect can
+    // restore the same permissions afterwards, so read-only pages need the check too
+    if (!state.softDirty || pagemap < 0) return false;
+
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t entries[512];
+    for (uint64_t page = region.start / pageSize; page < region.end / pageSize;) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(512, region.end / pageSize - page));
+        ssize_t got = pread(pagemap, entries, count * sizeof(uint64_t), static_cast<off_t>(page * sizeof(uint64_t)));
+        if (got <= 0) return false;
+
+        size_t read = static_cast<size_t>(got) / sizeof(uint64_t);
+        for (size_t i = 0; i < read; i++) {
+            if (entries[i] & PAGEMAP_SOFT_DIRTY) return false;
+        }
+        page += read;
+    }
+    return true;
+}
+
+bool ProcessMemoryScanner::scanRegion(pid_t pid, const MemoryRegion& region,
+                                      std::vector<unsigned char>& buffer) {
+    Utils::PatternScanner scanner(Utils::shellcodePatterns());
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+    uint64_t address = region.start;
+    while (address < region.end && !ScanBudget::threadExhausted()) {
+        size_t toRead = static_cast<size_t>(std::min<uint64_t>(buffer.size(), region.end - address));
+        iovec local{buffer.data(), toRead};
+        iovec remote{reinterpret_cast<void*>(address), toRead};
+        ssize_t got = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+
+        if (got < 0) {
+            // The process exited or we lack ptrace access; no point trying further pages
+            if (errno == ESRCH || errno == EPERM) return false;
+            // An unreadable page: skip it, the scanner drops its carry-over on the gap
+            address = (address / pageSize + 1) * pageSize;
+            continue;
+        }
+        if (got == 0) break;
+
+        bytesRead += static_cast<uint64_t>(got);
+        if (scanner.update(buffer.data(), static_cast<size_t>(got), address)) {
+            return true;
+        }
+        address += static_cast<uint64_t>(got);
+    }
+    return false;
+}
+
+bool ProcessMemoryScanner::scanProcess(pid_t pid, ProcessState& state, MemoryFinding* finding) {
+    uint64_t startTime = processStartTime(pid);
+    if (startTime == 0) return false;
+
+    // A reused PID is a different process
+    if (state.startTime != startTime) {
+        state = ProcessState();
+        state.startTime = startTime;
+    }
+
+    std::vector<MemoryRegion> regions = readMaps(pid);
+    std::vector<unsigned char> buffer(Config::SCAN_CHUNK_SIZE);
+    std::unordered_set<std::string> clean;
+    std::vector<const MemoryRegion*> changed;
+
+    // Soft-dirty bits must be read before they are cleared, or every region looks untouched
+    int pagemap = state.softDirty
+        ? open(("/proc/" + std::to_string(pid) + "/pagemap").c_str(), O_RDONLY | O_CLOEXEC)
+        : -1;
+    for (const auto& region : regions) {
+        if (!shouldScan(region)) continue;
+        if (regionUnchanged(pagemap, region, state)) {
+            regionsSkipped++;
+            clean.insert(regionKey(region));
+        } else {
+            changed.push_back(&region);
+        }
+    }
+    if (pagemap >= 0) close(pagemap);
+
+    // Clear before scanning so that any write racing with the scan is seen next sweep
+    bool softDirty = clearSoftDirty(pid);
+
+    for (const MemoryRegion* region : changed) {
+        regionsScanned++;
+        if (scanRegion(pid, *region, buffer)) {
+            if (finding) *finding = {pid, processName(pid), *region};
+            // Keep the region dirty so it is examined again next sweep
+            state.cleanRegions = std::move(clean);
+            state.softDirty = softDirty;
+            return true;
+        }
+        // A region cut short by the scan budget is not known to be clean
+        if (ScanBudget::threadExhausted()) break;
+        clean.insert(regionKey(*region));
+    }
+
+    state.cleanRegions = std::move(clean);
+    state.softDirty = softDirty;
+    return false;
+}
+
+bool ProcessMemoryScanner::scanProcess(pid_t pid, MemoryFinding* finding) {
+    ProcessState state;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = states.find(pid);
+        if (it != states.end()) state = std::move(it->second);
+    }
+
+    bool suspicious = scanProcess(pid, state, finding);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    states[pid] = std::move(state);
+    return suspicious;
+}
+
+void ProcessMemoryScanner::forget(pid_t pid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    states.erase(pid);
+}
+
+size_t ProcessMemoryScanner::trackedProcesses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return states.size();
+}
+
+std::vector<MemoryFinding> ProcessMemoryScanner::sweep() {
+    std::vector<pid_t> pids = listProcesses();
+    std::vector<MemoryFinding> findings;
+    std::mutex findingsMutex;
+    std::atomic<size_t> next{0};
+
+    regionsScanned = 0;
+    regionsSkipped = 0;
+    bytesRead = 0;
+
+    auto worker = [&]() {
+        // Unlimited, but stopSweeping can cut it short
+        ScanBudget budget(std::chrono::milliseconds(0), &cancelSweep);
+        ScanBudget::Scope scope(budget);
+        for (size_t i = next++; i < pids.size() && !ScanBudget::threadExhausted(); i = next++) {
+            MemoryFinding finding;
+            try {
+                if (scanProcess(pids[i], &finding)) {
+                    Logger::logWarning("Suspicious code in process " + std::to_string(finding.pid) + " (" +
+                                       finding.processName + ") at " + regionKey(finding.region) + " " +
+                                       finding.region.path);
+                    std::lock_guard<std::mutex> lock(findingsMutex);
+                    findings.push_back(std::move(finding));
+                }
+            } catch (const std::exception& e) {
+                Logger::logError("Error scanning process " + std::to_string(pids[i]) + ": " + e.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Forget processes that have exited
+    std::unordered_set<pid_t> alive(pids.begin(), pids.end());
+    for (auto it = states.begin(); it != states.end();) {
+        it = alive.count(it->first) ? std::next(it) : states.erase(it);
+    }
+
+    lastStats = {pids.size(), regionsScanned.load(), regionsSkipped.load(), bytesRead.load()};
+    Logger::logInfo("Memory sweep: " + std::to_string(lastStats.processes) + " processes, " +
+                    std::to_string(lastStats.regionsScanned) + " regions scanned, " +
+                    std::to_string(lastStats.regionsSkipped) + " unchanged");
+    return findings;
+}
+
+MemorySweepStats ProcessMemoryScanner::getLastStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastStats;
+}
+
+#endif // __linux__
@@ -0,0 +1,105 @@
+#ifndef PROCESS_MEMORY_SCANNER_H
+#define PROCESS_MEMORY_SCANNER_H
+
+#ifdef __linux__
+
+#include "Config.h"
+#include "../utils/ScanBudget.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// One line of /proc/<pid>/maps
+struct MemoryRegion {
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+    uint64_t inode;
+    std::string perms;
+    std::string path;
+};
+
+struct MemoryFinding {
+    pid_t pid;
+    std::string processName;
+    MemoryRegion region;
+};
+
+struct MemorySweepStats {
+    size_t processes = 0;
+    size_t regionsScanned = 0;
+    size_t regionsSkipped = 0;
+    uint64_t bytesRead = 0;
+};
+
+// Linux counterpart of BehaviorAnalyzer::checkProcessMemory. Executable and
+// anonymous writable regions are read through process_vm_readv one chunk at
+// a time, so memory per worker stays at one chunk whatever the region size.
+//
+// Between sweeps a private region is skipped when its mapping is unchanged
+// and none of its pages has been written since the last scan, as tracked by
+// the kernel's soft-dirty bits. Shared regions, and every region where
+// soft-dirty tracking is unavailable, are scanned each sweep.
+class ProcessMemoryScanner {
+public:
+    explicit ProcessMemoryScanner(int threads = Config::SCAN_THREADS);
+    ~ProcessMemoryScanner();
+
+    // Scans every visible process in parallel and returns the flagged ones
+    std::vector<MemoryFinding> sweep();
+    bool scanProcess(pid_t pid, MemoryFinding* finding = nullptr);
+    // Drops what is known about an exited process
+    void forget(pid_t pid);
+    size_t trackedProcesses() const;
+
+    // Sweeps on a background thread, once right away and then every interval
+    void startSweeping(std::chrono::seconds interval);
+    void stopSweeping();
+
+    MemorySweepStats getLastStats() const;
+    static std::vector<MemoryRegion> readMaps(pid_t pid);
+    // Clock ticks after boot; 0 if the process is gone
+    static uint64_t processStartTime(pid_t pid);
+
+private:
+    struct ProcessState {
+        uint64_t startTime = 0;
+        bool softDirty = false;   // Soft-dirty bits were cleared after the last scan
+        std::unordered_set<std::string> cleanRegions;
+    };
+
+    int threads;
+    std::unordered_map<pid_t, ProcessState> states;
+    mutable std::mutex mutex;
+
+    std::atomic<size_t> regionsScanned{0};
+    std::atomic<size_t> regionsSkipped{0};
+    std::atomic<uint64_t> bytesRead{0};
+    MemorySweepStats lastStats;
+
+    std::atomic<bool> sweeping{false};
+    CancellationToken cancelSweep;     // Lets stopSweeping interrupt a sweep in progress
+    std::thread sweepThread;
+    std::mutex sweepMutex;
+    std::condition_variable wake;
+
+    void sweepLoop(std::chrono::seconds interval);
+    bool scanProcess(pid_t pid, ProcessState& state, MemoryFinding* finding);
+    bool scanRegion(pid_t pid, const MemoryRegion& region, std::vector<unsigned char>& buffer);
+    bool regionUnchanged(int pagemap, const MemoryRegion& region, const ProcessState& state) const;
+    static bool shouldScan(const MemoryRegion& region);
+    static std::string regionKey(const MemoryRegion& region);
+    static bool clearSoftDirty(pid_t pid);
+};
+
+#endif // __linux__
+
+#endif // PROCESS_MEMORY_SCANNER_H
@@ -0,0 +1,349 @@
+#include "ProcessMonitor.h"
+
+#ifdef __linux__
+
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+    std::string procPath(pid_t pid, const char* entry) {
+        return "/proc/" + std::to_string(pid) + "/" + entry;
+    }
+
+    std::string readExecutable(pid_t pid) {
+        char target[PATH_MAX];
+        ssize_t length = readlink(procPath(pid, "exe").c_str(), target, sizeof(target));
+        return length > 0 ? std::string(target, static_cast<size_t>(length)) : std::string();
+    }
+
+    uint64_t regionFingerprint(const MemoryRegion& region) {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (uint64_t value : {region.start, region.end, region.offset, region.inode}) {
+            hash = (hash ^ value) * 0x100000001B3ULL;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    bool listProcesses(std::vector<pid_t>& pids) {
+        DIR* proc = opendir("/proc");
+        if (!proc) return false;
+
+        pid_t self = getpid();
+        while (dirent* entry = readdir(proc)) {
+            char* end = nullptr;
+            long pid = std::strtol(entry->d_name, &end, 10);
+            if (*end == '\0' && pid > 0 && pid != self) {
+                pids.push_back(static_cast<pid_t>(pid));
+            }
+        }
+        closedir(proc);
+        return true;
+    }
+
+    // Keeping statm open for every process needs far more descriptors than
+    // the usual soft limit; take what the hard limit allows and use half
+    size_t raiseDescriptorLimit() {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return 0;
+        if (limit.rlim_cur < limit.rlim_max) {
+            rlimit raised = limit;
+            raised.rlim_cur = limit.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &raised) == 0) limit = raised;
+        }
+        if (limit.rlim_cur == RLIM_INFINITY) return 1u << 20;
+        return static_cast<size_t>(limit.rlim_cur / 2);
+    }
+}
+
+ProcessMonitor::ProcessMonitor(ProcessMemoryScanner* scanner, HookDetector* hooks)
+    : scanner(scanner),
+      hooks(hooks),
+      descriptorBudget(raiseDescriptorLimit()),
+      pageSize(static_cast<uint64_t>(sysconf(_SC_PAGESIZE))),
+      loadavgFd(open("/proc/loadavg", O_RDONLY | O_CLOEXEC)) {}
+
+ProcessMonitor::~ProcessMonitor() {
+    stopMonitoring();
+    for (auto& entry : processes) {
+        forget(entry.second);
+    }
+    if (loadavgFd >= 0) close(loadavgFd);
+}
+
+void ProcessMonitor::startMonitoring() {
+    if (running.exchange(true)) return;
+    cancelScans.reset();
+    monitorThread = std::thread(&ProcessMonitor::monitorLoop, this);
+    Logger::logInfo("Process monitoring started");
+}
+
+void ProcessMonitor::stopMonitoring() {
+    if (!running.exchange(false)) return;
+    cancelScans.cancel();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_all();
+    if (monitorThread.joinable()) {
+        monitorThread.join();
+    }
+    Logger::logInfo("Process monitoring stopped");
+}
+
+void ProcessMonitor::monitorLoop() {
+    while (running) {
+        auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(Config::MONITOR_INTERVAL_MS);
+        try {
+            poll();
+        } catch (const std::exception& e) {
+            Logger::logError("Process monitor error: " + std::string(e.what()));
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait_until(lock, next, [this] { return !running; });
+    }
+}
+
+std::vector<ProcessEvent> ProcessMonitor::poll() {
+    auto began = std::chrono::steady_clock::now();
+    std::vector<ProcessEvent> events;
+    ProcessPollStats stats;
+
+    bool baseline = generation == 0;
+    generation++;
+
+    // When no PID has been handed out since the last poll, the tracked set
+    // is already complete and listing /proc again can be skipped
+    long newestPid = lastAssignedPid();
+    bool listed = baseline || newestPid < 0 || newestPid != lastPid;
+
+    pids.clear();
+    if (listed) {
+        if (!listProcesses(pids)) {
+            Logger::logError("Cannot read /proc");
+            return events;
+        }
+        lastPid = newestPid;
+    } else {
+        for (const auto& entry : processes) {
+            pids.push_back(entry.first);
+        }
+    }
+
+    for (pid_t pid : pids) {
+        auto [it, inserted] = processes.try_emplace(pid);
+        TrackedProcess& process = it->second;
+        size_t eventsBefore = events.size();
+        Snapshot snapshot;
+
+        if (!inserted && !readSnapshot(pid, process, snapshot)) {
+            // Exited; unless listed, it is dropped below as unseen
+            if (!listed) continue;
+            // The process behind our descriptor exited; the PID may already be reused
+            forget(process);
+            if (scanner) scanner->forget(pid);
+            process = TrackedProcess();
+            inserted = true;
+        }
+
+        if (inserted) {
+            if (!track(pid, process) || !readSnapshot(pid, process, snapshot)) {
+                forget(process);
+                processes.erase(it);
+                continue;
+            }
+            process.snapshot = snapshot;
+            inspectAddressSpace(pid, process, events, false);
+            if (!baseline) events.push_back({pid, ProcessChange::Started, process.executable});
+        } else if (snapshot.size != process.snapshot.size || snapshot.text != process.snapshot.text) {
+            // Any mmap, munmap or exec changes the total size
+            inspectAddressSpace(pid, process, events, true);
+        }
+        process.generation = generation;
+        stats.processes++;
+
+        bool overLimit = snapshot.resident * pageSize > Config::MAX_PROCESS_MEMORY;
+        if (overLimit && !process.overLimit && !baseline) {
+            uint64_t residentBytes = snapshot.resident * pageSize;
+            Logger::logWarning("Process " + std::to_string(pid) + " resident memory reached " +
+                               std::to_string(residentBytes / (1024 * 1024)) + " MB");
+            events.push_back({pid, ProcessChange::MemoryLimit, process.executable});
+        }
+        process.overLimit = overLimit;
+        process.snapshot = snapshot;
+
+        if (events.size() > eventsBefore) stats.changed++;
+    }
+
+    // Forget processes that have exited
+    for (auto it = processes.begin(); it != processes.end();) {
+        if (it->second.generation != generation) {
+            forget(it->second);
+            if (scanner) scanner->forget(it->first);
+            it = processes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    analyze(events, stats);
+
+    stats.pollMicros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - began).count());
+    std::lock_guard<std::mutex> lock(statsMutex);
+    lastStats = stats;
+    return events;
+}
+
+long ProcessMonitor::lastAssignedPid() const {
+    if (loadavgFd < 0) return -1;
+    char text[128];
+    ssize_t got = pread(loadavgFd, text, sizeof(text) - 1, 0);
+    if (got <= 0) return -1;
+    text[got] = '\0';
+
+    // "0.10 0.20 0.30 2/345 6789": the last field is the most recent PID
+    const char* last = std::strrchr(text, ' ');
+    return last ? std::strtol(last + 1, nullptr, 10) : -1;
+}
+
+bool ProcessMonitor::track(pid_t pid, TrackedProcess& process) {
+    process.startTime = ProcessMemoryScanner::processStartTime(pid);
+    if (process.startTime == 0) return false;
+
+    if (openDescriptors < descriptorBudget) {
+        int fd = open(procPath(pid, "statm").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            process.statmFd = fd;
+            openDescriptors++;
+        }
+    }
+    return true;
+}
+
+bool ProcessMonitor::readSnapshot(pid_t pid, TrackedProcess& process, Snapshot& snapshot) const {
+    char text[128];
+    ssize_t got;
+    if (process.statmFd >= 0) {
+        // Reads fail with ESRCH once the process is gone, even if the PID is reused
+        got = pread(process.statmFd, text, sizeof(text) - 1, 0);
+    } else {
+        // Without a descriptor of our own, a reused PID shows up as a new start time
+        if (process.generation != 0 && ProcessMemoryScanner::processStartTime(pid) != process.startTime) {
+            return false;
+        }
+        int fd = open(procPath(pid, "statm").c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        got = pread(fd, text, sizeof(text) - 1, 0);
+        close(fd);
+    }
+    if (got <= 0) return false;
+    text[got] = '\0';
+
+    // size resident shared text lib data dt
+    unsigned long long size, resident, shared, code;
+    if (std::sscanf(text, "%llu %llu %llu %llu", &size, &resident, &shared, &code) != 4) return false;
+    snapshot.size = size;
+    snapshot.resident = resident;
+    snapshot.text = code;
+    return true;
+}
+
+void ProcessMonitor::inspectAddressSpace(pid_t pid, TrackedProcess& process,
+                                         std::vector<ProcessEvent>& events, bool report) {
+    std::string executable = readExecutable(pid);
+    // A zombie has no image left; it is about to disappear from /proc
+    if (report && executable.empty()) return;
+    bool executed = report && executable != process.executable;
+    if (executed) {
+        events.push_back({pid, ProcessChange::Executed, executable});
+    }
+
+    std::vector<MemoryRegion> regions = ProcessMemoryScanner::readMaps(pid);
+    std::vector<uint64_t> fingerprints;
+    for (const auto& region : regions) {
+        if (region.perms.size() < 3 || region.perms[2] != 'x') continue;
+        uint64_t fingerprint = regionFingerprint(region);
+        fingerprints.push_back(fingerprint);
+
+        // After an exec every mapping is new; the exec event covers them
+        if (report && !executed &&
+            !std::binary_search(process.executableRegions.begin(), process.executableRegions.end(), fingerprint)) {
+            events.push_back({pid, ProcessChange::ExecutableMapping,
+                              region.path.empty() ? "[anonymous]" : region.path});
+        }
+    }
+    std::sort(fingerprints.begin(), fingerprints.end());
+
+    process.executable = std::move(executable);
+    process.executableRegions = std::move(fingerprints);
+}
+
+void ProcessMonitor::forget(TrackedProcess& process) {
+    if (process.statmFd >= 0) {
+        close(process.statmFd);
+        process.statmFd = -1;
+        openDescriptors--;
+    }
+}
+
+void ProcessMonitor::analyze(const std::vector<ProcessEvent>& events, ProcessPollStats& stats) {
+    if (!scanner && !hooks) return;
+
+    // Events arrive grouped by process; queue each changed process once
+    for (const auto& event : events) {
+        bool codeChanged = event.change != ProcessChange::MemoryLimit;
+        auto queued = backlogged.find(event.pid);
+        if (queued != backlogged.end()) {
+            queued->second = queued->second || codeChanged;
+            continue;
+        }
+        if (backlog.size() >= Config::MONITOR_ANALYSIS_BACKLOG) break;
+        backlogged.emplace(event.pid, codeChanged);
+        backlog.push_back(event.pid);
+    }
+
+    // One budget for the whole poll; a process it cuts short is left to the next sweep
+    ScanBudget budget(std::chrono::milliseconds(Config::MONITOR_ANALYSIS_BUDGET_MS), &cancelScans);
+    ScanBudget::Scope scope(budget);
+    while (!backlog.empty() && !ScanBudget::threadExhausted()) {
+        pid_t pid = backlog.front();
+        backlog.pop_front();
+        bool codeChanged = backlogged[pid];
+        backlogged.erase(pid);
+
+        try {
+            stats.analyzed++;
+            bool flagged = false;
+            MemoryFinding finding;
+            if (scanner && scanner->scanProcess(pid, &finding)) {
+                flagged = true;
+                Logger::logWarning("Suspicious code in process " + std::to_string(finding.pid) + " (" +
+                                   finding.processName + ") at " + finding.region.path + " after change");
+            }
+            // checkProcess logs each hooked export itself
+            if (hooks && codeChanged && !hooks->checkProcess(pid).empty()) flagged = true;
+            if (flagged) stats.flagged++;
+        } catch (const std::exception& e) {
+            Logger::logError("Error analyzing process " + std::to_string(pid) + ": " + e.what());
+        }
+    }
+    stats.backlog = backlog.size();
+}
+
+ProcessPollStats ProcessMonitor::getLastStats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return lastStats;
+}
+
+#endif // __linux__
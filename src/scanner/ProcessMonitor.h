@@ -0,0 +1,123 @@
+#ifndef PROCESS_MONITOR_H
+#define PROCESS_MONITOR_H
+
+#ifdef __linux__
+
+#include "HookDetector.h"
+#include "ProcessMemoryScanner.h"
+#include "../utils/ScanBudget.h"
+#include "Config.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class ProcessChange {
+    Started,
+    Executed,           // exec() replaced the program image
+    MemoryLimit,        // Resident set grew past MAX_PROCESS_MEMORY
+    ExecutableMapping   // A new executable region was mapped
+};
+
+struct ProcessEvent {
+    pid_t pid;
+    ProcessChange change;
+    std::string detail;     // Executable or mapping path
+};
+
+struct ProcessPollStats {
+    size_t processes = 0;
+    size_t changed = 0;
+    size_t analyzed = 0;
+    size_t flagged = 0;
+    size_t backlog = 0;         // Changed processes left for later polls
+    uint64_t pollMicros = 0;
+};
+
+// Polls /proc every MONITOR_INTERVAL_MS and diffs each process against the
+// previous snapshot, handing only changed processes to the memory scanner
+// when one is given. Processes that started, exec'd or mapped new code also
+// have their libraries' exports checked for inline hooks. Analysis runs on the polling thread, so each poll
+// spends at most MONITOR_ANALYSIS_BUDGET_MS on it and leaves the remaining
+// changed processes queued for the next poll.
+//
+// The steady-state cost is one pread of /proc/<pid>/statm per process on a
+// descriptor kept open between polls; /proc itself is only listed again when
+// /proc/loadavg shows a new PID was assigned. The maps and exe link, which
+// are far more expensive, are only read when statm shows the address space
+// changed.
+// Processes already running at the first poll form the baseline and are
+// left to the scanner's periodic sweeps (ProcessMemoryScanner::startSweeping).
+class ProcessMonitor {
+public:
+    // Without a scanner or hook detector, changes are only reported
+    explicit ProcessMonitor(ProcessMemoryScanner* scanner = nullptr, HookDetector* hooks = nullptr);
+    ~ProcessMonitor();
+
+    ProcessMonitor(const ProcessMonitor&) = delete;
+    ProcessMonitor& operator=(const ProcessMonitor&) = delete;
+
+    void startMonitoring();
+    void stopMonitoring();
+
+    // One diff against the previous snapshot; the monitor thread calls this
+    // every interval, so only use it directly when the monitor is not running
+    std::vector<ProcessEvent> poll();
+    ProcessPollStats getLastStats() const;
+
+private:
+    struct Snapshot {
+        uint64_t size = 0;          // statm fields, in pages
+        uint64_t resident = 0;
+        uint64_t text = 0;
+    };
+
+    struct TrackedProcess {
+        int statmFd = -1;           // -1 once the descriptor budget is spent
+        uint64_t startTime = 0;
+        uint64_t generation = 0;    // Last poll that saw the process
+        Snapshot snapshot;
+        std::string executable;
+        std::vector<uint64_t> executableRegions;    // Sorted region fingerprints
+        bool overLimit = false;
+    };
+
+    ProcessMemoryScanner* scanner;
+    HookDetector* hooks;
+    std::unordered_map<pid_t, TrackedProcess> processes;
+    std::deque<pid_t> backlog;      // Changed processes not analyzed yet, oldest first
+    std::unordered_map<pid_t, bool> backlogged;    // Whether the process's code changed
+    uint64_t generation = 0;
+    std::vector<pid_t> pids;        // Reused between polls
+    size_t openDescriptors = 0;
+    size_t descriptorBudget;
+    uint64_t pageSize;
+    int loadavgFd;
+    long lastPid = -1;
+
+    std::atomic<bool> running{false};
+    CancellationToken cancelScans;     // Lets stopMonitoring interrupt an analysis in progress
+    std::thread monitorThread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    mutable std::mutex statsMutex;
+    ProcessPollStats lastStats;
+
+    void monitorLoop();
+    long lastAssignedPid() const;
+    bool track(pid_t pid, TrackedProcess& process);
+    bool readSnapshot(pid_t pid, TrackedProcess& process, Snapshot& snapshot) const;
+    void inspectAddressSpace(pid_t pid, TrackedProcess& process, std::vector<ProcessEvent>& events, bool report);
+    void forget(TrackedProcess& process);
+    void analyze(const std::vector<ProcessEvent>& events, ProcessPollStats& stats);
+};
+
+#endif // __linux__
+
+#endif // PROCESS_MONITOR_H
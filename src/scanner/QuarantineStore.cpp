@@ -0,0 +1,467 @@
+#include "QuarantineStore.h"
+#include "../utils/HashUtil.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <sstream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    const char* const INDEX_FILE = "index.db";
+    const char* const STAGING_DIR = "staging";
+    const char* const LEGACY_MONITOR_DIR = ".quarantine";
+    const std::string LEGACY_EXTENSION = ".quarantine";
+
+    // Index fields are tab separated, so tabs and newlines in paths are escaped
+    std::string escapeField(const std::string& value) {
+        std::string result;
+        result.reserve(value.size());
+        for (char c : value) {
+            switch (c) {
+                case '\\': result += "\\\\"; break;
+                case '\t': result += "\\t"; break;
+                case '\n': result += "\\n"; break;
+                default: result += c;
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::string> splitRecord(const std::string& line) {
+        std::vector<std::string> fields(1);
+        for (size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (c == '\t') {
+                fields.emplace_back();
+            } else if (c == '\\' && i + 1 < line.size()) {
+                char next = line[++i];
+                fields.back() += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+            } else {
+                fields.back() += c;
+            }
+        }
+        return fields;
+    }
+}
+
+QuarantineStore::QuarantineStore(const std::string& rootPath)
+    : rootPath(rootPath),
+      objectsPath((fs::path(rootPath) / "objects").string()),
+      stagingPath((fs::path(rootPath) / STAGING_DIR).string()),
+      indexPath((fs::path(rootPath) / INDEX_FILE).string()) {
+    std::error_code ec;
+    fs::create_directories(objectsPath, ec);
+    if (!ec) fs::create_directories(stagingPath, ec);
+    if (ec) {
+        Logger::logError("Cannot create quarantine store: " + rootPath);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    loadIndex();
+    recoverStagedFiles();
+    importLegacyFiles();
+}
+
+void QuarantineStore::loadIndex() {
+    size_t removals = 0;
+    std::ifstream index(indexPath);
+    std::string line;
+
+    while (std::getline(index, line)) {
+        auto fields = splitRecord(line);
+        try {
+            if (fields[0] == "+" && fields.size() == 6) {
+                QuarantineEntry entry{fields[1], fields[2], fields[5], fields[4], std::stoll(fields[3])};
+                objectRefs[entry.digest]++;
+                entries[entry.id] = std::move(entry);
+            } else if (fields[0] == "-" && fields.size() == 2) {
+                auto it = entries.find(fields[1]);
+                if (it != entries.end()) {
+                    if (--objectRefs[it->second.digest] == 0) objectRefs.erase(it->second.digest);
+                    entries.erase(it);
+                }
+                removals++;
+            } else if (!line.empty()) {
+                Logger::logWarning("Ignoring malformed quarantine index record");
+            }
+        } catch (const std::exception&) {
+            Logger::logWarning("Ignoring malformed quarantine index record");
+        }
+    }
+    index.close();
+
+    // Rewrite the journal once restores start to dominate it
+    if (removals > 0 && removals >= entries.size()) {
+        compactIndex();
+    }
+
+    journal.open(indexPath, std::ios::app);
+    if (!journal) {
+        Logger::logError("Cannot open quarantine index: " + indexPath);
+    }
+}
+
+void QuarantineStore::compactIndex() {
+    std::string tempPath = indexPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        for (const auto& [id, entry] : entries) {
+            out << "+\t" << escapeField(entry.id) << '\t' << entry.digest << '\t' << entry.timestamp
+                << '\t' << escapeField(entry.reason) << '\t' << escapeField(entry.originalPath) << '\n';
+        }
+        if (!out) {
+            Logger::logError("Failed to compact quarantine index");
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tempPath, indexPath, ec);
+    if (ec) {
+        Logger::logError("Failed to replace quarantine index: " + ec.message());
+    }
+}
+
+void QuarantineStore::importLegacyFiles() {
+    // Older versions dropped files straight into the quarantine directory
+    // (and the monitor used its own .quarantine folder) with no metadata
+    for (const fs::path& dir : {fs::path(rootPath), fs::path(LEGACY_MONITOR_DIR)}) {
+        std::error_code ec;
+        if (!fs::is_directory(dir, ec)) continue;
+
+        std::vector<fs::path> legacyFiles;
+        for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            if (entry.is_regular_file(ec) && entry.path().filename() != INDEX_FILE &&
+                entry.path().extension() != ".tmp") {
+                legacyFiles.push_back(entry.path());
+            }
+        }
+
+        for (const auto& file : legacyFiles) {
+            try {
+                std::string name = file.filename().string();
+                if (name.size() > LEGACY_EXTENSION.size() &&
+                    name.compare(name.size() - LEGACY_EXTENSION.size(), LEGACY_EXTENSION.size(),
+                                 LEGACY_EXTENSION) == 0) {
+                    name.erase(name.size() - LEGACY_EXTENSION.size());
+                }
+
+                std::string originalPath = (fs::current_path() / name).string();
+                std::string id = addEntry(file.string(), HashUtil::computeSHA256(file.string()),
+                                          "Legacy quarantine", originalPath);
+                if (!id.empty()) {
+                    Logger::logInfo("Imported legacy quarantine file " + file.string() + " as " + id);
+                }
+            } catch (const std::exception& e) {
+                Logger::logError("Failed to import legacy quarantine file: " + std::string(e.what()));
+            }
+        }
+    }
+    journal.flush();
+}
+
+void QuarantineStore::recoverStagedFiles() {
+    // Left behind when a quarantine was interrupted between the move and the
+    // index record; the staged name keeps the original file name
+    std::error_code ec;
+    std::vector<fs::path> staged;
+    for (const auto& entry : fs::directory_iterator(stagingPath, ec)) {
+        if (entry.is_regular_file(ec)) staged.push_back(entry.path());
+    }
+
+    for (const auto& file : staged) {
+        try {
+            std::string name = file.filename().string();
+            size_t separator = name.find('-');
+            std::string originalPath = (fs::current_path() / name.substr(separator + 1)).string();
+            std::string id = addEntry(file.string(), HashUtil::computeSHA256(file.string()),
+                                      "Interrupted quarantine", originalPath);
+            if (!id.empty()) {
+                Logger::logInfo("Recovered staged quarantine file " + file.string() + " as " + id);
+            }
+        } catch (const std::exception& e) {
+            Logger::logError("Failed to recover staged quarantine file: " + std::string(e.what()));
+        }
+    }
+    journal.flush();
+}
+
+std::string QuarantineStore::quarantine(const std::string& filePath, const std::string& reason) {
+    std::error_code ec;
+    std::string originalPath = fs::absolute(filePath, ec).string();
+    std::string staged = stagedPath(originalPath);
+    if (!moveFile(filePath, staged)) {
+        Logger::logError("Quarantine failed, cannot move " + filePath);
+        return "";
+    }
+
+    // Only the store can change the staged copy, so its digest is the one filed
+    std::string digest;
+    try {
+        digest = HashUtil::computeSHA256(staged);
+    } catch (const std::exception& e) {
+        Logger::logError("Quarantine failed: " + std::string(e.what()));
+        if (!moveFile(staged, originalPath)) {
+            Logger::logError("Cannot put back " + originalPath + ", left at " + staged);
+        }
+        return "";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string id = addEntry(staged, digest, reason, originalPath);
+    journal.flush();
+    return id;
+}
+
+std::string QuarantineStore::addEntry(const std::string& storedPath, const std::string& digest,
+                                      const std::string& reason, const std::string& originalPath) {
+    std::string target = objectPath(digest);
+    std::error_code ec;
+
+    if ((objectRefs.count(digest) > 0 || fs::exists(target, ec)) && sameContent(storedPath, target)) {
+        // Identical content is already stored, the new copy is redundant
+        fs::remove(storedPath, ec);
+        if (ec) {
+            Logger::logError("Quarantine failed, cannot remove " + storedPath + ": " + ec.message());
+            return "";
+        }
+    } else {
+        // A stored object that no longer matches its digest is replaced by the new copy
+        fs::create_directories(fs::path(target).parent_path(), ec);
+        fs::remove(target, ec);
+        if (!moveFile(storedPath, target)) {
+            Logger::logError("Quarantine failed, cannot move " + storedPath);
+            return "";
+        }
+    }
+
+    QuarantineEntry entry{uniqueId(digest), digest, originalPath, reason,
+                          static_cast<int64_t>(std::time(nullptr))};
+    objectRefs[digest]++;
+
+    journal << "+\t" << escapeField(entry.id) << '\t' << entry.digest << '\t' << entry.timestamp
+            << '\t' << escapeField(entry.reason) << '\t' << escapeField(entry.originalPath) << '\n';
+
+    std::string id = entry.id;
+    entries.emplace(id, std::move(entry));
+    Logger::logInfo("Quarantined " + originalPath + " as " + id + " (" + reason + ")");
+    return id;
+}
+
+bool QuarantineStore::restore(const std::string& id, std::string* restoredPath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool restored = restoreEntry(id, restoredPath);
+    journal.flush();
+    return restored;
+}
+
+size_t QuarantineStore::restoreAll(std::vector<std::string>* restoredPaths) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::string> ids;
+    ids.reserve(entries.size());
+    for (const auto& [id, entry] : entries) {
+        ids.push_back(id);
+    }
+
+    size_t restored = 0;
+    for (const auto& id : ids) {
+        std::string path;
+        if (restoreEntry(id, &path)) {
+            restored++;
+            if (restoredPaths) restoredPaths->push_back(path);
+        }
+    }
+
+    journal.flush();
+    return restored;
+}
+
+bool QuarantineStore::restoreEntry(const std::string& id, std::string* restoredPath) {
+    auto it = entries.find(id);
+    if (it == entries.end()) return false;
+
+    const QuarantineEntry& entry = it->second;
+    std::string source = objectPath(entry.digest);
+    std::string dest = uniqueRestorePath(entry.originalPath);
+
+    std::error_code ec;
+    fs::path parent = fs::path(dest).parent_path();
+    if (!parent.empty()) fs::create_directories(parent, ec);
+
+    // The last reference can take the object itself, the others get a clone
+    auto refs = objectRefs.find(entry.digest);
+    bool shared = refs != objectRefs.end() && refs->second > 1;
+    if (!(shared ? cloneFile(source, dest) : moveFile(source, dest))) {
+        Logger::logError("Failed to restore " + id + " to " + dest);
+        return false;
+    }
+
+    if (refs != objectRefs.end() && --refs->second == 0) {
+        objectRefs.erase(refs);
+    }
+    journal << "-\t" << escapeField(id) << '\n';
+
+    Logger::logInfo("Restored " + id + " to " + dest);
+    if (restoredPath) *restoredPath = dest;
+    entries.erase(it);
+    return true;
+}
+
+std::optional<QuarantineEntry> QuarantineStore::find(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(id);
+    if (it == entries.end()) return std::nullopt;
+    return it->second;
+}
+
+std::vector<QuarantineEntry> QuarantineStore::list() const {
+    std::vector<QuarantineEntry> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reserve(entries.size());
+        for (const auto& [id, entry] : entries) {
+            result.push_back(entry);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.timestamp != b.timestamp ? a.timestamp < b.timestamp : a.id < b.id;
+    });
+    return result;
+}
+
+size_t QuarantineStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::string QuarantineStore::objectPath(const std::string& digest) const {
+    return (fs::path(objectsPath) / digest.substr(0, 2) / digest).string();
+}
+
+std::string QuarantineStore::uniqueId(const std::string& digest) const {
+    std::string base = digest.substr(0, 12);
+    std::string id = base;
+    for (int counter = 2; entries.count(id) > 0; counter++) {
+        id = base + "-" + std::to_string(counter);
+    }
+    return id;
+}
+
+std::string QuarantineStore::stagedPath(const std::string& originalPath) const {
+    // Unique across threads and processes sharing the store; the original
+    // name follows the first '-' so an interrupted quarantine can be recovered
+    static std::atomic<uint64_t> counter{0};
+    auto stamp = std::chrono::system_clock::now().time_since_epoch().count();
+    std::string name = std::to_string(stamp) + "." + std::to_string(counter++) + "." +
+#ifdef __linux__
+                       std::to_string(::getpid()) +
+#endif
+                       "-" + fs::path(originalPath).filename().string();
+    return (fs::path(stagingPath) / name).string();
+}
+
+std::string QuarantineStore::uniqueRestorePath(const std::string& originalPath) {
+    fs::path path(originalPath);
+    std::error_code ec;
+    if (!fs::exists(path, ec)) return originalPath;
+
+    for (int counter = 1;; counter++) {
+        fs::path candidate = path.parent_path() /
+            (path.stem().string() + "_restored_" + std::to_string(counter) + path.extension().string());
+        if (!fs::exists(candidate, ec)) return candidate.string();
+    }
+}
+
+bool QuarantineStore::moveFile(const std::string& from, const std::string& to) {
+    std::error_code ec;
+    fs::rename(from, to, ec);
+    if (!ec) return true;
+
+    // Different volume: clone or copy, then drop the source
+    if (!cloneFile(from, to)) return false;
+    fs::remove(from, ec);
+    return true;
+}
+
+bool QuarantineStore::cloneFile(const std::string& from, const std::string& to) {
+#ifdef __linux__
+    int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in >= 0) {
+        struct stat st;
+        int out = -1;
+        if (::fstat(in, &st) == 0) {
+            out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777);
+        }
+
+        bool copied = false;
+        if (out >= 0) {
+            // Share extents on CoW filesystems, otherwise copy in the kernel
+            copied = ::ioctl(out, FICLONE, in) == 0;
+            if (!copied) {
+                off_t remaining = st.st_size;
+                copied = true;
+                while (remaining > 0) {
+                    ssize_t n = ::copy_file_range(in, nullptr, out, nullptr, remaining, 0);
+                    if (n < 0) {
+                        copied = false;
+                        break;
+                    }
+                    if (n == 0) break;
+                    remaining -= n;
+                }
+            }
+            ::close(out);
+        }
+        ::close(in);
+
+        if (copied) return true;
+        if (out >= 0) {
+            std::error_code ec;
+            fs::remove(to, ec);
+        }
+    }
+#endif
+
+    std::error_code ec;
+    fs::copy_file(from, to, fs::copy_options::none, ec);
+    if (ec) {
+        Logger::logError("Failed to copy " + from + " to " + to + ": " + ec.message());
+        return false;
+    }
+    return true;
+}
+
+bool QuarantineStore::sameContent(const std::string& a, const std::string& b) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(a, ec);
+    if (ec || fs::file_size(b, ec) != size || ec) return false;
+
+    std::ifstream first(a, std::ios::binary);
+    std::ifstream second(b, std::ios::binary);
+    std::vector<char> left(Config::SCAN_CHUNK_SIZE);
+    std::vector<char> right(Config::SCAN_CHUNK_SIZE);
+    while (first && second) {
+        first.read(left.data(), static_cast<std::streamsize>(left.size()));
+        second.read(right.data(), static_cast<std::streamsize>(right.size()));
+        if (first.gcount() != second.gcount() ||
+            std::memcmp(left.data(), right.data(), static_cast<size_t>(first.gcount())) != 0) {
+            return false;
+        }
+    }
+    return first.eof() && second.eof();
+}
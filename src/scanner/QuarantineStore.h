@@ -0,0 +1,68 @@
+#ifndef QUARANTINE_STORE_H
+#define QUARANTINE_STORE_H
+
+#include "Config.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct QuarantineEntry {
+    std::string id;
+    std::string digest;         // SHA-256 of the quarantined content
+    std::string originalPath;
+    std::string reason;
+    int64_t timestamp;          // Seconds since the epoch
+};
+
+// Content-addressed quarantine. Files are stored once per digest under
+// objects/, and an append-only index maps entry ids to their metadata.
+// A file is first moved to staging/ inside the store and hashed there, so
+// the digest it is filed under is that of the bytes actually stored, not of
+// a path the owner could still write to.
+class QuarantineStore {
+public:
+    explicit QuarantineStore(const std::string& rootPath = Config::QUARANTINE_PATH);
+
+    // Returns the new entry id, or an empty string on failure
+    std::string quarantine(const std::string& filePath, const std::string& reason);
+
+    // Moves the content back to its original path (or a unique sibling if taken)
+    bool restore(const std::string& id, std::string* restoredPath = nullptr);
+    size_t restoreAll(std::vector<std::string>* restoredPaths = nullptr);
+
+    std::optional<QuarantineEntry> find(const std::string& id) const;
+    std::vector<QuarantineEntry> list() const;
+    size_t size() const;
+
+private:
+    std::string rootPath;
+    std::string objectsPath;
+    std::string stagingPath;
+    std::string indexPath;
+    std::unordered_map<std::string, QuarantineEntry> entries;
+    std::unordered_map<std::string, size_t> objectRefs;
+    std::ofstream journal;
+    mutable std::mutex mutex;
+
+    void loadIndex();
+    void compactIndex();
+    void importLegacyFiles();
+    void recoverStagedFiles();
+    // Files a copy already held by the store, consuming `storedPath`
+    std::string addEntry(const std::string& storedPath, const std::string& digest,
+                         const std::string& reason, const std::string& originalPath);
+    bool restoreEntry(const std::string& id, std::string* restoredPath);
+    std::string objectPath(const std::string& digest) const;
+    std::string uniqueId(const std::string& digest) const;
+    std::string stagedPath(const std::string& originalPath) const;
+    static std::string uniqueRestorePath(const std::string& originalPath);
+    static bool moveFile(const std::string& from, const std::string& to);
+    static bool cloneFile(const std::string& from, const std::string& to);
+    static bool sameContent(const std::string& a, const std::string& b);
+};
+
+#endif // QUARANTINE_STORE_H
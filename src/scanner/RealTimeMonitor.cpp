@@ -1,8 +1,15 @@
 #include "RealTimeMonitor.h"
 #include "../utils/Logger.h"
+#include "../utils/Utils.h"
+#include "../utils/ExtensionSet.h"
+#include "../utils/ScanArena.h"
 #include <windows.h>
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
 #include <thread>
 #include <vector>
 #include <chrono>
@@ -15,6 +22,75 @@
 
 namespace fs = std::filesystem;
 
+namespace {
+    constexpr std::string_view EXCLUDED_PATH_PATTERNS[] = {
+        "\\windows\\", "\\program files\\", "\\programdata\\", 
+        "\\appdata\\", "\\temp\\", "\\.quarantine", "\\data\\quarantine\\", "\\logs\\",
+        "\\system32\\", "\\syswow64\\", "\\.dll", "\\.sys",
+        "scan_results.log", "signatures.db", "\\.git\\",
+        "\\node_modules\\", "\\packages\\"
+    };
+
+    constexpr ExtensionSet HIGH_RISK_EXTENSIONS({
+        ".exe", ".dll", ".scr", ".bat", ".cmd", ".vbs", ".js", ".ws", ".wsf", ".wsh",
+        ".ps1", ".msi", ".msp", ".hta", ".jar", ".py", ".pyw", ".com", ".msc", ".cpl",
+        ".reg", ".inf", ".scf", ".url", ".lnk", ".job", ".jse", ".pif", ".application"
+    });
+
+    const DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE |
+                                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SECURITY;
+    const int64_t FILETIME_TICKS_PER_MS = 10000;
+
+    std::string describeChange(FingerprintChange change) {
+        return change == FingerprintChange::TypeLoss ? " lost its file type" : " became high-entropy data";
+    }
+
+    std::string describeReplacement(const ReplacementTracker::Replacement& replacement) {
+        return " replaced the deleted " + replacement.original +
+               (replacement.change == FingerprintChange::TypeLoss ? " with data of no known type"
+                                                                  : " with high-entropy data");
+    }
+
+    bool isExcludedPath(std::string_view lowerPath) {
+        for (std::string_view pattern : EXCLUDED_PATH_PATTERNS) {
+            if (lowerPath.find(pattern) != std::string_view::npos) return true;
+        }
+        return false;
+    }
+
+    ChangePriority changePriority(const std::string& filePath, bool created) {
+        if (created || HIGH_RISK_EXTENSIONS.containsExtensionOf(filePath)) return ChangePriority::High;
+        std::string lowerPath(filePath);
+        std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
+        return isExcludedPath(lowerPath) ? ChangePriority::Low : ChangePriority::Normal;
+    }
+
+    std::string toUtf8(const wchar_t* text, size_t length) {
+        int size = WideCharToMultiByte(CP_UTF8, 0, text, static_cast<int>(length), nullptr, 0, nullptr, nullptr);
+        std::string result(size, 0);
+        WideCharToMultiByte(CP_UTF8, 0, text, static_cast<int>(length), &result[0], size, nullptr, nullptr);
+        return result;
+    }
+
+    std::wstring toWide(const std::string& text) {
+        int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), nullptr, 0);
+        std::wstring result(size, 0);
+        MultiByteToWideChar(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &result[0], size);
+        return result;
+    }
+
+    int64_t fileTimeValue(const FILETIME& time) {
+        return static_cast<int64_t>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime);
+    }
+
+    // Same clock as FileHandle::modifiedTime() on Windows
+    int64_t currentFileTime() {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        return fileTimeValue(now);
+    }
+}
+
 RealTimeMonitor::RealTimeMonitor() : running(false), dirHandle(INVALID_HANDLE_VALUE) {}
 
 RealTimeMonitor::~RealTimeMonitor() {
@@ -57,7 +133,14 @@ void RealTimeMonitor::startMonitoring(const std::string& directoryPath, FileScan
     }
 
     running = true;
-    monitorThread = std::thread(&RealTimeMonitor::monitorDirectory, this, cleanPath, std::ref(scanner));
+    cancelScans.reset();
+    fingerprints = &scanner.getFingerprintCache();
+    fingerprints->setEnabled(true);
+    queue.reopen();
+    for (int i = 0; i < std::max(1, Config::REALTIME_SCAN_THREADS); i++) {
+        scanThreads.emplace_back(&RealTimeMonitor::scanLoop, this, std::ref(scanner));
+    }
+    monitorThread = std::thread(&RealTimeMonitor::monitorDirectory, this, cleanPath);
     Logger::logInfo("Real-time monitoring started for: " + cleanPath);
 }
 
@@ -65,7 +148,9 @@ void RealTimeMonitor::stopMonitoring() {
     if (!running) return;
 
     running = false;
-    
+    cancelScans.cancel();
+    queue.close();
+
     if (dirHandle != INVALID_HANDLE_VALUE) {
         CancelIo(dirHandle);
         CloseHandle(dirHandle);
@@ -75,94 +160,206 @@ void RealTimeMonitor::stopMonitoring() {
     if (monitorThread.joinable()) {
         monitorThread.join();
     }
+    for (auto& thread : scanThreads) {
+        thread.join();
+    }
+    scanThreads.clear();
 
     Logger::logInfo("Real-time monitoring stopped");
 }
 
-void RealTimeMonitor::monitorDirectory(const std::string& path, FileScanner& scanner) {
-    const DWORD bufferSize = 4096;
+void RealTimeMonitor::monitorDirectory(const std::string& path) {
+    const DWORD bufferSize = static_cast<DWORD>(Config::REALTIME_NOTIFY_BUFFER_SIZE);
+    // The next read is issued into one buffer before the other is parsed
     std::vector<BYTE> buffer(bufferSize);
+    std::vector<BYTE> received(bufferSize);
     OVERLAPPED overlapped = {0};
     overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    lastDelivery = currentFileTime();
+    activeDirectories.clear();
 
-    while (running) {
-        DWORD bytesReturned = 0;
-        if (!ReadDirectoryChangesW(
-            dirHandle,
-            buffer.data(),
-            bufferSize,
-            TRUE,
-            FILE_NOTIFY_CHANGE_FILE_NAME |
-            FILE_NOTIFY_CHANGE_SIZE |
-            FILE_NOTIFY_CHANGE_LAST_WRITE |
-            FILE_NOTIFY_CHANGE_SECURITY,
-            &bytesReturned,
-            &overlapped,
-            nullptr))
-        {
+    auto watch = [&]() {
+        if (!ReadDirectoryChangesW(dirHandle, buffer.data(), bufferSize, TRUE, NOTIFY_FILTER,
+                                   nullptr, &overlapped, nullptr)) {
             DWORD err = GetLastError();
             if (err != ERROR_IO_PENDING) {
                 Logger::logError("ReadDirectoryChangesW failed: " + std::to_string(err));
-                break;
+                return false;
             }
         }
+        return true;
+    };
 
+    bool watching = watch();
+    while (running && watching) {
         DWORD waitResult = WaitForSingleObject(overlapped.hEvent, 1000);
-        if (waitResult == WAIT_OBJECT_0) {
-            if (GetOverlappedResult(dirHandle, &overlapped, &bytesReturned, FALSE)) {
-                if (bytesReturned > 0) {
-                    FILE_NOTIFY_INFORMATION* notification = 
-                        reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer.data());
-
-                    do {
-                        std::wstring fileName(
-                            notification->FileName,
-                            notification->FileNameLength / sizeof(WCHAR)
-                        );
-
-                        // Convert to UTF-8
-                        int utf8Size = WideCharToMultiByte(
-                            CP_UTF8, 0,
-                            fileName.c_str(), static_cast<int>(fileName.size()),
-                            nullptr, 0, nullptr, nullptr
-                        );
-                        
-                        std::string strFileName(utf8Size, 0);
-                        WideCharToMultiByte(
-                            CP_UTF8, 0,
-                            fileName.c_str(), static_cast<int>(fileName.size()),
-                            &strFileName[0], utf8Size,
-                            nullptr, nullptr
-                        );
-
-                        fs::path fullPath(path);
-                        fullPath /= strFileName;
-                        std::string filePath = fullPath.lexically_normal().string();
-
-                        Logger::logInfo("Detected change: " + filePath);
-                        handleFileChange(filePath, scanner);
-
-                        if (notification->NextEntryOffset == 0) break;
-                        notification = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
-                            reinterpret_cast<BYTE*>(notification) + 
-                            notification->NextEntryOffset);
-                    } while (running);
-                }
+        if (waitResult != WAIT_OBJECT_0) continue;
+
+        DWORD bytesReturned = 0;
+        bool completed = GetOverlappedResult(dirHandle, &overlapped, &bytesReturned, FALSE);
+        DWORD err = completed ? ERROR_SUCCESS : GetLastError();
+        ResetEvent(overlapped.hEvent);
+        if (!running) break;
+
+        std::swap(buffer, received);
+        watching = watch();
+        int64_t now = currentFileTime();
+
+        // The system reports an empty result when changes no longer fit in the buffer
+        if (err == ERROR_NOTIFY_ENUM_DIR || (completed && bytesReturned == 0)) {
+            recoverLostChanges(path);
+            lastDelivery = now;
+            continue;
+        }
+        if (!completed) {
+            Logger::logError("Reading directory changes failed: " + std::to_string(err));
+            continue;
+        }
+        lastDelivery = now;
+
+        auto* notification = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(received.data());
+        std::string renamedFrom;
+        while (true) {
+            fs::path fullPath(toWide(path));
+            fullPath /= std::wstring(notification->FileName, notification->FileNameLength / sizeof(WCHAR));
+            std::wstring widePath = fullPath.lexically_normal().wstring();
+            std::string filePath = toUtf8(widePath.c_str(), widePath.size());
+
+            // Removed files have nothing left to scan
+            switch (notification->Action) {
+                case FILE_ACTION_REMOVED:
+                    if (std::optional<ContentFingerprint> removed = fingerprints->remove(filePath)) {
+                        auto replacement = replacements.deleted(filePath, *removed);
+                        if (replacement) recordSuspiciousChange(replacement->copy, describeReplacement(*replacement));
+                    }
+                    break;
+                case FILE_ACTION_RENAMED_OLD_NAME:
+                    renamedFrom = std::move(filePath);
+                    break;
+                case FILE_ACTION_RENAMED_NEW_NAME:
+                    // Encrypting in place and then renaming must still compare against the original
+                    if (!renamedFrom.empty()) fingerprints->rename(renamedFrom, filePath);
+                    renamedFrom.clear();
+                    queueChange(filePath, true);
+                    break;
+                default:
+                    queueChange(filePath, notification->Action == FILE_ACTION_ADDED);
+                    break;
             }
-            ResetEvent(overlapped.hEvent);
+
+            if (notification->NextEntryOffset == 0) break;
+            notification = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
+                reinterpret_cast<BYTE*>(notification) + notification->NextEntryOffset);
         }
     }
 
     CloseHandle(overlapped.hEvent);
 }
 
+void RealTimeMonitor::queueChange(const std::string& filePath, bool created) {
+    std::string directory = fs::path(filePath).parent_path().string();
+    activeDirectories[directory] = std::chrono::steady_clock::now();
+    if (activeDirectories.size() > Config::REALTIME_ACTIVE_DIRECTORIES) {
+        activeDirectories.erase(std::min_element(activeDirectories.begin(), activeDirectories.end(),
+            [](const auto& a, const auto& b) { return a.second < b.second; }));
+    }
+
+    ChangePriority priority = changePriority(filePath, created);
+    if (!queue.push({filePath, priority})) {
+        // Too far behind to hold every change; the directory is rescanned instead
+        int64_t since = currentFileTime() - Config::OVERFLOW_RESCAN_SLACK_MS * FILETIME_TICKS_PER_MS;
+        queue.push({directory, priority, true, false, since});
+    }
+}
+
+void RealTimeMonitor::recoverLostChanges(const std::string& root) {
+    overflows++;
+    int64_t since = lastDelivery - Config::OVERFLOW_RESCAN_SLACK_MS * FILETIME_TICKS_PER_MS;
+    Logger::logWarning("Change notifications were lost; rescanning recently changed files under " + root);
+
+    // The directories that were busy when notifications were lost most
+    // likely hold what was missed, so they go ahead of the full tree
+    std::vector<std::pair<std::chrono::steady_clock::time_point, std::string>> recent;
+    for (const auto& [directory, time] : activeDirectories) {
+        recent.emplace_back(time, directory);
+    }
+    std::sort(recent.begin(), recent.end(), std::greater<>());
+    for (const auto& entry : recent) {
+        queue.push({entry.second, ChangePriority::High, true, false, since});
+    }
+    queue.push({root, ChangePriority::High, true, true, since});
+}
+
+void RealTimeMonitor::scanLoop(FileScanner& scanner) {
+    while (std::optional<ChangeJob> job = queue.pop()) {
+        try {
+            if (job->rescan) {
+                rescanDirectory(*job, scanner);
+            } else {
+                Logger::logInfo("Detected change: " + job->path);
+                handleFileChange(job->path, scanner);
+            }
+        } catch (const std::exception& e) {
+            Logger::logError("Real-time scan error: " + std::string(e.what()));
+        }
+    }
+}
+
+void RealTimeMonitor::rescanDirectory(const ChangeJob& job, FileScanner& scanner) {
+    size_t changed = 0;
+    std::vector<std::string> directories{job.path};
+    while (!directories.empty() && running) {
+        std::string directory = std::move(directories.back());
+        directories.pop_back();
+
+        // Listing returns both timestamps, so unchanged files are never opened
+        WIN32_FIND_DATAW data;
+        HANDLE find = FindFirstFileExW(toWide(directory + "\\*").c_str(), FindExInfoBasic, &data,
+                                       FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+        if (find == INVALID_HANDLE_VALUE) continue;
+
+        do {
+            std::wstring_view name(data.cFileName);
+            if (name == L"." || name == L"..") continue;
+            std::string entryPath = directory + "\\" + toUtf8(name.data(), name.size());
+
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                // Reparse points can lead out of the tree or back into it
+                if (job.recursive && !(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+                    directories.push_back(std::move(entryPath));
+                }
+                continue;
+            }
+
+            // A copied file keeps its write time but gets a new creation time
+            if (std::max(fileTimeValue(data.ftLastWriteTime), fileTimeValue(data.ftCreationTime)) < job.since) {
+                continue;
+            }
+            changed++;
+            if (!queue.push({entryPath, changePriority(entryPath, false)})) {
+                // With the queue full, scanning here paces the rescan to the scan threads
+                handleFileChange(entryPath, scanner);
+            }
+        } while (running && FindNextFileW(find, &data));
+        FindClose(find);
+    }
+
+    Logger::logInfo("Rescan of " + job.path + " found " + std::to_string(changed) + " changed files");
+}
+
 void RealTimeMonitor::handleFileChange(const std::string& filePath, FileScanner& scanner) {
+    // Bounds everything below, so one slow file cannot stall the change queue
+    ScanBudget budget(std::chrono::milliseconds(Config::REALTIME_SCAN_TIMEOUT_MS), &cancelScans);
+    ScanBudget::Scope budgetScope(budget);
+    ScanArena::Scope arenaScope;
+
     try {
         // More aggressive retry strategy for file access
         bool fileReady = false;
-        for (int i = 0; i < 10; ++i) {
+        for (int i = 0; i < 10 && !ScanBudget::threadExhausted(); ++i) {
+            std::error_code ec;
+            if (fs::is_directory(filePath, ec)) return;
             if (fs::exists(filePath)) {
-                std::error_code ec;
                 auto fileSize = fs::file_size(filePath, ec);
                 if (!ec && fileSize > 0) {
                     fileReady = true;
@@ -174,146 +371,72 @@ void RealTimeMonitor::handleFileChange(const std::string& filePath, FileScanner&
         if (!fileReady || !fs::exists(filePath)) return;
 
         // Enhanced system file protection
-        const std::vector<std::string> excludedPatterns = {
-            "\\windows\\", "\\program files\\", "\\programdata\\", 
-            "\\appdata\\", "\\temp\\", "\\.quarantine", "\\logs\\",
-            "\\system32\\", "\\syswow64\\", "\\.dll", "\\.sys",
-            "scan_results.log", "signatures.db", "\\.git\\",
-            "\\node_modules\\", "\\packages\\"
-        };
-
-        std::string lowerPath = filePath;
+        std::pmr::string lowerPath(filePath, ScanArena::resource());
         std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(), ::tolower);
         
-        bool isSystemFile = false;
-        for (const auto& pattern : excludedPatterns) {
-            if (lowerPath.find(pattern) != std::string::npos) {
-                Logger::logInfo("System file detected: " + filePath);
-                isSystemFile = true;
-                break;
-            }
+        bool isSystemFile = isExcludedPath(lowerPath);
+        if (isSystemFile) {
+            Logger::logInfo("System file detected: " + filePath);
         }
 
-        // Enhanced extension checking
-        std::string ext = fs::path(filePath).extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-        
-        const std::vector<std::string> highRiskExts = {
-            ".exe", ".dll", ".scr", ".bat", ".cmd", ".vbs", ".js", ".ws", ".wsf", ".wsh",
-            ".ps1", ".msi", ".msp", ".hta", ".jar", ".py", ".pyw", ".com", ".msc", ".cpl",
-            ".reg", ".inf", ".scf", ".url", ".lnk", ".job", ".jse", ".pif", ".application"
-        };
+        FileHandle file = FileHandle::open(filePath);
+        if (!file.isOpen()) return;
+
+        // Measured once here; the scan then finds the fingerprint current
+        FingerprintCache& cache = scanner.getFingerprintCache();
+        std::optional<ContentFingerprint> previous = cache.find(filePath);
+        cache.refresh(file);
+        std::optional<ContentFingerprint> current = cache.find(filePath);
+        if (current && previous) {
+            FingerprintChange change = FingerprintCache::compare(*previous, *current);
+            if (change != FingerprintChange::None) recordSuspiciousChange(filePath, describeChange(change));
+        } else if (current) {
+            auto replacement = replacements.created(filePath, *current);
+            if (replacement) recordSuspiciousChange(filePath, describeReplacement(*replacement));
+        }
 
         // Immediate aggressive scan for high-risk files
-        if (std::find(highRiskExts.begin(), highRiskExts.end(), ext) != highRiskExts.end() || !isSystemFile) {
-            // Check file entropy for potential encryption/packing
-            if (checkFileEntropy(filePath)) {
-                Logger::logWarning("High entropy detected in file: " + filePath);
-                quarantineFile(filePath);
-                return;
-            }
-
-            if (scanner.scanFile(filePath)) {
+        if (HIGH_RISK_EXTENSIONS.containsExtensionOf(filePath) || !isSystemFile) {
+            ScanStatus status = scanner.scan(file, budget);
+            file.close();
+            if (status == ScanStatus::Threat) {
                 Logger::logWarning("Threat detected: " + filePath);
-                quarantineFile(filePath);
+                quarantineFile(filePath, scanner, "Threat detected");
                 return;
             }
+            if (status != ScanStatus::Clean) return;
 
             behaviorAnalyzer.analyze(filePath);
         }
-
-        // Enhanced ransomware detection
-        auto now = std::chrono::steady_clock::now();
-        auto it = this->lastChange.find(filePath);
-        if (it != this->lastChange.end()) {
-            auto duration = now - it->second;
-            if (duration < std::chrono::minutes(1)) {
-                if (++this->fileChangeCount[filePath] > 5) {
-                    if (checkSurroundingFilesForChanges(filePath)) {
-                        Logger::logWarning("Ransomware behavior detected: " + filePath);
-                        quarantineFile(filePath);
-                        return;
-                    }
-                }
-            } else {
-                this->fileChangeCount[filePath] = 1;
-            }
-        } else {
-            this->fileChangeCount[filePath] = 1;
-        }
-        this->lastChange[filePath] = now;
-
     } catch (const std::exception& e) {
         Logger::logError("File change error: " + std::string(e.what()));
     }
 }
 
-bool RealTimeMonitor::checkFileEntropy(const std::string& filePath) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file) return false;
-
-    std::vector<unsigned char> buffer(std::istreambuf_iterator<char>(file), {});
-    if (buffer.empty()) return false;
-
-    std::array<int, 256> frequencies = {0};
-    for (unsigned char byte : buffer) {
-        frequencies[byte]++;
-    }
+void RealTimeMonitor::recordSuspiciousChange(const std::string& filePath, const std::string& description) {
+    Logger::logInfo(filePath + description);
 
-    double entropy = 0.0;
-    for (int freq : frequencies) {
-        if (freq == 0) continue;
-        double probability = static_cast<double>(freq) / buffer.size();
-        entropy -= probability * std::log2(probability);
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(changeMutex);
+    suspiciousChanges.push_back(now);
+    while (now - suspiciousChanges.front() > std::chrono::seconds(Config::RANSOMWARE_WINDOW_SEC)) {
+        suspiciousChanges.pop_front();
     }
-
-    return entropy > 7.0;
+    if (suspiciousChanges.size() < Config::RANSOMWARE_FILE_THRESHOLD) return;
+
+    // One alert per batch of files; a continuing attack raises another
+    size_t count = suspiciousChanges.size();
+    suspiciousChanges.clear();
+    Logger::logWarning("Ransomware behavior detected: " + std::to_string(count) +
+                       " files look encrypted after changes within " +
+                       std::to_string(Config::RANSOMWARE_WINDOW_SEC) + "s, latest " + filePath);
+    std::cout << "\n[!] RANSOMWARE ACTIVITY: " << count << " files encrypted, latest " << filePath << "\n";
 }
 
-bool RealTimeMonitor::checkSurroundingFilesForChanges(const std::string& filePath) {
-    try {
-        fs::path path(filePath);
-        fs::path dir = path.parent_path();
-        int changedFiles = 0;
-        
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            auto it = this->lastChange.find(entry.path().string());
-            if (it != this->lastChange.end()) {
-                changedFiles++;
-                if (changedFiles > 3) {
-                    return true;
-                }
-            }
-        }
-    } catch (...) {
-        Logger::logError("Error checking surrounding files");
-    }
-    return false;
-}
-
-void RealTimeMonitor::quarantineFile(const std::string& filePath) {
-    try {
-        fs::path source(filePath);
-        fs::path quarantineDir = ".quarantine";
-        fs::path target = quarantineDir / source.filename();
-
-        if (!fs::exists(quarantineDir)) {
-            fs::create_directories(quarantineDir);
-        }
-
-        // Handle duplicate filenames
-        int counter = 0;
-        while (fs::exists(target)) {
-            target = quarantineDir / 
-                    (source.stem().string() + 
-                     "_" + std::to_string(++counter) + 
-                     source.extension().string());
-        }
-
-        fs::rename(source, target);
-        Logger::logInfo("Quarantined: " + filePath + " -> " + target.string());
-        std::cout << "\n[!] QUARANTINED: " << filePath << "\n";
-    } catch (const std::exception& e) {
-        Logger::logError("Quarantine failed: " + std::string(e.what()));
+void RealTimeMonitor::quarantineFile(const std::string& filePath, FileScanner& scanner,
+                                     const std::string& reason) {
+    std::string id = scanner.quarantine(filePath, reason);
+    if (!id.empty()) {
+        std::cout << "\n[!] QUARANTINED: " << filePath << " (ID " << id << ")\n";
     }
 }
\ No newline at end of file
@@ -6,15 +6,30 @@
 #include <string>
 #include <thread>
 #include <atomic>
+#include <deque>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include <chrono>
 #include <filesystem>
 #include "FileScanner.h"
 #include "BehaviorAnalyzer.h"
+#include "ChangeQueue.h"
 #include "../utils/Logger.h"
 
 namespace fs = std::filesystem;
 
+// Watches a directory tree for changes and scans what changed. The watcher
+// thread only reads notifications and queues them by priority, so new files
+// and executables are scanned ahead of a backlog of ordinary edits. When the
+// notification buffer overflows and changes are lost, the directories that
+// were active and then the whole tree are rescanned for files changed since
+// the last notifications that did arrive.
+//
+// Ransomware is recognized by what a rewrite does to a file's content
+// fingerprint rather than by how often it changes: many files losing their
+// type or turning from plain to high-entropy data within a short window,
+// whether rewritten in place or replaced by a new file beside them.
 class RealTimeMonitor {
 public:
     RealTimeMonitor();
@@ -23,21 +38,38 @@ public:
     void startMonitoring(const std::string& directoryPath, FileScanner& scanner);
     void stopMonitoring();
 
+    ChangeQueueStats getQueueStats() const { return queue.getStats(); }
+    size_t getOverflowCount() const { return overflows; }
+
 private:
     std::atomic<bool> running;
+    CancellationToken cancelScans;     // Lets stopMonitoring interrupt a scan in progress
     std::thread monitorThread;
+    std::vector<std::thread> scanThreads;
     HANDLE dirHandle;
     BehaviorAnalyzer behaviorAnalyzer;
-    
-    // File change tracking
-    std::unordered_map<std::string, int> fileChangeCount;
-    std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastChange;
+    ChangeQueue queue;
+    std::atomic<size_t> overflows{0};
+
+    // Watcher thread only
+    int64_t lastDelivery = 0;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> activeDirectories;
+
+    FingerprintCache* fingerprints = nullptr;   // The scanner's, also filled by its other scans
+    ReplacementTracker replacements;
+
+    // When files last turned into what looks like encrypted data, shared by the scan threads
+    std::mutex changeMutex;
+    std::deque<std::chrono::steady_clock::time_point> suspiciousChanges;
 
-    void monitorDirectory(const std::string& path, FileScanner& scanner);
+    void monitorDirectory(const std::string& path);
+    void queueChange(const std::string& filePath, bool created);
+    void recoverLostChanges(const std::string& root);
+    void scanLoop(FileScanner& scanner);
+    void rescanDirectory(const ChangeJob& job, FileScanner& scanner);
     void handleFileChange(const std::string& filePath, FileScanner& scanner);
-    void quarantineFile(const std::string& filePath);
-    bool checkFileEntropy(const std::string& filePath);
-    bool checkSurroundingFilesForChanges(const std::string& filePath);
+    void quarantineFile(const std::string& filePath, FileScanner& scanner, const std::string& reason);
+    void recordSuspiciousChange(const std::string& filePath, const std::string& description);
 };
 
 #endif // REAL_TIME_MONITOR_H
\ No newline at end of file
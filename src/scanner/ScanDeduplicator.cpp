@@ -0,0 +1,37 @@
+#include "ScanDeduplicator.h"
+
+ScanStatus ScanDeduplicator::run(const std::string& key, const std::function<ScanStatus()>& scan,
+                                 bool* wasReused) {
+    if (wasReused) *wasReused = false;
+    if (key.empty()) return scan();
+
+    std::promise<ScanStatus> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = results.find(key);
+        if (it != results.end()) {
+            std::shared_future<ScanStatus> result = it->second;
+            lock.unlock();
+            reused++;
+            if (wasReused) *wasReused = true;
+            return result.get();
+        }
+        results.emplace(key, promise.get_future().share());
+    }
+
+    // Waiters see the same exception the first scan threw
+    try {
+        ScanStatus result = scan();
+        promise.set_value(result);
+        return result;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+std::string ScanDeduplicator::identityKey(const FileHandle& file) {
+    if (file.inode() == 0) return "";
+    return "inode:" + std::to_string(file.device()) + ":" + std::to_string(file.inode()) + ":" +
+           std::to_string(file.size()) + ":" + std::to_string(file.modifiedTime());
+}
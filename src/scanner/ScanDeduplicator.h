@@ -0,0 +1,33 @@
+#ifndef SCAN_DEDUPLICATOR_H
+#define SCAN_DEDUPLICATOR_H
+
+#include "ScoringEngine.h"
+#include "../utils/FileHandle.h"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Shares scan verdicts between files that are known to be the same within
+// one scan pass: hard links to one inode, and byte-identical copies once
+// their digest is known. The first caller for a key runs the scan; callers
+// that arrive while it is in flight wait on its result instead of repeating it.
+class ScanDeduplicator {
+public:
+    // Runs scan once per key. Sets reused when the result came from another caller.
+    ScanStatus run(const std::string& key, const std::function<ScanStatus()>& scan, bool* reused = nullptr);
+
+    // Same inode on the same volume, unchanged since it was opened. Empty when
+    // the filesystem reports no usable file id.
+    static std::string identityKey(const FileHandle& file);
+    size_t reusedCount() const { return reused.load(); }
+
+private:
+    std::unordered_map<std::string, std::shared_future<ScanStatus>> results;
+    std::mutex mutex;
+    std::atomic<size_t> reused{0};
+};
+
+#endif // SCAN_DEDUPLICATOR_H
@@ -0,0 +1,143 @@
+#include "ScanPolicy.h"
+#include "../utils/ExtensionSet.h"
+#include "Config.h"
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <string_view>
+
+namespace {
+    // Large containers rarely carry anything interesting past their headers
+    constexpr ExtensionSet MEDIA_EXTENSIONS({
+        ".iso", ".img", ".vmdk", ".vhd", ".vhdx", ".qcow2", ".vdi",
+        ".mp4", ".mkv", ".avi", ".mov", ".wmv", ".mp3", ".flac", ".wav"
+    });
+
+    // Longer extensions cannot match an override worth keeping a buffer for
+    const size_t MAX_EXTENSION_LENGTH = 32;
+    const uint64_t SAMPLE_ALIGNMENT = 4096;
+
+    uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+}
+
+ScanPolicy::ScanPolicy()
+    : defaultPolicy{Config::MAX_FILE_SIZE, Config::SAMPLED_SCAN_LIMIT, std::numeric_limits<uint64_t>::max()},
+      mediaPolicy{Config::MEDIA_FULL_SCAN_LIMIT, Config::MEDIA_SAMPLED_SCAN_LIMIT, std::numeric_limits<uint64_t>::max()},
+      headTailSize(Config::HEAD_TAIL_SCAN_SIZE),
+      sampling{Config::SAMPLE_EDGE_SIZE, Config::SAMPLE_BLOCK_SIZE, Config::SAMPLE_BLOCK_COUNT} {}
+
+void ScanPolicy::setDefaultPolicy(const SizePolicy& policy) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    defaultPolicy = policy;
+}
+
+void ScanPolicy::setPolicy(const std::string& extension, const SizePolicy& policy) {
+    std::string ext = extension;
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    extensionPolicies[ext] = policy;
+}
+
+void ScanPolicy::setHeadTailSize(uint64_t bytes) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    headTailSize = bytes;
+}
+
+void ScanPolicy::setSampling(const SamplingPolicy& policy) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    sampling = policy;
+    sampling.blockSize = std::max<uint64_t>(sampling.blockSize, 1);
+}
+
+SamplingPolicy ScanPolicy::getSampling() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return sampling;
+}
+
+const SizePolicy& ScanPolicy::policyFor(const std::string& filePath) const {
+    std::string_view ext = ExtensionSet<1>::extensionOf(filePath);
+
+    if (!extensionPolicies.empty() && ext.size() <= MAX_EXTENSION_LENGTH) {
+        char lower[MAX_EXTENSION_LENGTH];
+        std::transform(ext.begin(), ext.end(), lower, ::tolower);
+        auto it = extensionPolicies.find(std::string_view(lower, ext.size()));
+        if (it != extensionPolicies.end()) return it->second;
+    }
+    return MEDIA_EXTENSIONS.contains(ext) ? mediaPolicy : defaultPolicy;
+}
+
+ScanPlan ScanPolicy::plan(const std::string& filePath) const {
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(filePath, ec);
+    return plan(filePath, ec ? 0 : fileSize);
+}
+
+ScanPlan ScanPolicy::plan(const std::string& filePath, uint64_t fileSize) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const SizePolicy& policy = policyFor(filePath);
+    ScanPlan result{ScanMode::Full, fileSize, {}};
+
+    uint64_t sampledBytes = 2 * sampling.edgeSize + sampling.blockCount * sampling.blockSize;
+    if (fileSize > policy.sampleLimit) {
+        result.mode = ScanMode::Skip;
+    } else if (fileSize <= policy.fullScanLimit || fileSize <= 2 * headTailSize) {
+        result.regions.push_back({0, fileSize});
+    } else if (fileSize <= policy.headTailLimit || fileSize <= sampledBytes) {
+        result.mode = ScanMode::HeadTail;
+        result.regions.push_back({0, headTailSize});
+        result.regions.push_back({fileSize - headTailSize, headTailSize});
+    } else {
+        result.mode = ScanMode::Sampled;
+        addRegions(result, sampleRegions(fileSize));
+    }
+
+    return result;
+}
+
+std::vector<ScanRegion> ScanPolicy::sampleRegions(uint64_t fileSize) const {
+    uint64_t edge = std::min(sampling.edgeSize, fileSize / 2);
+    std::vector<ScanRegion> regions{{0, edge}, {fileSize - edge, edge}};
+
+    // One block at a pseudo-random place in each of blockCount equal strata,
+    // so the sample covers the whole file without a fixed stride that the
+    // layout of a format could line up with. Seeded by the size, the same
+    // file is sampled the same way on every scan.
+    uint64_t middle = fileSize - 2 * edge;
+    if (sampling.blockCount == 0 || middle == 0) return regions;
+    uint64_t stratum = std::max<uint64_t>(middle / sampling.blockCount, 1);
+    uint64_t seed = fileSize;
+    for (size_t i = 0; i < sampling.blockCount; i++) {
+        uint64_t start = edge + i * stratum;
+        if (start >= fileSize - edge) break;
+        uint64_t room = stratum > sampling.blockSize ? stratum - sampling.blockSize : 0;
+        uint64_t offset = start + (room ? splitMix64(seed) % (room + 1) : 0);
+        offset -= offset % SAMPLE_ALIGNMENT;
+        regions.push_back({offset, std::min(sampling.blockSize, fileSize - offset)});
+    }
+    return regions;
+}
+
+void ScanPolicy::addRegions(ScanPlan& plan, const std::vector<ScanRegion>& regions) {
+    std::vector<ScanRegion>& merged = plan.regions;
+    merged.insert(merged.end(), regions.begin(), regions.end());
+    std::sort(merged.begin(), merged.end(),
+              [](const ScanRegion& a, const ScanRegion& b) { return a.offset < b.offset; });
+
+    size_t kept = 0;
+    for (const auto& region : merged) {
+        if (region.length == 0) continue;
+        if (kept > 0 && region.offset <= merged[kept - 1].offset + merged[kept - 1].length) {
+            ScanRegion& last = merged[kept - 1];
+            last.length = std::max(last.offset + last.length, region.offset + region.length) - last.offset;
+        } else {
+            merged[kept++] = region;
+        }
+    }
+    merged.resize(kept);
+}
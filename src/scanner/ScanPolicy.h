@@ -0,0 +1,69 @@
+#ifndef SCAN_POLICY_H
+#define SCAN_POLICY_H
+
+#include "../utils/ChunkedReader.h"
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <vector>
+
+enum class ScanMode {
+    Full,       // Every byte goes through the content detectors
+    HeadTail,   // Only the start and end of the file are read
+    Sampled,    // The ends plus a fixed pseudo-random set of blocks; a full scan follows if they look suspicious
+    Skip        // Too large to be worth reading
+};
+
+struct SizePolicy {
+    uint64_t fullScanLimit;   // Files up to this size are scanned completely
+    uint64_t headTailLimit;   // Files up to this size get a head/tail scan, larger ones are sampled
+    uint64_t sampleLimit;     // Files up to this size are sampled, larger ones are skipped
+};
+
+// How much of a file a sampled scan reads
+struct SamplingPolicy {
+    uint64_t edgeSize;      // Read from each end
+    uint64_t blockSize;
+    size_t blockCount;      // Blocks spread over the rest of the file
+};
+
+struct ScanPlan {
+    ScanMode mode;
+    uint64_t fileSize;
+    std::vector<ScanRegion> regions;
+};
+
+// Decides, per file type and size, how much of a file the detectors read.
+// Settings may change while scans are planning; each plan sees one
+// consistent set of them.
+class ScanPolicy {
+public:
+    ScanPolicy();
+
+    void setDefaultPolicy(const SizePolicy& policy);
+    void setPolicy(const std::string& extension, const SizePolicy& policy);
+    void setHeadTailSize(uint64_t bytes);
+    void setSampling(const SamplingPolicy& policy);
+    SamplingPolicy getSampling() const;
+
+    ScanPlan plan(const std::string& filePath) const;
+    ScanPlan plan(const std::string& filePath, uint64_t fileSize) const;
+
+    // Adds regions to a plan, keeping its regions sorted and disjoint
+    static void addRegions(ScanPlan& plan, const std::vector<ScanRegion>& regions);
+
+private:
+    SizePolicy defaultPolicy;
+    SizePolicy mediaPolicy;                                          // Built-in media and disk image types
+    std::map<std::string, SizePolicy, std::less<>> extensionPolicies; // Overrides, keyed by lowercase extension
+    uint64_t headTailSize;
+    SamplingPolicy sampling;
+    mutable std::shared_mutex mutex;
+
+    const SizePolicy& policyFor(const std::string& filePath) const;
+    std::vector<ScanRegion> sampleRegions(uint64_t fileSize) const;
+};
+
+#endif // SCAN_POLICY_H
@@ -0,0 +1,152 @@
+#include "ScanScheduler.h"
+#include "DirectoryWalker.h"
+#include "IncrementalScanState.h"
+#include "../utils/Logger.h"
+#include "Config.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+    // CPU time consumed by the calling thread, used for duty-cycle pacing
+    std::chrono::nanoseconds threadCpuTime() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+            return std::chrono::nanoseconds(0);
+        }
+        auto toTicks = [](const FILETIME& ft) {
+            return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+        };
+        return std::chrono::nanoseconds((toTicks(kernel) + toTicks(user)) * 100);
+#else
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+#endif
+    }
+}
+
+ScanScheduler::ScanScheduler(FileScanner& scanner)
+    : scanner(scanner), running(false), incremental(Config::BACKGROUND_SCAN_INCREMENTAL),
+      verifyInterval(std::chrono::seconds(Config::BACKGROUND_SCAN_VERIFY_INTERVAL_SEC)),
+      filesScanned(0), threatsFound(0) {}
+
+ScanScheduler::~ScanScheduler() {
+    stop();
+}
+
+void ScanScheduler::start(const std::string& rootPath, bool continuous) {
+    if (running) {
+        Logger::logWarning("Background scan is already running");
+        return;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    running = true;
+    cancelScans.reset();
+    throttle.reset();
+    worker = std::thread(&ScanScheduler::run, this, rootPath, continuous);
+    Logger::logInfo("Background scan started for: " + rootPath);
+}
+
+void ScanScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    cancelScans.cancel();
+    wakeup.notify_all();
+    throttle.interrupt();
+
+    if (worker.joinable()) {
+        worker.join();
+        Logger::logInfo("Background scan stopped");
+    }
+}
+
+bool ScanScheduler::isRunning() const {
+    return running;
+}
+
+void ScanScheduler::run(std::string rootPath, bool continuous) {
+    throttle.applyIoPriority();
+    ChunkedReader::setThreadObserver(&throttle);
+
+    while (running) {
+        scanPass(rootPath);
+        if (!continuous) break;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait_for(lock, std::chrono::seconds(Config::BACKGROUND_SCAN_INTERVAL_SEC),
+                        [this] { return !running; });
+    }
+
+    ChunkedReader::setThreadObserver(nullptr);
+    running = false;
+}
+
+void ScanScheduler::scanPass(const std::string& rootPath) {
+    size_t passThreats = 0;
+    size_t passSkipped = 0;
+    size_t passTimeouts = 0;
+
+    IncrementalScanState state(rootPath, scanner.engineVersion());
+    std::string statePath = IncrementalScanState::statePathFor(rootPath);
+    if (incremental) {
+        state.load(statePath);
+    }
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+    state.beginPass(!incremental || now - std::chrono::seconds(state.lastFullPassTime()) >= verifyInterval.load());
+
+    // Single-threaded walk on this thread, so the throttle observes every read
+    DirectoryWalker walker(1);
+    size_t passFiles = walker.walk(rootPath, [this, &passThreats, &passSkipped, &passTimeouts, &state](FileHandle& file) {
+        if (state.unchanged(file)) {
+            state.recordFile(file, true);
+            passSkipped++;
+            return running.load();
+        }
+
+        throttle.beforeFile();
+        if (!running) return false;
+
+        auto cpuStart = threadCpuTime();
+        ScanStatus status = scanner.scan(
+            file, ScanBudget(std::chrono::milliseconds(Config::FILE_SCAN_TIMEOUT_MS), &cancelScans));
+        // Only complete clean verdicts may be skipped next pass
+        state.recordFile(file, status == ScanStatus::Clean);
+        if (status == ScanStatus::TimedOut) passTimeouts++;
+        if (status == ScanStatus::Threat) {
+            passThreats++;
+            threatsFound++;
+            std::string path = file.path();
+            file.close();
+            scanner.quarantine(path, "Background scan");
+        }
+        filesScanned++;
+
+        throttle.afterFile(threadCpuTime() - cpuStart);
+        return running.load();
+    }, &state);
+
+    if (incremental) {
+        state.save(statePath, running);
+    }
+
+    Logger::logInfo(std::string(state.isFullPass() ? "Full" : "Incremental") + " background scan pass finished: " +
+                    std::to_string(passFiles - passSkipped) + " files scanned, " +
+                    std::to_string(passSkipped) + " unchanged files and " +
+                    std::to_string(state.prunedDirectories()) + " unchanged directories skipped, " +
+                    std::to_string(passThreats) + " threats found, " +
+                    std::to_string(passTimeouts) + " timed out");
+}
\ No newline at end of file
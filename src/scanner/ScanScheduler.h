@@ -0,0 +1,50 @@
+#ifndef SCAN_SCHEDULER_H
+#define SCAN_SCHEDULER_H
+
+#include "FileScanner.h"
+#include "ScanThrottle.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs paced background scans of a directory tree on its own thread
+class ScanScheduler {
+public:
+    explicit ScanScheduler(FileScanner& scanner);
+    ~ScanScheduler();
+
+    // With continuous set, the tree is rescanned every BACKGROUND_SCAN_INTERVAL_SEC
+    void start(const std::string& rootPath, bool continuous = true);
+    void stop();
+    bool isRunning() const;
+
+    // Incremental passes skip what has not changed since the previous pass,
+    // with a full pass at least once per verify interval
+    void setIncremental(bool enabled) { incremental = enabled; }
+    void setVerifyInterval(std::chrono::seconds interval) { verifyInterval = interval; }
+
+    ScanThrottle& getThrottle() { return throttle; }
+    size_t getFilesScanned() const { return filesScanned; }
+    size_t getThreatsFound() const { return threatsFound; }
+
+private:
+    FileScanner& scanner;
+    ScanThrottle throttle;
+    std::thread worker;
+    std::atomic<bool> running;
+    CancellationToken cancelScans;     // Interrupts the file being scanned on stop()
+    std::atomic<bool> incremental;
+    std::atomic<std::chrono::seconds> verifyInterval;
+    std::atomic<size_t> filesScanned;
+    std::atomic<size_t> threatsFound;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+
+    void run(std::string rootPath, bool continuous);
+    void scanPass(const std::string& rootPath);
+};
+
+#endif // SCAN_SCHEDULER_H
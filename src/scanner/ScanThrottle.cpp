@@ -0,0 +1,248 @@
+#include "ScanThrottle.h"
+#include "Config.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace {
+    const double MIN_ADAPTIVE_SCALE = 0.05;
+    const double LATENCY_SMOOTHING = 0.1;
+    const double BASELINE_DRIFT = 1.0005;    // Lets the baseline follow a permanently slower device
+    const size_t MIN_LATENCY_SAMPLE = 4096;  // Smaller reads are dominated by fixed costs
+    const auto ADJUST_INTERVAL = std::chrono::milliseconds(500);
+
+    double burstFor(double rate, double minimum) {
+        return std::max(rate / 4.0, minimum);
+    }
+}
+
+TokenBucket::TokenBucket(double ratePerSecond, double burst)
+    : rate(ratePerSecond), burst(burst), tokens(burst),
+      lastRefill(std::chrono::steady_clock::now()) {}
+
+void TokenBucket::setRate(double ratePerSecond, double newBurst) {
+    refill();
+    rate = ratePerSecond;
+    burst = newBurst;
+    tokens = std::min(tokens, burst);
+    generation++;
+}
+
+double TokenBucket::getRate() const {
+    return rate;
+}
+
+void TokenBucket::refill() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    lastRefill = now;
+    if (rate > 0.0) {
+        tokens = std::min(burst, tokens + elapsed * rate);
+    }
+}
+
+void TokenBucket::acquire(double requested, std::condition_variable& wakeup,
+                          std::unique_lock<std::mutex>& lock, const std::atomic<bool>& interrupted) {
+    refill();
+    if (rate <= 0.0) return;
+
+    tokens -= requested;
+    while (tokens < 0.0 && !interrupted) {
+        // Lifting the limit forgives the debt
+        if (rate <= 0.0) {
+            tokens = 0.0;
+            return;
+        }
+
+        // Wait out the debt at the current rate, starting over if it changes
+        uint64_t seen = generation;
+        auto debt = std::chrono::duration<double>(-tokens / rate);
+        wakeup.wait_for(lock, debt, [&] { return interrupted.load() || generation != seen; });
+        refill();
+    }
+}
+
+ScanThrottle::ScanThrottle()
+    : interrupted(false),
+      priorityChanged(false),
+      byteBucket(Config::BACKGROUND_SCAN_BYTES_PER_SEC,
+                 burstFor(Config::BACKGROUND_SCAN_BYTES_PER_SEC, Config::SCAN_CHUNK_SIZE)),
+      fileBucket(Config::BACKGROUND_SCAN_FILES_PER_SEC,
+                 burstFor(Config::BACKGROUND_SCAN_FILES_PER_SEC, 1.0)),
+      configuredBytesPerSecond(Config::BACKGROUND_SCAN_BYTES_PER_SEC),
+      configuredFilesPerSecond(Config::BACKGROUND_SCAN_FILES_PER_SEC),
+      dutyCycle(Config::BACKGROUND_SCAN_CPU_DUTY),
+      ioPriority(IoPriority::Low),
+      adaptive(true),
+      scale(1.0),
+      latencyAverageMicros(0.0),
+      latencyBaselineMicros(0.0),
+      lastAdjustment(std::chrono::steady_clock::now()) {}
+
+void ScanThrottle::setBytesPerSecond(double bytesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    configuredBytesPerSecond = std::max(0.0, bytesPerSecond);
+    applyScale();
+}
+
+void ScanThrottle::setFilesPerSecond(double filesPerSecond) {
+    std::lock_guard<std::mutex> lock(mutex);
+    configuredFilesPerSecond = std::max(0.0, filesPerSecond);
+    applyScale();
+}
+
+void ScanThrottle::setCpuDutyCycle(double cycle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    dutyCycle = std::clamp(cycle, 0.01, 1.0);
+}
+
+void ScanThrottle::setIoPriority(IoPriority priority) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ioPriority = priority;
+    priorityChanged = true;
+}
+
+void ScanThrottle::setAdaptive(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    adaptive = enabled;
+    if (!adaptive) {
+        scale = 1.0;
+        applyScale();
+    }
+}
+
+double ScanThrottle::getBytesPerSecond() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return configuredBytesPerSecond;
+}
+
+double ScanThrottle::getFilesPerSecond() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return configuredFilesPerSecond;
+}
+
+double ScanThrottle::getCpuDutyCycle() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dutyCycle;
+}
+
+IoPriority ScanThrottle::getIoPriority() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ioPriority;
+}
+
+bool ScanThrottle::isAdaptive() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return adaptive;
+}
+
+double ScanThrottle::getAdaptiveScale() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return scale;
+}
+
+void ScanThrottle::applyIoPriority() const {
+    IoPriority priority = getIoPriority();
+#ifdef __linux__
+    const int IOPRIO_CLASS_SHIFT = 13;
+    const int IOPRIO_CLASS_BE = 2;
+    const int IOPRIO_CLASS_IDLE = 3;
+    const int IOPRIO_WHO_PROCESS = 1;
+
+    int value = IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT | 4;
+    if (priority == IoPriority::Low) value = IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT | 7;
+    if (priority == IoPriority::Idle) value = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+
+    // Who 0 with IOPRIO_WHO_PROCESS means the calling thread
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, value);
+#elif defined(_WIN32)
+    // Background mode lowers both CPU scheduling and I/O priority
+    SetThreadPriority(GetCurrentThread(), priority == IoPriority::Normal
+                                              ? THREAD_MODE_BACKGROUND_END
+                                              : THREAD_MODE_BACKGROUND_BEGIN);
+#else
+    (void)priority;
+#endif
+}
+
+void ScanThrottle::beforeFile() {
+    if (priorityChanged.exchange(false)) {
+        applyIoPriority();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    fileBucket.acquire(1.0, wakeup, lock, interrupted);
+}
+
+void ScanThrottle::afterFile(std::chrono::nanoseconds busyTime) {
+    std::unique_lock<std::mutex> lock(mutex);
+    double effective = dutyCycle * (adaptive ? scale : 1.0);
+    if (effective >= 1.0 || busyTime.count() <= 0) return;
+
+    // Idle long enough that busy time is only `effective` of the total
+    auto pause = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        busyTime * (1.0 / effective - 1.0));
+    sleepFor(pause, lock);
+}
+
+void ScanThrottle::beforeRead(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    byteBucket.acquire(static_cast<double>(bytes), wakeup, lock, interrupted);
+}
+
+void ScanThrottle::afterRead(size_t bytes, std::chrono::nanoseconds latency) {
+    if (bytes < MIN_LATENCY_SAMPLE) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!adaptive) return;
+
+    // Normalize to one full chunk so partial reads compare fairly
+    double sample = std::chrono::duration<double, std::micro>(latency).count() *
+                    Config::SCAN_CHUNK_SIZE / bytes;
+    latencyAverageMicros = latencyAverageMicros == 0.0
+        ? sample
+        : latencyAverageMicros * (1.0 - LATENCY_SMOOTHING) + sample * LATENCY_SMOOTHING;
+    latencyBaselineMicros = latencyBaselineMicros == 0.0
+        ? latencyAverageMicros
+        : std::min(latencyAverageMicros, latencyBaselineMicros * BASELINE_DRIFT);
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastAdjustment < ADJUST_INTERVAL) return;
+    lastAdjustment = now;
+
+    // Multiplicative back-off when the device is struggling, slow recovery otherwise
+    if (latencyAverageMicros > latencyBaselineMicros * Config::ADAPTIVE_LATENCY_FACTOR) {
+        scale = std::max(MIN_ADAPTIVE_SCALE, scale * 0.5);
+        applyScale();
+    } else if (scale < 1.0 && latencyAverageMicros < latencyBaselineMicros * 1.25) {
+        scale = std::min(1.0, scale + 0.05);
+        applyScale();
+    }
+}
+
+void ScanThrottle::interrupt() {
+    interrupted = true;
+    wakeup.notify_all();
+}
+
+void ScanThrottle::reset() {
+    interrupted = false;
+}
+
+void ScanThrottle::applyScale() {
+    double bytesPerSecond = configuredBytesPerSecond * scale;
+    double filesPerSecond = configuredFilesPerSecond * scale;
+    byteBucket.setRate(bytesPerSecond, burstFor(bytesPerSecond, Config::SCAN_CHUNK_SIZE));
+    fileBucket.setRate(filesPerSecond, burstFor(filesPerSecond, 1.0));
+    // Let waiters recompute against the new rates
+    wakeup.notify_all();
+}
+
+void ScanThrottle::sleepFor(std::chrono::nanoseconds duration, std::unique_lock<std::mutex>& lock) {
+    wakeup.wait_for(lock, duration, [this] { return interrupted.load(); });
+}
@@ -0,0 +1,99 @@
+#ifndef SCAN_THROTTLE_H
+#define SCAN_THROTTLE_H
+
+#include "../utils/ChunkedReader.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+enum class IoPriority {
+    Normal,
+    Low,    // Best effort, lowest level
+    Idle    // Only uses the disk when nobody else does
+};
+
+// Classic token bucket. A rate of zero means unlimited.
+class TokenBucket {
+public:
+    TokenBucket(double ratePerSecond, double burst);
+
+    void setRate(double ratePerSecond, double burst);
+    double getRate() const;
+
+    // Blocks until the tokens are available or the wait is interrupted.
+    // Requests larger than the burst are allowed and paid back as debt.
+    // A rate change while waiting takes effect at once; callers must notify
+    // `wakeup` after setRate.
+    void acquire(double tokens, std::condition_variable& wakeup,
+                 std::unique_lock<std::mutex>& lock, const std::atomic<bool>& interrupted);
+
+private:
+    double rate;
+    double burst;
+    double tokens;
+    uint64_t generation = 0;    // Bumped by setRate, so waiters can tell a rate change from a spurious wakeup
+    std::chrono::steady_clock::time_point lastRefill;
+
+    void refill();
+};
+
+// Paces a background scan on bytes/s, files/s and CPU duty cycle. All
+// limits can be changed while a scan is running.
+class ScanThrottle : public ReadObserver {
+public:
+    ScanThrottle();
+
+    void setBytesPerSecond(double bytesPerSecond);
+    void setFilesPerSecond(double filesPerSecond);
+    void setCpuDutyCycle(double dutyCycle);        // Fraction of time allowed busy, (0, 1]
+    void setIoPriority(IoPriority priority);
+    void setAdaptive(bool enabled);
+
+    double getBytesPerSecond() const;
+    double getFilesPerSecond() const;
+    double getCpuDutyCycle() const;
+    IoPriority getIoPriority() const;
+    bool isAdaptive() const;
+    double getAdaptiveScale() const;
+
+    // Applies the I/O priority class to the calling thread
+    void applyIoPriority() const;
+
+    // Also re-applies the I/O priority if it changed since the last file
+    void beforeFile();
+    void afterFile(std::chrono::nanoseconds busyTime);
+
+    void beforeRead(size_t bytes) override;
+    void afterRead(size_t bytes, std::chrono::nanoseconds latency) override;
+
+    // Wakes up any throttled thread; subsequent waits return immediately until reset
+    void interrupt();
+    void reset();
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::atomic<bool> interrupted;
+    std::atomic<bool> priorityChanged;
+
+    TokenBucket byteBucket;
+    TokenBucket fileBucket;
+    double configuredBytesPerSecond;
+    double configuredFilesPerSecond;
+    double dutyCycle;
+    IoPriority ioPriority;
+
+    // Adaptive back-off state
+    bool adaptive;
+    double scale;
+    double latencyAverageMicros;
+    double latencyBaselineMicros;
+    std::chrono::steady_clock::time_point lastAdjustment;
+
+    void applyScale();
+    void sleepFor(std::chrono::nanoseconds duration, std::unique_lock<std::mutex>& lock);
+};
+
+#endif // SCAN_THROTTLE_H
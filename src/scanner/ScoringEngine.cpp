@@ -0,0 +1,139 @@
+#include "ScoringEngine.h"
+#include "../utils/Logger.h"
+#include "../utils/ScanBudget.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    // Declared costs are used until every applicable detector has this many timed runs
+    const uint64_t MIN_TIMED_RUNS = 32;
+}
+
+ScoringEngine::ScoringEngine(float threshold) : threshold(threshold) {}
+
+void ScoringEngine::addDetector(Detector detector) {
+    auto entry = std::make_unique<Entry>();
+    entry->detector = std::move(detector);
+    detectors.push_back(std::move(entry));
+}
+
+float ScoringEngine::weightOf(const std::string& name) const {
+    for (const auto& entry : detectors) {
+        if (entry->detector.name == name) return entry->detector.weight;
+    }
+    return 0.0f;
+}
+
+bool ScoringEngine::appliesTo(std::string_view name, FileType type) const {
+    for (const auto& entry : detectors) {
+        if (entry->detector.name == name) return (entry->detector.fileTypes & FileTypes::bit(type)) != 0;
+    }
+    return false;
+}
+
+double ScoringEngine::expectedCost(const Entry& entry, bool timed) {
+    uint64_t runs = entry.runs.load(std::memory_order_relaxed);
+    double cost = entry.detector.cost;
+    double hitRate = 0.0;
+
+    if (timed) {
+        cost = static_cast<double>(entry.totalMicros.load(std::memory_order_relaxed)) / runs;
+        hitRate = static_cast<double>(entry.hits.load(std::memory_order_relaxed)) / runs;
+    }
+
+    // Cheap, heavy and frequently firing detectors settle the verdict soonest
+    return cost / (entry.detector.weight * (1.0 + hitRate));
+}
+
+std::vector<const ScoringEngine::Entry*> ScoringEngine::executionOrder(FileType type) const {
+    // Declared costs and measured microseconds are not comparable, so the
+    // order switches to timings only once all the candidates have them
+    bool timed = true;
+    for (const auto& entry : detectors) {
+        if ((entry->detector.fileTypes & FileTypes::bit(type)) &&
+            entry->runs.load(std::memory_order_relaxed) < MIN_TIMED_RUNS) {
+            timed = false;
+            break;
+        }
+    }
+
+    std::vector<std::pair<double, const Entry*>> ranked;
+    ranked.reserve(detectors.size());
+    for (const auto& entry : detectors) {
+        if (!(entry->detector.fileTypes & FileTypes::bit(type))) continue;
+        ranked.emplace_back(expectedCost(*entry, timed), entry.get());
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<const Entry*> order;
+    order.reserve(ranked.size());
+    for (const auto& [cost, entry] : ranked) {
+        order.push_back(entry);
+    }
+    return order;
+}
+
+ScanVerdict ScoringEngine::evaluate(const ScanContext& context) const {
+    ScanVerdict verdict{false, 0.0f, 0, {}, true};
+
+    // Weight still to come at each step, summed from the end rather than
+    // subtracted as detectors run, so rounding cannot skip a deciding detector
+    std::vector<const Entry*> order = executionOrder(context.fileType);
+    std::vector<float> remaining(order.size() + 1, 0.0f);
+    for (size_t i = order.size(); i-- > 0;) {
+        remaining[i] = remaining[i + 1] + order[i]->detector.weight;
+    }
+
+    for (size_t i = 0; i < order.size(); i++) {
+        const Entry* entry = order[i];
+        // Stop once the verdict can no longer change either way
+        if (verdict.score >= threshold || verdict.score + remaining[i] < threshold) break;
+        if (ScanBudget::threadExhausted()) {
+            verdict.complete = false;
+            break;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool hit = false;
+        try {
+            hit = entry->detector.run(context);
+        } catch (const std::exception& e) {
+            Logger::logError("Detector " + entry->detector.name + " failed: " + e.what());
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        // A detector cut short by the budget says nothing about the file or its own cost
+        if (!hit && ScanBudget::threadExhausted()) {
+            verdict.complete = false;
+            break;
+        }
+
+        entry->runs.fetch_add(1, std::memory_order_relaxed);
+        entry->totalMicros.fetch_add(static_cast<uint64_t>(elapsed), std::memory_order_relaxed);
+        verdict.detectorsRun++;
+
+        if (hit) {
+            entry->hits.fetch_add(1, std::memory_order_relaxed);
+            verdict.score += entry->detector.weight;
+            verdict.triggered.push_back(entry->detector.name);
+        }
+    }
+
+    verdict.malicious = verdict.score >= threshold;
+    return verdict;
+}
+
+std::vector<DetectorStats> ScoringEngine::getStats() const {
+    std::vector<DetectorStats> result;
+    for (const auto& entry : detectors) {
+        uint64_t runs = entry->runs.load(std::memory_order_relaxed);
+        double average = runs > 0
+            ? static_cast<double>(entry->totalMicros.load(std::memory_order_relaxed)) / runs
+            : 0.0;
+        result.push_back({entry->detector.name, runs,
+                          entry->hits.load(std::memory_order_relaxed), average});
+    }
+    return result;
+}
@@ -0,0 +1,83 @@
+#ifndef SCORING_ENGINE_H
+#define SCORING_ENGINE_H
+
+#include "ScanPolicy.h"
+#include "../utils/FileTypeClassifier.h"
+#include "../utils/ScanSource.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ScanContext {
+    const ScanSource& source;
+    const ScanPlan& plan;
+    FileType fileType = FileType::Unknown;
+};
+
+struct Detector {
+    std::string name;
+    float cost;     // Relative cost estimate, used until every applicable detector has real timings
+    float weight;   // Score added when the detector fires
+    std::function<bool(const ScanContext&)> run;
+    uint32_t fileTypes = FileTypes::ALL;    // Content types the detector runs on
+};
+
+struct DetectorStats {
+    std::string name;
+    uint64_t runs;
+    uint64_t hits;
+    double averageMicros;
+};
+
+struct ScanVerdict {
+    bool malicious;
+    float score;
+    size_t detectorsRun;
+    std::vector<std::string> triggered;
+    bool complete;      // False if the thread's ScanBudget ran out first
+};
+
+// Outcome of scanning one file. A threat found before the budget runs out is
+// final; TimedOut and Cancelled mean nothing was found in the part that ran.
+enum class ScanStatus {
+    Clean,
+    Threat,
+    TimedOut,
+    Cancelled
+};
+
+// Weighted heuristic scoring. Detectors run cheapest-first and evaluation
+// stops as soon as the remaining detectors can no longer change the verdict.
+// Detectors that do not apply to the content type are left out entirely.
+class ScoringEngine {
+public:
+    explicit ScoringEngine(float threshold);
+
+    void addDetector(Detector detector);
+    ScanVerdict evaluate(const ScanContext& context) const;
+    std::vector<DetectorStats> getStats() const;
+    float getThreshold() const { return threshold; }
+    // Weight of the named detector, 0 if none is registered under that name
+    float weightOf(const std::string& name) const;
+    bool appliesTo(std::string_view name, FileType type) const;
+
+private:
+    struct Entry {
+        Detector detector;
+        mutable std::atomic<uint64_t> runs{0};
+        mutable std::atomic<uint64_t> hits{0};
+        mutable std::atomic<uint64_t> totalMicros{0};
+    };
+
+    std::vector<std::unique_ptr<Entry>> detectors;
+    float threshold;
+
+    std::vector<const Entry*> executionOrder(FileType type) const;
+    static double expectedCost(const Entry& entry, bool timed);
+};
+
+#endif // SCORING_ENGINE_H
@@ -1,27 +1,54 @@
 #include "SignatureDatabase.h"
+#include "EngineSnapshot.h"
 #include "../utils/Logger.h"
 #include <fstream>
 #include <algorithm>
 #include <filesystem>
 
-SignatureDatabase::SignatureDatabase(const std::string& dbPath) : dbPath(dbPath) {
+namespace {
+    // Digests are stored and compared in lowercase hex, as the scanner computes them
+    std::string normalizeHash(std::string hash) {
+        std::transform(hash.begin(), hash.end(), hash.begin(), ::tolower);
+        return hash;
+    }
+}
+
+SignatureDatabase::SignatureDatabase(const std::string& dbPath, std::shared_ptr<const EngineSnapshot> snapshot)
+    : dbPath(dbPath) {
+    if (snapshot) {
+        this->snapshot = std::move(snapshot);
+        Logger::logInfo("Loaded " + std::to_string(this->snapshot->signatureCount()) +
+                        " signatures from engine snapshot");
+        return;
+    }
     loadSignatures(dbPath);
 }
 
 bool SignatureDatabase::contains(const std::string& hash) const {
+    std::string normalized = normalizeHash(hash);
     std::lock_guard<std::mutex> lock(mutex);
-    return signatures.find(hash) != signatures.end();
+    if (signatures.find(normalized) != signatures.end()) return true;
+    return snapshot && snapshot->containsSha256(normalized);
 }
 
-void SignatureDatabase::addSignature(const std::string& hash) {
+void SignatureDatabase::addSignature(const std::string& signature) {
+    std::string hash = normalizeHash(signature);
     std::lock_guard<std::mutex> lock(mutex);
-    signatures.insert(hash);
+    if (!signatures.insert(hash).second) return;
+
+    if (snapshot) {
+        // The snapshot holds the rest of the database, so append rather than rewrite
+        std::ofstream file(dbPath, std::ios::app);
+        file << hash << '\n';
+        return;
+    }
     saveSignatures();
 }
 
 void SignatureDatabase::loadSignatures(const std::string& dbPath) {
     std::lock_guard<std::mutex> lock(mutex);
     signatures.clear();
+    snapshot.reset();
 
     try {
         if (!std::filesystem::exists(dbPath)) {
@@ -39,7 +66,7 @@ void SignatureDatabase::loadSignatures(const std::string& dbPath) {
             line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
             
             if (!line.empty()) {
-                signatures.insert(line);
+                signatures.insert(normalizeHash(line));
             }
         }
 
@@ -64,5 +91,5 @@ void SignatureDatabase::saveSignatures() const {
 
 size_t SignatureDatabase::getSignatureCount() const {
     std::lock_guard<std::mutex> lock(mutex);
-    return signatures.size();
+    return signatures.size() + (snapshot ? snapshot->signatureCount() : 0);
 }
\ No newline at end of file
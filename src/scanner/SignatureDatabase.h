@@ -3,11 +3,17 @@
 
 #include <string>
 #include <unordered_set>
+#include <memory>
 #include <mutex>
 
+class EngineSnapshot;
+
 class SignatureDatabase {
 public:
-    explicit SignatureDatabase(const std::string& dbPath);
+    // With a snapshot the text database is not parsed; hashes added later
+    // are kept in memory on top of the snapshot
+    explicit SignatureDatabase(const std::string& dbPath,
+                               std::shared_ptr<const EngineSnapshot> snapshot = nullptr);
     virtual ~SignatureDatabase() = default;  // Add virtual destructor
     
     bool contains(const std::string& hash) const;
@@ -16,7 +22,10 @@ public:
     size_t getSignatureCount() const;
 
 private:
+    friend class EngineSnapshot;
+
     std::unordered_set<std::string> signatures;
+    std::shared_ptr<const EngineSnapshot> snapshot;
     mutable std::mutex mutex;
     std::string dbPath;
 
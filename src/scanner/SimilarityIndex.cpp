@@ -0,0 +1,148 @@
+#include "SimilarityIndex.h"
+#include "EngineSnapshot.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+SimilarityIndex::SimilarityIndex(const std::string& dbPath, std::shared_ptr<const EngineSnapshot> snapshot)
+    : snapshot(std::move(snapshot)), dbPath(dbPath) {
+    if (this->snapshot) {
+        Logger::logInfo("Loaded " + std::to_string(this->snapshot->fuzzyCount()) +
+                        " fuzzy signatures from engine snapshot");
+        return;
+    }
+    load();
+}
+
+void SimilarityIndex::load() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    nodes.clear();
+    labels.clear();
+
+    try {
+        if (!std::filesystem::exists(dbPath)) return;
+
+        std::ifstream file(dbPath);
+        std::string line;
+        size_t rejected = 0;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            if (line.back() == '\r') line.pop_back();
+
+            size_t tab = line.find('\t');
+            FuzzyDigest digest = FuzzyDigest::fromString(line.substr(0, tab));
+            if (!digest.valid) {
+                rejected++;
+                continue;
+            }
+
+            labels.push_back(tab == std::string::npos ? "unnamed" : line.substr(tab + 1));
+            insert(digest, static_cast<uint32_t>(labels.size() - 1));
+        }
+
+        Logger::logInfo("Loaded " + std::to_string(nodes.size()) + " fuzzy signatures");
+        if (rejected > 0) {
+            Logger::logWarning("Skipped " + std::to_string(rejected) + " malformed fuzzy signatures");
+        }
+    } catch (const std::exception& e) {
+        Logger::logError("Error loading fuzzy signatures: " + std::string(e.what()));
+    }
+}
+
+void SimilarityIndex::insert(const FuzzyDigest& digest, uint32_t label) {
+    if (nodes.empty()) {
+        nodes.push_back({digest, label, {}});
+        return;
+    }
+
+    uint32_t current = 0;
+    while (true) {
+        int distance = fuzzyDistance(digest, nodes[current].digest);
+        // Identical digests add nothing to the search
+        if (distance == 0) return;
+
+        auto& children = nodes[current].children;
+        auto it = std::find_if(children.begin(), children.end(),
+                               [distance](const auto& child) { return child.first == distance; });
+        if (it == children.end()) {
+            uint32_t index = static_cast<uint32_t>(nodes.size());
+            children.emplace_back(static_cast<uint16_t>(distance), index);
+            nodes.push_back({digest, label, {}});
+            return;
+        }
+        current = it->second;
+    }
+}
+
+std::optional<SimilarityMatch> SimilarityIndex::findClosest(const FuzzyDigest& digest,
+                                                            int maxDistance) const {
+    if (!digest.valid) return std::nullopt;
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto match = findInMemory(digest, maxDistance);
+    if (!snapshot || (match && match->distance == 0)) return match;
+
+    // The snapshot only needs to beat what the in-memory tree already found
+    auto mapped = snapshot->findClosest(digest, match ? match->distance - 1 : maxDistance);
+    return mapped ? mapped : match;
+}
+
+std::optional<SimilarityMatch> SimilarityIndex::findInMemory(const FuzzyDigest& digest, int maxDistance) const {
+    if (nodes.empty()) return std::nullopt;
+
+    int bestDistance = maxDistance + 1;
+    uint32_t best = 0;
+    std::vector<uint32_t> pending{0};
+
+    while (!pending.empty()) {
+        uint32_t index = pending.back();
+        pending.pop_back();
+
+        const Node& node = nodes[index];
+        int distance = fuzzyDistance(digest, node.digest);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = index;
+            if (distance == 0) break;
+        }
+
+        // Triangle inequality: only children within the current radius can hold a closer match
+        for (const auto& child : node.children) {
+            if (std::abs(child.first - distance) < bestDistance) {
+                pending.push_back(child.second);
+            }
+        }
+    }
+
+    if (bestDistance > maxDistance) return std::nullopt;
+    return SimilarityMatch{labels[nodes[best].label], nodes[best].digest.toString(), bestDistance};
+}
+
+bool SimilarityIndex::addSample(const FuzzyDigest& digest, const std::string& label) {
+    if (!digest.valid) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    try {
+        std::ofstream file(dbPath, std::ios::app);
+        file << digest.toString() << '\t' << label << '\n';
+        if (!file) {
+            Logger::logError("Error saving fuzzy signature to: " + dbPath);
+            return false;
+        }
+
+        labels.push_back(label);
+        insert(digest, static_cast<uint32_t>(labels.size() - 1));
+        return true;
+    } catch (const std::exception& e) {
+        Logger::logError("Error saving fuzzy signature: " + std::string(e.what()));
+        return false;
+    }
+}
+
+size_t SimilarityIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return nodes.size() + (snapshot ? snapshot->fuzzyCount() : 0);
+}
@@ -0,0 +1,58 @@
+#ifndef SIMILARITY_INDEX_H
+#define SIMILARITY_INDEX_H
+
+#include "../utils/FuzzyHash.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class EngineSnapshot;
+
+struct SimilarityMatch {
+    std::string label;
+    std::string digest;
+    int distance;
+};
+
+// Known-bad fuzzy digests in a BK-tree keyed on fuzzyDistance. A lookup
+// within a small radius only visits the subtrees whose edge distance lies
+// inside that radius, so it touches a small fraction of a large reference set.
+//
+// File format, one sample per line: <digest>\t<label>
+//
+// When built from an engine snapshot the tree stays in the mapped file and
+// only samples added afterwards live in memory; lookups search both.
+class SimilarityIndex {
+public:
+    explicit SimilarityIndex(const std::string& dbPath, std::shared_ptr<const EngineSnapshot> snapshot = nullptr);
+
+    // Closest known sample no further than maxDistance away, if any
+    std::optional<SimilarityMatch> findClosest(const FuzzyDigest& digest, int maxDistance) const;
+    bool addSample(const FuzzyDigest& digest, const std::string& label);
+    size_t size() const;
+
+private:
+    friend class EngineSnapshot;
+
+    struct Node {
+        FuzzyDigest digest;
+        uint32_t label;
+        std::vector<std::pair<uint16_t, uint32_t>> children; // (edge distance, node index)
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::string> labels;
+    std::shared_ptr<const EngineSnapshot> snapshot;
+    mutable std::shared_mutex mutex;
+    std::string dbPath;
+
+    void load();
+    void insert(const FuzzyDigest& digest, uint32_t label);
+    std::optional<SimilarityMatch> findInMemory(const FuzzyDigest& digest, int maxDistance) const;
+};
+
+#endif // SIMILARITY_INDEX_H
@@ -0,0 +1,154 @@
+#include "StreamScanner.h"
+#include "../utils/Logger.h"
+#include "../utils/PEParser.h"
+#include "Config.h"
+#include <algorithm>
+#include <limits>
+
+StreamScanner::StreamScanner(const FileScanner& scanner, BufferMetadata metadata)
+    : scanner(scanner), metadata(std::move(metadata)),
+      packerScanner(Utils::packerPatterns()), stringScanner(Utils::suspiciousStringPatterns()),
+      fileType(FileType::Unknown), total(0), score(0.0f), started(false), finished(false),
+      packerFlagged(false), stringsFlagged(false), threat(false) {
+    head.reserve(Config::STREAM_HEAD_SIZE);
+}
+
+ScanStatus StreamScanner::feed(std::span<const std::byte> chunk) {
+    if (threat || finished) return threat ? ScanStatus::Threat : ScanStatus::Clean;
+
+    const auto* data = reinterpret_cast<const unsigned char*>(chunk.data());
+    size_t length = chunk.size();
+    try {
+        if (!started) {
+            size_t taken = std::min(length, Config::STREAM_HEAD_SIZE - head.size());
+            head.insert(head.end(), data, data + taken);
+            total += taken;
+            data += taken;
+            length -= taken;
+            if (head.size() < Config::STREAM_HEAD_SIZE) return ScanStatus::Clean;
+            start();
+        }
+        uint64_t offset = total;
+        total += length;
+        if (!threat && length > 0) {
+            process(data, length, offset);
+        }
+    } catch (const std::exception& e) {
+        Logger::logError("Error scanning stream " + metadata.name + ": " + e.what());
+    }
+    return threat ? ScanStatus::Threat : ScanStatus::Clean;
+}
+
+ScanStatus StreamScanner::finish() {
+    if (threat || finished) return threat ? ScanStatus::Threat : ScanStatus::Clean;
+    finished = true;
+
+    try {
+        if (!started) start();
+        if (threat) return ScanStatus::Threat;
+
+        encodedRuns.finish();
+        if (!stringsFlagged && encodedRuns.blobFound()) {
+            stringsFlagged = true;
+            addScore(FileScanner::DETECTOR_SUSPICIOUS_STRINGS);
+        }
+
+        FileDigests result = digests->finalize();
+        if (!threat && scanner.signatures->contains(result.sha256)) {
+            return reportThreat("Malicious file detected");
+        }
+
+        auto sectionFamily = scanner.peSignatures->findSection(result.sectionMD5);
+        if (!threat && sectionFamily) {
+            return reportThreat("PE section matches " + *sectionFamily);
+        }
+
+        auto variant = scanner.similarityIndex->findClosest(result.fuzzy, Config::FUZZY_MATCH_THRESHOLD);
+        if (!threat && variant) {
+            return reportThreat("Variant of " + variant->label + " detected (distance " +
+                                std::to_string(variant->distance) + ")");
+        }
+
+        if (!threat && applies(FileScanner::DETECTOR_HIGH_ENTROPY) &&
+            histogram.entropy() > Config::HEURISTIC_ENTROPY_THRESHOLD) {
+            addScore(FileScanner::DETECTOR_HIGH_ENTROPY);
+        }
+    } catch (const std::exception& e) {
+        Logger::logError("Error scanning stream " + metadata.name + ": " + e.what());
+    }
+    return threat ? ScanStatus::Threat : ScanStatus::Clean;
+}
+
+void StreamScanner::start() {
+    started = true;
+
+    // The held-back head is parsed in place, like any other buffer
+    ScanSource headSource(std::as_bytes(std::span(head)), metadata.name);
+    fileType = FileTypeClassifier::classify(head, metadata.name).type;
+
+    // Detectors that do not apply to this type count as already settled
+    packerFlagged = !applies(FileScanner::DETECTOR_PACKER_SIGNATURE);
+    stringsFlagged = !applies(FileScanner::DETECTOR_SUSPICIOUS_STRINGS);
+
+    PEInfo peInfo;
+    bool isPE = fileType == FileType::PE && PEParser::parse(headSource, peInfo);
+    if (isPE) {
+        auto family = scanner.peSignatures->findImportHash(PEParser::importHash(peInfo));
+        if (family) {
+            reportThreat("Import table matches " + *family);
+            return;
+        }
+        if (scanner.checkPEFile(headSource)) {
+            addScore(FileScanner::DETECTOR_PE_CHARACTERISTICS);
+        }
+    }
+
+    // The total size is not known yet, so sections are not clamped to it
+    digests = std::make_unique<DigestAccumulator>(
+        isPE ? PEParser::sectionRegions(peInfo, std::numeric_limits<uint64_t>::max())
+             : std::vector<ScanRegion>{});
+    if (!threat) {
+        process(head.data(), head.size(), 0);
+    }
+    head.clear();
+    head.shrink_to_fit();
+}
+
+void StreamScanner::process(const unsigned char* data, size_t length, uint64_t offset) {
+    digests->update(data, length, offset);
+    histogram.update(data, length);
+
+    if (!packerFlagged && packerScanner.update(data, length, offset)) {
+        packerFlagged = true;
+        addScore(FileScanner::DETECTOR_PACKER_SIGNATURE);
+    }
+    if (!stringsFlagged) {
+        bool blob = encodedRuns.update(data, length, offset);
+        bool strings = stringScanner.update(data, length, offset);
+        if (blob || strings) {
+            stringsFlagged = true;
+            addScore(FileScanner::DETECTOR_SUSPICIOUS_STRINGS);
+        }
+    }
+}
+
+bool StreamScanner::applies(const char* detector) const {
+    return scanner.scoringEngine.appliesTo(detector, fileType);
+}
+
+void StreamScanner::addScore(const char* detector) {
+    score += scanner.scoringEngine.weightOf(detector);
+    reasons += (reasons.empty() ? "" : ", ") + std::string(detector);
+
+    if (!threat && score >= scanner.scoringEngine.getThreshold()) {
+        reportThreat("Heuristic score " + std::to_string(score) + " (" + reasons + ") after " +
+                     std::to_string(total) + " bytes");
+    }
+}
+
+ScanStatus StreamScanner::reportThreat(const std::string& reason) {
+    threat = true;
+    Logger::logWarning(reason + ": " + metadata.name +
+                       (metadata.origin.empty() ? "" : " from " + metadata.origin));
+    return ScanStatus::Threat;
+}
@@ -0,0 +1,62 @@
+#ifndef STREAM_SCANNER_H
+#define STREAM_SCANNER_H
+
+#include "FileScanner.h"
+#include "../utils/EncodedRunDetector.h"
+#include "../utils/FileTypeClassifier.h"
+#include "../utils/HashUtil.h"
+#include "../utils/Utils.h"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Push-style scanner for content that arrives in pieces, such as a chunked
+// upload, so it never has to be buffered whole. Hash, histogram and pattern
+// automaton state carry across feed() calls and memory per stream stays
+// constant whatever the content size. The first STREAM_HEAD_SIZE bytes are
+// held back until the PE headers can be parsed from them.
+//
+// Not thread-safe; one StreamScanner per stream. The FileScanner must
+// outlive it.
+class StreamScanner {
+public:
+    StreamScanner(const FileScanner& scanner, BufferMetadata metadata);
+
+    // Threat as soon as the bytes seen so far are known to be malicious, so
+    // the caller can abort the transfer; Clean only means nothing yet.
+    // Chunks fed after a threat are ignored.
+    ScanStatus feed(std::span<const std::byte> chunk);
+    // Final verdict once the whole content has been fed
+    ScanStatus finish();
+
+    uint64_t bytesSeen() const { return total; }
+
+private:
+    const FileScanner& scanner;
+    BufferMetadata metadata;
+    std::vector<unsigned char> head;
+    std::unique_ptr<DigestAccumulator> digests;     // Created once the section table is known
+    Utils::ByteHistogram histogram;
+    Utils::PatternScanner packerScanner;
+    Utils::PatternScanner stringScanner;
+    EncodedRunDetector encodedRuns;
+    FileType fileType;          // Classified from the head
+    uint64_t total;
+    float score;
+    std::string reasons;        // Detectors that have fired so far
+    bool started;
+    bool finished;
+    bool packerFlagged;
+    bool stringsFlagged;
+    bool threat;
+
+    void start();
+    void process(const unsigned char* data, size_t length, uint64_t offset);
+    bool applies(const char* detector) const;
+    void addScore(const char* detector);
+    ScanStatus reportThreat(const std::string& reason);
+};
+
+#endif // STREAM_SCANNER_H
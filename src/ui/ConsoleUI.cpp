@@ -15,7 +15,8 @@ void ConsoleUI::showMainMenu() {
               << "5. Update Signatures\n"
               << "6. Restore Quarantined File\n"
               << "7. Restore All Files\n"
-              << "8. Exit\n"
+              << "8. Background Scan\n"
+              << "9. Exit\n"
               << "Choose an option: ";
 }
 
@@ -43,14 +44,14 @@ void ConsoleUI::showScanResults(int totalFiles, int threats) {
 }
 
 void ConsoleUI::unquarantineFile() {
-    std::cout << "Enter the name of the quarantined file to restore: ";
-    std::string filename;
-    std::getline(std::cin, filename);
-    if (filename.empty()) {
-        std::cout << "Invalid file name.\n";
+    std::cout << "Enter the ID of the quarantined file to restore: ";
+    std::string id;
+    std::getline(std::cin, id);
+    if (id.empty()) {
+        std::cout << "Invalid quarantine ID.\n";
         return;
     }
-    std::cout << "Restoring " << filename << " from quarantine...\n";
+    std::cout << "Restoring " << id << " from quarantine...\n";
 }
 
 void ConsoleUI::unquarantineAll() {
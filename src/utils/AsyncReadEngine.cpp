@@ -0,0 +1,333 @@
+#include "AsyncReadEngine.h"
+#include "Logger.h"
+#include <cstring>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define AV_HAVE_IO_URING 1
+#endif
+#endif
+
+struct AsyncReadEngine::Request {
+    size_t index;
+    unsigned char* buffer;
+    const FileHandle* file;
+    uint64_t offset;
+    size_t length;
+    int64_t result;
+    // Each waiter blocks on its own request (a futex on Linux), so a
+    // completion wakes only the thread that asked for it
+    std::atomic<bool> done;
+    std::chrono::steady_clock::time_point submitted;
+    std::chrono::nanoseconds elapsed;
+#ifdef AV_HAVE_IO_URING
+    iovec iov;
+#endif
+};
+
+#ifdef AV_HAVE_IO_URING
+struct AsyncReadEngine::Ring {
+    int fd = -1;
+    bool fixedBuffers = false;
+
+    void* sqMap = nullptr;
+    size_t sqMapSize = 0;
+    void* cqMap = nullptr;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqMap && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap) munmap(sqMap, sqMapSize);
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+namespace {
+    void* mapRing(int fd, size_t size, off_t offset) {
+        void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return map == MAP_FAILED ? nullptr : map;
+    }
+}
+#else
+struct AsyncReadEngine::Ring {};
+#endif
+
+AsyncReadEngine& AsyncReadEngine::instance() {
+    static AsyncReadEngine engine(Config::ASYNC_READ_BUFFERS, Config::SCAN_CHUNK_SIZE,
+                                  Config::ASYNC_READ_THREADS);
+    return engine;
+}
+
+AsyncReadEngine::AsyncReadEngine(size_t bufferCount, size_t bufferBytes, int fallbackThreads)
+    : bufferBytes(bufferBytes),
+      bufferMemory(new unsigned char[bufferCount * bufferBytes]),
+      running(true) {
+    for (size_t i = 0; i < bufferCount; i++) {
+        auto request = std::make_unique<Request>();
+        request->index = i;
+        request->buffer = bufferMemory.get() + i * bufferBytes;
+        freeRequests.push_back(request.get());
+        requests.push_back(std::move(request));
+    }
+
+    if (setupRing(bufferCount)) {
+        completionThread = std::thread(&AsyncReadEngine::reapCompletions, this);
+    } else {
+        for (int i = 0; i < fallbackThreads; i++) {
+            workers.emplace_back(&AsyncReadEngine::workerLoop, this);
+        }
+    }
+    Logger::logInfo(std::string("Async read engine using ") + backendName());
+}
+
+AsyncReadEngine::~AsyncReadEngine() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+#ifdef AV_HAVE_IO_URING
+    // A no-op completion wakes the reaper so it sees the shutdown
+    if (ring) submitToRing(nullptr);
+#endif
+    queued.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (completionThread.joinable()) {
+        completionThread.join();
+    }
+}
+
+const char* AsyncReadEngine::backendName() const {
+#ifdef AV_HAVE_IO_URING
+    if (ring) return ring->fixedBuffers ? "io_uring with registered buffers" : "io_uring";
+#endif
+    return "thread pool";
+}
+
+bool AsyncReadEngine::setupRing(size_t entries) {
+#ifdef AV_HAVE_IO_URING
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(entries), &params));
+    if (fd < 0) return false;
+
+    auto newRing = std::make_unique<Ring>();
+    newRing->fd = fd;
+
+    newRing->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    newRing->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        newRing->sqMapSize = newRing->cqMapSize = std::max(newRing->sqMapSize, newRing->cqMapSize);
+    }
+
+    newRing->sqMap = mapRing(fd, newRing->sqMapSize, IORING_OFF_SQ_RING);
+    if (!newRing->sqMap) return false;
+    newRing->cqMap = singleMap ? newRing->sqMap : mapRing(fd, newRing->cqMapSize, IORING_OFF_CQ_RING);
+    if (!newRing->cqMap) return false;
+    newRing->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    newRing->sqes = static_cast<io_uring_sqe*>(mapRing(fd, newRing->sqesSize, IORING_OFF_SQES));
+    if (!newRing->sqes) return false;
+
+    auto* sq = static_cast<char*>(newRing->sqMap);
+    newRing->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    newRing->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    newRing->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    auto* cq = static_cast<char*>(newRing->cqMap);
+    newRing->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    newRing->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    newRing->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    newRing->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Registering the pool lets reads skip per-request page pinning; it can
+    // fail under a low RLIMIT_MEMLOCK, in which case plain readv is used
+    std::vector<iovec> iovecs(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        iovecs[i].iov_base = requests[i]->buffer;
+        iovecs[i].iov_len = bufferBytes;
+    }
+    newRing->fixedBuffers = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                                    iovecs.data(), static_cast<unsigned>(iovecs.size())) == 0;
+
+    ring = std::move(newRing);
+    return true;
+#else
+    (void)entries;
+    return false;
+#endif
+}
+
+void AsyncReadEngine::submitToRing(Request* request) {
+#ifdef AV_HAVE_IO_URING
+    // In-flight requests never exceed the buffer count, which the ring was
+    // sized for, so the ring cannot overflow. Only filling the entry needs
+    // the queue lock; the kernel serialises concurrent io_uring_enter calls
+    // and each one submits a single entry in ring order.
+    std::unique_lock<std::mutex> lock(queueMutex);
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+    io_uring_sqe* sqe = &ring->sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    if (!request) {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+    } else if (ring->fixedBuffers) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = request->file->nativeHandle();
+        sqe->addr = reinterpret_cast<uintptr_t>(request->buffer);
+        sqe->len = static_cast<uint32_t>(request->length);
+        sqe->off = request->offset;
+        sqe->buf_index = static_cast<uint16_t>(request->index);
+        sqe->user_data = reinterpret_cast<uintptr_t>(request);
+    } else {
+        request->iov.iov_base = request->buffer;
+        request->iov.iov_len = request->length;
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = request->file->nativeHandle();
+        sqe->addr = reinterpret_cast<uintptr_t>(&request->iov);
+        sqe->len = 1;
+        sqe->off = request->offset;
+        sqe->user_data = reinterpret_cast<uintptr_t>(request);
+    }
+
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    lock.unlock();
+
+    long rc;
+    do {
+        rc = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, nullptr, 0);
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc < 0 && request) {
+        Logger::logError("io_uring submission failed: " + std::string(std::strerror(errno)));
+        complete(request, -1);
+    }
+#else
+    (void)request;
+#endif
+}
+
+void AsyncReadEngine::reapCompletions() {
+#ifdef AV_HAVE_IO_URING
+    while (true) {
+        long rc = syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (rc < 0 && errno != EINTR) {
+            Logger::logError("io_uring wait failed: " + std::string(std::strerror(errno)));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+            auto* request = reinterpret_cast<Request*>(static_cast<uintptr_t>(cqe->user_data));
+            if (request) {
+                complete(request, cqe->res < 0 ? -1 : cqe->res);
+            }
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+
+        if (!running) break;
+    }
+#endif
+}
+
+void AsyncReadEngine::workerLoop() {
+    while (true) {
+        Request* request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queued.wait(lock, [this] { return !queue.empty() || !running; });
+            if (queue.empty()) return;
+            request = queue.front();
+            queue.pop_front();
+        }
+
+        complete(request, request->file->readAt(request->buffer, request->length, request->offset));
+    }
+}
+
+void AsyncReadEngine::complete(Request* request, int64_t result) {
+    request->result = result;
+    request->elapsed = std::chrono::steady_clock::now() - request->submitted;
+    request->done.store(true, std::memory_order_release);
+    request->done.notify_one();
+}
+
+AsyncReadEngine::Request* AsyncReadEngine::submit(const FileHandle& file, uint64_t offset,
+                                                  size_t length, bool block) {
+    Request* request;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (freeRequests.empty()) {
+            if (!block) return nullptr;
+            bufferAvailable.wait(lock, [this] { return !freeRequests.empty(); });
+        }
+        request = freeRequests.back();
+        freeRequests.pop_back();
+    }
+
+    request->file = &file;
+    request->offset = offset;
+    request->length = std::min(length, bufferBytes);
+    request->result = 0;
+    request->done.store(false, std::memory_order_relaxed);
+    request->submitted = std::chrono::steady_clock::now();
+    request->elapsed = std::chrono::nanoseconds(0);
+
+    if (ring) {
+        submitToRing(request);
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(request);
+        }
+        queued.notify_one();
+    }
+    return request;
+}
+
+int64_t AsyncReadEngine::wait(Request* request) {
+    while (!request->done.load(std::memory_order_acquire)) {
+        request->done.wait(false, std::memory_order_acquire);
+    }
+    return request->result;
+}
+
+const unsigned char* AsyncReadEngine::data(const Request* request) const {
+    return request->buffer;
+}
+
+std::chrono::nanoseconds AsyncReadEngine::latency(const Request* request) const {
+    return request->elapsed;
+}
+
+void AsyncReadEngine::release(Request* request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeRequests.push_back(request);
+    }
+    bufferAvailable.notify_one();
+}
@@ -0,0 +1,78 @@
+#ifndef ASYNC_READ_ENGINE_H
+#define ASYNC_READ_ENGINE_H
+
+#include "FileHandle.h"
+#include "Config.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Process-wide asynchronous read engine. Reads land in a fixed pool of
+// buffers (registered with the kernel when io_uring is available) and many
+// can be outstanding at once, so a single scan thread can keep the device
+// queue full. Without io_uring a pool of threads issues positioned reads.
+class AsyncReadEngine {
+public:
+    struct Request;
+
+    static AsyncReadEngine& instance();
+    ~AsyncReadEngine();
+
+    AsyncReadEngine(const AsyncReadEngine&) = delete;
+    AsyncReadEngine& operator=(const AsyncReadEngine&) = delete;
+
+    // Queues a read of up to bufferSize() bytes. If every buffer is in use
+    // this blocks when `block` is set and returns nullptr otherwise.
+    Request* submit(const FileHandle& file, uint64_t offset, size_t length, bool block);
+
+    // Waits for the read; returns the bytes read, 0 at end of file, -1 on error
+    int64_t wait(Request* request);
+    const unsigned char* data(const Request* request) const;
+    std::chrono::nanoseconds latency(const Request* request) const;
+
+    // Returns the buffer to the pool; the request must have completed
+    void release(Request* request);
+
+    size_t bufferSize() const { return bufferBytes; }
+    const char* backendName() const;
+
+private:
+    AsyncReadEngine(size_t bufferCount, size_t bufferBytes, int fallbackThreads);
+
+    size_t bufferBytes;
+    std::unique_ptr<unsigned char[]> bufferMemory;
+    std::vector<std::unique_ptr<Request>> requests;
+    std::vector<Request*> freeRequests;
+
+    // Guards the buffer pool only; submission and completion never take it
+    std::mutex mutex;
+    std::condition_variable bufferAvailable;
+    std::atomic<bool> running;
+
+    // Guards the submission queue of whichever backend is in use
+    std::mutex queueMutex;
+
+    // Thread pool fallback
+    std::deque<Request*> queue;
+    std::condition_variable queued;
+    std::vector<std::thread> workers;
+
+    // io_uring backend
+    struct Ring;
+    std::unique_ptr<Ring> ring;
+    std::thread completionThread;
+
+    bool setupRing(size_t entries);
+    void submitToRing(Request* request);
+    void reapCompletions();
+    void workerLoop();
+    void complete(Request* request, int64_t result);
+};
+
+#endif // ASYNC_READ_ENGINE_H
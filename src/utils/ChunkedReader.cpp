@@ -0,0 +1,165 @@
+#include "ChunkedReader.h"
+#include "AsyncReadEngine.h"
+#include "ScanBudget.h"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace {
+    thread_local ReadObserver* threadObserver = nullptr;
+
+    struct PendingRead {
+        AsyncReadEngine::Request* request;
+        uint64_t offset;
+        size_t length;
+    };
+
+    // Reads in flight for one file, in offset order, in a fixed ring so a
+    // read makes no allocations. Buffers go back to the pool on every exit
+    // path, including a throwing callback.
+    class PendingReads {
+    public:
+        explicit PendingReads(AsyncReadEngine& engine) : engine(engine) {}
+        ~PendingReads() { drain(); }
+
+        void push(const PendingRead& read) { reads[(head + count++) % Config::ASYNC_READ_DEPTH] = read; }
+        PendingRead pop() {
+            PendingRead read = reads[head];
+            head = (head + 1) % Config::ASYNC_READ_DEPTH;
+            count--;
+            return read;
+        }
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+
+        void drain() {
+            while (!empty()) {
+                PendingRead read = pop();
+                engine.wait(read.request);
+                engine.release(read.request);
+            }
+            head = 0;
+        }
+
+    private:
+        AsyncReadEngine& engine;
+        std::array<PendingRead, Config::ASYNC_READ_DEPTH> reads;
+        size_t head = 0;
+        size_t count = 0;
+    };
+}
+
+ChunkedReader::ChunkedReader(size_t chunkSize) : chunkSize(chunkSize > 0 ? chunkSize : Config::SCAN_CHUNK_SIZE) {}
+
+bool ChunkedReader::read(const std::string& filePath, const ChunkCallback& callback) const {
+    FileHandle file = FileHandle::open(filePath);
+    return file.isOpen() && read(file, callback);
+}
+
+bool ChunkedReader::read(const std::string& filePath, const std::vector<ScanRegion>& regions,
+                         const ChunkCallback& callback) const {
+    FileHandle file = FileHandle::open(filePath);
+    return file.isOpen() && read(file, regions, callback);
+}
+
+bool ChunkedReader::read(const ScanSource& source, const ChunkCallback& callback) const {
+    return read(source, {{0, std::numeric_limits<uint64_t>::max()}}, callback);
+}
+
+bool ChunkedReader::read(const ScanSource& source, const std::vector<ScanRegion>& regions,
+                         const ChunkCallback& callback) const {
+    return source.isFile() ? readFile(source.fileHandle(), regions, callback)
+                           : readMemory(source.bytes(), regions, callback);
+}
+
+bool ChunkedReader::readMemory(std::span<const std::byte> buffer, const std::vector<ScanRegion>& regions,
+                               const ChunkCallback& callback) const {
+    const auto* data = reinterpret_cast<const unsigned char*>(buffer.data());
+
+    for (const auto& region : regions) {
+        uint64_t offset = std::min<uint64_t>(region.offset, buffer.size());
+        uint64_t end = offset + std::min<uint64_t>(region.length, buffer.size() - offset);
+
+        while (offset < end) {
+            if (ScanBudget::threadExhausted()) return false;
+
+            size_t length = static_cast<size_t>(std::min<uint64_t>(end - offset, chunkSize));
+            if (!callback(data + offset, length, offset)) return true;
+            offset += length;
+        }
+    }
+    return true;
+}
+
+bool ChunkedReader::readFile(const FileHandle& file, const std::vector<ScanRegion>& regions,
+                             const ChunkCallback& callback) const {
+    if (!file.isOpen()) return false;
+
+    AsyncReadEngine& engine = AsyncReadEngine::instance();
+    const size_t requestSize = std::min(chunkSize, engine.bufferSize());
+    ReadObserver* observer = threadObserver;
+    PendingReads pending(engine);
+
+    for (const auto& region : regions) {
+        uint64_t regionEnd = region.length > std::numeric_limits<uint64_t>::max() - region.offset
+                                 ? std::numeric_limits<uint64_t>::max()
+                                 : region.offset + region.length;
+        uint64_t submitOffset = region.offset;
+
+        while (true) {
+            // Read ahead up to the known end of the file; past it, one read at
+            // a time confirms end of file or picks up appended data
+            uint64_t readAheadEnd = std::min(regionEnd, file.size());
+            while (pending.size() < Config::ASYNC_READ_DEPTH && submitOffset < regionEnd &&
+                   (submitOffset < readAheadEnd || pending.empty())) {
+                size_t length = static_cast<size_t>(std::min<uint64_t>(regionEnd - submitOffset, requestSize));
+                // Only block for a buffer when nothing is in flight, otherwise a
+                // drained pool could leave every scan thread waiting on the others
+                AsyncReadEngine::Request* request = engine.submit(file, submitOffset, length, pending.empty());
+                if (!request) break;
+                if (observer) observer->beforeRead(length);
+                pending.push({request, submitOffset, length});
+                submitOffset += length;
+            }
+            if (pending.empty()) break;
+
+            // An exhausted budget ends the read like an I/O error; in-flight reads are drained
+            if (ScanBudget::threadExhausted()) return false;
+
+            PendingRead read = pending.pop();
+            int64_t bytesRead = engine.wait(read.request);
+            if (observer && bytesRead > 0) {
+                observer->afterRead(static_cast<size_t>(bytesRead), engine.latency(read.request));
+            }
+            if (bytesRead <= 0) {
+                engine.release(read.request);
+                pending.drain();
+                if (bytesRead < 0) return false;
+                break; // End of file
+            }
+
+            bool keepReading;
+            try {
+                keepReading = callback(engine.data(read.request), static_cast<size_t>(bytesRead), read.offset);
+            } catch (...) {
+                engine.release(read.request);
+                throw;
+            }
+            engine.release(read.request);
+            if (!keepReading) return true;
+
+            if (static_cast<size_t>(bytesRead) < read.length) {
+                // Short read: discard the read-ahead and continue where it stopped
+                pending.drain();
+                submitOffset = read.offset + bytesRead;
+            }
+        }
+    }
+
+    return true;
+}
+
+void ChunkedReader::setThreadObserver(ReadObserver* observer) {
+    threadObserver = observer;
+}
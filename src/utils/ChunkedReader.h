@@ -0,0 +1,61 @@
+#ifndef CHUNKED_READER_H
+#define CHUNKED_READER_H
+
+#include "Config.h"
+#include "FileHandle.h"
+#include "ScanSource.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A contiguous byte range of a file that should be fed to the detectors
+struct ScanRegion {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Notified around every chunk read on the thread it is installed on, so
+// background scans can be paced without touching the detectors
+class ReadObserver {
+public:
+    virtual ~ReadObserver() = default;
+    virtual void beforeRead(size_t bytes) = 0;
+    virtual void afterRead(size_t bytes, std::chrono::nanoseconds latency) = 0;
+};
+
+// Streams a file through a callback in fixed-size chunks so that peak memory
+// per file stays bounded, whatever the file size. Reads for FileHandles go
+// through the AsyncReadEngine with up to ASYNC_READ_DEPTH chunks in flight,
+// so the next chunks are loading while the callback processes this one.
+// Memory sources are handed to the callback in place, chunk by chunk.
+class ChunkedReader {
+public:
+    // Return false from the callback to stop reading early
+    using ChunkCallback = std::function<bool(const unsigned char* data, size_t length, uint64_t offset)>;
+
+    explicit ChunkedReader(size_t chunkSize = Config::SCAN_CHUNK_SIZE);
+
+    // All return false if the file could not be opened or read, or the
+    // calling thread's ScanBudget ran out before the read finished
+    bool read(const std::string& filePath, const ChunkCallback& callback) const;
+    bool read(const std::string& filePath, const std::vector<ScanRegion>& regions,
+              const ChunkCallback& callback) const;
+    bool read(const ScanSource& source, const ChunkCallback& callback) const;
+    bool read(const ScanSource& source, const std::vector<ScanRegion>& regions,
+              const ChunkCallback& callback) const;
+
+    // Installs an observer for reads made by the calling thread (nullptr to clear)
+    static void setThreadObserver(ReadObserver* observer);
+
+private:
+    size_t chunkSize;
+
+    bool readFile(const FileHandle& file, const std::vector<ScanRegion>& regions,
+                  const ChunkCallback& callback) const;
+    bool readMemory(std::span<const std::byte> buffer, const std::vector<ScanRegion>& regions,
+                    const ChunkCallback& callback) const;
+};
+
+#endif // CHUNKED_READER_H
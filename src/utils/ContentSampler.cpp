@@ -0,0 +1,91 @@
+#include "ContentSampler.h"
+#include "Utils.h"
+#include "Config.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    const double Z_95 = 1.96;
+}
+
+float SampleEstimate::patternShareBound() const {
+    if (blocks == 0) return 1.0f;
+    // Largest share p for which missing it in every block is still 5% likely: (1 - p)^n = 0.05
+    return static_cast<float>(1.0 - std::pow(0.05, 1.0 / static_cast<double>(blocks)));
+}
+
+std::string SampleEstimate::describe() const {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+                  "%zu blocks (%.2f%% of the file), entropy %.2f +/- %.2f, %.0f%% dense, "
+                  "packer signatures in %zu, suspicious strings in %zu",
+                  blocks, coverage * 100.0f, entropy, entropyMargin, denseShare * 100.0f,
+                  packerBlocks, stringBlocks);
+    std::string result(text);
+    if (packerBlocks == 0 && stringBlocks == 0 && blocks > 0) {
+        std::snprintf(text, sizeof(text), " (under %.1f%% of blocks at 95%% confidence)",
+                      patternShareBound() * 100.0f);
+        result += text;
+    }
+    return result;
+}
+
+SampleEstimate ContentSampler::estimate(const ScanSource& source, const std::vector<ScanRegion>& regions) {
+    const PatternAutomaton& packers = Utils::packerPatterns();
+    const PatternAutomaton& strings = Utils::suspiciousStringPatterns();
+
+    SampleEstimate result;
+    PatternAutomaton::State packerState = PatternAutomaton::START;
+    PatternAutomaton::State stringState = PatternAutomaton::START;
+    uint64_t nextOffset = 0;
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+    size_t dense = 0;
+
+    ChunkedReader reader;
+    result.complete = reader.read(source, regions, [&](const unsigned char* data, size_t length, uint64_t offset) {
+        // Patterns may only continue across chunks that are contiguous
+        if (offset != nextOffset) {
+            packerState = PatternAutomaton::START;
+            stringState = PatternAutomaton::START;
+        }
+        nextOffset = offset + length;
+
+        Utils::ByteHistogram histogram;
+        histogram.update(data, length);
+        double entropy = histogram.entropy();
+        sum += entropy;
+        sumOfSquares += entropy * entropy;
+        if (entropy > Config::HEURISTIC_ENTROPY_THRESHOLD) dense++;
+
+        // A match leaves the state mid-chunk, so start the next chunk afresh
+        if (packers.advance(packerState, data, length)) {
+            result.packerBlocks++;
+            packerState = PatternAutomaton::START;
+        }
+        if (strings.advance(stringState, data, length)) {
+            result.stringBlocks++;
+            stringState = PatternAutomaton::START;
+        }
+
+        result.blocks++;
+        result.bytesSampled += length;
+        return true;
+    });
+
+    if (result.blocks > 0) {
+        double n = static_cast<double>(result.blocks);
+        double mean = sum / n;
+        result.entropy = static_cast<float>(mean);
+        if (result.blocks > 1) {
+            double variance = std::max(0.0, (sumOfSquares - n * mean * mean) / (n - 1));
+            result.entropyMargin = static_cast<float>(Z_95 * std::sqrt(variance / n));
+        }
+        result.denseShare = static_cast<float>(dense / n);
+    }
+    if (source.size() > 0) {
+        result.coverage = static_cast<float>(static_cast<double>(result.bytesSampled) / source.size());
+    }
+    return result;
+}
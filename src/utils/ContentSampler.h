@@ -0,0 +1,37 @@
+#ifndef CONTENT_SAMPLER_H
+#define CONTENT_SAMPLER_H
+
+#include "ChunkedReader.h"
+#include "ScanSource.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a sampled read suggests about the whole file. Each chunk read is one
+// observation, so the margins shrink with the number of blocks sampled.
+struct SampleEstimate {
+    size_t blocks = 0;
+    uint64_t bytesSampled = 0;
+    float coverage = 0.0f;          // Share of the file that was read
+    float entropy = 0.0f;           // Mean bits per byte across blocks
+    float entropyMargin = 8.0f;     // Half-width of the 95% confidence interval of the mean
+    float denseShare = 0.0f;        // Share of blocks above HEURISTIC_ENTROPY_THRESHOLD
+    size_t packerBlocks = 0;        // Blocks with a packer signature
+    size_t stringBlocks = 0;        // Blocks with a suspicious API or library name
+    bool complete = false;          // False if a read failed or the scan budget ran out
+
+    // With 95% confidence, at most this share of the file's blocks holds a
+    // pattern that was seen in none of the samples
+    float patternShareBound() const;
+    std::string describe() const;
+};
+
+// Measures sampled regions of a file in a single pass, for scans that can
+// only afford to read a small part of it
+class ContentSampler {
+public:
+    static SampleEstimate estimate(const ScanSource& source, const std::vector<ScanRegion>& regions);
+};
+
+#endif // CONTENT_SAMPLER_H
@@ -0,0 +1,148 @@
+#include "ElfParser.h"
+#include <algorithm>
+
+namespace {
+    const uint32_t PT_LOAD_TYPE = 1;
+    const uint32_t SHT_RELA_TYPE = 4;
+    const uint32_t SHT_DYNSYM_TYPE = 11;
+    const uint32_t SHT_REL_TYPE = 9;
+    const uint8_t STT_FUNC_TYPE = 2;
+
+    const size_t MAX_SEGMENTS = 64;
+    const size_t MAX_SECTIONS = 4096;
+    const uint64_t MAX_TABLE_SIZE = 64ULL * 1024 * 1024;
+
+    uint16_t le16(const unsigned char* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t le32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint64_t le64(const unsigned char* p) {
+        return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+    }
+
+    // Reads a word sized for the file's class
+    uint64_t word(const unsigned char* p, bool is64) {
+        return is64 ? le64(p) : le32(p);
+    }
+
+    bool readTable(const FileHandle& file, uint64_t offset, uint64_t size, std::vector<unsigned char>& out) {
+        if (size == 0 || size > MAX_TABLE_SIZE || offset > file.size() || size > file.size() - offset) {
+            return false;
+        }
+        out.resize(static_cast<size_t>(size));
+        return file.readAt(out.data(), out.size(), offset) == static_cast<int64_t>(out.size());
+    }
+
+    struct Section {
+        uint32_t type;
+        uint64_t offset;
+        uint64_t size;
+        uint32_t link;
+        uint64_t entrySize;
+    };
+}
+
+bool ElfParser::parse(const FileHandle& file, ElfInfo& info) {
+    info = ElfInfo();
+
+    unsigned char header[64];
+    int64_t headerBytes = file.readAt(header, sizeof(header), 0);
+    if (headerBytes < 52 || header[0] != 0x7F || header[1] != 'E' || header[2] != 'L' || header[3] != 'F') {
+        return false;
+    }
+    if (header[5] != 1) return false; // Little-endian only
+    info.is64 = header[4] == 2;
+    if (info.is64 && headerBytes < 64) return false;
+    info.type = le16(header + 16);
+
+    bool is64 = info.is64;
+    uint64_t phOffset = is64 ? le64(header + 0x20) : le32(header + 0x1C);
+    uint64_t shOffset = is64 ? le64(header + 0x28) : le32(header + 0x20);
+    uint16_t phEntrySize = le16(header + (is64 ? 0x36 : 0x2A));
+    uint16_t phCount = le16(header + (is64 ? 0x38 : 0x2C));
+    uint16_t shEntrySize = le16(header + (is64 ? 0x3A : 0x2E));
+    uint16_t shCount = le16(header + (is64 ? 0x3C : 0x30));
+
+    std::vector<unsigned char> table;
+    if (phCount > 0 && phEntrySize >= (is64 ? 56 : 32) &&
+        readTable(file, phOffset, static_cast<uint64_t>(phEntrySize) * std::min<size_t>(phCount, MAX_SEGMENTS), table)) {
+        for (size_t i = 0; i < std::min<size_t>(phCount, MAX_SEGMENTS); i++) {
+            const unsigned char* ph = table.data() + i * phEntrySize;
+            if (le32(ph) != PT_LOAD_TYPE) continue;
+            ElfSegment segment;
+            if (is64) {
+                segment = {le64(ph + 8), le64(ph + 16), le64(ph + 32), le64(ph + 40), le32(ph + 4)};
+            } else {
+                segment = {le32(ph + 4), le32(ph + 8), le32(ph + 16), le32(ph + 20), le32(ph + 24)};
+            }
+            info.loadSegments.push_back(segment);
+        }
+    }
+
+    // Exports and relocations come from the section table; stripped section
+    // headers simply leave them empty
+    std::vector<Section> sections;
+    if (shCount > 0 && shEntrySize >= (is64 ? 64 : 40) &&
+        readTable(file, shOffset, static_cast<uint64_t>(shEntrySize) * std::min<size_t>(shCount, MAX_SECTIONS), table)) {
+        for (size_t i = 0; i < std::min<size_t>(shCount, MAX_SECTIONS); i++) {
+            const unsigned char* sh = table.data() + i * shEntrySize;
+            if (is64) {
+                sections.push_back({le32(sh + 4), le64(sh + 24), le64(sh + 32), le32(sh + 40), le64(sh + 56)});
+            } else {
+                sections.push_back({le32(sh + 4), le32(sh + 16), le32(sh + 20), le32(sh + 24), le32(sh + 36)});
+            }
+        }
+    }
+
+    const size_t symbolSize = is64 ? 24 : 16;
+    const size_t wordSize = is64 ? 8 : 4;
+    std::vector<unsigned char> strings;
+    for (const auto& section : sections) {
+        if (section.type == SHT_DYNSYM_TYPE && section.link < sections.size()) {
+            const Section& stringSection = sections[section.link];
+            if (!readTable(file, section.offset, section.size, table) ||
+                !readTable(file, stringSection.offset, stringSection.size, strings)) {
+                continue;
+            }
+
+            for (size_t offset = 0; offset + symbolSize <= table.size(); offset += symbolSize) {
+                const unsigned char* sym = table.data() + offset;
+                uint32_t nameOffset = le32(sym);
+                uint8_t symbolInfo = is64 ? sym[4] : sym[12];
+                uint16_t sectionIndex = is64 ? le16(sym + 6) : le16(sym + 14);
+                uint64_t value = is64 ? le64(sym + 8) : le32(sym + 4);
+                uint64_t size = is64 ? le64(sym + 16) : le32(sym + 8);
+
+                if ((symbolInfo & 0x0F) != STT_FUNC_TYPE || sectionIndex == 0 || value == 0) continue;
+                if (nameOffset >= strings.size()) continue;
+
+                auto nameStart = strings.begin() + nameOffset;
+                auto nameEnd = std::find(nameStart, strings.end(), '\0');
+                info.functions.push_back({std::string(nameStart, nameEnd), value, size});
+            }
+        } else if (section.type == SHT_RELA_TYPE || section.type == SHT_REL_TYPE) {
+            size_t entrySize = section.type == SHT_RELA_TYPE ? 3 * wordSize : 2 * wordSize;
+            if (!readTable(file, section.offset, section.size, table)) continue;
+            for (size_t offset = 0; offset + entrySize <= table.size(); offset += entrySize) {
+                info.relocations.push_back(word(table.data() + offset, is64));
+            }
+        }
+    }
+
+    std::sort(info.relocations.begin(), info.relocations.end());
+    return !info.loadSegments.empty();
+}
+
+int64_t ElfParser::addressToOffset(const ElfInfo& info, uint64_t address) {
+    for (const auto& segment : info.loadSegments) {
+        if (address >= segment.virtualAddress && address - segment.virtualAddress < segment.fileSize) {
+            return static_cast<int64_t>(segment.fileOffset + (address - segment.virtualAddress));
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,42 @@
+#ifndef ELF_PARSER_H
+#define ELF_PARSER_H
+
+#include "FileHandle.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ElfSegment {
+    uint64_t fileOffset;
+    uint64_t virtualAddress;
+    uint64_t fileSize;
+    uint64_t memorySize;
+    uint32_t flags;
+};
+
+struct ElfSymbol {
+    std::string name;
+    uint64_t value;
+    uint64_t size;
+};
+
+struct ElfInfo {
+    bool is64 = false;
+    uint16_t type = 0;
+    std::vector<ElfSegment> loadSegments;
+    std::vector<ElfSymbol> functions;       // Defined functions from .dynsym
+    std::vector<uint64_t> relocations;      // Addresses patched by the dynamic loader
+};
+
+// Bounds-checked reader for little-endian ELF files, covering what scanning
+// needs from shared libraries: load segments, exported functions and the
+// addresses the dynamic loader writes to.
+class ElfParser {
+public:
+    static bool parse(const FileHandle& file, ElfInfo& info);
+
+    // File offset backing a virtual address, -1 if it is not file-backed
+    static int64_t addressToOffset(const ElfInfo& info, uint64_t address);
+};
+
+#endif // ELF_PARSER_H
@@ -0,0 +1,167 @@
+#include "EncodedRunDetector.h"
+#include "Config.h"
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENCODED_RUN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    constexpr std::array<bool, 256> makeRunTable() {
+        std::array<bool, 256> table{};
+        for (char c : std::string_view("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=\r\n")) {
+            table[static_cast<unsigned char>(c)] = true;
+        }
+        return table;
+    }
+    constexpr std::array<bool, 256> RUN_CHARS = makeRunTable();
+
+    constexpr std::array<bool, 256> makeHexTable() {
+        std::array<bool, 256> table{};
+        for (char c : std::string_view("0123456789abcdefABCDEF\r\n")) {
+            table[static_cast<unsigned char>(c)] = true;
+        }
+        return table;
+    }
+    constexpr std::array<bool, 256> HEX_CHARS = makeHexTable();
+
+    unsigned countTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+    }
+
+#ifdef ENCODED_RUN_SSE2
+    // Bit i set when data[i] belongs to the base64 alphabet or is a line break
+    uint32_t classify16(const unsigned char* data) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        // Signed compares: bytes of 0x80 and above are negative and match no range
+        auto inRange = [&bytes](const __m128i& value, char low, char high) {
+            return _mm_and_si128(_mm_cmpgt_epi8(value, _mm_set1_epi8(static_cast<char>(low - 1))),
+                                 _mm_cmplt_epi8(value, _mm_set1_epi8(static_cast<char>(high + 1))));
+        };
+        __m128i letters = inRange(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i digits = inRange(bytes, '/', '9');
+        __m128i symbols = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('+')),
+                                       _mm_cmpeq_epi8(bytes, _mm_set1_epi8('=')));
+        __m128i breaks = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')),
+                                      _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+        __m128i all = _mm_or_si128(_mm_or_si128(letters, digits), _mm_or_si128(symbols, breaks));
+        return static_cast<uint32_t>(_mm_movemask_epi8(all));
+    }
+#endif
+
+    // Classifies up to 64 bytes into a bit mask
+    uint64_t classifyBlock(const unsigned char* data, size_t length) {
+        uint64_t mask = 0;
+        size_t i = 0;
+#ifdef ENCODED_RUN_SSE2
+        for (; i + 16 <= length; i += 16) {
+            mask |= static_cast<uint64_t>(classify16(data + i)) << i;
+        }
+#endif
+        for (; i < length; i++) {
+            mask |= static_cast<uint64_t>(RUN_CHARS[data[i]]) << i;
+        }
+        return mask;
+    }
+}
+
+EncodedRunDetector::EncodedRunDetector()
+    : longRunCount(0), pending(nullptr), runOffset(0), runLength(0), nextOffset(0),
+      inRun(false), tracking(false), foundBlob(false) {}
+
+bool EncodedRunDetector::update(const unsigned char* data, size_t length, uint64_t offset) {
+    if (foundBlob) return true;
+
+    // A run cannot continue across a gap between regions
+    if (offset != nextOffset) {
+        endRun();
+    }
+    nextOffset = offset + length;
+
+    for (size_t base = 0; base < length && !foundBlob; base += 64) {
+        size_t blockLength = std::min<size_t>(64, length - base);
+        uint64_t mask = classifyBlock(data + base, blockLength);
+        size_t pos = 0;
+
+        while (pos < blockLength) {
+            if (inRun) {
+                uint64_t breaks = ~mask >> pos;
+                size_t extent = breaks ? std::min<size_t>(countTrailingZeros(breaks), blockLength - pos)
+                                       : blockLength - pos;
+                extendRun(data + base + pos, extent);
+                pos += extent;
+                if (pos < blockLength) {
+                    endRun();
+                    pos++;
+                }
+            } else {
+                uint64_t starts = mask >> pos;
+                if (!starts) break;
+                pos += countTrailingZeros(starts);
+                inRun = true;
+                runOffset = offset + base + pos;
+            }
+        }
+    }
+
+    // Keep the bytes of a short open run; the chunk buffer is about to be reused
+    if (inRun && !tracking && pending) {
+        prefix.append(reinterpret_cast<const char*>(pending), data + length - pending);
+    }
+    pending = nullptr;
+    return foundBlob;
+}
+
+void EncodedRunDetector::finish() {
+    endRun();
+}
+
+void EncodedRunDetector::extendRun(const unsigned char* data, size_t length) {
+    runLength += length;
+    if (tracking) {
+        histogram.update(data, length);
+        return;
+    }
+    if (!pending) pending = data;
+    if (runLength >= Config::ENCODED_RUN_MIN_LENGTH) {
+        tracking = true;
+        histogram.reset();
+        histogram.update(reinterpret_cast<const unsigned char*>(prefix.data()), prefix.size());
+        histogram.update(pending, data + length - pending);
+        prefix.clear();
+        pending = nullptr;
+    }
+}
+
+void EncodedRunDetector::endRun() {
+    if (tracking) {
+        bool hex = true;
+        for (size_t c = 0; c < 256 && hex; c++) {
+            hex = HEX_CHARS[c] || histogram.count(static_cast<unsigned char>(c)) == 0;
+        }
+        EncodedRun run{runOffset, runLength, histogram.entropy(),
+                       hex ? EncodedRunType::Hex : EncodedRunType::Base64, false};
+        run.blob = run.entropy >= (hex ? Config::HEX_BLOB_ENTROPY : Config::BASE64_BLOB_ENTROPY);
+        foundBlob = foundBlob || run.blob;
+        if (longRuns.size() < Config::ENCODED_RUN_MAX_REPORTED) longRuns.push_back(run);
+        longRunCount++;
+    }
+    inRun = false;
+    tracking = false;
+    runLength = 0;
+    prefix.clear();
+    pending = nullptr;
+}
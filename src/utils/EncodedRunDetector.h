@@ -0,0 +1,59 @@
+#ifndef ENCODED_RUN_DETECTOR_H
+#define ENCODED_RUN_DETECTOR_H
+
+#include "Utils.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class EncodedRunType {
+    Base64,
+    Hex
+};
+
+struct EncodedRun {
+    uint64_t offset;
+    uint64_t length;
+    float entropy;
+    EncodedRunType type;
+    bool blob;          // Dense enough to be encoded data rather than text
+};
+
+// Finds long contiguous runs of base64 or hex characters in a stream fed
+// chunk by chunk. Bytes are classified sixteen at a time with SSE2 where
+// available; only runs that reach the minimum length are histogrammed, so
+// ordinary text costs little more than the classification pass. Line breaks
+// do not end a run, so wrapped base64 is reported as one blob.
+class EncodedRunDetector {
+public:
+    EncodedRunDetector();
+
+    // Returns true once a run has been classified as an encoded blob
+    bool update(const unsigned char* data, size_t length, uint64_t offset);
+    // Closes the run still open at the end of the stream
+    void finish();
+
+    bool blobFound() const { return foundBlob; }
+    // The first ENCODED_RUN_MAX_REPORTED runs of at least ENCODED_RUN_MIN_LENGTH
+    // bytes, blob or not; runCount() counts them all
+    const std::vector<EncodedRun>& runs() const { return longRuns; }
+    uint64_t runCount() const { return longRunCount; }
+
+private:
+    std::vector<EncodedRun> longRuns;
+    uint64_t longRunCount;
+    Utils::ByteHistogram histogram;     // Bytes of the current run, once it is long enough
+    std::string prefix;                 // Short run carried over from earlier chunks
+    const unsigned char* pending;       // Start of the current short run within this chunk
+    uint64_t runOffset;
+    uint64_t runLength;
+    uint64_t nextOffset;
+    bool inRun;
+    bool tracking;
+    bool foundBlob;
+
+    void extendRun(const unsigned char* data, size_t length);
+    void endRun();
+};
+
+#endif // ENCODED_RUN_DETECTOR_H
@@ -0,0 +1,88 @@
+#ifndef EXTENSION_SET_H
+#define EXTENSION_SET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Compile-time perfect hash set of file extensions such as ".exe". The seed
+// is searched for at compile time until every extension lands in its own
+// slot, so a lookup is one hash, one slot and one comparison, with no
+// allocation. Lookups ignore ASCII case.
+//
+//   constexpr ExtensionSet SCRIPTS({".js", ".vbs", ".ps1"});
+template <size_t N>
+class ExtensionSet {
+public:
+    constexpr explicit ExtensionSet(const std::string_view (&extensions)[N]) : slots{}, seed(0) {
+        for (uint32_t candidate = 1;; candidate++) {
+            std::array<std::string_view, TABLE_SIZE> table{};
+            bool collision = false;
+            for (size_t i = 0; i < N && !collision; i++) {
+                size_t slot = hash(extensions[i], candidate) & (TABLE_SIZE - 1);
+                collision = !table[slot].empty();
+                table[slot] = extensions[i];
+            }
+            if (!collision) {
+                slots = table;
+                seed = candidate;
+                return;
+            }
+        }
+    }
+
+    constexpr bool contains(std::string_view extension) const {
+        if (extension.empty()) return false;
+        return equalsIgnoreCase(slots[hash(extension, seed) & (TABLE_SIZE - 1)], extension);
+    }
+
+    constexpr bool containsExtensionOf(std::string_view path) const {
+        return contains(extensionOf(path));
+    }
+
+    // Extension of the last path component including the dot, as
+    // std::filesystem reports it, without building a path object
+    static constexpr std::string_view extensionOf(std::string_view path) {
+        size_t separator = path.find_last_of("/\\");
+        std::string_view name = separator == std::string_view::npos ? path : path.substr(separator + 1);
+        if (name == "..") return {};
+        size_t dot = name.rfind('.');
+        if (dot == std::string_view::npos || dot == 0) return {};
+        return name.substr(dot);
+    }
+
+private:
+    // A load factor of at most a quarter keeps the seed search short
+    static constexpr size_t tableSize() {
+        size_t size = 1;
+        while (size < N * 4) size <<= 1;
+        return size;
+    }
+    static constexpr size_t TABLE_SIZE = tableSize();
+
+    std::array<std::string_view, TABLE_SIZE> slots;
+    uint32_t seed;
+
+    static constexpr char lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static constexpr uint32_t hash(std::string_view text, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char c : text) {
+            h = (h ^ static_cast<unsigned char>(lower(c))) * 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    static constexpr bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (lower(a[i]) != lower(b[i])) return false;
+        }
+        return true;
+    }
+};
+
+#endif // EXTENSION_SET_H
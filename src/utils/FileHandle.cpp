@@ -0,0 +1,156 @@
+#include "FileHandle.h"
+#include <utility>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileHandle::~FileHandle() {
+    close();
+}
+
+FileHandle::FileHandle(FileHandle&& other) noexcept {
+    *this = std::move(other);
+}
+
+FileHandle& FileHandle::operator=(FileHandle&& other) noexcept {
+    if (this != &other) {
+        close();
+#ifdef _WIN32
+        handle = std::exchange(other.handle, INVALID_HANDLE_VALUE);
+#else
+        fd = std::exchange(other.fd, -1);
+#endif
+        filePath = std::move(other.filePath);
+        fileSize = other.fileSize;
+        deviceId = other.deviceId;
+        inodeId = other.inodeId;
+        mtime = other.mtime;
+        ctime = other.ctime;
+    }
+    return *this;
+}
+
+bool FileHandle::isOpen() const {
+#ifdef _WIN32
+    return handle != INVALID_HANDLE_VALUE;
+#else
+    return fd >= 0;
+#endif
+}
+
+void FileHandle::close() {
+#ifdef _WIN32
+    if (handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+#ifdef _WIN32
+
+FileHandle FileHandle::open(const std::string& path) {
+    FileHandle file;
+    int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring widePath(sizeNeeded, 0);
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], sizeNeeded);
+
+    file.handle = CreateFileW(widePath.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    file.filePath = path;
+    if (file.isOpen() && !file.loadMetadata()) {
+        file.close();
+    }
+    return file;
+}
+
+bool FileHandle::loadMetadata() {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(handle, &info)) return false;
+    if (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) return false;
+
+    fileSize = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    deviceId = info.dwVolumeSerialNumber;
+    inodeId = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    mtime = static_cast<int64_t>((static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) |
+                                 info.ftLastWriteTime.dwLowDateTime);
+
+    FILE_BASIC_INFO basic;
+    ctime = GetFileInformationByHandleEx(handle, FileBasicInfo, &basic, sizeof(basic))
+                ? basic.ChangeTime.QuadPart : mtime;
+    return true;
+}
+
+int64_t FileHandle::readAt(void* buffer, size_t length, uint64_t offset) const {
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD bytesRead = 0;
+    if (!ReadFile(handle, buffer, static_cast<DWORD>(length), &bytesRead, &overlapped)) {
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return bytesRead;
+}
+
+#else
+
+FileHandle FileHandle::open(const std::string& path) {
+    return openAt(AT_FDCWD, path.c_str(), path);
+}
+
+FileHandle FileHandle::openAt(int dirFd, const char* name, const std::string& path) {
+    const int flags = O_RDONLY | O_CLOEXEC | O_NOCTTY;
+#ifdef O_NOATIME
+    // O_NOATIME keeps scans from dirtying inodes, but only works on files we own
+    int fd = ::openat(dirFd, name, flags | O_NOATIME);
+    if (fd < 0 && errno == EPERM) {
+        fd = ::openat(dirFd, name, flags);
+    }
+#else
+    int fd = ::openat(dirFd, name, flags);
+#endif
+    return adopt(fd, path);
+}
+
+FileHandle FileHandle::adopt(int fd, const std::string& path) {
+    FileHandle file;
+    file.fd = fd;
+    file.filePath = path;
+    if (file.isOpen() && !file.loadMetadata()) {
+        file.close();
+    }
+    return file;
+}
+
+bool FileHandle::loadMetadata() {
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+
+    fileSize = static_cast<uint64_t>(st.st_size);
+    deviceId = static_cast<uint64_t>(st.st_dev);
+    inodeId = static_cast<uint64_t>(st.st_ino);
+    mtime = static_cast<int64_t>(st.st_mtime);
+    ctime = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+    return true;
+}
+
+int64_t FileHandle::readAt(void* buffer, size_t length, uint64_t offset) const {
+    ssize_t n;
+    do {
+        n = ::pread(fd, buffer, length, static_cast<off_t>(offset));
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+#endif
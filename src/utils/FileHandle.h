@@ -0,0 +1,65 @@
+#ifndef FILE_HANDLE_H
+#define FILE_HANDLE_H
+
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Read-only file handle that carries the metadata captured when it was
+// opened, so scan stages never need to stat or reopen the file by path.
+class FileHandle {
+public:
+    FileHandle() = default;
+    ~FileHandle();
+
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+    FileHandle(FileHandle&& other) noexcept;
+    FileHandle& operator=(FileHandle&& other) noexcept;
+
+    static FileHandle open(const std::string& path);
+#ifndef _WIN32
+    // Opens `name` relative to an open directory descriptor
+    static FileHandle openAt(int dirFd, const char* name, const std::string& path);
+    // Takes ownership of an already open descriptor
+    static FileHandle adopt(int fd, const std::string& path);
+    int nativeHandle() const { return fd; }
+#else
+    HANDLE nativeHandle() const { return handle; }
+#endif
+
+    bool isOpen() const;
+    void close();
+
+    const std::string& path() const { return filePath; }
+    uint64_t size() const { return fileSize; }
+    uint64_t device() const { return deviceId; }
+    uint64_t inode() const { return inodeId; }
+    int64_t modifiedTime() const { return mtime; }
+    // Fine-grained metadata change stamp (ctime); only meaningful for equality
+    int64_t changeTime() const { return ctime; }
+
+    // Positioned read that does not move any shared file offset.
+    // Returns the number of bytes read, 0 at end of file, -1 on error.
+    int64_t readAt(void* buffer, size_t length, uint64_t offset) const;
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+    std::string filePath;
+    uint64_t fileSize = 0;
+    uint64_t deviceId = 0;
+    uint64_t inodeId = 0;
+    int64_t mtime = 0;
+    int64_t ctime = 0;
+
+    bool loadMetadata();
+};
+
+#endif // FILE_HANDLE_H
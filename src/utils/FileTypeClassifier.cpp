@@ -0,0 +1,271 @@
+#include "FileTypeClassifier.h"
+#include "ExtensionSet.h"
+#include "Config.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+    using namespace std::string_view_literals;
+
+    struct MagicPart {
+        uint16_t offset;
+        std::string_view bytes;
+    };
+
+    struct MagicSignature {
+        FileType type;
+        const char* description;
+        MagicPart magic;        // Indexed by the trie
+        MagicPart confirm;      // Compared after a trie hit; empty if the magic is enough
+    };
+
+    // Longer and confirmed signatures win over shorter ones they share a prefix with
+    constexpr MagicSignature SIGNATURES[] = {
+        // Executables
+        {FileType::PE, "PE executable", {0, "MZ"sv}, {}},
+        {FileType::ELF, "ELF executable", {0, "\x7F" "ELF"sv}, {}},
+        {FileType::MachO, "Mach-O executable", {0, "\xFE\xED\xFA\xCE"sv}, {}},
+        {FileType::MachO, "Mach-O executable", {0, "\xFE\xED\xFA\xCF"sv}, {}},
+        {FileType::MachO, "Mach-O executable", {0, "\xCE\xFA\xED\xFE"sv}, {}},
+        {FileType::MachO, "Mach-O executable", {0, "\xCF\xFA\xED\xFE"sv}, {}},
+        {FileType::MachO, "Mach-O universal binary", {0, "\xCA\xFE\xBA\xBE"sv}, {}},
+
+        // Scripts
+        {FileType::Script, "script", {0, "#!"sv}, {}},
+        {FileType::Script, "PHP script", {0, "<?php"sv}, {}},
+        {FileType::Script, "batch file", {0, "@echo off"sv}, {}},
+        {FileType::Script, "batch file", {0, "@ECHO OFF"sv}, {}},
+        {FileType::Script, "Windows script file", {0, "<job"sv}, {}},
+        {FileType::Script, "Windows script file", {0, "<package"sv}, {}},
+
+        // Office documents; OOXML and OpenDocument are ZIP files with a known first entry
+        {FileType::Office, "OLE2 compound document", {0, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1"sv}, {}},
+        {FileType::Office, "OOXML document", {0, "PK\x03\x04"sv}, {30, "[Content_Types].xml"sv}},
+        {FileType::Office, "OpenDocument", {0, "PK\x03\x04"sv}, {30, "mimetypeapplication/vnd.oasis"sv}},
+        {FileType::Office, "RTF document", {0, "{\\rtf"sv}, {}},
+        {FileType::PDF, "PDF document", {0, "%PDF-"sv}, {}},
+
+        // Archives
+        {FileType::Archive, "ZIP archive", {0, "PK\x03\x04"sv}, {}},
+        {FileType::Archive, "ZIP archive", {0, "PK\x05\x06"sv}, {}},
+        {FileType::Archive, "RAR archive", {0, "Rar!\x1A\x07"sv}, {}},
+        {FileType::Archive, "7-Zip archive", {0, "7z\xBC\xAF\x27\x1C"sv}, {}},
+        {FileType::Archive, "gzip archive", {0, "\x1F\x8B"sv}, {}},
+        {FileType::Archive, "bzip2 archive", {0, "BZh"sv}, {}},
+        {FileType::Archive, "xz archive", {0, "\xFD" "7zXZ\x00"sv}, {}},
+        {FileType::Archive, "zstd archive", {0, "\x28\xB5\x2F\xFD"sv}, {}},
+        {FileType::Archive, "cabinet archive", {0, "MSCF"sv}, {}},
+        {FileType::Archive, "tar archive", {257, "ustar"sv}, {}},
+
+        // Images
+        {FileType::Image, "PNG image", {0, "\x89PNG\r\n\x1A\n"sv}, {}},
+        {FileType::Image, "JPEG image", {0, "\xFF\xD8\xFF"sv}, {}},
+        {FileType::Image, "GIF image", {0, "GIF87a"sv}, {}},
+        {FileType::Image, "GIF image", {0, "GIF89a"sv}, {}},
+        {FileType::Image, "TIFF image", {0, "II*\x00"sv}, {}},
+        {FileType::Image, "TIFF image", {0, "MM\x00*"sv}, {}},
+        {FileType::Image, "WebP image", {0, "RIFF"sv}, {8, "WEBP"sv}},
+
+        // Audio and video
+        {FileType::Media, "WAV audio", {0, "RIFF"sv}, {8, "WAVE"sv}},
+        {FileType::Media, "AVI video", {0, "RIFF"sv}, {8, "AVI "sv}},
+        {FileType::Media, "MP3 audio", {0, "ID3"sv}, {}},
+        {FileType::Media, "Ogg media", {0, "OggS"sv}, {}},
+        {FileType::Media, "FLAC audio", {0, "fLaC"sv}, {}},
+        {FileType::Media, "Matroska video", {0, "\x1A\x45\xDF\xA3"sv}, {}},
+        {FileType::Media, "FLV video", {0, "FLV\x01"sv}, {}},
+        {FileType::Media, "MP4 video", {4, "ftyp"sv}, {}},
+
+        // Byte order marks
+        {FileType::Text, "UTF-8 text", {0, "\xEF\xBB\xBF"sv}, {}},
+        {FileType::Text, "UTF-16 text", {0, "\xFF\xFE"sv}, {}},
+        {FileType::Text, "UTF-16 text", {0, "\xFE\xFF"sv}, {}},
+    };
+
+    constexpr ExtensionSet SCRIPT_EXTENSIONS({
+        ".ps1", ".psm1", ".vbs", ".vbe", ".js", ".jse", ".wsf", ".hta",
+        ".bat", ".cmd", ".sh", ".py", ".pl"
+    });
+
+    const size_t MAX_MAGIC_LENGTH = 32;
+    const size_t TEXT_SNIFF_SIZE = 512;
+
+    // Byte trie over the signatures that share one magic offset, flattened
+    // into arrays once built so a lookup touches only contiguous memory
+    class MagicTrie {
+    public:
+        explicit MagicTrie(uint16_t offset) : offset(offset) {}
+
+        uint16_t magicOffset() const { return offset; }
+
+        void build(const std::vector<uint16_t>& signatures) {
+            struct BuildNode {
+                std::map<unsigned char, uint32_t> children;
+                std::vector<uint16_t> signatures;
+            };
+            std::vector<BuildNode> building(1);
+
+            for (uint16_t index : signatures) {
+                uint32_t node = 0;
+                for (char c : SIGNATURES[index].magic.bytes) {
+                    auto byte = static_cast<unsigned char>(c);
+                    auto it = building[node].children.find(byte);
+                    if (it == building[node].children.end()) {
+                        building.emplace_back();
+                        it = building[node].children.emplace(byte, static_cast<uint32_t>(building.size() - 1)).first;
+                    }
+                    node = it->second;
+                }
+                building[node].signatures.push_back(index);
+            }
+
+            for (auto& node : building) {
+                // Confirmed signatures are more specific than the bare magic they extend
+                std::stable_sort(node.signatures.begin(), node.signatures.end(), [](uint16_t a, uint16_t b) {
+                    return !SIGNATURES[a].confirm.bytes.empty() && SIGNATURES[b].confirm.bytes.empty();
+                });
+                nodes.push_back({static_cast<uint32_t>(edges.size()), static_cast<uint32_t>(node.children.size()),
+                                 static_cast<uint32_t>(terminals.size()), static_cast<uint32_t>(node.signatures.size())});
+                for (const auto& [byte, child] : node.children) {
+                    edges.push_back({byte, child});
+                }
+                terminals.insert(terminals.end(), node.signatures.begin(), node.signatures.end());
+            }
+        }
+
+        const MagicSignature* match(std::span<const unsigned char> head) const {
+            if (head.size() <= offset) return nullptr;
+
+            // Nodes that end a magic, shallowest first
+            uint32_t hits[MAX_MAGIC_LENGTH];
+            size_t hitCount = 0;
+            uint32_t node = 0;
+            size_t end = std::min(head.size(), offset + MAX_MAGIC_LENGTH);
+            for (size_t i = offset; i < end; i++) {
+                const Node& current = nodes[node];
+                auto first = edges.begin() + current.firstEdge;
+                auto last = first + current.edgeCount;
+                auto edge = std::lower_bound(first, last, head[i],
+                    [](const Edge& e, unsigned char byte) { return e.byte < byte; });
+                if (edge == last || edge->byte != head[i]) break;
+
+                node = edge->child;
+                if (nodes[node].terminalCount > 0) hits[hitCount++] = node;
+            }
+
+            for (size_t k = hitCount; k-- > 0;) {
+                const Node& hit = nodes[hits[k]];
+                for (uint32_t t = 0; t < hit.terminalCount; t++) {
+                    const MagicSignature& signature = SIGNATURES[terminals[hit.firstTerminal + t]];
+                    const MagicPart& confirm = signature.confirm;
+                    if (confirm.bytes.empty() ||
+                        (head.size() >= confirm.offset + confirm.bytes.size() &&
+                         std::memcmp(head.data() + confirm.offset, confirm.bytes.data(), confirm.bytes.size()) == 0)) {
+                        return &signature;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        struct Node {
+            uint32_t firstEdge;
+            uint32_t edgeCount;
+            uint32_t firstTerminal;
+            uint32_t terminalCount;
+        };
+        struct Edge {
+            unsigned char byte;
+            uint32_t child;
+        };
+
+        uint16_t offset;
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;            // Sorted by byte within each node
+        std::vector<uint16_t> terminals;    // Indices into SIGNATURES
+    };
+
+    // One trie per distinct magic offset, in offset order
+    const std::vector<MagicTrie>& magicTries() {
+        static const std::vector<MagicTrie> tries = []() {
+            std::map<uint16_t, std::vector<uint16_t>> byOffset;
+            for (size_t i = 0; i < std::size(SIGNATURES); i++) {
+                if (SIGNATURES[i].magic.bytes.size() > MAX_MAGIC_LENGTH) continue;
+                byOffset[SIGNATURES[i].magic.offset].push_back(static_cast<uint16_t>(i));
+            }
+
+            std::vector<MagicTrie> built;
+            for (const auto& [offset, signatures] : byOffset) {
+                built.emplace_back(offset);
+                built.back().build(signatures);
+            }
+            return built;
+        }();
+        return tries;
+    }
+
+    bool looksLikeText(std::span<const unsigned char> head) {
+        size_t length = std::min(head.size(), TEXT_SNIFF_SIZE);
+        if (length == 0) return false;
+
+        size_t control = 0;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = head[i];
+            if (c == 0) return false;
+            if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != 0x1B) control++;
+        }
+        return control * 20 <= length;
+    }
+}
+
+FileClassification FileTypeClassifier::classify(std::span<const unsigned char> head, std::string_view name) {
+    head = head.first(std::min(head.size(), Config::FILE_TYPE_SNIFF_SIZE));
+
+    FileClassification result{FileType::Unknown, "data"};
+    for (const auto& trie : magicTries()) {
+        if (const MagicSignature* signature = trie.match(head)) {
+            result = {signature->type, signature->description};
+            break;
+        }
+    }
+    if (result.type == FileType::Unknown && looksLikeText(head)) {
+        result = {FileType::Text, "text"};
+    }
+
+    // Most script languages have no header of their own
+    if (result.type == FileType::Text && SCRIPT_EXTENSIONS.containsExtensionOf(name)) {
+        result = {FileType::Script, "script"};
+    }
+    return result;
+}
+
+FileClassification FileTypeClassifier::classify(const ScanSource& source) {
+    if (!source.isFile()) {
+        std::span<const std::byte> bytes = source.bytes();
+        return classify({reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size()}, source.name());
+    }
+
+    unsigned char head[Config::FILE_TYPE_SNIFF_SIZE];
+    int64_t got = source.readAt(head, sizeof(head), 0);
+    return classify({head, got > 0 ? static_cast<size_t>(got) : 0}, source.name());
+}
+
+const char* FileTypeClassifier::typeName(FileType type) {
+    switch (type) {
+        case FileType::PE: return "pe";
+        case FileType::ELF: return "elf";
+        case FileType::MachO: return "macho";
+        case FileType::Script: return "script";
+        case FileType::Archive: return "archive";
+        case FileType::Office: return "office";
+        case FileType::PDF: return "pdf";
+        case FileType::Image: return "image";
+        case FileType::Media: return "media";
+        case FileType::Text: return "text";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef FILE_TYPE_CLASSIFIER_H
+#define FILE_TYPE_CLASSIFIER_H
+
+#include "ScanSource.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+enum class FileType : uint8_t {
+    Unknown,
+    PE,
+    ELF,
+    MachO,
+    Script,
+    Archive,
+    Office,
+    PDF,
+    Image,
+    Media,
+    Text
+};
+
+// Sets of file types, for detectors that only make sense for some content
+namespace FileTypes {
+    constexpr uint32_t bit(FileType type) { return 1u << static_cast<unsigned>(type); }
+
+    constexpr uint32_t ALL = ~0u;
+    constexpr uint32_t EXECUTABLE = bit(FileType::PE) | bit(FileType::ELF) | bit(FileType::MachO);
+    // Compressed by nature, and no place for code that runs on its own
+    constexpr uint32_t MEDIA = bit(FileType::Image) | bit(FileType::Media);
+}
+
+struct FileClassification {
+    FileType type;
+    const char* description;    // Such as "PNG image"; "data" if unrecognized
+};
+
+// Identifies content from the magic bytes in its first FILE_TYPE_SNIFF_SIZE
+// bytes. The signatures are compiled once into a byte trie per magic
+// offset, so classification is a single walk over the head whatever the
+// number of signatures. Text without a recognizable header is reported as a
+// script when the name has a script extension.
+class FileTypeClassifier {
+public:
+    static FileClassification classify(std::span<const unsigned char> head, std::string_view name = {});
+    // Reads the head itself; use the span form when the bytes are already in memory
+    static FileClassification classify(const ScanSource& source);
+
+    static const char* typeName(FileType type);
+};
+
+#endif // FILE_TYPE_CLASSIFIER_H
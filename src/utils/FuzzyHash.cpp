@@ -0,0 +1,177 @@
+#include "FuzzyHash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    // Pearson permutation, generated once at compile time from a fixed seed
+    constexpr std::array<uint8_t, 256> makePearsonTable() {
+        std::array<uint8_t, 256> table{};
+        for (int i = 0; i < 256; i++) table[i] = static_cast<uint8_t>(i);
+        uint32_t state = 0x9E3779B9u;
+        for (int i = 255; i > 0; i--) {
+            state = state * 1664525u + 1013904223u;
+            int j = static_cast<int>((state >> 8) % static_cast<uint32_t>(i + 1));
+            uint8_t tmp = table[i];
+            table[i] = table[j];
+            table[j] = tmp;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> PEARSON = makePearsonTable();
+
+    // L1 distance between two nibbles holding two 2-bit bucket codes each,
+    // indexed by (a << 4) | b
+    constexpr std::array<uint8_t, 256> makeNibbleDistanceTable() {
+        std::array<uint8_t, 256> table{};
+        for (int a = 0; a < 16; a++) {
+            for (int b = 0; b < 16; b++) {
+                int low = (a & 3) - (b & 3);
+                int high = (a >> 2) - (b >> 2);
+                table[(a << 4) | b] = static_cast<uint8_t>((low < 0 ? -low : low) + (high < 0 ? -high : high));
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> NIBBLE_DISTANCE = makeNibbleDistanceTable();
+
+    inline uint8_t pearson(uint8_t salt, uint8_t a, uint8_t b, uint8_t c) {
+        uint8_t h = PEARSON[salt];
+        h = PEARSON[h ^ a];
+        h = PEARSON[h ^ b];
+        return PEARSON[h ^ c];
+    }
+
+    // Log-scale length bucket, so similar sizes get nearby codes
+    uint8_t encodeLength(uint64_t length) {
+        double code;
+        if (length <= 656) {
+            code = std::log(static_cast<double>(length)) / std::log(1.5);
+        } else if (length <= 3199) {
+            code = std::log(static_cast<double>(length)) / std::log(1.3) - 8.72777;
+        } else {
+            code = std::log(static_cast<double>(length)) / std::log(1.1) - 62.5472;
+        }
+        return static_cast<uint8_t>(std::min(255.0, std::max(0.0, std::floor(code))));
+    }
+
+    int circularDistance(int a, int b, int range) {
+        int d = std::abs(a - b);
+        return std::min(d, range - d);
+    }
+}
+
+void FuzzyHasher::update(const unsigned char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c0 = data[i];
+        // window[0] is the previous byte, window[3] the oldest
+        if (total >= 4) {
+            unsigned char c1 = window[0], c2 = window[1], c3 = window[2], c4 = window[3];
+            checksum = pearson(0, c0, c1, checksum);
+            buckets[pearson(2, c0, c1, c2) & 127]++;
+            buckets[pearson(3, c0, c1, c3) & 127]++;
+            buckets[pearson(5, c0, c2, c3) & 127]++;
+            buckets[pearson(7, c0, c2, c4) & 127]++;
+            buckets[pearson(11, c0, c1, c4) & 127]++;
+            buckets[pearson(13, c0, c3, c4) & 127]++;
+        }
+        window[3] = window[2];
+        window[2] = window[1];
+        window[1] = window[0];
+        window[0] = c0;
+        total++;
+    }
+}
+
+FuzzyDigest FuzzyHasher::finalize() const {
+    FuzzyDigest digest;
+    if (total < MIN_INPUT) return digest;
+
+    std::array<uint32_t, 128> sorted = buckets;
+    std::nth_element(sorted.begin(), sorted.begin() + 95, sorted.end());
+    uint32_t q3 = sorted[95];
+    std::nth_element(sorted.begin(), sorted.begin() + 63, sorted.begin() + 95);
+    uint32_t q2 = sorted[63];
+    std::nth_element(sorted.begin(), sorted.begin() + 31, sorted.begin() + 63);
+    uint32_t q1 = sorted[31];
+
+    // Too little variety to say anything about similarity
+    if (q3 == 0) return digest;
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+        uint8_t code = buckets[i] <= q1 ? 0 : buckets[i] <= q2 ? 1 : buckets[i] <= q3 ? 2 : 3;
+        digest.body[i / 4] |= static_cast<uint8_t>(code << ((i % 4) * 2));
+    }
+
+    digest.checksum = checksum;
+    digest.lengthCode = encodeLength(total);
+    digest.q1Ratio = static_cast<uint8_t>((static_cast<uint64_t>(q1) * 100 / q3) % 16);
+    digest.q2Ratio = static_cast<uint8_t>((static_cast<uint64_t>(q2) * 100 / q3) % 16);
+    digest.valid = true;
+    return digest;
+}
+
+void FuzzyDigest::encode(uint8_t* out) const {
+    out[0] = checksum;
+    out[1] = lengthCode;
+    out[2] = static_cast<uint8_t>((q1Ratio << 4) | q2Ratio);
+    std::copy(body.begin(), body.end(), out + 3);
+}
+
+FuzzyDigest FuzzyDigest::decode(const uint8_t* in) {
+    FuzzyDigest digest;
+    digest.checksum = in[0];
+    digest.lengthCode = in[1];
+    digest.q1Ratio = in[2] >> 4;
+    digest.q2Ratio = in[2] & 0x0F;
+    std::copy(in + 3, in + ENCODED_SIZE, digest.body.begin());
+    digest.valid = true;
+    return digest;
+}
+
+std::string FuzzyDigest::toString() const {
+    if (!valid) return "";
+
+    uint8_t bytes[ENCODED_SIZE];
+    encode(bytes);
+
+    std::string text = "T1";
+    char hex[3];
+    for (uint8_t byte : bytes) {
+        std::snprintf(hex, sizeof(hex), "%02X", byte);
+        text += hex;
+    }
+    return text;
+}
+
+FuzzyDigest FuzzyDigest::fromString(const std::string& text) {
+    if (text.size() != 2 + ENCODED_SIZE * 2 || text.compare(0, 2, "T1") != 0) return FuzzyDigest();
+
+    uint8_t bytes[ENCODED_SIZE];
+    for (size_t i = 0; i < ENCODED_SIZE; i++) {
+        char* end = nullptr;
+        std::string pair = text.substr(2 + i * 2, 2);
+        unsigned long value = std::strtoul(pair.c_str(), &end, 16);
+        if (end != pair.c_str() + 2) return FuzzyDigest();
+        bytes[i] = static_cast<uint8_t>(value);
+    }
+    return decode(bytes);
+}
+
+int fuzzyDistance(const FuzzyDigest& a, const FuzzyDigest& b) {
+    // Weighted sum of metrics is itself a metric
+    int distance = a.checksum == b.checksum ? 0 : 1;
+    distance += 4 * circularDistance(a.lengthCode, b.lengthCode, 256);
+    distance += 6 * circularDistance(a.q1Ratio, b.q1Ratio, 16);
+    distance += 6 * circularDistance(a.q2Ratio, b.q2Ratio, 16);
+
+    for (size_t i = 0; i < a.body.size(); i++) {
+        uint8_t x = a.body[i], y = b.body[i];
+        distance += NIBBLE_DISTANCE[((x & 0x0F) << 4) | (y & 0x0F)];
+        distance += NIBBLE_DISTANCE[(x & 0xF0) | (y >> 4)];
+    }
+    return distance;
+}
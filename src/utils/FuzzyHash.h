@@ -0,0 +1,51 @@
+#ifndef FUZZY_HASH_H
+#define FUZZY_HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Locality-sensitive digest in the style of TLSH: a 5-byte sliding window
+// feeds byte-triplet counts into 128 buckets, and each bucket is stored as
+// its quartile (2 bits). Files that differ by a few edits produce digests a
+// small distance apart, which an exact SHA-256 lookup cannot offer.
+struct FuzzyDigest {
+    uint8_t checksum = 0;
+    uint8_t lengthCode = 0;
+    uint8_t q1Ratio = 0;
+    uint8_t q2Ratio = 0;
+    std::array<uint8_t, 32> body{};
+    bool valid = false;
+
+    static constexpr size_t ENCODED_SIZE = 35;
+
+    // "T1" followed by 70 hex digits; empty for an invalid digest
+    std::string toString() const;
+    static FuzzyDigest fromString(const std::string& text);
+
+    // Raw ENCODED_SIZE-byte form, as stored in engine snapshots
+    void encode(uint8_t* out) const;
+    static FuzzyDigest decode(const uint8_t* in);
+};
+
+// Distance between two digests, 0 for identical content. Unlike the original
+// TLSH scoring this is a true metric, so a BK-tree can prune on it.
+int fuzzyDistance(const FuzzyDigest& a, const FuzzyDigest& b);
+
+// Streaming digest builder, fed chunk by chunk alongside the other hashes
+class FuzzyHasher {
+public:
+    static constexpr size_t MIN_INPUT = 50;
+
+    void update(const unsigned char* data, size_t length);
+    FuzzyDigest finalize() const;
+
+private:
+    std::array<uint32_t, 128> buckets{};
+    unsigned char window[4] = {};
+    uint8_t checksum = 0;
+    uint64_t total = 0;
+};
+
+#endif // FUZZY_HASH_H
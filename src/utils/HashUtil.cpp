@@ -1,56 +1,141 @@
 #include "HashUtil.h"
+#include "ChunkedReader.h"
 #include <openssl/sha.h>
 #include <openssl/md5.h>
-#include <fstream>
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    std::string toHex(const unsigned char* bytes, size_t length) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(length * 2, '0');
+        for (size_t i = 0; i < length; i++) {
+            hex[2 * i] = digits[bytes[i] >> 4];
+            hex[2 * i + 1] = digits[bytes[i] & 0x0f];
+        }
+        return hex;
+    }
+}
+
+struct DigestAccumulator::State {
+    SHA256_CTX sha256Context;
+    FuzzyHasher fuzzyHasher;
+    std::vector<ScanRegion> sections;
+    std::vector<MD5_CTX> sectionContexts;
+    std::vector<uint64_t> sectionBytes;
+};
+
+DigestAccumulator::DigestAccumulator(const std::vector<ScanRegion>& sections) : state(std::make_unique<State>()) {
+    SHA256_Init(&state->sha256Context);
+    state->sections = sections;
+    state->sectionContexts.resize(sections.size());
+    state->sectionBytes.assign(sections.size(), 0);
+    for (auto& context : state->sectionContexts) {
+        MD5_Init(&context);
+    }
+}
+
+DigestAccumulator::~DigestAccumulator() = default;
+
+void DigestAccumulator::update(const unsigned char* data, size_t length, uint64_t offset) {
+    SHA256_Update(&state->sha256Context, data, length);
+    state->fuzzyHasher.update(data, length);
+
+    // Feed the part of this chunk that falls inside each section
+    const auto& sections = state->sections;
+    for (size_t i = 0; i < sections.size(); i++) {
+        uint64_t start = std::max(offset, sections[i].offset);
+        uint64_t end = std::min(offset + length, sections[i].offset + sections[i].length);
+        if (start < end) {
+            MD5_Update(&state->sectionContexts[i], data + (start - offset), static_cast<size_t>(end - start));
+            state->sectionBytes[i] += end - start;
+        }
+    }
+}
+
+FileDigests DigestAccumulator::finalize() {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256_Final(hash, &state->sha256Context);
+
+    FileDigests digests{toHex(hash, SHA256_DIGEST_LENGTH), state->fuzzyHasher.finalize(), {}};
+    for (size_t i = 0; i < state->sections.size(); i++) {
+        unsigned char sectionHash[MD5_DIGEST_LENGTH];
+        MD5_Final(sectionHash, &state->sectionContexts[i]);
+        digests.sectionMD5.push_back(state->sectionBytes[i] > 0 ? toHex(sectionHash, MD5_DIGEST_LENGTH) : "");
+    }
+    return digests;
+}
+
+FileDigests HashUtil::computeDigests(const ScanSource& source, const std::vector<ScanRegion>& sections) {
+    DigestAccumulator accumulator(sections);
+
+    ChunkedReader reader;
+    bool readOk = reader.read(source, [&accumulator](const unsigned char* data, size_t length, uint64_t offset) {
+        accumulator.update(data, length, offset);
+        return true;
+    });
+    if (!readOk) {
+        throw std::runtime_error("Cannot read file: " + source.name());
+    }
+    return accumulator.finalize();
+}
 
 std::string HashUtil::computeSHA256(const std::string& filePath) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file) {
+    FileHandle file = FileHandle::open(filePath);
+    if (!file.isOpen()) {
         throw std::runtime_error("Cannot open file: " + filePath);
     }
+    return computeSHA256(file);
+}
 
+std::string HashUtil::computeSHA256(const ScanSource& source) {
     SHA256_CTX sha256Context;
     SHA256_Init(&sha256Context);
 
-    char buffer[8192];
-    while (file.read(buffer, sizeof(buffer))) {
-        SHA256_Update(&sha256Context, buffer, file.gcount());
+    ChunkedReader reader;
+    bool readOk = reader.read(source, [&](const unsigned char* data, size_t length, uint64_t) {
+        SHA256_Update(&sha256Context, data, length);
+        return true;
+    });
+    if (!readOk) {
+        throw std::runtime_error("Cannot read file: " + source.name());
     }
 
     unsigned char hash[SHA256_DIGEST_LENGTH];
     SHA256_Final(hash, &sha256Context);
 
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
-    }
-
-    return ss.str();
+    return toHex(hash, SHA256_DIGEST_LENGTH);
 }
 
 std::string HashUtil::computeMD5(const std::string& filePath) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file) {
+    FileHandle file = FileHandle::open(filePath);
+    if (!file.isOpen()) {
         throw std::runtime_error("Cannot open file: " + filePath);
     }
+    return computeMD5(file);
+}
 
+std::string HashUtil::computeMD5(const ScanSource& source) {
     MD5_CTX md5Context;
     MD5_Init(&md5Context);
 
-    char buffer[8192];
-    while (file.read(buffer, sizeof(buffer))) {
-        MD5_Update(&md5Context, buffer, file.gcount());
+    ChunkedReader reader;
+    bool readOk = reader.read(source, [&](const unsigned char* data, size_t length, uint64_t) {
+        MD5_Update(&md5Context, data, length);
+        return true;
+    });
+    if (!readOk) {
+        throw std::runtime_error("Cannot read file: " + source.name());
     }
 
     unsigned char hash[MD5_DIGEST_LENGTH];
     MD5_Final(hash, &md5Context);
 
-    std::stringstream ss;
-    for (int i = 0; i < MD5_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[i]);
-    }
+    return toHex(hash, MD5_DIGEST_LENGTH);
+}
 
-    return ss.str();
+std::string HashUtil::computeMD5(const unsigned char* data, size_t length) {
+    unsigned char hash[MD5_DIGEST_LENGTH];
+    MD5(data, length, hash);
+    return toHex(hash, MD5_DIGEST_LENGTH);
 }
\ No newline at end of file
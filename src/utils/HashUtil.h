@@ -1,12 +1,44 @@
 #ifndef HASH_UTIL_H
 #define HASH_UTIL_H
 
+#include "ChunkedReader.h"
+#include "FileHandle.h"
+#include "ScanSource.h"
+#include "FuzzyHash.h"
+#include <memory>
 #include <string>
+#include <vector>
+
+struct FileDigests {
+    std::string sha256;
+    FuzzyDigest fuzzy;
+    std::vector<std::string> sectionMD5;   // One per requested section, "" when empty
+};
+
+// Incremental form of HashUtil::computeDigests for content that arrives in
+// pieces. Bytes must be fed in order; sections that receive no bytes get "".
+class DigestAccumulator {
+public:
+    explicit DigestAccumulator(const std::vector<ScanRegion>& sections = {});
+    ~DigestAccumulator();
+
+    void update(const unsigned char* data, size_t length, uint64_t offset);
+    FileDigests finalize();
+
+private:
+    struct State;   // Keeps OpenSSL types out of this header
+    std::unique_ptr<State> state;
+};
 
 class HashUtil {
 public:
+    // Exact, fuzzy and per-section digests from a single pass over the content
+    static FileDigests computeDigests(const ScanSource& source, const std::vector<ScanRegion>& sections = {});
     static std::string computeSHA256(const std::string& filePath);
+    static std::string computeSHA256(const ScanSource& source);
     static std::string computeMD5(const std::string& filePath);
+    static std::string computeMD5(const ScanSource& source);
+    static std::string computeMD5(const unsigned char* data, size_t length);
 };
 
 #endif // HASH_UTIL_H
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <chrono>
 #include <iomanip>
+#include <mutex>
 
 class Logger {
 public:
@@ -26,6 +27,10 @@ public:
 
 private:
     static void log(const std::string& message, const std::string& level) {
+        // Scans run on several threads; keep their lines from interleaving
+        static std::mutex logMutex;
+        std::lock_guard<std::mutex> lock(logMutex);
+
         std::ofstream logFile("logs/scan_results.log", std::ios::app);
         if (logFile.is_open()) {
             auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        mapping = std::exchange(other.mapping, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+MappedFile MappedFile::open(const std::string& path) {
+    MappedFile file;
+    int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    std::wstring widePath(sizeNeeded, 0);
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], sizeNeeded);
+
+    HANDLE handle = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return file;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+        HANDLE section = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (section) {
+            file.mapping = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+            if (file.mapping) file.length = static_cast<size_t>(size.QuadPart);
+            // The view keeps the section alive
+            CloseHandle(section);
+        }
+    }
+    CloseHandle(handle);
+    return file;
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        UnmapViewOfFile(mapping);
+        mapping = nullptr;
+        length = 0;
+    }
+}
+
+#else
+
+MappedFile MappedFile::open(const std::string& path) {
+    MappedFile file;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return file;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            // Lookups jump around; read-ahead would only fault in pages nobody needs
+            madvise(address, static_cast<size_t>(info.st_size), MADV_RANDOM);
+            file.mapping = address;
+            file.length = static_cast<size_t>(info.st_size);
+        }
+    }
+    ::close(fd);
+    return file;
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        munmap(mapping, length);
+        mapping = nullptr;
+        length = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first
+// touch, so mapping a large file costs almost nothing until it is read.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    static MappedFile open(const std::string& path);
+
+    bool isOpen() const { return mapping != nullptr; }
+    const unsigned char* data() const { return static_cast<const unsigned char*>(mapping); }
+    size_t size() const { return length; }
+    void close();
+
+private:
+    void* mapping = nullptr;
+    size_t length = 0;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,17 @@
+#ifndef PE_ORDINALS_H
+#define PE_ORDINALS_H
+
+#include <cstdint>
+#include <string_view>
+
+// Names of functions that common system DLLs export by ordinal only. Import
+// hashes name these imports the way pefile's ordlookup does, so a sample
+// importing ws2_32!23 hashes the same as one importing ws2_32!socket.
+class PEOrdinals {
+public:
+    // `library` is the DLL name as imported, in any case and with its
+    // extension; nullptr if the ordinal is not known for that library
+    static const char* lookup(std::string_view library, uint16_t ordinal);
+};
+
+#endif // PE_ORDINALS_H
@@ -0,0 +1,299 @@
+#include "PEParser.h"
+#include "HashUtil.h"
+#include "PEOrdinals.h"
+#include "ScanBudget.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    const size_t MAX_SECTIONS = 96;
+    const size_t MAX_IMPORT_LIBRARIES = 1024;
+    const size_t MAX_IMPORTS = 16384;               // Thunks examined across all libraries
+    const size_t MAX_THUNKS_PER_LIBRARY = 4096;
+    const size_t THUNK_BATCH = 64;
+    const size_t MAX_NAME_LENGTH = 256;
+    const size_t MAX_EXPORTS = 65536;
+    const size_t MAX_RELOCATIONS = 1 << 20;
+
+    const size_t DIRECTORY_EXPORT = 0;
+    const size_t DIRECTORY_IMPORT = 1;
+    const size_t DIRECTORY_BASERELOC = 5;
+
+    uint16_t le16(const unsigned char* p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t le32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint64_t le64(const unsigned char* p) {
+        return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+    }
+
+    bool readExact(const ScanSource& source, void* buffer, size_t length, uint64_t offset) {
+        return source.readAt(buffer, length, offset) == static_cast<int64_t>(length);
+    }
+
+    bool readString(const ScanSource& source, uint64_t offset, std::string& out) {
+        char buffer[MAX_NAME_LENGTH];
+        int64_t bytesRead = source.readAt(buffer, sizeof(buffer), offset);
+        if (bytesRead <= 0) return false;
+
+        char* end = std::find(buffer, buffer + bytesRead, '\0');
+        if (end == buffer + bytesRead) return false;
+        out.assign(buffer, end);
+        return true;
+    }
+
+    void parseImports(const ScanSource& source, PEInfo& info, uint32_t importRva) {
+        int64_t descriptorOffset = PEParser::rvaToOffset(info, importRva);
+        if (descriptorOffset < 0) return;
+
+        const size_t thunkSize = info.is64 ? 8 : 4;
+        const uint64_t ordinalFlag = info.is64 ? 0x8000000000000000ULL : 0x80000000ULL;
+
+        size_t thunksExamined = 0;
+        for (size_t library = 0; library < MAX_IMPORT_LIBRARIES && thunksExamined < MAX_IMPORTS; library++) {
+            if (ScanBudget::threadExhausted()) return;
+            unsigned char descriptor[20];
+            if (!readExact(source, descriptor, sizeof(descriptor), descriptorOffset + library * 20)) return;
+
+            uint32_t lookupRva = le32(descriptor);
+            uint32_t nameRva = le32(descriptor + 12);
+            uint32_t thunkRva = le32(descriptor + 16);
+            if (nameRva == 0 && thunkRva == 0) return;
+
+            std::string libraryName;
+            int64_t nameOffset = PEParser::rvaToOffset(info, nameRva);
+            if (nameOffset < 0 || !readString(source, nameOffset, libraryName)) continue;
+
+            // Bound imports overwrite the IAT, so prefer the lookup table
+            int64_t thunkOffset = PEParser::rvaToOffset(info, lookupRva != 0 ? lookupRva : thunkRva);
+            if (thunkOffset < 0) continue;
+
+            // Thunks are read a batch at a time; every entry examined counts
+            // against the limits, including those skipped as unreadable
+            unsigned char thunks[THUNK_BATCH * 8];
+            size_t available = 0;
+            for (size_t i = 0; i < MAX_THUNKS_PER_LIBRARY && thunksExamined < MAX_IMPORTS; i++, thunksExamined++) {
+                if (i % THUNK_BATCH == 0) {
+                    if (ScanBudget::threadExhausted()) return;
+                    int64_t got = source.readAt(thunks, THUNK_BATCH * thunkSize, thunkOffset + i * thunkSize);
+                    available = got > 0 ? static_cast<size_t>(got) / thunkSize : 0;
+                }
+                if (i % THUNK_BATCH >= available) break;
+
+                const unsigned char* thunk = thunks + (i % THUNK_BATCH) * thunkSize;
+                uint64_t value = info.is64 ? le64(thunk) : le32(thunk);
+                if (value == 0) break;
+
+                PEImport import{libraryName, "", 0};
+                if (value & ordinalFlag) {
+                    import.ordinal = static_cast<uint16_t>(value & 0xFFFF);
+                } else {
+                    // Hint/name entry: a 2-byte hint followed by the name
+                    int64_t hintOffset = PEParser::rvaToOffset(info, static_cast<uint32_t>(value & 0x7FFFFFFF));
+                    if (hintOffset < 0 || !readString(source, hintOffset + 2, import.function)) continue;
+                }
+                info.imports.push_back(std::move(import));
+            }
+        }
+    }
+}
+
+bool PEParser::parse(const ScanSource& source, PEInfo& info, bool withImports) {
+    info = PEInfo();
+
+    unsigned char dosHeader[64];
+    if (!readExact(source, dosHeader, sizeof(dosHeader), 0)) return false;
+    if (dosHeader[0] != 'M' || dosHeader[1] != 'Z') return false;
+
+    uint32_t ntOffset = le32(dosHeader + 0x3C);
+    if (ntOffset >= source.size()) return false;
+
+    // Signature + file header + the largest optional header we read from
+    unsigned char ntHeaders[4 + 20 + 240];
+    int64_t bytesRead = source.readAt(ntHeaders, sizeof(ntHeaders), ntOffset);
+    if (bytesRead < 24) return false;
+    if (le32(ntHeaders) != 0x00004550) return false; // "PE\0\0"
+
+    const unsigned char* fileHeader = ntHeaders + 4;
+    info.machine = le16(fileHeader);
+    uint16_t sectionCount = le16(fileHeader + 2);
+    uint16_t optionalSize = le16(fileHeader + 16);
+    info.characteristics = le16(fileHeader + 18);
+
+    const unsigned char* optional = fileHeader + 20;
+    size_t optionalAvailable = std::min<size_t>(optionalSize, static_cast<size_t>(bytesRead) - 24);
+    if (optionalAvailable < 72) return false;
+
+    uint16_t magic = le16(optional);
+    if (magic != 0x10B && magic != 0x20B) return false;
+    info.is64 = magic == 0x20B;
+    info.entryPoint = le32(optional + 16);
+    info.imageBase = info.is64 ? le64(optional + 24) : le32(optional + 28);
+    info.subsystem = le16(optional + 68);
+    info.dllCharacteristics = le16(optional + 70);
+
+    uint64_t sectionTable = static_cast<uint64_t>(ntOffset) + 24 + optionalSize;
+    size_t sectionsToRead = std::min<size_t>(sectionCount, MAX_SECTIONS);
+    std::vector<unsigned char> table(sectionsToRead * 40);
+    if (!table.empty() && !readExact(source, table.data(), table.size(), sectionTable)) return false;
+
+    for (size_t i = 0; i < sectionsToRead; i++) {
+        const unsigned char* entry = table.data() + i * 40;
+        PESection section;
+        section.name.assign(reinterpret_cast<const char*>(entry),
+                            std::find(entry, entry + 8, '\0') - entry);
+        section.virtualSize = le32(entry + 8);
+        section.virtualAddress = le32(entry + 12);
+        section.rawSize = le32(entry + 16);
+        section.rawOffset = le32(entry + 20);
+        section.characteristics = le32(entry + 36);
+        info.sections.push_back(std::move(section));
+    }
+
+    // Data directories follow the fixed part of the optional header
+    size_t directoriesOffset = info.is64 ? 112 : 96;
+    if (optionalAvailable >= directoriesOffset) {
+        size_t declared = le32(optional + directoriesOffset - 4);
+        size_t available = (optionalAvailable - directoriesOffset) / 8;
+        for (size_t i = 0; i < std::min<size_t>({declared, available, 16}); i++) {
+            const unsigned char* entry = optional + directoriesOffset + i * 8;
+            info.directories.emplace_back(le32(entry), le32(entry + 4));
+        }
+    }
+
+    if (withImports && info.directories.size() > DIRECTORY_IMPORT) {
+        uint32_t importRva = info.directories[DIRECTORY_IMPORT].first;
+        if (importRva != 0) parseImports(source, info, importRva);
+    }
+
+    return true;
+}
+
+void PEParser::readExports(const ScanSource& source, PEInfo& info) {
+    info.exports.clear();
+    if (info.directories.size() <= DIRECTORY_EXPORT) return;
+
+    auto [exportRva, exportSize] = info.directories[DIRECTORY_EXPORT];
+    int64_t directoryOffset = rvaToOffset(info, exportRva);
+    if (exportRva == 0 || directoryOffset < 0) return;
+
+    unsigned char directory[40];
+    if (!readExact(source, directory, sizeof(directory), directoryOffset)) return;
+    uint32_t functionCount = le32(directory + 20);
+    uint32_t nameCount = std::min<uint32_t>(le32(directory + 24), MAX_EXPORTS);
+    int64_t functions = rvaToOffset(info, le32(directory + 28));
+    int64_t names = rvaToOffset(info, le32(directory + 32));
+    int64_t ordinals = rvaToOffset(info, le32(directory + 36));
+    if (functions < 0 || names < 0 || ordinals < 0) return;
+
+    std::vector<unsigned char> nameTable(nameCount * 4);
+    std::vector<unsigned char> ordinalTable(nameCount * 2);
+    if (nameCount == 0 || !readExact(source, nameTable.data(), nameTable.size(), names) ||
+        !readExact(source, ordinalTable.data(), ordinalTable.size(), ordinals)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < nameCount; i++) {
+        uint16_t ordinal = le16(ordinalTable.data() + i * 2);
+        if (ordinal >= functionCount) continue;
+
+        unsigned char functionRva[4];
+        if (!readExact(source, functionRva, sizeof(functionRva), functions + ordinal * 4)) continue;
+        uint32_t rva = le32(functionRva);
+        // An RVA inside the export directory is a forwarder string, not code
+        if (rva == 0 || (rva >= exportRva && rva - exportRva < exportSize)) continue;
+
+        PEExport entry{"", rva};
+        int64_t nameOffset = rvaToOffset(info, le32(nameTable.data() + i * 4));
+        if (nameOffset < 0 || !readString(source, nameOffset, entry.name)) continue;
+        info.exports.push_back(std::move(entry));
+    }
+}
+
+void PEParser::readRelocations(const ScanSource& source, PEInfo& info) {
+    info.relocations.clear();
+    if (info.directories.size() <= DIRECTORY_BASERELOC) return;
+
+    auto [relocRva, relocSize] = info.directories[DIRECTORY_BASERELOC];
+    int64_t offset = rvaToOffset(info, relocRva);
+    if (relocRva == 0 || offset < 0) return;
+
+    std::vector<unsigned char> table(std::min<uint64_t>(relocSize, source.size()));
+    int64_t bytesRead = source.readAt(table.data(), table.size(), offset);
+    if (bytesRead <= 0) return;
+    table.resize(static_cast<size_t>(bytesRead));
+
+    // Blocks of (page rva, block size) followed by 16-bit type:offset entries
+    size_t position = 0;
+    while (position + 8 <= table.size() && info.relocations.size() < MAX_RELOCATIONS) {
+        uint32_t pageRva = le32(table.data() + position);
+        uint32_t blockSize = le32(table.data() + position + 4);
+        if (blockSize < 8 || position + blockSize > table.size()) break;
+
+        for (size_t entry = position + 8; entry + 2 <= position + blockSize; entry += 2) {
+            uint16_t value = le16(table.data() + entry);
+            uint8_t type = static_cast<uint8_t>(value >> 12);
+            if (type == 3) { // IMAGE_REL_BASED_HIGHLOW
+                info.relocations.push_back({pageRva + (value & 0x0FFF), 4});
+            } else if (type == 10) { // IMAGE_REL_BASED_DIR64
+                info.relocations.push_back({pageRva + (value & 0x0FFF), 8});
+            }
+        }
+        position += blockSize;
+    }
+}
+
+int64_t PEParser::rvaToOffset(const PEInfo& info, uint32_t rva) {
+    for (const auto& section : info.sections) {
+        uint32_t span = std::max(section.virtualSize, section.rawSize);
+        if (rva >= section.virtualAddress && rva - section.virtualAddress < span) {
+            uint32_t delta = rva - section.virtualAddress;
+            if (delta >= section.rawSize) return -1; // Uninitialized data
+            return static_cast<int64_t>(section.rawOffset) + delta;
+        }
+    }
+    return -1;
+}
+
+std::string PEParser::importHash(const PEInfo& info) {
+    if (info.imports.empty()) return "";
+
+    std::string list;
+    for (const auto& import : info.imports) {
+        std::string library = import.library;
+        std::transform(library.begin(), library.end(), library.begin(), ::tolower);
+        for (const char* ext : {".dll", ".ocx", ".sys"}) {
+            size_t length = std::char_traits<char>::length(ext);
+            if (library.size() > length && library.compare(library.size() - length, length, ext) == 0) {
+                library.erase(library.size() - length);
+                break;
+            }
+        }
+
+        std::string function = import.function;
+        if (function.empty()) {
+            const char* known = PEOrdinals::lookup(import.library, import.ordinal);
+            function = known ? known : "ord" + std::to_string(import.ordinal);
+        }
+        std::transform(function.begin(), function.end(), function.begin(), ::tolower);
+
+        if (!list.empty()) list += ',';
+        list += library + "." + function;
+    }
+
+    return HashUtil::computeMD5(reinterpret_cast<const unsigned char*>(list.data()), list.size());
+}
+
+std::vector<ScanRegion> PEParser::sectionRegions(const PEInfo& info, uint64_t fileSize) {
+    std::vector<ScanRegion> regions;
+    for (const auto& section : info.sections) {
+        uint64_t start = std::min<uint64_t>(section.rawOffset, fileSize);
+        regions.push_back({start, std::min<uint64_t>(section.rawSize, fileSize - start)});
+    }
+    return regions;
+}
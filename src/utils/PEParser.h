@@ -0,0 +1,77 @@
+#ifndef PE_PARSER_H
+#define PE_PARSER_H
+
+#include "ChunkedReader.h"
+#include "ScanSource.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PESection {
+    std::string name;
+    uint32_t virtualAddress;
+    uint32_t virtualSize;
+    uint32_t rawOffset;
+    uint32_t rawSize;
+    uint32_t characteristics;
+};
+
+struct PEImport {
+    std::string library;
+    std::string function;   // Empty when imported by ordinal
+    uint16_t ordinal;
+};
+
+struct PEExport {
+    std::string name;
+    uint32_t rva;
+};
+
+// Base relocation: the pointer-sized field at `rva` holds an absolute address
+struct PERelocation {
+    uint32_t rva;
+    uint8_t width;
+};
+
+struct PEInfo {
+    bool is64 = false;
+    uint64_t imageBase = 0;
+    uint16_t machine = 0;
+    uint16_t characteristics = 0;
+    uint16_t subsystem = 0;
+    uint16_t dllCharacteristics = 0;
+    uint32_t entryPoint = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> directories; // (rva, size)
+    std::vector<PESection> sections;
+    std::vector<PEImport> imports;
+    std::vector<PEExport> exports;          // Filled by readExports
+    std::vector<PERelocation> relocations;  // Filled by readRelocations
+};
+
+// Bounds-checked PE reader working on raw little-endian bytes, so it does
+// not depend on the Windows SDK headers and never trusts a length field.
+class PEParser {
+public:
+    static constexpr uint16_t FILE_DLL = 0x2000;
+    static constexpr uint16_t SUBSYSTEM_UNKNOWN = 0;
+    static constexpr uint16_t DLL_DYNAMIC_BASE = 0x0040;
+
+    // Headers and section table, plus the import table when requested.
+    // Returns false if the file is not a well-formed PE image.
+    static bool parse(const ScanSource& source, PEInfo& info, bool withImports = true);
+
+    // Named exports that point at code (forwarders are skipped)
+    static void readExports(const ScanSource& source, PEInfo& info);
+    static void readRelocations(const ScanSource& source, PEInfo& info);
+
+    // Normalized import list hashed the same way as pefile's get_imphash(),
+    // including its names for ws2_32, wsock32 and oleaut32 ordinals
+    static std::string importHash(const PEInfo& info);
+
+    // File range of each section's raw data, clamped to the file size
+    static std::vector<ScanRegion> sectionRegions(const PEInfo& info, uint64_t fileSize);
+
+    static int64_t rvaToOffset(const PEInfo& info, uint32_t rva);
+};
+
+#endif // PE_PARSER_H
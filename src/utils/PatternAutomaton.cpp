@@ -0,0 +1,75 @@
+#include "PatternAutomaton.h"
+#include <queue>
+
+namespace {
+    const PatternAutomaton::State NONE = UINT32_MAX;
+}
+
+PatternAutomaton::PatternAutomaton(const std::vector<std::string>& patterns) : classCount(1) {
+    for (const auto& pattern : patterns) {
+        for (unsigned char c : pattern) {
+            if (byteClass[c] == 0) byteClass[c] = static_cast<uint16_t>(classCount++);
+        }
+    }
+
+    // Trie of the patterns; missing edges are filled in below
+    transitions.assign(classCount, NONE);
+    accepting.assign(1, 0);
+    for (const auto& pattern : patterns) {
+        State state = START;
+        for (unsigned char c : pattern) {
+            State& next = transitions[state * classCount + byteClass[c]];
+            if (next == NONE) {
+                next = static_cast<State>(accepting.size());
+                accepting.push_back(0);
+                transitions.resize(transitions.size() + classCount, NONE);
+            }
+            // resize may have moved the row, so index again
+            state = transitions[state * classCount + byteClass[c]];
+        }
+        accepting[state] = 1;
+    }
+
+    // Breadth-first, so every failure link points at a finished row
+    std::vector<State> failure(accepting.size(), START);
+    std::queue<State> queue;
+    for (size_t c = 0; c < classCount; c++) {
+        State& next = transitions[c];
+        if (next == NONE) {
+            next = START;
+        } else {
+            queue.push(next);
+        }
+    }
+    while (!queue.empty()) {
+        State state = queue.front();
+        queue.pop();
+        accepting[state] |= accepting[failure[state]];
+
+        for (size_t c = 0; c < classCount; c++) {
+            State& next = transitions[state * classCount + c];
+            State fallback = transitions[failure[state] * classCount + c];
+            if (next == NONE) {
+                next = fallback;
+            } else {
+                failure[next] = fallback;
+                queue.push(next);
+            }
+        }
+    }
+}
+
+bool PatternAutomaton::advance(State& state, const unsigned char* data, size_t length) const {
+    if (accepting[state]) return true;
+
+    State current = state;
+    for (size_t i = 0; i < length; i++) {
+        current = transitions[current * classCount + byteClass[data[i]]];
+        if (accepting[current]) {
+            state = current;
+            return true;
+        }
+    }
+    state = current;
+    return false;
+}
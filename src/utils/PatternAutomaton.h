@@ -0,0 +1,32 @@
+#ifndef PATTERN_AUTOMATON_H
+#define PATTERN_AUTOMATON_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Aho-Corasick matcher compiled once per pattern table into a dense
+// transition table over byte classes. The whole match state is a single
+// integer, so it carries across chunk boundaries without keeping any bytes
+// and every byte costs one table lookup, however many patterns there are.
+class PatternAutomaton {
+public:
+    using State = uint32_t;
+    static constexpr State START = 0;
+
+    explicit PatternAutomaton(const std::vector<std::string>& patterns);
+
+    // Advances over data; returns true as soon as any pattern has ended
+    bool advance(State& state, const unsigned char* data, size_t length) const;
+    size_t stateCount() const { return accepting.size(); }
+
+private:
+    std::array<uint16_t, 256> byteClass{};   // Class 0 is every byte no pattern uses
+    size_t classCount;
+    std::vector<State> transitions;          // stateCount() rows of classCount entries
+    std::vector<uint8_t> accepting;
+};
+
+#endif // PATTERN_AUTOMATON_H
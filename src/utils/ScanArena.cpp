@@ -0,0 +1,33 @@
+#include "ScanArena.h"
+#include "Config.h"
+#include <memory>
+#include <optional>
+
+namespace {
+    struct ThreadArena {
+        std::unique_ptr<unsigned char[]> block;
+        std::optional<std::pmr::monotonic_buffer_resource> resource;
+        int depth = 0;
+    };
+
+    thread_local ThreadArena arena;
+}
+
+std::pmr::memory_resource* ScanArena::resource() {
+    return arena.resource ? &*arena.resource : std::pmr::new_delete_resource();
+}
+
+ScanArena::Scope::Scope() {
+    if (arena.depth++ > 0) return;
+
+    if (!arena.block) {
+        arena.block = std::make_unique<unsigned char[]>(Config::SCAN_ARENA_SIZE);
+    }
+    // A fresh resource over the same block starts again from its beginning
+    arena.resource.emplace(arena.block.get(), Config::SCAN_ARENA_SIZE, std::pmr::new_delete_resource());
+}
+
+ScanArena::Scope::~Scope() {
+    if (--arena.depth > 0) return;
+    arena.resource.reset();
+}
@@ -0,0 +1,32 @@
+#ifndef SCAN_ARENA_H
+#define SCAN_ARENA_H
+
+#include <memory_resource>
+
+// Per-thread bump allocator for temporaries that live no longer than one
+// file event. The outermost Scope on a thread marks the start of an event;
+// when it ends, everything allocated since is dropped at once and the block
+// is reused for the next one. Only allocations made through resource() are
+// served from the block, so a scope saves nothing by itself. The real-time
+// handler uses it for its path strings; FileScanner's per-file values
+// (digests, PE imports, region lists) are std containers passed through
+// APIs that are not allocator-aware, so file scans open no scope. Requests
+// beyond the block spill to the heap.
+//
+// Only objects local to the scope may use resource(); outside any scope it
+// is plain new/delete.
+class ScanArena {
+public:
+    static std::pmr::memory_resource* resource();
+
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+#endif // SCAN_ARENA_H
@@ -0,0 +1,40 @@
+#include "ScanBudget.h"
+
+namespace {
+    thread_local const ScanBudget::Scope* innermostScope = nullptr;
+}
+
+ScanBudget::ScanBudget() : deadline(std::chrono::steady_clock::time_point::max()), token(nullptr) {}
+
+ScanBudget::ScanBudget(std::chrono::milliseconds timeout, const CancellationToken* token)
+    : deadline(timeout.count() > 0 ? std::chrono::steady_clock::now() + timeout
+                                   : std::chrono::steady_clock::time_point::max()),
+      token(token) {}
+
+ScanBudget::State ScanBudget::check() const {
+    if (token && token->isCancelled()) return State::Cancelled;
+    if (deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() >= deadline) {
+        return State::TimedOut;
+    }
+    return State::Ok;
+}
+
+ScanBudget::State ScanBudget::threadState() {
+    State result = State::Ok;
+    for (const Scope* scope = innermostScope; scope; scope = scope->outer) {
+        State state = scope->budget.check();
+        // Cancellation wins over a timeout
+        if (state == State::Cancelled) return state;
+        if (state == State::TimedOut) result = state;
+    }
+    return result;
+}
+
+ScanBudget::Scope::Scope(const ScanBudget& budget) : budget(budget), outer(innermostScope) {
+    innermostScope = this;
+}
+
+ScanBudget::Scope::~Scope() {
+    innermostScope = outer;
+}
@@ -0,0 +1,63 @@
+#ifndef SCAN_BUDGET_H
+#define SCAN_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+
+// Shared flag that asks every scan holding it to stop at its next check
+class CancellationToken {
+public:
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled.store(false, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled{false};
+};
+
+// Deadline and cancellation for one unit of scan work. Budgets are checked
+// cooperatively at chunk and stage boundaries, so a single blocking read can
+// still overrun by up to one chunk.
+//
+// A Scope installs a budget for the calling thread; ChunkedReader, the
+// detectors and the behavior analyzer check every budget installed on the
+// thread, so nested scopes can only shorten the time available.
+class ScanBudget {
+public:
+    enum class State {
+        Ok,
+        TimedOut,
+        Cancelled
+    };
+
+    // Unlimited
+    ScanBudget();
+    // A timeout of zero means no deadline
+    explicit ScanBudget(std::chrono::milliseconds timeout, const CancellationToken* token = nullptr);
+
+    State check() const;
+
+    // Combined state of every budget installed on the calling thread
+    static State threadState();
+    static bool threadExhausted() { return threadState() != State::Ok; }
+
+    class Scope {
+    public:
+        explicit Scope(const ScanBudget& budget);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        friend class ScanBudget;
+        const ScanBudget& budget;
+        const Scope* outer;
+    };
+
+private:
+    std::chrono::steady_clock::time_point deadline;
+    const CancellationToken* token;
+};
+
+#endif // SCAN_BUDGET_H
@@ -0,0 +1,12 @@
+#include "ScanSource.h"
+#include <algorithm>
+#include <cstring>
+
+int64_t ScanSource::readAt(void* destination, size_t length, uint64_t offset) const {
+    if (file) return file->readAt(destination, length, offset);
+
+    if (offset >= buffer.size()) return 0;
+    size_t count = static_cast<size_t>(std::min<uint64_t>(length, buffer.size() - offset));
+    std::memcpy(destination, buffer.data() + offset, count);
+    return static_cast<int64_t>(count);
+}
@@ -0,0 +1,39 @@
+#ifndef SCAN_SOURCE_H
+#define SCAN_SOURCE_H
+
+#include "FileHandle.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+
+// The bytes a scan reads: an open file, or memory owned by the caller that
+// is scanned in place. Non-owning; the file or buffer must outlive it.
+class ScanSource {
+public:
+    // Implicit, so everything that took a FileHandle still accepts one
+    ScanSource(const FileHandle& file) : file(&file) {}
+    ScanSource(std::span<const std::byte> buffer, std::string name)
+        : buffer(buffer), label(std::move(name)) {}
+
+    bool isFile() const { return file != nullptr; }
+    // Only for file sources
+    const FileHandle& fileHandle() const { return *file; }
+    // Only for memory sources
+    std::span<const std::byte> bytes() const { return buffer; }
+
+    // The file path, or the name given with the buffer
+    const std::string& name() const { return file ? file->path() : label; }
+    uint64_t size() const { return file ? file->size() : buffer.size(); }
+
+    // Same contract as FileHandle::readAt, for small structured reads such as headers
+    int64_t readAt(void* destination, size_t length, uint64_t offset) const;
+
+private:
+    const FileHandle* file = nullptr;
+    std::span<const std::byte> buffer;
+    std::string label;
+};
+
+#endif // SCAN_SOURCE_H
@@ -1,165 +1,200 @@
 #include "Utils.h"
+#include "EncodedRunDetector.h"
+#include "FileTypeClassifier.h"
 #include <fstream>
 #include <sstream>
 #include <iterator>
 #include <filesystem>
 #include <vector>
 #include <algorithm>
-#include <windows.h>
-#include <shellapi.h>
+#include <string_view>
 #include <cmath>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 namespace Utils {
     namespace {
-        // Helper function for string searching
-        bool containsPattern(const std::string& content, const std::vector<std::string>& patterns) {
-            for (const auto& pattern : patterns) {
-                if (content.find(pattern) != std::string::npos) {
-                    return true;
-                }
+        constexpr std::string_view PACKER_SIGNATURES[] = {
+            "UPX!", "ASPack", "FSG!", "PECompact", "MEW", "MPRESS",
+            "PACK", "Themida", "Obsidium", "VMProtect"
+        };
+
+        // Malicious patterns by category
+        constexpr std::string_view SUSPICIOUS_STRINGS[] = {
+            // Process manipulation
+            "CreateRemoteThread", "WriteProcessMemory", "VirtualAllocEx",
+            "OpenProcess", "CreateProcess", "ShellExecute", "WinExec",
+            "SetWindowsHookEx", "GetAsyncKeyState", "RegisterHotKey",
+            // Network
+            "WSAStartup", "socket", "connect", "InternetOpen",
+            "HttpSendRequest", "URLDownloadToFile", "InternetReadFile",
+            // File and registry
+            "CreateFile", "WriteFile", "CopyFile", "MoveFile",
+            "DeleteFile", "RegCreateKey", "RegSetValue",
+            // Anti-analysis
+            "IsDebuggerPresent", "CheckRemoteDebuggerPresent",
+            "OutputDebugString", "GetTickCount", "QueryPerformanceCounter",
+            // Injection
+            "VirtualProtect", "VirtualAlloc", "LoadLibrary",
+            "GetProcAddress", "CreateThread", "CreateMutex",
+            // Spyware
+            "GetForegroundWindow", "GetKeyState", "GetClipboardData",
+            "SetClipboardData", "GetWindowText", "BitBlt", "GetDC",
+            // Ransomware
+            "CryptEncrypt", "CryptDecrypt", "CryptGenKey",
+            "BCryptEncrypt", "BCryptDecrypt", "wincrypt.h"
+        };
+
+        template <size_t N>
+        std::vector<std::string> toPatterns(const std::string_view (&table)[N]) {
+            return std::vector<std::string>(std::begin(table), std::end(table));
+        }
+
+        // Streams the selected regions of a file or buffer through a pattern scanner
+        bool scanForPatterns(const ScanSource& source, const std::vector<ScanRegion>& regions,
+                             PatternScanner& scanner) {
+            ChunkedReader reader;
+            auto onChunk = [&](const unsigned char* data, size_t length, uint64_t offset) {
+                return !scanner.update(data, length, offset);
+            };
+
+            if (regions.empty()) {
+                reader.read(source, onChunk);
+            } else {
+                reader.read(source, regions, onChunk);
             }
-            return false;
+            return scanner.matched();
         }
     }
 
-    bool ends_with(const std::string& str, const std::string& suffix) {
-        if (str.length() < suffix.length()) {
-            return false;
+    void ByteHistogram::update(const unsigned char* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            counts[data[i]]++;
         }
-        return str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
+        total += length;
     }
 
-    float calculateEntropy(const std::string& content) {
-        if (content.empty()) return 0.0f;
+    void ByteHistogram::reset() {
+        counts.fill(0);
+        total = 0;
+    }
 
-        std::vector<int> frequencies(256, 0);
-        for (unsigned char c : content) {
-            frequencies[c]++;
-        }
+    float ByteHistogram::entropy() const {
+        if (total == 0) return 0.0f;
 
         float entropy = 0.0f;
-        float contentSize = static_cast<float>(content.size());
-
-        for (int frequency : frequencies) {
+        for (uint64_t frequency : counts) {
             if (frequency > 0) {
-                float probability = frequency / contentSize;
+                float probability = static_cast<float>(frequency) / total;
                 entropy -= probability * std::log2(probability);
             }
         }
-
         return entropy;
     }
 
-    std::string getFileType(const std::string& filePath) {
-        SHFILEINFOW fileInfo = {0};
-        std::wstring widePath(filePath.begin(), filePath.end());
-        
-        DWORD_PTR result = SHGetFileInfoW(
-            widePath.c_str(),
-            0,
-            &fileInfo,
-            sizeof(fileInfo),
-            SHGFI_TYPENAME
-        );
-
-        if (result == 0) return "";
-        
-        std::wstring fileType(fileInfo.szTypeName);
-        return std::string(fileType.begin(), fileType.end());
+    PatternScanner::PatternScanner(const PatternAutomaton& automaton)
+        : automaton(automaton), state(PatternAutomaton::START), nextOffset(0), found(false) {}
+
+    bool PatternScanner::update(const unsigned char* data, size_t length, uint64_t offset) {
+        if (found) return true;
+
+        // Only carry the match state over when this chunk continues the previous one
+        if (offset != nextOffset) {
+            state = PatternAutomaton::START;
+        }
+        nextOffset = offset + length;
+        return found = automaton.advance(state, data, length);
     }
 
-    bool isExecutable(const std::string& filePath) {
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file) return false;
-
-        char magic[2];
-        file.read(magic, 2);
-        
-        // Check for MZ header (DOS/PE executable)
-        if (magic[0] == 'M' && magic[1] == 'Z') return true;
-        
-        return false;
-    }
-
-    bool isPacked(const std::string& filePath) {
-        // Check for common packer signatures
-        const std::vector<std::string> packerSigs = {
-            "UPX!", "ASPack", "FSG!", "PECompact", "MEW", "MPRESS", 
-            "PACK", "Themida", "Obsidium", "VMProtect"
-        };
+    void PatternScanner::reset() {
+        state = PatternAutomaton::START;
+        nextOffset = 0;
+        found = false;
+    }
 
-        std::ifstream file(filePath, std::ios::binary);
-        std::string content((std::istreambuf_iterator<char>(file)), 
-                           std::istreambuf_iterator<char>());
+    const PatternAutomaton& shellcodePatterns() {
+        // Only sequences long and specific enough not to turn up in compiled code;
+        // prologues, short jumps and NOP runs are everywhere in ordinary binaries
+        static const PatternAutomaton automaton({
+            std::string("\x31\xC0\x50\x68\x2F\x2F\x73\x68", 8),             // XOR EAX, EAX; PUSH EAX; PUSH "//sh"
+            std::string("\x68\x2F\x2F\x73\x68\x68\x2F\x62\x69\x6E", 10),    // PUSH "//sh"; PUSH "/bin"
+            std::string("\x48\xBB\x2F\x62\x69\x6E\x2F\x2F\x73\x68", 10),    // MOV RBX, "/bin//sh"
+            std::string("\x48\xBF\x2F\x62\x69\x6E\x2F\x2F\x73\x68", 10),    // MOV RDI, "/bin//sh"
+            std::string("\xD9\xEE\xD9\x74\x24\xF4", 6),                     // FLDZ; FNSTENV [ESP-0Ch] (encoder GetPC)
+            std::string("\x60\x89\xE5\x31\xC0\x64\x8B\x50\x30", 9),         // PUSHAD; MOV EBP, ESP; XOR EAX, EAX; MOV EDX, FS:[EAX+30h]
+            std::string("\x48\x31\xD2\x65\x48\x8B\x52\x60", 8),             // XOR RDX, RDX; MOV RDX, GS:[RDX+60h]
+            std::string("\xC1\xCF\x0D\x01\xC7", 5),                         // ROR EDI, 0Dh; ADD EDI, EAX (API name hash)
+            std::string("\x41\xC1\xC9\x0D\x41\x01\xC1", 7)                  // ROR R9D, 0Dh; ADD R9D, EAX
+        });
+        return automaton;
+    }
 
-        return containsPattern(content, packerSigs);
+    const PatternAutomaton& packerPatterns() {
+        static const PatternAutomaton automaton(toPatterns(PACKER_SIGNATURES));
+        return automaton;
     }
 
-    bool containsSuspiciousStrings(const std::string& filePath) {
-        // Malicious patterns by category
-        const std::vector<std::string> processPatterns = {
-            "CreateRemoteThread", "WriteProcessMemory", "VirtualAllocEx",
-            "OpenProcess", "CreateProcess", "ShellExecute", "WinExec",
-            "SetWindowsHookEx", "GetAsyncKeyState", "RegisterHotKey"
-        };
+    const PatternAutomaton& suspiciousStringPatterns() {
+        static const PatternAutomaton automaton(toPatterns(SUSPICIOUS_STRINGS));
+        return automaton;
+    }
 
-        const std::vector<std::string> networkPatterns = {
-            "WSAStartup", "socket", "connect", "InternetOpen",
-            "HttpSendRequest", "URLDownloadToFile", "InternetReadFile"
-        };
+    bool ends_with(const std::string& str, const std::string& suffix) {
+        if (str.length() < suffix.length()) {
+            return false;
+        }
+        return str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
+    }
 
-        const std::vector<std::string> filePatterns = {
-            "CreateFile", "WriteFile", "CopyFile", "MoveFile",
-            "DeleteFile", "RegCreateKey", "RegSetValue"
-        };
+    float calculateEntropy(const std::string& content) {
+        ByteHistogram histogram;
+        histogram.update(reinterpret_cast<const unsigned char*>(content.data()), content.size());
+        return histogram.entropy();
+    }
 
-        const std::vector<std::string> antiAnalysisPatterns = {
-            "IsDebuggerPresent", "CheckRemoteDebuggerPresent",
-            "OutputDebugString", "GetTickCount", "QueryPerformanceCounter"
-        };
+    std::string getFileType(const std::string& filePath) {
+        FileHandle file = FileHandle::open(filePath);
+        if (!file.isOpen()) return "";
+        return FileTypeClassifier::classify(file).description;
+    }
 
-        const std::vector<std::string> injectionPatterns = {
-            "VirtualProtect", "VirtualAlloc", "LoadLibrary",
-            "GetProcAddress", "CreateThread", "CreateMutex"
-        };
+    bool isExecutable(const std::string& filePath) {
+        FileHandle file = FileHandle::open(filePath);
+        if (!file.isOpen()) return false;
+        return (FileTypes::bit(FileTypeClassifier::classify(file).type) & FileTypes::EXECUTABLE) != 0;
+    }
 
-        const std::vector<std::string> spywarePatterns = {
-            "GetForegroundWindow", "GetKeyState", "GetClipboardData",
-            "SetClipboardData", "GetWindowText", "BitBlt", "GetDC"
-        };
+    bool isPacked(const std::string& filePath, const std::vector<ScanRegion>& regions) {
+        return isPacked(FileHandle::open(filePath), regions);
+    }
 
-        const std::vector<std::string> ransomwarePatterns = {
-            "CryptEncrypt", "CryptDecrypt", "CryptGenKey",
-            "BCryptEncrypt", "BCryptDecrypt", "wincrypt.h"
-        };
+    bool isPacked(const ScanSource& source, const std::vector<ScanRegion>& regions) {
+        PatternScanner scanner(packerPatterns());
+        return scanForPatterns(source, regions, scanner);
+    }
 
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file) return false;
+    bool containsSuspiciousStrings(const std::string& filePath, const std::vector<ScanRegion>& regions) {
+        return containsSuspiciousStrings(FileHandle::open(filePath), regions);
+    }
 
-        std::string content((std::istreambuf_iterator<char>(file)), 
-                           std::istreambuf_iterator<char>());
+    bool containsSuspiciousStrings(const ScanSource& source, const std::vector<ScanRegion>& regions) {
+        PatternScanner scanner(suspiciousStringPatterns());
+        // Embedded base64/hex blobs, as opposed to ordinary text
+        EncodedRunDetector encodedRuns;
 
-        // Check for encoded/obfuscated content
-        std::string base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
-        size_t base64Count = 0;
-        const size_t BASE64_THRESHOLD = 100;
+        ChunkedReader reader;
+        auto onChunk = [&](const unsigned char* data, size_t length, uint64_t offset) {
+            if (encodedRuns.update(data, length, offset)) return false;
+            return !scanner.update(data, length, offset);
+        };
 
-        for (char c : content) {
-            if (base64Chars.find(c) != std::string::npos) {
-                base64Count++;
-                if (base64Count > BASE64_THRESHOLD) {
-                    return true;
-                }
-            }
-        }
+        bool readOk = regions.empty() ? reader.read(source, onChunk)
+                                      : reader.read(source, regions, onChunk);
+        if (!readOk) return false;
+        encodedRuns.finish();
 
-        // Check all pattern categories
-        return containsPattern(content, processPatterns) ||
-               containsPattern(content, networkPatterns) ||
-               containsPattern(content, filePatterns) ||
-               containsPattern(content, antiAnalysisPatterns) ||
-               containsPattern(content, injectionPatterns) ||
-               containsPattern(content, spywarePatterns) ||
-               containsPattern(content, ransomwarePatterns);
+        return encodedRuns.blobFound() || scanner.matched();
     }
 }
\ No newline at end of file
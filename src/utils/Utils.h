@@ -1,15 +1,64 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "ChunkedReader.h"
+#include "PatternAutomaton.h"
+#include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Utils {
+    // Running byte frequency table for streaming entropy calculation
+    class ByteHistogram {
+    public:
+        void update(const unsigned char* data, size_t length);
+        float entropy() const;
+        uint64_t size() const { return total; }
+        uint64_t count(unsigned char byte) const { return counts[byte]; }
+        void reset();
+
+    private:
+        std::array<uint64_t, 256> counts{};
+        uint64_t total = 0;
+    };
+
+    // Multi-pattern matcher fed chunk by chunk. Only the automaton state is
+    // carried from one chunk to the next, so patterns spanning a boundary
+    // still match. The automaton is not copied and must outlive the scanner.
+    class PatternScanner {
+    public:
+        explicit PatternScanner(const PatternAutomaton& automaton);
+
+        // Returns true once any pattern has matched
+        bool update(const unsigned char* data, size_t length, uint64_t offset);
+        bool matched() const { return found; }
+        void reset();
+
+    private:
+        const PatternAutomaton& automaton;
+        PatternAutomaton::State state;
+        uint64_t nextOffset;
+        bool found;
+    };
+
+    // Byte patterns shared by the file and process memory shellcode checks
+    const PatternAutomaton& shellcodePatterns();
+    const PatternAutomaton& packerPatterns();
+    // API and library names across all suspicious-string categories
+    const PatternAutomaton& suspiciousStringPatterns();
+
     bool ends_with(const std::string& str, const std::string& suffix);
     float calculateEntropy(const std::string& content);
+    // Both classify by content (see FileTypeClassifier), not by extension
     std::string getFileType(const std::string& filePath);
     bool isExecutable(const std::string& filePath);
-    bool isPacked(const std::string& filePath);              // Add this
-    bool containsSuspiciousStrings(const std::string& filePath); // Add this
+
+    // An empty region list scans the whole file
+    bool isPacked(const std::string& filePath, const std::vector<ScanRegion>& regions = {});
+    bool isPacked(const ScanSource& source, const std::vector<ScanRegion>& regions = {});
+    bool containsSuspiciousStrings(const std::string& filePath, const std::vector<ScanRegion>& regions = {});
+    bool containsSuspiciousStrings(const ScanSource& source, const std::vector<ScanRegion>& regions = {});
 }
 
 #endif // UTILS_H
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Minimal harness for the test executables: each test is a function that
+// records failed checks, and main() returns non-zero if any check failed.
+namespace TestSupport {
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void check(bool condition, const char* expression, const char* file, int line) {
+        if (condition) return;
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        failures()++;
+    }
+
+    struct Test {
+        const char* name;
+        std::function<void()> run;
+    };
+
+    inline int runAll(const std::vector<Test>& tests) {
+        for (const auto& test : tests) {
+            int before = failures();
+            test.run();
+            std::printf("%s %s\n", failures() == before ? "PASS" : "FAIL", test.name);
+        }
+        return failures() == 0 ? 0 : 1;
+    }
+
+    // A fresh directory under the system temp path, removed when it goes out of scope
+    class TempDir {
+    public:
+        explicit TempDir(const std::string& name) {
+            auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+            dir = std::filesystem::temp_directory_path() / (name + "_" + std::to_string(stamp));
+            std::filesystem::create_directories(dir);
+        }
+        ~TempDir() {
+            std::error_code ec;
+            std::filesystem::remove_all(dir, ec);
+        }
+
+        const std::filesystem::path& root() const { return dir; }
+        std::string path(const std::string& name) const { return (dir / name).string(); }
+
+        std::string write(const std::string& name, const std::string& content) const {
+            std::ofstream out(dir / name, std::ios::binary | std::ios::trunc);
+            out << content;
+            return path(name);
+        }
+
+    private:
+        std::filesystem::path dir;
+    };
+
+    inline std::string readFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+}
+
+#define CHECK(condition) TestSupport::check((condition), #condition, __FILE__, __LINE__)
+
+#endif // TEST_SUPPORT_H
@@ -0,0 +1,9 @@
+// Shared library the hook detector test loads and patches in memory
+
+extern "C" int hookTargetAdd(int a, int b) {
+    return a + b;
+}
+
+extern "C" int hookTargetScale(int value, int factor) {
+    return value * factor + 1;
+}
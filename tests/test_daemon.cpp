@@ -0,0 +1,208 @@
+#include "TestSupport.h"
+
+#ifdef __linux__
+
+#include "Config.h"
+#include "daemon/ScanDaemon.h"
+#include "scanner/FileScanner.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const std::string KNOWN_CONTENT = "malicious content";
+    const std::string KNOWN_SHA256 = "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3";
+
+    // Blocking client connection that reads whole response lines
+    class Connection {
+    public:
+        explicit Connection(const std::string& socketPath) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+            // The daemon starts listening on its own thread
+            for (int attempt = 0; attempt < 200; attempt++) {
+                fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) break;
+                close(fd);
+                fd = -1;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            timeval timeout{5, 0};
+            if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+        ~Connection() {
+            if (fd >= 0) close(fd);
+        }
+
+        bool connected() const { return fd >= 0; }
+
+        void send(const std::string& text, int descriptor = -1) {
+            iovec iov{const_cast<char*>(text.data()), text.size()};
+            msghdr message{};
+            message.msg_iov = &iov;
+            message.msg_iovlen = 1;
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+            if (descriptor >= 0) {
+                message.msg_control = control;
+                message.msg_controllen = sizeof(control);
+                cmsghdr* header = CMSG_FIRSTHDR(&message);
+                header->cmsg_level = SOL_SOCKET;
+                header->cmsg_type = SCM_RIGHTS;
+                header->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+            }
+            CHECK(sendmsg(fd, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(text.size()));
+        }
+
+        // Empty once the daemon hangs up or nothing arrives in time
+        std::string readLine() {
+            while (buffered.find('\n') == std::string::npos) {
+                char data[4096];
+                ssize_t received = recv(fd, data, sizeof(data), 0);
+                if (received <= 0) return "";
+                buffered.append(data, static_cast<size_t>(received));
+            }
+            size_t newline = buffered.find('\n');
+            std::string line = buffered.substr(0, newline);
+            buffered.erase(0, newline + 1);
+            return line;
+        }
+
+        std::string request(const std::string& line) {
+            send(line + "\n");
+            return readLine();
+        }
+
+    private:
+        int fd = -1;
+        std::string buffered;
+    };
+
+    // Runs a daemon with a single worker on its own thread for the length of a test
+    class RunningDaemon {
+    public:
+        RunningDaemon(const FileScanner& scanner, const std::string& socketPath)
+            : daemon(scanner, 1), socketPath(socketPath), thread([this] { daemon.run(this->socketPath); }) {}
+        ~RunningDaemon() {
+            daemon.stop();
+            thread.join();
+        }
+
+        ScanDaemon daemon;
+        std::string socketPath;
+        std::thread thread;
+    };
+
+    uint64_t requestsCounted(const std::string& stats) {
+        size_t start = stats.find("requests=");
+        return start == std::string::npos ? 0 : std::stoull(stats.substr(start + 9));
+    }
+
+    void testDaemonAnswersInOrder() {
+        TestSupport::TempDir dir("daemon_protocol");
+        FileScanner scanner(dir.write("signatures.db", KNOWN_SHA256 + "\n"));
+        std::string known = dir.write("known.txt", KNOWN_CONTENT);
+        std::string clean = dir.write("clean.txt", "nothing here");
+        RunningDaemon running(scanner, dir.path("scand.sock"));
+
+        Connection client(running.socketPath);
+        CHECK(client.connected());
+        CHECK(client.request("PING") == "PONG");
+
+        // Pipelined requests come back in the order they were sent
+        client.send("SCAN " + known + "\nSCAN " + clean + "\r\nSCAN " + dir.path("missing.txt") +
+                    "\nSCAN\nFDSCAN upload\nBOGUS\n\nPING\n");
+        CHECK(client.readLine() == "FOUND");
+        CHECK(client.readLine() == "OK");
+        CHECK(client.readLine() == "ERROR cannot open file");
+        CHECK(client.readLine() == "ERROR missing path");
+        CHECK(client.readLine() == "ERROR no descriptor attached");
+        CHECK(client.readLine() == "ERROR unknown command");
+        CHECK(client.readLine() == "PONG");
+
+        // A descriptor passed alongside FDSCAN is scanned without a path
+        int fd = open(known.c_str(), O_RDONLY | O_CLOEXEC);
+        client.send("FDSCAN upload.bin\n", fd);
+        close(fd);
+        CHECK(client.readLine() == "FOUND");
+
+        std::string stats = client.request("STATS");
+        CHECK(stats.rfind("STATS ", 0) == 0);
+        CHECK(requestsCounted(stats) == 10);
+        CHECK(stats.find("threats=2") != std::string::npos);
+
+        // A line that never ends costs the client its connection
+        Connection flood(running.socketPath);
+        flood.send(std::string(Config::DAEMON_MAX_LINE + 1, 'x'));
+        CHECK(flood.readLine().empty());
+        CHECK(client.request("PING") == "PONG");
+    }
+
+    void testDaemonPausesFullPipeline() {
+        TestSupport::TempDir dir("daemon_backpressure");
+        FileScanner scanner(dir.write("signatures.db", KNOWN_SHA256 + "\n"));
+        std::string clean = dir.write("clean.txt", "nothing here");
+        // Opening a FIFO blocks until a writer appears, which holds the only worker
+        std::string fifo = dir.path("blocker");
+        CHECK(mkfifo(fifo.c_str(), 0600) == 0);
+        RunningDaemon running(scanner, dir.path("scand.sock"));
+
+        Connection client(running.socketPath);
+        CHECK(client.connected());
+        std::string burst = "SCAN " + fifo + "\n";
+        for (size_t i = 1; i < Config::DAEMON_MAX_PIPELINE; i++) {
+            burst += "SCAN " + clean + "\n";
+        }
+        client.send(burst + "PING\n");
+
+        // Once the pipeline is full the PING behind it is not even parsed
+        Connection observer(running.socketPath);
+        uint64_t observed = 0;
+        uint64_t fromClient = 0;
+        for (int attempt = 0; attempt < 200 && fromClient < Config::DAEMON_MAX_PIPELINE; attempt++) {
+            fromClient = requestsCounted(observer.request("STATS")) - ++observed;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(requestsCounted(observer.request("STATS")) - ++observed == Config::DAEMON_MAX_PIPELINE);
+
+        // Releasing the worker drains the pipeline and reading resumes
+        int writer = open(fifo.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        CHECK(writer >= 0);
+        if (writer >= 0) close(writer);
+        client.readLine();
+        size_t cleanAnswers = 0;
+        for (size_t i = 1; i < Config::DAEMON_MAX_PIPELINE; i++) {
+            if (client.readLine() == "OK") cleanAnswers++;
+        }
+        CHECK(cleanAnswers == Config::DAEMON_MAX_PIPELINE - 1);
+        CHECK(client.readLine() == "PONG");
+    }
+}
+
+int main() {
+    TestSupport::TempDir workspace("daemon_workspace");
+    fs::current_path(workspace.root());
+    fs::create_directories("data");
+
+    return TestSupport::runAll({
+        {"daemon_answers_in_order", testDaemonAnswersInOrder},
+        {"daemon_pauses_full_pipeline", testDaemonPausesFullPipeline},
+    });
+}
+
+#else
+
+int main() {
+    return TestSupport::runAll({});
+}
+
+#endif
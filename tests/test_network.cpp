@@ -0,0 +1,244 @@
+#include "TestSupport.h"
+#include "network/NetworkAnalyzer.h"
+#include "network/PacketParser.h"
+#include "network/PcapReader.h"
+#include <cstring>
+
+namespace {
+    const uint8_t CLIENT[4] = {10, 0, 0, 1};
+    const uint8_t SERVER[4] = {10, 0, 0, 2};
+    const uint16_t CLIENT_PORT = 50000;
+    const uint16_t SERVER_PORT = 80;
+
+    void putBe16(std::string& packet, size_t offset, uint16_t value) {
+        packet[offset] = static_cast<char>(value >> 8);
+        packet[offset + 1] = static_cast<char>(value);
+    }
+
+    void putBe32(std::string& packet, size_t offset, uint32_t value) {
+        putBe16(packet, offset, static_cast<uint16_t>(value >> 16));
+        putBe16(packet, offset + 2, static_cast<uint16_t>(value));
+    }
+
+    // IPv4 + TCP without options, as captured with LINKTYPE_RAW
+    std::string tcpPacket(bool toServer, uint32_t sequence, uint8_t flags, const std::string& payload) {
+        std::string packet(40, '\0');
+        packet[0] = 0x45;
+        putBe16(packet, 2, static_cast<uint16_t>(packet.size() + payload.size()));
+        packet[8] = 64;
+        packet[9] = 6;
+        std::memcpy(&packet[12], toServer ? CLIENT : SERVER, 4);
+        std::memcpy(&packet[16], toServer ? SERVER : CLIENT, 4);
+
+        putBe16(packet, 20, toServer ? CLIENT_PORT : SERVER_PORT);
+        putBe16(packet, 22, toServer ? SERVER_PORT : CLIENT_PORT);
+        putBe32(packet, 24, sequence);
+        packet[32] = 0x50;
+        packet[33] = static_cast<char>(flags);
+        return packet + payload;
+    }
+
+    void deliver(NetworkAnalyzer& analyzer, const std::string& packet, uint64_t timestampNs = 0,
+                 uint16_t linkType = LinkType::RAW) {
+        CapturedPacket captured{reinterpret_cast<const unsigned char*>(packet.data()),
+                                static_cast<uint32_t>(packet.size()), static_cast<uint32_t>(packet.size()),
+                                timestampNs, linkType};
+        analyzer.processPacket(captured);
+    }
+
+    bool parse(uint16_t linkType, const std::string& packet, TcpSegment& segment) {
+        return PacketParser::parseTcp(linkType, reinterpret_cast<const unsigned char*>(packet.data()),
+                                      packet.size(), segment);
+    }
+
+    void testParserDecodesTcp() {
+        TcpSegment segment;
+        std::string packet = tcpPacket(true, 1000, PacketParser::TCP_SYN, "hello");
+        CHECK(parse(LinkType::RAW, packet, segment));
+        CHECK(segment.source.toString() == "10.0.0.1" && segment.destination.toString() == "10.0.0.2");
+        CHECK(segment.sourcePort == CLIENT_PORT && segment.destinationPort == SERVER_PORT);
+        CHECK(segment.sequence == 1000 && segment.flags == PacketParser::TCP_SYN);
+        CHECK(std::string(reinterpret_cast<const char*>(segment.payload), segment.payloadLength) == "hello");
+
+        // Ethernet with a VLAN tag, padded past the end of the IP packet
+        std::string frame(12, '\0');
+        frame += std::string("\x81\x00\x00\x05\x08\x00", 6) + packet + std::string(10, '\0');
+        CHECK(parse(LinkType::ETHERNET, frame, segment));
+        CHECK(segment.payloadLength == 5);
+    }
+
+    void testParserRejectsMalformedPackets() {
+        TcpSegment segment;
+        std::string packet = tcpPacket(true, 1, 0, "data");
+
+        CHECK(!parse(LinkType::RAW, "", segment));
+        CHECK(!parse(LinkType::RAW, packet.substr(0, 30), segment));   // TCP header cut off
+        CHECK(!parse(9999, packet, segment));
+
+        std::string fragment = packet;
+        fragment[6] = 0x20;                 // More fragments
+        CHECK(!parse(LinkType::RAW, fragment, segment));
+
+        std::string udp = packet;
+        udp[9] = 17;
+        CHECK(!parse(LinkType::RAW, udp, segment));
+
+        std::string badHeader = packet;
+        badHeader[0] = 0x44;                // Header length below the minimum
+        CHECK(!parse(LinkType::RAW, badHeader, segment));
+
+        std::string badOffset = packet;
+        badOffset[32] = static_cast<char>(0xF0);    // TCP header longer than the packet
+        CHECK(!parse(LinkType::RAW, badOffset, segment));
+    }
+
+    void testReassemblyFindsSplitPattern() {
+        PatternAutomaton automaton({"EVILPAYLOAD"});
+        NetworkAnalyzer analyzer(automaton);
+
+        deliver(analyzer, tcpPacket(true, 999, PacketParser::TCP_SYN, ""));
+        deliver(analyzer, tcpPacket(true, 1000, 0, "GET / EVIL"));
+        CHECK(analyzer.findings().empty());
+        deliver(analyzer, tcpPacket(true, 1010, 0, "PAYLOAD HTTP/1.1"));
+        CHECK(analyzer.findings().size() == 1);
+        if (analyzer.findings().size() == 1) {
+            const NetworkFinding& finding = analyzer.findings()[0];
+            CHECK(finding.toServer && finding.serverPort == SERVER_PORT && finding.clientPort == CLIENT_PORT);
+            CHECK(finding.client.toString() == "10.0.0.1");
+        }
+
+        // One finding per direction
+        deliver(analyzer, tcpPacket(true, 1026, 0, "EVILPAYLOAD"));
+        CHECK(analyzer.findings().size() == 1);
+        CHECK(analyzer.stats().flows == 1);
+    }
+
+    void testReassemblyReordersSegments() {
+        PatternAutomaton automaton({"EVILPAYLOAD"});
+        NetworkAnalyzer analyzer(automaton);
+
+        // Server to client, starting mid-flow, out of order and with a retransmission
+        deliver(analyzer, tcpPacket(false, 5000, 0, "xxEVI"));
+        deliver(analyzer, tcpPacket(false, 5009, 0, "LOADyy"));
+        CHECK(analyzer.findings().empty());
+        deliver(analyzer, tcpPacket(false, 5002, 0, "EVILPAY"));
+        CHECK(analyzer.findings().size() == 1);
+        if (!analyzer.findings().empty()) CHECK(!analyzer.findings()[0].toServer);
+
+        // Neither port monitored
+        NetworkAnalyzer other(automaton);
+        std::string packet = tcpPacket(true, 1, 0, "EVILPAYLOAD");
+        putBe16(packet, 22, 12345);
+        deliver(other, packet);
+        CHECK(other.stats().segments == 0 && other.findings().empty());
+    }
+
+    void testReassemblyForgetsClosedFlows() {
+        PatternAutomaton automaton({"EVILPAYLOAD"});
+        NetworkAnalyzer analyzer(automaton);
+
+        deliver(analyzer, tcpPacket(true, 1, 0, "hello"));
+        CHECK(analyzer.activeFlows() == 1);
+        deliver(analyzer, tcpPacket(true, 6, PacketParser::TCP_RST, ""));
+        CHECK(analyzer.activeFlows() == 0);
+
+        deliver(analyzer, tcpPacket(true, 100, 0, "hello"));
+        deliver(analyzer, tcpPacket(false, 200, PacketParser::TCP_FIN, "bye"));
+        deliver(analyzer, tcpPacket(true, 105, PacketParser::TCP_FIN, ""));
+        CHECK(analyzer.activeFlows() == 0);
+    }
+
+    std::string le32(uint32_t value) {
+        std::string bytes(4, '\0');
+        for (int i = 0; i < 4; i++) bytes[i] = static_cast<char>(value >> (8 * i));
+        return bytes;
+    }
+
+    std::string pcapHeader(uint32_t linkType) {
+        return le32(0xA1B2C3D4) + std::string("\x02\x00\x04\x00", 4) + le32(0) + le32(0) +
+               le32(65535) + le32(linkType);
+    }
+
+    std::string pcapRecord(uint32_t seconds, const std::string& packet) {
+        return le32(seconds) + le32(500) + le32(static_cast<uint32_t>(packet.size())) +
+               le32(static_cast<uint32_t>(packet.size())) + packet;
+    }
+
+    void testPcapReaderStreamsRecords() {
+        TestSupport::TempDir dir("pcap_reader");
+        std::string first = tcpPacket(true, 1, 0, "one");
+        std::string second = tcpPacket(true, 4, 0, "two");
+        std::string path = dir.write("good.pcap",
+                                     pcapHeader(LinkType::RAW) + pcapRecord(10, first) + pcapRecord(11, second));
+
+        PcapReader reader(64);              // Smaller than a record, so the buffer has to grow
+        std::vector<std::string> packets;
+        std::vector<uint64_t> timestamps;
+        CHECK(reader.read(path, [&](const CapturedPacket& packet) {
+            CHECK(packet.linkType == LinkType::RAW);
+            packets.emplace_back(reinterpret_cast<const char*>(packet.data), packet.capturedLength);
+            timestamps.push_back(packet.timestampNs);
+            return true;
+        }));
+        CHECK(reader.packetsRead() == 2);
+        CHECK((packets == std::vector<std::string>{first, second}));
+        CHECK((timestamps == std::vector<uint64_t>{10000500000ULL, 11000500000ULL}));
+
+        // Stopping early
+        size_t seen = 0;
+        CHECK(reader.read(path, [&](const CapturedPacket&) { return ++seen < 1; }));
+        CHECK(seen == 1);
+    }
+
+    void testPcapReaderRejectsDamage() {
+        TestSupport::TempDir dir("pcap_reader");
+        std::string packet = tcpPacket(true, 1, 0, "one");
+        PcapReader reader;
+        size_t seen = 0;
+        auto count = [&](const CapturedPacket&) { seen++; return true; };
+
+        CHECK(!reader.read(dir.path("missing.pcap"), count));
+        CHECK(!reader.read(dir.write("empty.pcap", ""), count));
+        CHECK(!reader.read(dir.write("text.pcap", "this is not a capture"), count));
+
+        // A record claiming an absurd length ends the read after what came before it
+        std::string huge = le32(1) + le32(0) + le32(0x7FFFFFFF) + le32(0x7FFFFFFF);
+        seen = 0;
+        CHECK(!reader.read(dir.write("huge.pcap", pcapHeader(LinkType::RAW) + pcapRecord(1, packet) + huge), count));
+        CHECK(seen == 1);
+
+        // A capture cut off mid-packet, as when a capture is still being written
+        std::string cut = pcapHeader(LinkType::RAW) + pcapRecord(1, packet) + pcapRecord(2, packet);
+        seen = 0;
+        CHECK(reader.read(dir.write("cut.pcap", cut.substr(0, cut.size() - 5)), count));
+        CHECK(seen == 1);
+    }
+
+    void testAnalyzerReadsCapture() {
+        TestSupport::TempDir dir("network_analyzer");
+        std::string capture = pcapHeader(LinkType::RAW) +
+                              pcapRecord(1, tcpPacket(true, 999, PacketParser::TCP_SYN, "")) +
+                              pcapRecord(1, tcpPacket(true, 1000, 0, "POST EVILPAY")) +
+                              pcapRecord(2, tcpPacket(true, 1012, 0, "LOAD"));
+
+        PatternAutomaton automaton({"EVILPAYLOAD"});
+        NetworkAnalyzer analyzer(automaton);
+        CHECK(analyzer.analyzeCapture(dir.write("flow.pcap", capture)));
+        CHECK(analyzer.stats().packets == 3);
+        CHECK(analyzer.findings().size() == 1);
+        if (!analyzer.findings().empty()) CHECK(analyzer.findings()[0].timestampNs == 2000500000ULL);
+    }
+}
+
+int main() {
+    return TestSupport::runAll({
+        {"parser_decodes_tcp", testParserDecodesTcp},
+        {"parser_rejects_malformed_packets", testParserRejectsMalformedPackets},
+        {"reassembly_finds_split_pattern", testReassemblyFindsSplitPattern},
+        {"reassembly_reorders_segments", testReassemblyReordersSegments},
+        {"reassembly_forgets_closed_flows", testReassemblyForgetsClosedFlows},
+        {"pcap_reader_streams_records", testPcapReaderStreamsRecords},
+        {"pcap_reader_rejects_damage", testPcapReaderRejectsDamage},
+        {"analyzer_reads_capture", testAnalyzerReadsCapture},
+    });
+}
@@ -0,0 +1,965 @@
+#include "TestSupport.h"
+#include "Config.h"
+#include "scanner/ChangeQueue.h"
+#include "scanner/EngineSnapshot.h"
+#include "scanner/FileScanner.h"
+#include "scanner/FingerprintCache.h"
+#include "scanner/HookDetector.h"
+#include "scanner/IncrementalScanState.h"
+#include "scanner/PESignatureIndex.h"
+#include "scanner/ScanDeduplicator.h"
+#include "scanner/ProcessMonitor.h"
+#include "scanner/QuarantineStore.h"
+#include "scanner/ScanPolicy.h"
+#include "scanner/ScanThrottle.h"
+#include "scanner/ScoringEngine.h"
+#include "scanner/SignatureDatabase.h"
+#include "scanner/SimilarityIndex.h"
+#include "scanner/StreamScanner.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef HOOK_TARGET_PATH
+#include <dlfcn.h>
+#include <sys/mman.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    const uint64_t MB = 1024 * 1024;
+
+    void useSmallLimits(ScanPolicy& policy) {
+        policy.setDefaultPolicy({1 * MB, 8 * MB, 1024 * MB});
+        policy.setHeadTailSize(64 * 1024);
+        policy.setSampling({64 * 1024, 4096, 16});
+    }
+
+    // Built on first use, once main() has moved into the scratch workspace
+    // the relative data/ paths resolve against
+    const FileScanner& scanner() {
+        static const FileScanner instance(Config::SIGNATURE_DB_PATH);
+        return instance;
+    }
+
+    ScanStatus scanText(const std::string& content, const std::string& name) {
+        return scanner().scanBuffer(std::as_bytes(std::span(content.data(), content.size())), {name, "test"});
+    }
+
+    bool sortedAndDisjoint(const std::vector<ScanRegion>& regions, uint64_t fileSize) {
+        for (size_t i = 0; i < regions.size(); i++) {
+            if (regions[i].length == 0 || regions[i].offset + regions[i].length > fileSize) return false;
+            if (i > 0 && regions[i].offset <= regions[i - 1].offset + regions[i - 1].length) return false;
+        }
+        return true;
+    }
+
+    void testPolicyChoosesModeBySize() {
+        ScanPolicy policy;
+        useSmallLimits(policy);
+
+        ScanPlan full = policy.plan("a.bin", 512 * 1024);
+        CHECK(full.mode == ScanMode::Full);
+        CHECK(full.regions.size() == 1 && full.regions[0].offset == 0 && full.regions[0].length == 512 * 1024);
+
+        ScanPlan headTail = policy.plan("a.bin", 4 * MB);
+        CHECK(headTail.mode == ScanMode::HeadTail);
+        CHECK(headTail.regions.size() == 2);
+        if (headTail.regions.size() == 2) {
+            CHECK(headTail.regions[0].offset == 0 && headTail.regions[0].length == 64 * 1024);
+            CHECK(headTail.regions[1].offset + headTail.regions[1].length == 4 * MB);
+        }
+
+        CHECK(policy.plan("a.bin", 100 * MB).mode == ScanMode::Sampled);
+        CHECK(policy.plan("a.bin", 2048 * MB).mode == ScanMode::Skip);
+
+        // Overrides match the extension case-insensitively
+        policy.setPolicy(".LOG", {std::numeric_limits<uint64_t>::max(), 0, std::numeric_limits<uint64_t>::max()});
+        CHECK(policy.plan("server.log", 100 * MB).mode == ScanMode::Full);
+        CHECK(policy.plan("server.Log", 100 * MB).mode == ScanMode::Full);
+
+        // Media has its own, lower limits
+        CHECK(ScanPolicy().plan("movie.mp4", 64 * MB).mode == ScanMode::HeadTail);
+        CHECK(ScanPolicy().plan("notes.txt", 64 * MB).mode == ScanMode::Full);
+    }
+
+    void testSamplingIsDeterministic() {
+        ScanPolicy policy;
+        useSmallLimits(policy);
+        const uint64_t size = 100 * MB + 12345;
+
+        ScanPlan first = policy.plan("a.bin", size);
+        ScanPlan second = policy.plan("b.bin", size);
+        CHECK(first.mode == ScanMode::Sampled);
+        CHECK(sortedAndDisjoint(first.regions, size));
+        CHECK(first.regions.size() == second.regions.size());
+        for (size_t i = 0; i < std::min(first.regions.size(), second.regions.size()); i++) {
+            CHECK(first.regions[i].offset == second.regions[i].offset);
+            CHECK(first.regions[i].length == second.regions[i].length);
+        }
+
+        // Both ends, plus at most one block per stratum, aligned to pages
+        CHECK(first.regions.size() >= 3 && first.regions.size() <= 18);
+        if (first.regions.size() >= 3) {
+            CHECK(first.regions.front().offset == 0 && first.regions.front().length >= 64 * 1024);
+            CHECK(first.regions.back().offset + first.regions.back().length == size);
+            for (size_t i = 1; i + 1 < first.regions.size(); i++) {
+                CHECK(first.regions[i].offset % 4096 == 0);
+            }
+        }
+
+        // Another size lands its blocks elsewhere
+        ScanPlan other = policy.plan("a.bin", size + 4096 * 7);
+        bool moved = false;
+        for (size_t i = 1; i + 1 < std::min(first.regions.size(), other.regions.size()); i++) {
+            moved = moved || first.regions[i].offset != other.regions[i].offset;
+        }
+        CHECK(moved);
+    }
+
+    void testAddRegionsMerges() {
+        ScanPlan plan{ScanMode::Full, 100, {{40, 10}}};
+        ScanPolicy::addRegions(plan, {{0, 10}, {5, 10}, {20, 0}, {15, 5}, {45, 20}, {80, 5}});
+        CHECK(plan.regions.size() == 3);
+        if (plan.regions.size() == 3) {
+            CHECK(plan.regions[0].offset == 0 && plan.regions[0].length == 20);
+            CHECK(plan.regions[1].offset == 40 && plan.regions[1].length == 25);
+            CHECK(plan.regions[2].offset == 80 && plan.regions[2].length == 5);
+        }
+    }
+
+    void testScoringRunsCheapestFirst() {
+        std::vector<std::string> ran;
+        bool fire = true;
+        auto detector = [&](const std::string& name, float cost, uint32_t types = FileTypes::ALL) {
+            return Detector{name, cost, 0.5f, [&ran, &fire, name](const ScanContext&) {
+                ran.push_back(name);
+                if (name == "throws") throw std::runtime_error("broken");
+                return fire;
+            }, types};
+        };
+        ScoringEngine engine(1.0f);
+        engine.addDetector(detector("costly", 10.0f));
+        engine.addDetector(detector("pe-only", 0.1f, FileTypes::bit(FileType::PE)));
+        engine.addDetector(detector("cheap", 1.0f));
+        engine.addDetector(detector("mid", 2.0f));
+
+        std::string content = "content";
+        ScanSource source(std::as_bytes(std::span(content.data(), content.size())), "a.txt");
+        ScanPlan plan{ScanMode::Full, content.size(), {{0, content.size()}}};
+        ScanContext context{source, plan, FileType::Text};
+
+        // Two hits reach the threshold, so the costly detector never runs
+        ScanVerdict verdict = engine.evaluate(context);
+        CHECK((ran == std::vector<std::string>{"cheap", "mid"}));
+        CHECK(verdict.malicious && verdict.complete && verdict.detectorsRun == 2);
+        CHECK((verdict.triggered == std::vector<std::string>{"cheap", "mid"}));
+
+        // Two misses leave too little weight to reach it
+        ran.clear();
+        fire = false;
+        verdict = engine.evaluate(context);
+        CHECK((ran == std::vector<std::string>{"cheap", "mid"}));
+        CHECK(!verdict.malicious && verdict.complete && verdict.score == 0.0f);
+
+        // Detectors for the type join in, cheapest first
+        ran.clear();
+        fire = true;
+        context.fileType = FileType::PE;
+        CHECK(engine.evaluate(context).malicious);
+        CHECK((ran == std::vector<std::string>{"pe-only", "cheap"}));
+        CHECK(engine.appliesTo("pe-only", FileType::PE) && !engine.appliesTo("pe-only", FileType::Text));
+        CHECK(engine.weightOf("mid") == 0.5f && engine.weightOf("missing") == 0.0f);
+
+        // A failing detector counts as a miss
+        ScoringEngine failing(0.5f);
+        failing.addDetector(detector("throws", 1.0f));
+        ran.clear();
+        verdict = failing.evaluate(context);
+        CHECK(!verdict.malicious && verdict.detectorsRun == 1);
+
+        // Nothing runs once the budget is spent
+        CancellationToken token;
+        token.cancel();
+        ScanBudget budget(std::chrono::milliseconds(0), &token);
+        ScanBudget::Scope scope(budget);
+        ran.clear();
+        verdict = engine.evaluate(context);
+        CHECK(ran.empty() && !verdict.complete && !verdict.malicious);
+    }
+
+    void testDeduplicatorSharesResults() {
+        ScanDeduplicator deduplicator;
+        int scans = 0;
+        auto threat = [&scans] { scans++; return ScanStatus::Threat; };
+        bool reused = true;
+
+        CHECK(deduplicator.run("a", threat, &reused) == ScanStatus::Threat && !reused);
+        CHECK(deduplicator.run("a", threat, &reused) == ScanStatus::Threat && reused);
+        CHECK(deduplicator.run("", threat, &reused) == ScanStatus::Threat && !reused);
+        CHECK(deduplicator.run("", threat) == ScanStatus::Threat);
+        CHECK(scans == 3 && deduplicator.reusedCount() == 1);
+
+        // A caller arriving mid-scan waits for the first result
+        std::atomic<bool> started{false};
+        std::atomic<bool> release{false};
+        std::thread first([&] {
+            deduplicator.run("slow", [&] {
+                scans++;
+                started = true;
+                while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                return ScanStatus::Clean;
+            });
+        });
+        while (!started) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::thread second([&] {
+            CHECK(deduplicator.run("slow", threat, &reused) == ScanStatus::Clean && reused);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        release = true;
+        first.join();
+        second.join();
+        CHECK(scans == 4);
+
+        // Waiters see the exception the scan threw
+        auto rethrows = [&deduplicator](const std::function<ScanStatus()>& scan) {
+            try {
+                deduplicator.run("fails", scan);
+            } catch (const std::runtime_error&) {
+                return true;
+            }
+            return false;
+        };
+        CHECK(rethrows([]() -> ScanStatus { throw std::runtime_error("read"); }));
+        CHECK(rethrows(threat));
+        CHECK(scans == 4);
+
+        // Hard links share an identity, copies share only their content
+        TestSupport::TempDir dir("deduplicator");
+        std::string payload = std::string(200, 'a') + " UPX! " + std::string(200, 'b') + " CreateRemoteThread ";
+        std::string original = dir.write("original.bin", payload);
+        std::string copy = dir.write("copy.bin", payload);
+        std::error_code ec;
+        fs::create_hard_link(original, dir.path("link.bin"), ec);
+        FileHandle originalFile = FileHandle::open(original);
+        FileHandle copyFile = FileHandle::open(copy);
+        if (!ec) {
+            FileHandle linkFile = FileHandle::open(dir.path("link.bin"));
+            CHECK(ScanDeduplicator::identityKey(originalFile) == ScanDeduplicator::identityKey(linkFile));
+        }
+        CHECK(ScanDeduplicator::identityKey(originalFile) != ScanDeduplicator::identityKey(copyFile));
+
+        ScanDeduplicator pass;
+        CHECK(scanner().scan(originalFile, ScanBudget(), &pass) == ScanStatus::Threat);
+        CHECK(scanner().scan(copyFile, ScanBudget(), &pass) == ScanStatus::Threat);
+        CHECK(pass.reusedCount() == 1);
+    }
+
+    void testIncrementalStatePrunesCleanDirectories() {
+        TestSupport::TempDir dir("incremental_state");
+        fs::create_directories(dir.root() / "a");
+        fs::create_directories(dir.root() / "b");
+        std::string clean = dir.write("a/clean.txt", "clean");
+        std::string bad = dir.write("b/bad.txt", "bad");
+        std::string root = dir.root().string();
+        std::string statePath = dir.path("scan.state");
+        const DirectoryStamp rootStamp{1, 10, 10}, stampA{2, 20, 20}, stampB{3, 30, 30};
+
+        IncrementalScanState first(root, "engine-1");
+        first.beginPass(true);
+        first.recordFile(FileHandle::open(clean), true);
+        first.directoryListed(dir.path("a"), stampA, {}, true);
+        first.recordFile(FileHandle::open(bad), false);
+        first.directoryListed(dir.path("b"), stampB, {}, true);
+        first.directoryListed(root + "/", rootStamp, {"a", "b"}, false);
+        CHECK(first.save(statePath, true));
+
+        IncrementalScanState second(root, "engine-1");
+        CHECK(second.load(statePath));
+        second.beginPass(false);
+        std::vector<std::string> subdirectories;
+        CHECK(second.skipDirectory(dir.path("a"), stampA, subdirectories));
+        CHECK(!second.skipDirectory(dir.path("b"), stampB, subdirectories));                // Held a threat
+        CHECK(!second.skipDirectory(root, rootStamp, subdirectories));                      // Listed incompletely
+        CHECK(!second.skipDirectory(dir.path("a"), {2, 21, 21}, subdirectories));          // Changed since
+        CHECK(second.prunedDirectories() == 1);
+        CHECK(second.unchanged(FileHandle::open(clean)));
+        CHECK(!second.unchanged(FileHandle::open(bad)));
+        dir.write("a/clean.txt", "rewritten");
+        CHECK(!second.unchanged(FileHandle::open(clean)));
+
+        // An incomplete pass keeps what it did not reach
+        CHECK(second.save(statePath, false));
+        IncrementalScanState third(root, "engine-1");
+        CHECK(third.load(statePath));
+        third.beginPass(false);
+        CHECK(third.skipDirectory(dir.path("a"), stampA, subdirectories));
+
+        // Full passes and new signatures trust nothing
+        third.beginPass(true);
+        CHECK(!third.skipDirectory(dir.path("a"), stampA, subdirectories));
+        IncrementalScanState upgraded(root, "engine-2");
+        CHECK(!upgraded.load(statePath));
+        upgraded.beginPass(false);
+        CHECK(!upgraded.skipDirectory(dir.path("a"), stampA, subdirectories));
+        CHECK(!IncrementalScanState(dir.path("a"), "engine-1").load(statePath));
+    }
+
+    ChangeJob fileJob(const std::string& path, ChangePriority priority) {
+        ChangeJob job;
+        job.path = path;
+        job.priority = priority;
+        return job;
+    }
+
+    void testChangeQueueOrdersByPriority() {
+        ChangeQueue queue(16);
+        CHECK(queue.push(fileJob("low", ChangePriority::Low)));
+        CHECK(queue.push(fileJob("normal1", ChangePriority::Normal)));
+        CHECK(queue.push(fileJob("high", ChangePriority::High)));
+        CHECK(queue.push(fileJob("normal2", ChangePriority::Normal)));
+
+        std::vector<std::string> order;
+        while (queue.size() > 0) order.push_back(queue.pop()->path);
+        CHECK((order == std::vector<std::string>{"high", "normal1", "normal2", "low"}));
+    }
+
+    void testChangeQueueCoalesces() {
+        ChangeQueue queue(16);
+        queue.push(fileJob("a", ChangePriority::Normal));
+        queue.push(fileJob("b", ChangePriority::Normal));
+        queue.push(fileJob("a", ChangePriority::Low));     // Cannot lower a waiting job
+        queue.push(fileJob("b", ChangePriority::High));    // Raises it ahead of "a"
+        CHECK(queue.size() == 2);
+        CHECK(queue.getStats().coalesced == 2);
+
+        std::optional<ChangeJob> first = queue.pop();
+        CHECK(first && first->path == "b" && first->priority == ChangePriority::High);
+        std::optional<ChangeJob> second = queue.pop();
+        CHECK(second && second->path == "a" && second->priority == ChangePriority::Normal);
+        CHECK(queue.size() == 0);
+
+        // A rescan of a directory is kept apart from a change to a file of the same name
+        ChangeJob rescan = fileJob("dir", ChangePriority::Low);
+        rescan.rescan = true;
+        rescan.since = 100;
+        queue.push(fileJob("dir", ChangePriority::Normal));
+        queue.push(rescan);
+        rescan.since = 50;
+        rescan.recursive = true;
+        queue.push(rescan);
+        CHECK(queue.size() == 2);
+        queue.pop();
+        std::optional<ChangeJob> merged = queue.pop();
+        CHECK(merged && merged->rescan && merged->recursive && merged->since == 50);
+    }
+
+    void testChangeQueueBoundsFiles() {
+        ChangeQueue queue(2);
+        CHECK(queue.push(fileJob("a", ChangePriority::Normal)));
+        CHECK(queue.push(fileJob("b", ChangePriority::Normal)));
+        CHECK(!queue.push(fileJob("c", ChangePriority::High)));
+        CHECK(queue.getStats().rejected == 1);
+
+        // Rescans recover what was rejected, so they always get in
+        ChangeJob rescan = fileJob("dir", ChangePriority::Low);
+        rescan.rescan = true;
+        CHECK(queue.push(rescan));
+        CHECK(queue.size() == 3);
+
+        queue.close();
+        CHECK(!queue.pop());
+        CHECK(!queue.push(fileJob("d", ChangePriority::High)));
+        queue.reopen();
+        CHECK(queue.push(fileJob("d", ChangePriority::High)));
+    }
+
+    void testQuarantineReplaysJournal() {
+        TestSupport::TempDir dir("quarantine_store");
+        std::string root = dir.path("store");
+        std::string first = dir.write("first.exe", "malicious content");
+        std::string copy = dir.write("copy\twith tab.exe", "malicious content");
+        std::string other = dir.write("other.exe", "other content");
+
+        std::string firstId, copyId, otherId;
+        {
+            QuarantineStore store(root);
+            firstId = store.quarantine(first, "test threat");
+            copyId = store.quarantine(copy, "same content");
+            otherId = store.quarantine(other, "another threat");
+            CHECK(!firstId.empty() && !copyId.empty() && !otherId.empty());
+            CHECK(firstId != copyId);
+            CHECK(!fs::exists(first) && !fs::exists(copy) && !fs::exists(other));
+            CHECK(store.size() == 3);
+        }
+
+        // Identical content is stored once
+        size_t objects = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(fs::path(root) / "objects")) {
+            if (entry.is_regular_file()) objects++;
+        }
+        CHECK(objects == 2);
+
+        {
+            QuarantineStore store(root);
+            CHECK(store.size() == 3);
+            std::optional<QuarantineEntry> entry = store.find(copyId);
+            CHECK(entry && fs::path(entry->originalPath) == fs::absolute(copy) && entry->reason == "same content");
+
+            std::string restored;
+            CHECK(store.restore(firstId, &restored));
+            CHECK(restored == fs::absolute(first).string());
+            CHECK(TestSupport::readFile(first) == "malicious content");
+            CHECK(!store.restore(firstId));
+        }
+
+        {
+            QuarantineStore store(root);
+            CHECK(store.size() == 2);
+            CHECK(!store.find(firstId));
+
+            // The original path is taken again, so the copy lands beside it
+            dir.write("copy\twith tab.exe", "new file");
+            std::string restored;
+            CHECK(store.restore(copyId, &restored));
+            CHECK(restored != fs::absolute(copy).string());
+            CHECK(TestSupport::readFile(restored) == "malicious content");
+            CHECK(TestSupport::readFile(copy) == "new file");
+
+            std::vector<std::string> paths;
+            CHECK(store.restoreAll(&paths) == 1);
+            CHECK(paths.size() == 1 && TestSupport::readFile(other) == "other content");
+        }
+
+        CHECK(QuarantineStore(root).size() == 0);
+    }
+
+    void testQuarantineFilesStagedContent() {
+        TestSupport::TempDir dir("quarantine_store");
+        std::string root = dir.path("store");
+        fs::path staging = fs::path(root) / "staging";
+        std::string content = "malicious content";
+        std::string digest = "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3";
+        std::string object = (fs::path(root) / "objects" / digest.substr(0, 2) / digest).string();
+
+        {
+            QuarantineStore store(root);
+            std::string id = store.quarantine(dir.write("first.exe", content), "test threat");
+            CHECK(!id.empty() && fs::is_empty(staging));
+            CHECK(TestSupport::readFile(object) == content);
+
+            // A stored object that no longer matches its digest gives way to a good copy
+            { std::ofstream damaged(object, std::ios::binary | std::ios::trunc); damaged << "damaged"; }
+            CHECK(!store.quarantine(dir.write("again.exe", content), "same content").empty());
+            CHECK(TestSupport::readFile(object) == content);
+        }
+
+        // A file staged when the process stopped is filed on the next start
+        { std::ofstream leftover(staging / "1.0.1-lost.exe", std::ios::binary); leftover << "other content"; }
+        QuarantineStore store(root);
+        CHECK(store.size() == 3 && fs::is_empty(staging));
+        bool recovered = false;
+        for (const auto& entry : store.list()) {
+            recovered |= entry.reason == "Interrupted quarantine" &&
+                         fs::path(entry.originalPath).filename() == "lost.exe";
+        }
+        CHECK(recovered);
+
+        // Nothing is left in staging when the file cannot be moved
+        CHECK(store.quarantine(dir.path("missing.exe"), "gone").empty());
+        CHECK(fs::is_empty(staging));
+    }
+
+    const std::string KNOWN_SHA256 = "275a021bbfb6489e54d471899f7db9d1663fc695ec2fe2a2c4538aabf651fd0f";
+
+    struct EngineFiles {
+        std::vector<std::string> sources;
+        std::string snapshot;
+    };
+
+    EngineFiles writeEngine(const TestSupport::TempDir& dir) {
+        EngineFiles files;
+        files.sources = {dir.write("signatures.db", KNOWN_SHA256 + "\n"),
+                         dir.write("fuzzy.db", ""), dir.write("pe.db", "")};
+        files.snapshot = dir.path("engine.snap");
+
+        SignatureDatabase signatures(files.sources[0]);
+        SimilarityIndex similarity(files.sources[1]);
+        PESignatureIndex peSignatures(files.sources[2]);
+        CHECK(EngineSnapshot::save(files.snapshot, files.sources, signatures, similarity, peSignatures));
+        return files;
+    }
+
+    void testSignaturesIgnoreHexCase() {
+        TestSupport::TempDir dir("signature_database");
+        std::string upper = KNOWN_SHA256;
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        std::string added = "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08";
+
+        SignatureDatabase signatures(dir.write("signatures.db", upper + "\n"));
+        CHECK(signatures.contains(KNOWN_SHA256) && signatures.contains(upper));
+
+        std::string addedUpper = added;
+        std::transform(addedUpper.begin(), addedUpper.end(), addedUpper.begin(), ::toupper);
+        signatures.addSignature(addedUpper);
+        signatures.addSignature(added);
+        CHECK(signatures.contains(added));
+        CHECK(signatures.getSignatureCount() == 2);
+    }
+
+    void testSnapshotLoadsCurrentSources() {
+        TestSupport::TempDir dir("engine_snapshot");
+        EngineFiles files = writeEngine(dir);
+
+        auto snapshot = EngineSnapshot::load(files.snapshot, files.sources);
+        CHECK(snapshot != nullptr);
+        if (snapshot) {
+            CHECK(snapshot->signatureCount() == 1);
+            CHECK(snapshot->containsSha256(KNOWN_SHA256));
+            CHECK(!snapshot->containsSha256(std::string(64, '0')));
+            CHECK(!snapshot->containsSha256("not hex"));
+        }
+        CHECK(!EngineSnapshot::load(dir.path("missing.snap"), files.sources));
+    }
+
+    void testSnapshotRejectsStaleSources() {
+        TestSupport::TempDir dir("engine_snapshot");
+        EngineFiles files = writeEngine(dir);
+
+        // A different set of sources
+        CHECK(!EngineSnapshot::load(files.snapshot, {files.sources[0], files.sources[1]}));
+        CHECK(!EngineSnapshot::load(files.snapshot, {files.sources[1], files.sources[0], files.sources[2]}));
+
+        // Same size, new modification time
+        fs::last_write_time(files.sources[1], fs::last_write_time(files.sources[1]) + std::chrono::seconds(10));
+        CHECK(!EngineSnapshot::load(files.snapshot, files.sources));
+
+        files = writeEngine(dir);
+        dir.write("signatures.db", KNOWN_SHA256 + "\n" + std::string(64, 'a') + "\n");
+        CHECK(!EngineSnapshot::load(files.snapshot, files.sources));
+    }
+
+    void testSnapshotRejectsCorruption() {
+        TestSupport::TempDir dir("engine_snapshot");
+        EngineFiles files = writeEngine(dir);
+        const std::string original = TestSupport::readFile(files.snapshot);
+        CHECK(original.size() > 48);
+
+        auto loadWith = [&](const std::string& content) {
+            dir.write("engine.snap", content);
+            return EngineSnapshot::load(files.snapshot, files.sources);
+        };
+        CHECK(loadWith(original) != nullptr);
+
+        CHECK(!loadWith(original.substr(0, original.size() - 1)));
+        CHECK(!loadWith(original.substr(0, 20)));
+        CHECK(!loadWith(""));
+
+        std::string badMagic = original;
+        badMagic[0] = 'X';
+        CHECK(!loadWith(badMagic));
+
+        std::string badVersion = original;
+        badVersion[8] = static_cast<char>(badVersion[8] + 1);
+        CHECK(!loadWith(badVersion));
+
+        // Section table pointing past the end of the file
+        std::string badOffset = original;
+        for (size_t i = 32; i < 40; i++) badOffset[i] = '\x7f';
+        CHECK(!loadWith(badOffset));
+    }
+
+    ContentFingerprint fingerprint(float entropy, FileType type = FileType::Unknown) {
+        ContentFingerprint result;
+        result.entropy = entropy;
+        result.type = type;
+        result.size = 64 * 1024;
+        return result;
+    }
+
+    void testFingerprintCompare() {
+        CHECK(FingerprintCache::compare(fingerprint(4.5f), fingerprint(7.9f)) == FingerprintChange::EntropyRise);
+        CHECK(FingerprintCache::compare(fingerprint(7.5f, FileType::PE), fingerprint(7.9f)) ==
+              FingerprintChange::TypeLoss);
+        // Compressing a text file is not encrypting it
+        CHECK(FingerprintCache::compare(fingerprint(4.5f), fingerprint(7.9f, FileType::Archive)) ==
+              FingerprintChange::None);
+        CHECK(FingerprintCache::compare(fingerprint(4.5f), fingerprint(5.0f)) == FingerprintChange::None);
+
+        ContentFingerprint tiny = fingerprint(7.9f);
+        tiny.size = 16;
+        CHECK(FingerprintCache::compare(fingerprint(4.5f), tiny) == FingerprintChange::None);
+    }
+
+    void testReplacementPairsDeletionWithCopy() {
+        ReplacementTracker tracker;
+        const std::string dir = (fs::path("data") / "docs").string();
+        const std::string original = (fs::path(dir) / "report.txt").string();
+        const std::string copy = (fs::path(dir) / "report.txt.locked").string();
+
+        // Copy written first, original deleted after
+        CHECK(!tracker.created(copy, fingerprint(7.9f)));
+        std::optional<ReplacementTracker::Replacement> replacement = tracker.deleted(original, fingerprint(4.5f));
+        CHECK(replacement && replacement->original == original && replacement->copy == copy);
+        CHECK(replacement && replacement->change == FingerprintChange::EntropyRise);
+
+        // Each file pairs once
+        CHECK(!tracker.deleted(original, fingerprint(4.5f)));
+        // The other order, and the pending deletion above is taken by the next copy
+        replacement = tracker.created(copy, fingerprint(7.9f));
+        CHECK(replacement && replacement->original == original);
+
+        // Files in different directories, or that do not look encrypted, do not pair
+        CHECK(!tracker.deleted((fs::path("data") / "a.txt").string(), fingerprint(4.5f)));
+        CHECK(!tracker.created((fs::path("other") / "a.locked").string(), fingerprint(7.9f)));
+        CHECK(!tracker.deleted((fs::path("data") / "b.txt").string(), fingerprint(4.5f)));
+        CHECK(!tracker.created((fs::path("data") / "b.zip").string(), fingerprint(7.9f, FileType::Archive)));
+        CHECK(!tracker.created((fs::path("data") / "b.log").string(), fingerprint(5.0f)));
+    }
+    FuzzyDigest fuzzyOf(const std::string& content) {
+        FuzzyHasher hasher;
+        hasher.update(reinterpret_cast<const unsigned char*>(content.data()), content.size());
+        return hasher.finalize();
+    }
+
+    std::string pseudoRandomText(size_t length, uint32_t seed) {
+        std::string text;
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            text += static_cast<char>('!' + (seed >> 16) % 90);
+        }
+        return text;
+    }
+
+    void testSimilarityFindsVariants() {
+        TestSupport::TempDir dir("similarity_index");
+        std::string sample = pseudoRandomText(8192, 1);
+        std::string variant = sample;
+        variant.replace(2000, 16, std::string(16, '#'));
+        FuzzyDigest unrelated = fuzzyOf(pseudoRandomText(8192, 2));
+
+        std::string line = fuzzyOf(sample).toString() + "\tTrojan.Sample\n";
+        std::string db = dir.write("fuzzy.db", "# comment\n" + line + "not a digest\tBroken\n");
+        SimilarityIndex index(db);
+        CHECK(index.size() == 1);
+        auto match = index.findClosest(fuzzyOf(variant), Config::FUZZY_MATCH_THRESHOLD);
+        CHECK(match && match->label == "Trojan.Sample" && match->distance > 0);
+        CHECK(!index.findClosest(unrelated, Config::FUZZY_MATCH_THRESHOLD));
+        CHECK(!index.findClosest(FuzzyDigest{}, Config::FUZZY_MATCH_THRESHOLD));
+
+        // The closest of several samples wins
+        CHECK(index.addSample(fuzzyOf(variant), "Trojan.Variant"));
+        CHECK(index.addSample(unrelated, "Other"));
+        match = index.findClosest(fuzzyOf(variant), Config::FUZZY_MATCH_THRESHOLD);
+        CHECK(match && match->label == "Trojan.Variant" && match->distance == 0);
+        CHECK(index.size() == 3);
+        CHECK(SimilarityIndex(db).size() == 3);         // Added samples are kept in the database
+
+        // Searched in place from a snapshot, alongside samples added later
+        db = dir.write("snapshot_fuzzy.db", line);
+        std::vector<std::string> sources = {dir.write("signatures.db", ""), db, dir.write("pe.db", "")};
+        SignatureDatabase signatures(sources[0]);
+        SimilarityIndex fromText(sources[1]);
+        PESignatureIndex peSignatures(sources[2]);
+        CHECK(EngineSnapshot::save(dir.path("engine.snap"), sources, signatures, fromText, peSignatures));
+        auto snapshot = EngineSnapshot::load(dir.path("engine.snap"), sources);
+        CHECK(snapshot != nullptr);
+        SimilarityIndex mapped(db, snapshot);
+        match = mapped.findClosest(fuzzyOf(variant), Config::FUZZY_MATCH_THRESHOLD);
+        CHECK(match && match->label == "Trojan.Sample");
+        CHECK(mapped.addSample(unrelated, "Other"));
+        match = mapped.findClosest(unrelated, 0);
+        CHECK(match && match->label == "Other");
+    }
+
+    void testScanBufferMatchesFileScan() {
+        TestSupport::TempDir dir("scan_buffer");
+        std::string known = "malicious content";
+        std::string digest = "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3";
+        FileScanner local(dir.write("signatures.db", digest + "\n"));
+
+        auto scan = [&local](const std::string& content, const std::string& name) {
+            return local.scanBuffer(std::as_bytes(std::span(content.data(), content.size())), {name, "test"});
+        };
+        CHECK(scan(known, "note.txt") == ScanStatus::Threat);
+        CHECK(scan(known + " ", "note.txt") == ScanStatus::Clean);
+        CHECK(scan("", "empty.txt") == ScanStatus::Clean);
+
+        // Same verdict as the file path takes for the same bytes
+        std::string payload = std::string(200, 'a') + " UPX! " + std::string(200, 'b') + " CreateRemoteThread ";
+        CHECK(local.scanFile(dir.write("payload.bin", payload)) == true);
+        CHECK(scan(payload, "payload.bin") == ScanStatus::Threat);
+        CHECK(local.scanFile(dir.write("known.txt", known)) == true);
+        CHECK(local.scanFile(dir.write("plain.txt", "nothing here")) == false);
+        CHECK(scan("nothing here", "plain.txt") == ScanStatus::Clean);
+
+        // The budget is honoured without a file behind the scan
+        CancellationToken token;
+        token.cancel();
+        CHECK(local.scanBuffer(std::as_bytes(std::span(payload.data(), payload.size())), {"payload.bin", "test"},
+                               ScanBudget(std::chrono::milliseconds(0), &token)) == ScanStatus::Cancelled);
+    }
+
+    ScanStatus feedText(StreamScanner& stream, const std::string& chunk) {
+        return stream.feed(std::as_bytes(std::span(chunk.data(), chunk.size())));
+    }
+
+    void testStreamReportsThreatMidStream() {
+        // Both signals split across feeds, past the held-back head
+        StreamScanner stream(scanner(), {"upload.bin", "test"});
+        CHECK(feedText(stream, std::string(Config::STREAM_HEAD_SIZE - 10, 'a')) == ScanStatus::Clean);
+        CHECK(feedText(stream, std::string(10, 'a') + " UP") == ScanStatus::Clean);
+        CHECK(feedText(stream, "X! " + std::string(1000, 'b') + " CreateRemote") == ScanStatus::Clean);
+        CHECK(feedText(stream, "Thread ") == ScanStatus::Threat);
+        uint64_t seen = stream.bytesSeen();
+
+        // Later chunks are ignored and the verdict sticks
+        CHECK(feedText(stream, std::string(100, 'c')) == ScanStatus::Threat);
+        CHECK(stream.bytesSeen() == seen);
+        CHECK(stream.finish() == ScanStatus::Threat);
+
+        // A stream shorter than the head is only judged at the end
+        StreamScanner shortStream(scanner(), {"short.bin", "test"});
+        CHECK(feedText(shortStream, "UPX! CreateRemoteThread ") == ScanStatus::Clean);
+        CHECK(shortStream.finish() == ScanStatus::Threat);
+
+        // Whole-content signatures need the whole content
+        TestSupport::TempDir dir("stream_scanner");
+        FileScanner local(dir.write("signatures.db",
+                                    "e85df646815c48d4d82c7c429837d86a18748959d79478d20eb0ca0b7bb05bf3\n"));
+        StreamScanner known(local, {"note.txt", "test"});
+        CHECK(feedText(known, "malicious ") == ScanStatus::Clean);
+        CHECK(feedText(known, "content") == ScanStatus::Clean);
+        CHECK(known.finish() == ScanStatus::Threat);
+        CHECK(known.bytesSeen() == 17);
+
+        StreamScanner plain(scanner(), {"plain.txt", "test"});
+        CHECK(feedText(plain, std::string(Config::STREAM_HEAD_SIZE * 2, 'a')) == ScanStatus::Clean);
+        CHECK(plain.finish() == ScanStatus::Clean);
+    }
+
+    void testScanIgnoresChosenType() {
+        // Packer and strings together reach the threshold whatever the magic says
+        std::string payload = std::string(200, 'a') + " UPX! " + std::string(200, 'b') + " CreateRemoteThread ";
+        CHECK(scanText("GIF89a" + payload, "image.gif") == ScanStatus::Threat);
+        CHECK(scanText("%PDF-1.7\n" + payload, "doc.pdf") == ScanStatus::Threat);
+        CHECK(scanText("PK\x05\x06" + payload, "a.zip") == ScanStatus::Threat);
+        CHECK(scanText("ID3" + payload, "song.mp3") == ScanStatus::Threat);
+
+        // Either signal alone is not enough
+        CHECK(scanText("GIF89a" + std::string(400, 'a') + " UPX! ", "image.gif") == ScanStatus::Clean);
+        CHECK(scanText("GIF89a" + std::string(400, 'a') + " CreateRemoteThread ", "image.gif") == ScanStatus::Clean);
+    }
+    void testSampleEscalatesOnAnyPattern() {
+        FileScanner sampler(Config::SIGNATURE_DB_PATH);
+        ScanPolicy& policy = sampler.getScanPolicy();
+        policy.setPolicy(".mp3", {64 * 1024, 128 * 1024, std::numeric_limits<uint64_t>::max()});
+        policy.setHeadTailSize(16 * 1024);
+        policy.setSampling({16 * 1024, 4096, 8});
+
+        // A string in the head is all the sample sees; the packer signature
+        // sits where no sampled block reaches, so only a full scan finds both
+        std::string content = "ID3 CreateRemoteThread " + std::string(MB - 23, 'a');
+        ScanPlan plan = policy.plan("song.mp3", content.size());
+        CHECK(plan.mode == ScanMode::Sampled);
+        uint64_t hidden = 0;
+        for (uint64_t offset = 64 * 1024; offset < content.size() && hidden == 0; offset += 4096) {
+            bool sampled = false;
+            for (const auto& region : plan.regions) {
+                sampled |= offset + 8 > region.offset && offset < region.offset + region.length;
+            }
+            if (!sampled) hidden = offset;
+        }
+        CHECK(hidden != 0);
+        content.replace(hidden, 4, "UPX!");
+
+        auto bytes = std::as_bytes(std::span(content.data(), content.size()));
+        CHECK(sampler.scanBuffer(bytes, {"song.mp3", "test"}) == ScanStatus::Threat);
+
+        // Nothing in the sample, nothing escalated
+        content.replace(4, 18, std::string(18, 'a'));
+        bytes = std::as_bytes(std::span(content.data(), content.size()));
+        CHECK(sampler.scanBuffer(bytes, {"song.mp3", "test"}) == ScanStatus::Clean);
+    }
+    std::chrono::milliseconds elapsedSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    void testThrottlePacesReads() {
+        ScanThrottle throttle;
+        throttle.setAdaptive(false);
+        throttle.setFilesPerSecond(0);
+        throttle.setBytesPerSecond(640 * 1024);     // 160KB burst
+
+        auto start = std::chrono::steady_clock::now();
+        throttle.beforeRead(160 * 1024);
+        CHECK(elapsedSince(start) < std::chrono::milliseconds(50));
+        throttle.beforeRead(64 * 1024);
+        CHECK(elapsedSince(start) >= std::chrono::milliseconds(80));
+    }
+
+    void testThrottleFollowsRateChanges() {
+        ScanThrottle throttle;
+        throttle.setAdaptive(false);
+        throttle.setFilesPerSecond(0);
+        throttle.setBytesPerSecond(64 * 1024);
+
+        // Each read below leaves at least two seconds of debt at 64KB/s
+        auto waitWhile = [&](const std::function<void()>& change) {
+            std::atomic<bool> done{false};
+            auto start = std::chrono::steady_clock::now();
+            std::thread reader([&] {
+                throttle.beforeRead(192 * 1024);
+                done = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            CHECK(!done);
+            change();
+            reader.join();
+            return elapsedSince(start);
+        };
+
+        auto limit = std::chrono::milliseconds(700);
+        CHECK(waitWhile([&] { throttle.setBytesPerSecond(64 * 1024 * 1024); }) < limit);
+        throttle.setBytesPerSecond(64 * 1024);
+        CHECK(waitWhile([&] { throttle.setBytesPerSecond(0); }) < limit);
+        throttle.setBytesPerSecond(64 * 1024);
+        CHECK(waitWhile([&] { throttle.interrupt(); }) < limit);
+    }
+
+#ifdef __linux__
+    pid_t startIdleChild() {
+        pid_t child = fork();
+        if (child == 0) {
+            pause();
+            _exit(0);
+        }
+        return child;
+    }
+
+    void stopChild(pid_t child) {
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+    }
+
+    void testMemoryScannerForgetsProcesses() {
+        ProcessMemoryScanner scanner(1);
+        pid_t child = startIdleChild();
+        scanner.scanProcess(child);
+        CHECK(scanner.trackedProcesses() == 1);
+        scanner.forget(child);
+        CHECK(scanner.trackedProcesses() == 0);
+        stopChild(child);
+
+        // The monitor drops exited processes from the scanner as it forgets them
+        ProcessMonitor monitor(&scanner);
+        monitor.poll();
+        child = startIdleChild();
+        monitor.poll();
+        size_t tracked = scanner.trackedProcesses();
+        CHECK(tracked >= 1);
+        stopChild(child);
+        monitor.poll();
+        CHECK(scanner.trackedProcesses() < tracked);
+    }
+
+    void testMemoryScannerSweepsInBackground() {
+        ProcessMemoryScanner scanner(1);
+        pid_t child = startIdleChild();
+        scanner.startSweeping(std::chrono::seconds(3600));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // Stopping cuts the sweep under way short, which still records its stats
+        auto began = std::chrono::steady_clock::now();
+        scanner.stopSweeping();
+        CHECK(std::chrono::steady_clock::now() - began < std::chrono::seconds(2));
+        CHECK(scanner.getLastStats().processes > 0);
+        stopChild(child);
+    }
+#endif
+
+#ifdef HOOK_TARGET_PATH
+    void testHookDetectorFindsPatchedExport() {
+        void* library = dlopen(HOOK_TARGET_PATH, RTLD_NOW | RTLD_LOCAL);
+        CHECK(library != nullptr);
+        if (!library) return;
+        auto* target = reinterpret_cast<unsigned char*>(dlsym(library, "hookTargetScale"));
+        CHECK(target != nullptr);
+
+        HookDetector detector;
+        auto hookedInLibrary = [&]() {
+            std::vector<std::string> functions;
+            for (const auto& finding : detector.checkProcess(getpid())) {
+                if (finding.module.find("hook_target") != std::string::npos) functions.push_back(finding.function);
+            }
+            return functions;
+        };
+        CHECK(hookedInLibrary().empty());
+
+        // Overwrite the first byte of one export, as an inline hook would
+        uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(target) & ~(pageSize - 1));
+        bool writable = target && mprotect(page, pageSize, PROT_READ | PROT_WRITE | PROT_EXEC) == 0;
+        CHECK(writable);
+        if (writable) {
+            unsigned char original = target[0];
+            target[0] = 0xCC;
+            CHECK((hookedInLibrary() == std::vector<std::string>{"hookTargetScale"}));
+            target[0] = original;
+            CHECK(hookedInLibrary().empty());
+            mprotect(page, pageSize, PROT_READ | PROT_EXEC);
+        }
+        CHECK(detector.cachedModules() > 0);
+        dlclose(library);
+    }
+#endif
+}
+
+int main() {
+    TestSupport::TempDir workspace("scanner_workspace");
+    fs::current_path(workspace.root());
+    fs::create_directories("data");
+
+    return TestSupport::runAll({
+        {"policy_chooses_mode_by_size", testPolicyChoosesModeBySize},
+        {"sampling_is_deterministic", testSamplingIsDeterministic},
+        {"add_regions_merges", testAddRegionsMerges},
+        {"scoring_runs_cheapest_first", testScoringRunsCheapestFirst},
+        {"deduplicator_shares_results", testDeduplicatorSharesResults},
+        {"incremental_state_prunes_clean_directories", testIncrementalStatePrunesCleanDirectories},
+        {"change_queue_orders_by_priority", testChangeQueueOrdersByPriority},
+        {"change_queue_coalesces", testChangeQueueCoalesces},
+        {"change_queue_bounds_files", testChangeQueueBoundsFiles},
+        {"quarantine_replays_journal", testQuarantineReplaysJournal},
+        {"quarantine_files_staged_content", testQuarantineFilesStagedContent},
+        {"signatures_ignore_hex_case", testSignaturesIgnoreHexCase},
+        {"snapshot_loads_current_sources", testSnapshotLoadsCurrentSources},
+        {"snapshot_rejects_stale_sources", testSnapshotRejectsStaleSources},
+        {"snapshot_rejects_corruption", testSnapshotRejectsCorruption},
+        {"fingerprint_compare", testFingerprintCompare},
+        {"replacement_pairs_deletion_with_copy", testReplacementPairsDeletionWithCopy},
+        {"similarity_finds_variants", testSimilarityFindsVariants},
+        {"scan_buffer_matches_file_scan", testScanBufferMatchesFileScan},
+        {"stream_reports_threat_mid_stream", testStreamReportsThreatMidStream},
+        {"scan_ignores_chosen_type", testScanIgnoresChosenType},
+        {"sample_escalates_on_any_pattern", testSampleEscalatesOnAnyPattern},
+        {"throttle_paces_reads", testThrottlePacesReads},
+        {"throttle_follows_rate_changes", testThrottleFollowsRateChanges},
+#ifdef __linux__
+        {"memory_scanner_forgets_processes", testMemoryScannerForgetsProcesses},
+        {"memory_scanner_sweeps_in_background", testMemoryScannerSweepsInBackground},
+#endif
+#ifdef HOOK_TARGET_PATH
+        {"hook_detector_finds_patched_export", testHookDetectorFindsPatchedExport},
+#endif
+    });
+}
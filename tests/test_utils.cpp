@@ -0,0 +1,489 @@
+#include "TestSupport.h"
+#include "utils/AsyncReadEngine.h"
+#include "utils/ChunkedReader.h"
+#include "utils/ElfParser.h"
+#include "utils/EncodedRunDetector.h"
+#include "utils/FileTypeClassifier.h"
+#include "utils/FuzzyHash.h"
+#include "utils/PEParser.h"
+#include "utils/PatternAutomaton.h"
+#include "utils/ScanBudget.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace {
+    void put16(std::vector<unsigned char>& image, size_t offset, uint16_t value) {
+        image[offset] = static_cast<unsigned char>(value);
+        image[offset + 1] = static_cast<unsigned char>(value >> 8);
+    }
+
+    void put32(std::vector<unsigned char>& image, size_t offset, uint32_t value) {
+        put16(image, offset, static_cast<uint16_t>(value));
+        put16(image, offset + 2, static_cast<uint16_t>(value >> 16));
+    }
+
+    void putString(std::vector<unsigned char>& image, size_t offset, const char* text) {
+        std::memcpy(image.data() + offset, text, std::strlen(text) + 1);
+    }
+
+    // PE32 image with one section mapping RVA 0x1000 to file offset 0x200,
+    // importing KERNEL32.dll!ExitProcess and ordinal 5
+    std::vector<unsigned char> minimalPe(size_t sectionSize = 0x200) {
+        std::vector<unsigned char> image(0x200 + sectionSize, 0);
+        image[0] = 'M';
+        image[1] = 'Z';
+        put32(image, 0x3C, 0x40);
+
+        putString(image, 0x40, "PE");
+        put16(image, 0x44, 0x14C);          // i386
+        put16(image, 0x46, 1);              // Sections
+        put16(image, 0x54, 0xE0);           // Optional header size
+        put16(image, 0x56, 0x0102);
+
+        const size_t optional = 0x58;
+        put16(image, optional, 0x10B);
+        put32(image, optional + 16, 0x1000);
+        put32(image, optional + 28, 0x400000);
+        put16(image, optional + 68, 2);
+        put32(image, optional + 92, 16);
+        put32(image, optional + 104, 0x1000);   // Import directory
+        put32(image, optional + 108, 40);
+
+        const size_t section = optional + 0xE0;
+        putString(image, section, ".text");
+        put32(image, section + 8, static_cast<uint32_t>(sectionSize));
+        put32(image, section + 12, 0x1000);
+        put32(image, section + 16, static_cast<uint32_t>(sectionSize));
+        put32(image, section + 20, 0x200);
+        put32(image, section + 36, 0x60000020);
+
+        put32(image, 0x200, 0x1040);        // Lookup table
+        put32(image, 0x20C, 0x1080);        // Library name
+        put32(image, 0x210, 0x1040);        // Address table
+        put32(image, 0x240, 0x10A0);
+        put32(image, 0x244, 0x80000005);
+        putString(image, 0x280, "KERNEL32.dll");
+        putString(image, 0x2A2, "ExitProcess");
+        return image;
+    }
+
+    bool parsePe(const std::vector<unsigned char>& image, PEInfo& info) {
+        ScanSource source(std::as_bytes(std::span(image.data(), image.size())), "image.exe");
+        return PEParser::parse(source, info);
+    }
+
+    void testPeParsesImports() {
+        PEInfo info;
+        CHECK(parsePe(minimalPe(), info));
+        CHECK(!info.is64);
+        CHECK(info.imageBase == 0x400000);
+        CHECK(info.sections.size() == 1 && info.sections[0].name == ".text");
+        CHECK(info.imports.size() == 2);
+        if (info.imports.size() == 2) {
+            CHECK(info.imports[0].library == "KERNEL32.dll" && info.imports[0].function == "ExitProcess");
+            CHECK(info.imports[1].function.empty() && info.imports[1].ordinal == 5);
+        }
+        CHECK(PEParser::importHash(info) == "6e397cc7bfa2ad2a121f499d79972673");
+        CHECK(PEParser::rvaToOffset(info, 0x1040) == 0x240);
+        CHECK(PEParser::rvaToOffset(info, 0x9000) < 0);
+    }
+
+    void testImportHashNamesKnownOrdinals() {
+        // Same list pefile builds: ordinals it can name through ordlookup are named
+        PEInfo info;
+        info.imports = {{"WS2_32.dll", "", 23}, {"wsock32.DLL", "", 115}, {"OleAut32.dll", "", 2},
+                        {"OLEAUT32.dll", "", 320}, {"KERNEL32.dll", "", 5}, {"USER32.dll", "MessageBoxA", 0}};
+        CHECK(PEParser::importHash(info) == "3a81c11c656f0c028aa85d63ec82a379");
+
+        std::vector<unsigned char> image = minimalPe();
+        putString(image, 0x280, "WS2_32.dll");
+        CHECK(parsePe(image, info));
+        CHECK(PEParser::importHash(info) == "332c2d6a97815b962810b72598f0f27c");
+    }
+
+    void testPeRejectsMalformedHeaders() {
+        PEInfo info;
+        CHECK(!parsePe({}, info));
+        CHECK(!parsePe(std::vector<unsigned char>(32, 'M'), info));
+
+        std::vector<unsigned char> image = minimalPe();
+        put32(image, 0x3C, 0x7FFFFFF0);     // Headers past the end of the file
+        CHECK(!parsePe(image, info));
+
+        image = minimalPe();
+        image[0x41] = 'X';
+        CHECK(!parsePe(image, info));
+
+        image = minimalPe();
+        put16(image, 0x58, 0x107);          // ROM image, not PE32 or PE32+
+        CHECK(!parsePe(image, info));
+
+        image = minimalPe();
+        put16(image, 0x54, 16);             // Optional header too short to hold the fields we read
+        CHECK(!parsePe(image, info));
+
+        image = minimalPe();
+        image.resize(0x180);                // Section table cut off
+        put16(image, 0x46, 0xFFFF);
+        CHECK(!parsePe(image, info));
+    }
+
+    void testPeIgnoresBrokenImports() {
+        PEInfo info;
+        std::vector<unsigned char> image = minimalPe();
+        put32(image, 0x58 + 104, 0x7000);   // Import directory outside every section
+        CHECK(parsePe(image, info));
+        CHECK(info.imports.empty());
+        CHECK(PEParser::importHash(info).empty());
+
+        image = minimalPe();
+        put32(image, 0x20C, 0x5000);        // Library name outside every section
+        CHECK(parsePe(image, info));
+        CHECK(info.imports.empty());
+    }
+
+    void testPeBoundsRunawayImports() {
+        // Every descriptor points at the same endless run of ordinal thunks
+        const size_t descriptors = 1024;
+        std::vector<unsigned char> image = minimalPe(0x10000);
+        for (size_t i = 0; i < descriptors; i++) {
+            put32(image, 0x200 + i * 20, 0x7000);
+            put32(image, 0x200 + i * 20 + 12, 0x6000);
+            put32(image, 0x200 + i * 20 + 16, 0x7000);
+        }
+        putString(image, 0x200 + 0x5000, "loop.dll");
+        for (size_t offset = 0x200 + 0x6000; offset + 4 <= image.size(); offset += 4) {
+            put32(image, offset, 0x80000001);
+        }
+        put32(image, 0x58 + 108, static_cast<uint32_t>(descriptors * 20));
+
+        PEInfo info;
+        CHECK(parsePe(image, info));
+        CHECK(!info.imports.empty());
+        CHECK(info.imports.size() <= 16384);
+    }
+
+    void testElfRejectsMalformedFiles() {
+        TestSupport::TempDir dir("elf_parser");
+        ElfInfo info;
+
+        FileHandle text = FileHandle::open(dir.write("text", std::string(128, 'x')));
+        CHECK(!ElfParser::parse(text, info));
+
+        FileHandle truncated = FileHandle::open(dir.write("truncated", std::string("\x7f" "ELF\x02\x01", 6)));
+        CHECK(!ElfParser::parse(truncated, info));
+
+        std::string header(64, '\0');
+        header.replace(0, 4, "\x7f" "ELF");
+        header[4] = 2;
+        header[5] = 2;                      // Big-endian
+        FileHandle bigEndian = FileHandle::open(dir.write("big", header));
+        CHECK(!ElfParser::parse(bigEndian, info));
+
+        // Tables claimed far past the end of the file are skipped, not read,
+        // which leaves nothing to load
+        header[5] = 1;
+        std::memset(&header[0x20], 0xFF, 16);   // Program and section header offsets
+        header[0x36] = 56;
+        header[0x38] = header[0x39] = '\xff';
+        header[0x3A] = 64;
+        header[0x3C] = header[0x3D] = '\xff';
+        FileHandle wild = FileHandle::open(dir.write("wild", header));
+        CHECK(!ElfParser::parse(wild, info));
+        CHECK(info.loadSegments.empty() && info.functions.empty() && info.relocations.empty());
+    }
+
+#ifdef __linux__
+    void testElfParsesOwnExecutable() {
+        FileHandle self = FileHandle::open("/proc/self/exe");
+        ElfInfo info;
+        CHECK(ElfParser::parse(self, info));
+        CHECK(info.is64 == (sizeof(void*) == 8));
+        CHECK(!info.loadSegments.empty());
+        if (!info.loadSegments.empty()) {
+            const ElfSegment& first = info.loadSegments.front();
+            CHECK(ElfParser::addressToOffset(info, first.virtualAddress) == static_cast<int64_t>(first.fileOffset));
+        }
+        CHECK(ElfParser::addressToOffset(info, UINT64_MAX - 1) == -1);
+    }
+#endif
+
+    bool matches(const PatternAutomaton& automaton, const std::vector<std::string>& chunks) {
+        PatternAutomaton::State state = PatternAutomaton::START;
+        bool found = false;
+        for (const auto& chunk : chunks) {
+            found = automaton.advance(state, reinterpret_cast<const unsigned char*>(chunk.data()), chunk.size()) || found;
+        }
+        return found;
+    }
+
+    void testAutomatonMatchesAcrossChunks() {
+        PatternAutomaton automaton({"VirtualAllocEx", "abcd", "bce"});
+        const std::string text = "xx VirtualAllocEx yy";
+        for (size_t split = 0; split <= text.size(); split++) {
+            CHECK(matches(automaton, {text.substr(0, split), text.substr(split)}));
+        }
+
+        std::vector<std::string> bytes;
+        for (char c : text) bytes.emplace_back(1, c);
+        CHECK(matches(automaton, bytes));
+
+        // Falls back from the partial "abc" to the suffix that starts "bce"
+        CHECK(matches(automaton, {"ab", "ce"}));
+        CHECK(!matches(automaton, {"VirtualAlloc", "E"}));
+        CHECK(matches(automaton, {"abc", "", "e"}));
+        CHECK(!matches(automaton, {"ab d", "bc d"}));
+    }
+
+    std::string randomText(const char* alphabet, size_t alphabetSize, size_t length, uint32_t seed) {
+        std::string result;
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            result += alphabet[(seed >> 16) % alphabetSize];
+        }
+        return result;
+    }
+
+    EncodedRunDetector detect(const std::string& content, size_t chunkSize) {
+        EncodedRunDetector detector;
+        const auto* data = reinterpret_cast<const unsigned char*>(content.data());
+        for (size_t offset = 0; offset < content.size(); offset += chunkSize) {
+            detector.update(data + offset, std::min(chunkSize, content.size() - offset), offset);
+        }
+        detector.finish();
+        return detector;
+    }
+
+    const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char HEX_ALPHABET[] = "0123456789abcdef";
+
+    void testEncodedRunsAcrossChunks() {
+        const std::string prose = "Nothing to see in this part of the file. ";
+        std::string blob = randomText(BASE64_ALPHABET, 64, 1000, 7);
+        std::string content = prose + blob + " end";
+
+        for (size_t chunkSize : {1, 7, 64, 100, 4096}) {
+            EncodedRunDetector detector = detect(content, chunkSize);
+            CHECK(detector.blobFound());
+            CHECK(detector.runs().size() == 1);
+            if (detector.runs().size() == 1) {
+                CHECK(detector.runs()[0].offset == prose.size());
+                CHECK(detector.runs()[0].length == blob.size());
+                CHECK(detector.runs()[0].type == EncodedRunType::Base64);
+            }
+        }
+
+        // Wrapped base64 is one run
+        std::string wrapped;
+        for (size_t i = 0; i < blob.size(); i += 76) wrapped += blob.substr(i, 76) + "\r\n";
+        EncodedRunDetector lines = detect(prose + wrapped + " end", 33);
+        CHECK(lines.blobFound() && lines.runs().size() == 1);
+
+        EncodedRunDetector hex = detect(prose + randomText(HEX_ALPHABET, 16, 600, 11) + " end", 50);
+        CHECK(hex.blobFound() && hex.runs().size() == 1);
+        if (hex.runs().size() == 1) CHECK(hex.runs()[0].type == EncodedRunType::Hex);
+    }
+
+    void testEncodedRunsIgnorePlainData() {
+        std::string prose;
+        for (int i = 0; i < 40; i++) prose += "The quick brown fox jumps over the lazy dog. ";
+        EncodedRunDetector text = detect(prose, 64);
+        CHECK(!text.blobFound());
+        CHECK(text.runCount() == 0);
+
+        // Long but repetitive: a run, not a blob
+        EncodedRunDetector padding = detect(std::string(1000, 'A'), 64);
+        CHECK(!padding.blobFound());
+        CHECK(padding.runCount() == 1);
+
+        // Two short runs separated by a gap between regions do not join up
+        std::string half = randomText(BASE64_ALPHABET, 64, 200, 3);
+        EncodedRunDetector detector;
+        detector.update(reinterpret_cast<const unsigned char*>(half.data()), half.size(), 0);
+        detector.update(reinterpret_cast<const unsigned char*>(half.data()), half.size(), 4096);
+        detector.finish();
+        CHECK(detector.runCount() == 0);
+    }
+    FileType classify(const std::string& head, std::string_view name = {}) {
+        return FileTypeClassifier::classify({reinterpret_cast<const unsigned char*>(head.data()), head.size()},
+                                            name).type;
+    }
+
+    void testClassifierReadsMagic() {
+        CHECK(classify("MZ\x90\x00") == FileType::PE);
+        CHECK(classify("\x7F" "ELF\x02") == FileType::ELF);
+        CHECK(classify("GIF89a\x01\x00") == FileType::Image);
+        CHECK(classify("%PDF-1.7") == FileType::PDF);
+        CHECK(classify("#!/bin/sh\n") == FileType::Script);
+        CHECK(classify(std::string("\x1F\x8B\x08\x00", 4)) == FileType::Archive);
+
+        // Confirmed signatures win over the bare magic they extend
+        std::string riff = std::string("RIFF\x10\x00\x00\x00", 8);
+        CHECK(classify(riff + "WEBPVP8 ") == FileType::Image);
+        CHECK(classify(riff + "WAVEfmt ") == FileType::Media);
+        std::string zip = std::string("PK\x03\x04", 4) + std::string(26, '\0');
+        CHECK(classify(zip + "[Content_Types].xml") == FileType::Office);
+        CHECK(classify(zip + "word/document.xml") == FileType::Archive);
+
+        // Magic at an offset
+        std::string tar(512, '\0');
+        tar.replace(257, 5, "ustar");
+        CHECK(classify(tar) == FileType::Archive);
+
+        // Headerless text is a script only by its name
+        CHECK(classify("print('hello')\n") == FileType::Text);
+        CHECK(classify("print('hello')\n", "run.PY") == FileType::Script);
+        CHECK(classify(std::string("\x00\x01\x02\x03", 4)) == FileType::Unknown);
+        CHECK(classify("") == FileType::Unknown);
+    }
+
+    FuzzyDigest fuzzy(const std::string& content, size_t chunkSize) {
+        FuzzyHasher hasher;
+        const auto* data = reinterpret_cast<const unsigned char*>(content.data());
+        for (size_t offset = 0; offset < content.size(); offset += chunkSize) {
+            hasher.update(data + offset, std::min(chunkSize, content.size() - offset));
+        }
+        return hasher.finalize();
+    }
+
+    void testFuzzyDigestTracksEdits() {
+        std::string content = randomText(BASE64_ALPHABET, 64, 4096, 5);
+        FuzzyDigest digest = fuzzy(content, content.size());
+        CHECK(digest.valid);
+        CHECK(digest.toString().size() == 72 && digest.toString().rfind("T1", 0) == 0);
+        for (size_t chunkSize : {1, 7, 1000}) {
+            CHECK(fuzzy(content, chunkSize).toString() == digest.toString());
+        }
+        CHECK(!fuzzy(content.substr(0, FuzzyHasher::MIN_INPUT - 1), 64).valid);
+        CHECK(fuzzy(content.substr(0, FuzzyHasher::MIN_INPUT - 1), 64).toString().empty());
+
+        // Both encodings round-trip
+        CHECK(FuzzyDigest::fromString(digest.toString()).toString() == digest.toString());
+        uint8_t raw[FuzzyDigest::ENCODED_SIZE];
+        digest.encode(raw);
+        CHECK(FuzzyDigest::decode(raw).toString() == digest.toString());
+        CHECK(!FuzzyDigest::fromString("T1abc").valid);
+
+        // A few edits stay close; unrelated content does not
+        std::string edited = content;
+        edited.replace(100, 8, "XXXXXXXX");
+        edited.replace(3000, 8, "YYYYYYYY");
+        FuzzyDigest near = fuzzy(edited, 512);
+        FuzzyDigest far = fuzzy(randomText(BASE64_ALPHABET, 64, 4096, 99), 512);
+        CHECK(fuzzyDistance(digest, digest) == 0);
+        CHECK(fuzzyDistance(digest, near) == fuzzyDistance(near, digest));
+        CHECK(fuzzyDistance(digest, near) < fuzzyDistance(digest, far));
+        CHECK(fuzzyDistance(digest, far) <= fuzzyDistance(digest, near) + fuzzyDistance(near, far));
+    }
+
+    void testScanBudgetStopsReads() {
+        CHECK(ScanBudget().check() == ScanBudget::State::Ok);
+        CHECK(ScanBudget(std::chrono::milliseconds(0)).check() == ScanBudget::State::Ok);
+        ScanBudget shortBudget(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(shortBudget.check() == ScanBudget::State::TimedOut);
+
+        CancellationToken token;
+        ScanBudget cancellable(std::chrono::milliseconds(0), &token);
+        token.cancel();
+        CHECK(cancellable.check() == ScanBudget::State::Cancelled);
+        token.reset();
+        CHECK(cancellable.check() == ScanBudget::State::Ok);
+
+        // Nested scopes combine, with cancellation winning over a timeout
+        CHECK(ScanBudget::threadState() == ScanBudget::State::Ok);
+        {
+            ScanBudget::Scope outer(cancellable);
+            {
+                ScanBudget::Scope inner(shortBudget);
+                CHECK(ScanBudget::threadState() == ScanBudget::State::TimedOut);
+                token.cancel();
+                CHECK(ScanBudget::threadState() == ScanBudget::State::Cancelled);
+                token.reset();
+            }
+            CHECK(!ScanBudget::threadExhausted());
+        }
+
+        // Reads stop at the next chunk once the budget runs out
+        std::string content(64 * 1024, 'x');
+        ScanSource source(std::as_bytes(std::span(content.data(), content.size())), "buffer");
+        ChunkedReader reader(1024);
+        size_t chunks = 0;
+        CHECK(reader.read(source, [&](const unsigned char*, size_t, uint64_t) { return ++chunks > 0; }));
+        CHECK(chunks == 64);
+
+        ScanBudget::Scope scope(cancellable);
+        chunks = 0;
+        CHECK(!reader.read(source, [&](const unsigned char*, size_t, uint64_t) {
+            if (++chunks == 3) token.cancel();
+            return true;
+        }));
+        CHECK(chunks == 3);
+    }
+
+    void testAsyncReadsCompleteIndependently() {
+        TestSupport::TempDir dir("async_reads");
+        AsyncReadEngine& engine = AsyncReadEngine::instance();
+        const size_t chunk = engine.bufferSize();
+        const int readers = 8;
+
+        std::vector<std::string> contents;
+        for (int i = 0; i < readers; i++) {
+            contents.push_back(randomText(BASE64_ALPHABET, 64, 3 * chunk + 123, static_cast<uint32_t>(i + 1)));
+            dir.write("file" + std::to_string(i), contents.back());
+        }
+
+        // Every reader queues its whole file, then collects the chunks in
+        // reverse so completions arrive for requests nobody is waiting on yet
+        std::atomic<int> mismatches{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; i++) {
+            threads.emplace_back([&, i] {
+                FileHandle file = FileHandle::open(dir.path("file" + std::to_string(i)));
+                std::vector<AsyncReadEngine::Request*> requests;
+                for (uint64_t offset = 0; offset < file.size(); offset += chunk) {
+                    requests.push_back(engine.submit(file, offset, chunk, true));
+                }
+                for (size_t r = requests.size(); r-- > 0;) {
+                    int64_t bytes = engine.wait(requests[r]);
+                    std::string expected = contents[i].substr(r * chunk, chunk);
+                    if (bytes != static_cast<int64_t>(expected.size()) ||
+                        std::memcmp(engine.data(requests[r]), expected.data(), expected.size()) != 0) {
+                        mismatches++;
+                    }
+                    engine.release(requests[r]);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        CHECK(mismatches == 0);
+
+        // Past the end of the file
+        FileHandle file = FileHandle::open(dir.path("file0"));
+        AsyncReadEngine::Request* request = engine.submit(file, file.size(), chunk, true);
+        CHECK(engine.wait(request) == 0);
+        engine.release(request);
+    }
+}
+
+int main() {
+    return TestSupport::runAll({
+        {"classifier_reads_magic", testClassifierReadsMagic},
+        {"pe_parses_imports", testPeParsesImports},
+        {"import_hash_names_known_ordinals", testImportHashNamesKnownOrdinals},
+        {"pe_rejects_malformed_headers", testPeRejectsMalformedHeaders},
+        {"pe_ignores_broken_imports", testPeIgnoresBrokenImports},
+        {"pe_bounds_runaway_imports", testPeBoundsRunawayImports},
+        {"elf_rejects_malformed_files", testElfRejectsMalformedFiles},
+#ifdef __linux__
+        {"elf_parses_own_executable", testElfParsesOwnExecutable},
+#endif
+        {"automaton_matches_across_chunks", testAutomatonMatchesAcrossChunks},
+        {"encoded_runs_across_chunks", testEncodedRunsAcrossChunks},
+        {"encoded_runs_ignore_plain_data", testEncodedRunsIgnorePlainData},
+        {"fuzzy_digest_tracks_edits", testFuzzyDigestTracksEdits},
+        {"scan_budget_stops_reads", testScanBudgetStopsReads},
+        {"async_reads_complete_independently", testAsyncReadsCompleteIndependently},
+    });
+}